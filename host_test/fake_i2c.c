@@ -0,0 +1,184 @@
+#include "fake_i2c.h"
+#include "freertos/queue.h"
+#include "host_test.h"
+#include <string.h>
+
+#define FAKE_I2C_MODELS 4
+#define FAKE_I2C_DEVICES 8
+#define FAKE_I2C_TX_MAX 16
+
+struct i2c_master_bus_t {
+    int unused;
+};
+
+struct i2c_master_dev_t {
+    bool used;
+    uint16_t addr;
+    uint32_t scl_hz;
+    i2c_master_callback_t on_trans_done;
+    void* user_data;
+};
+
+typedef struct {
+    uint16_t addr;
+    fake_i2c_model_fn_t fn;
+    void* ctx;
+} fake_model_t;
+
+typedef struct {
+    i2c_master_dev_handle_t dev;
+    uint8_t tx[FAKE_I2C_TX_MAX];
+    size_t tx_len;
+    uint8_t* rx;
+    size_t rx_len;
+} fake_trans_t;
+
+static struct i2c_master_bus_t g_bus;
+static struct i2c_master_dev_t g_devs[FAKE_I2C_DEVICES];
+static fake_model_t g_models[FAKE_I2C_MODELS];
+static uint32_t g_model_count;
+static fake_trans_t g_queue[FAKE_I2C_QUEUE_DEPTH];
+static uint32_t g_head;
+static uint32_t g_count;
+static fake_i2c_stats_t g_stats;
+
+static void wait_hook(void)
+{
+    fake_i2c_run();
+}
+
+i2c_master_bus_handle_t fake_i2c_bus(void)
+{
+    fake_queue_set_wait_hook(wait_hook);
+    return &g_bus;
+}
+
+void fake_i2c_add_model(uint16_t addr, fake_i2c_model_fn_t fn, void* ctx)
+{
+    CHECK(g_model_count < FAKE_I2C_MODELS);
+    g_models[g_model_count++] = (fake_model_t) { .addr = addr, .fn = fn, .ctx = ctx };
+}
+
+uint32_t fake_i2c_queued(void)
+{
+    return g_count;
+}
+
+const fake_i2c_stats_t* fake_i2c_stats(void)
+{
+    return &g_stats;
+}
+
+uint32_t fake_i2c_run(void)
+{
+    uint32_t done = 0;
+    while (g_count > 0) {
+        /* dequeue first, the callback may queue the next transaction */
+        const fake_trans_t trans = g_queue[g_head];
+        g_head = (g_head + 1) % FAKE_I2C_QUEUE_DEPTH;
+        g_count -= 1;
+
+        i2c_master_event_data_t evt = { .event = I2C_EVENT_NACK };
+        for (uint32_t i = 0; i < g_model_count; i++) {
+            if (g_models[i].addr == trans.dev->addr) {
+                evt.event = g_models[i].fn(
+                    g_models[i].ctx, trans.dev->scl_hz, trans.tx, trans.tx_len, trans.rx, trans.rx_len);
+            }
+        }
+        if (trans.dev->on_trans_done != NULL) {
+            trans.dev->on_trans_done(trans.dev, &evt, trans.dev->user_data);
+        }
+        done += 1;
+    }
+    return done;
+}
+
+static bool dev_busy(i2c_master_dev_handle_t dev)
+{
+    for (uint32_t i = 0; i < g_count; i++) {
+        if (g_queue[(g_head + i) % FAKE_I2C_QUEUE_DEPTH].dev == dev) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t i2c_master_bus_add_device(
+    i2c_master_bus_handle_t bus_handle, const i2c_device_config_t* dev_config, i2c_master_dev_handle_t* ret_handle)
+{
+    if (bus_handle != &g_bus || dev_config == NULL || ret_handle == NULL || dev_config->scl_speed_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (uint32_t i = 0; i < FAKE_I2C_DEVICES; i++) {
+        if (!g_devs[i].used) {
+            g_devs[i] = (struct i2c_master_dev_t) {
+                .used = true,
+                .addr = dev_config->device_address,
+                .scl_hz = dev_config->scl_speed_hz,
+            };
+            *ret_handle = &g_devs[i];
+            g_stats.devices_added += 1;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle)
+{
+    CHECK(handle != NULL && handle->used);
+    /* the driver would drop them, i2c_async must never remove a device with transactions queued */
+    CHECK(!dev_busy(handle));
+    handle->used = false;
+    g_stats.devices_removed += 1;
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_register_event_callbacks(
+    i2c_master_dev_handle_t i2c_dev, const i2c_master_event_callbacks_t* cbs, void* user_data)
+{
+    CHECK(i2c_dev != NULL && i2c_dev->used);
+    i2c_dev->on_trans_done = cbs->on_trans_done;
+    i2c_dev->user_data = user_data;
+    return ESP_OK;
+}
+
+static esp_err_t queue_trans(
+    i2c_master_dev_handle_t dev, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len)
+{
+    CHECK(dev != NULL && dev->used);
+    if (tx_len > FAKE_I2C_TX_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_count == FAKE_I2C_QUEUE_DEPTH) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    fake_trans_t* trans = &g_queue[(g_head + g_count) % FAKE_I2C_QUEUE_DEPTH];
+    *trans = (fake_trans_t) { .dev = dev, .tx_len = tx_len, .rx = rx, .rx_len = rx_len };
+    memcpy(trans->tx, tx, tx_len);
+    g_count += 1;
+    g_stats.transactions += 1;
+    if (g_count > g_stats.max_queued) {
+        g_stats.max_queued = g_count;
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_transmit(
+    i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, int xfer_timeout_ms)
+{
+    return queue_trans(i2c_dev, write_buffer, write_size, NULL, 0);
+}
+
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer,
+    size_t write_size, uint8_t* read_buffer, size_t read_size, int xfer_timeout_ms)
+{
+    return queue_trans(i2c_dev, write_buffer, write_size, read_buffer, read_size);
+}
+
+esp_err_t i2c_master_execute_defined_operations(
+    i2c_master_dev_handle_t i2c_dev, i2c_operation_job_t* i2c_operation, size_t operation_list_num, int xfer_timeout_ms)
+{
+    /* free-form operation lists are not modelled */
+    return ESP_ERR_NOT_SUPPORTED;
+}
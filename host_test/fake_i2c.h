@@ -0,0 +1,62 @@
+/**
+ * @file fake_i2c.h
+ * @brief Queued I2C master driver on the host, with device models written by the test.
+ *
+ * `i2c_master_transmit*()` only queue the transaction, as the driver does with
+ * `trans_queue_depth > 0`. The queue is run, in order, by `fake_i2c_run()` or
+ * when a task would block on an empty FreeRTOS queue (the completion ISR of
+ * the target). Each transaction goes to the model of its device address,
+ * which answers with the event the driver would report.
+ */
+
+#ifndef FAKE_I2C_H
+#define FAKE_I2C_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/i2c_master.h"
+
+/** Transactions the fake driver queues, like `trans_queue_depth` */
+#define FAKE_I2C_QUEUE_DEPTH 8
+
+/**
+ * @brief Device model: handle one transaction at `scl_hz`, fill `rx`, return DONE, NACK or TIMEOUT.
+ */
+typedef i2c_master_event_t (*fake_i2c_model_fn_t)(
+    void *ctx, uint32_t scl_hz, const uint8_t *tx, size_t tx_len, uint8_t *rx, size_t rx_len);
+
+typedef struct fake_i2c_stats_s {
+    uint32_t transactions;   /**< queued by the driver calls */
+    uint32_t max_queued;     /**< high-water mark of the driver queue */
+    uint32_t devices_added;
+    uint32_t devices_removed;
+} fake_i2c_stats_t;
+
+/**
+ * @brief The bus, models attach to it by address.
+ */
+i2c_master_bus_handle_t fake_i2c_bus(void);
+
+/**
+ * @brief Answer transactions to `addr` with `fn`, at most 4 models.
+ */
+void fake_i2c_add_model(uint16_t addr, fake_i2c_model_fn_t fn, void *ctx);
+
+/**
+ * @brief Complete every queued transaction, oldest first.
+ *
+ * @return transactions completed
+ */
+uint32_t fake_i2c_run(void);
+
+/**
+ * @brief Transactions queued and not yet completed.
+ */
+uint32_t fake_i2c_queued(void);
+
+/**
+ * @brief Counters since the start of the test.
+ */
+const fake_i2c_stats_t *fake_i2c_stats(void);
+
+#endif // FAKE_I2C_H
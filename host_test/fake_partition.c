@@ -0,0 +1,150 @@
+#include "fake_partition.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_PARTITION_MAX 4
+
+typedef struct {
+    esp_partition_t part;
+    uint8_t* data;
+} fake_partition_t;
+
+static fake_partition_t g_parts[FAKE_PARTITION_MAX];
+static uint32_t g_part_count;
+static uint64_t g_steps;
+static uint64_t g_cut_at = FAKE_PARTITION_NO_CUT;
+static bool g_power_lost;
+
+static fake_partition_t* lookup(const esp_partition_t* part)
+{
+    for (uint32_t i = 0; i < g_part_count; i++) {
+        if (&g_parts[i].part == part) {
+            return &g_parts[i];
+        }
+    }
+    CHECK(!"unknown partition");
+    return NULL;
+}
+
+typedef enum {
+    STEP_RUN,   /**< power is on */
+    STEP_CUT,   /**< the power goes during this step */
+    STEP_OFF,   /**< the power is gone */
+} step_t;
+
+static step_t step(void)
+{
+    if (g_power_lost) {
+        return STEP_OFF;
+    }
+    if (g_steps == g_cut_at) {
+        g_power_lost = true;
+        return STEP_CUT;
+    }
+    g_steps += 1;
+    return STEP_RUN;
+}
+
+const esp_partition_t* fake_partition_add(const char* label, uint32_t size)
+{
+    CHECK(g_part_count < FAKE_PARTITION_MAX);
+    fake_partition_t* fake = &g_parts[g_part_count];
+    fake->data = malloc(size);
+    CHECK(fake->data != NULL);
+    memset(fake->data, 0xFF, size);
+    fake->part = (esp_partition_t) {
+        .type = ESP_PARTITION_TYPE_DATA,
+        .subtype = ESP_PARTITION_SUBTYPE_ANY,
+        .address = 0x100000u * (g_part_count + 1),
+        .size = size,
+        .erase_size = 4096,
+    };
+    strncpy(fake->part.label, label, sizeof(fake->part.label) - 1);
+    g_part_count += 1;
+    return &fake->part;
+}
+
+uint8_t* fake_partition_data(const esp_partition_t* part)
+{
+    return lookup(part)->data;
+}
+
+void fake_partition_power_cut(uint64_t after_steps)
+{
+    g_steps = 0;
+    g_cut_at = after_steps;
+    g_power_lost = false;
+}
+
+uint64_t fake_partition_steps(void)
+{
+    return g_steps;
+}
+
+bool fake_partition_power_lost(void)
+{
+    return g_power_lost;
+}
+
+const esp_partition_t* esp_partition_find_first(
+    esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label)
+{
+    for (uint32_t i = 0; i < g_part_count; i++) {
+        const esp_partition_t* part = &g_parts[i].part;
+        if (part->type == type && (subtype == ESP_PARTITION_SUBTYPE_ANY || part->subtype == subtype)
+            && (label == NULL || strcmp(part->label, label) == 0)) {
+            return part;
+        }
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size)
+{
+    const fake_partition_t* fake = lookup(partition);
+    if (src_offset > partition->size || size > partition->size - src_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(dst, &fake->data[src_offset], size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size)
+{
+    fake_partition_t* fake = lookup(partition);
+    if (dst_offset > partition->size || size > partition->size - dst_offset) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    const uint8_t* bytes = src;
+    for (size_t i = 0; i < size; i++) {
+        const step_t st = step();
+        if (st != STEP_RUN) {
+            if (st == STEP_CUT) {
+                /* the byte being programmed when the power went: only the low bits made it */
+                fake->data[dst_offset + i] &= bytes[i] | 0xF0;
+            }
+            return ESP_FAIL;
+        }
+        fake->data[dst_offset + i] &= bytes[i];
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size)
+{
+    fake_partition_t* fake = lookup(partition);
+    if (offset % partition->erase_size != 0 || size % partition->erase_size != 0 || offset > partition->size
+        || size > partition->size - offset) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const step_t st = step();
+    if (st != STEP_RUN) {
+        if (st == STEP_CUT) {
+            memset(&fake->data[offset], 0xFF, size / 2);
+        }
+        return ESP_FAIL;
+    }
+    memset(&fake->data[offset], 0xFF, size);
+    return ESP_OK;
+}
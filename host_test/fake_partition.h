@@ -0,0 +1,47 @@
+/**
+ * @file fake_partition.h
+ * @brief esp_partition_* on RAM, with NOR flash rules and a power cut at a chosen point.
+ *
+ * A write can only clear bits, an erase sets a whole range back to 0xFF.
+ * Every programmed byte and every erase is one step. The power cut hits at a
+ * step: a write stops inside it, the byte being programmed gets only some of
+ * its bits, an erase clears only the first half of its range. From then on
+ * writes and erases fail and change nothing, until the next
+ * `fake_partition_power_cut()` call, the reboot.
+ */
+
+#ifndef FAKE_PARTITION_H
+#define FAKE_PARTITION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_partition.h"
+
+#define FAKE_PARTITION_NO_CUT UINT64_MAX
+
+/**
+ * @brief Add an erased partition of type data, at most 4 per test.
+ */
+const esp_partition_t *fake_partition_add(const char *label, uint32_t size);
+
+/**
+ * @brief The partition contents.
+ */
+uint8_t *fake_partition_data(const esp_partition_t *part);
+
+/**
+ * @brief Power is back, then cut `after_steps` steps from now (`FAKE_PARTITION_NO_CUT` for never).
+ */
+void fake_partition_power_cut(uint64_t after_steps);
+
+/**
+ * @brief Steps since the last `fake_partition_power_cut()`.
+ */
+uint64_t fake_partition_steps(void);
+
+/**
+ * @brief The cut has happened.
+ */
+bool fake_partition_power_lost(void);
+
+#endif // FAKE_PARTITION_H
@@ -0,0 +1,515 @@
+#include "fake_w5500.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Register offsets and bits from the W5500 datasheet, kept apart from the driver's w5500.h on purpose. */
+#define COMMON_REG_SIZE 0x40
+#define SOCK_REG_SIZE 0x30
+#define SOCK_NUM 8
+
+#define MR 0x00
+#define SIMR 0x18
+#define PHYCFGR 0x2E
+#define VERSIONR 0x39
+#define MR_RST 0x80
+
+#define SN_MR 0x00
+#define SN_CR 0x01
+#define SN_IR 0x02
+#define SN_SR 0x03
+#define SN_RXBUF_SIZE 0x1E
+#define SN_TXBUF_SIZE 0x1F
+#define SN_TX_FSR 0x20
+#define SN_TX_RD 0x22
+#define SN_TX_WR 0x24
+#define SN_RX_RSR 0x26
+#define SN_RX_RD 0x28
+#define SN_RX_WR 0x2A
+#define SN_IMR 0x2C
+
+#define CR_OPEN 0x01
+#define CR_CLOSE 0x10
+#define CR_SEND 0x20
+#define CR_RECV 0x40
+#define IR_RECV 0x04
+#define IR_TIMEOUT 0x08
+#define IR_SEND_OK 0x10
+#define SR_CLOSED 0x00
+#define SR_MACRAW 0x42
+
+#define FRAME_OVERHEAD_BYTES (8 + 4 + 12) // preamble, CRC and inter-frame gap
+#define SENT_LOG_LEN 64
+
+typedef struct {
+    uint8_t data[1536];
+    uint32_t len;
+} sent_frame_t;
+
+static struct {
+    fake_w5500_timing_t timing;
+    uint64_t spare_ns; // bus time not yet moved to the clock, below a microsecond
+    uint8_t common[COMMON_REG_SIZE];
+    uint8_t sock[SOCK_NUM][SOCK_REG_SIZE];
+    uint8_t tx_mem[FAKE_W5500_MEM_SIZE];
+    uint8_t rx_mem[FAKE_W5500_MEM_SIZE];
+    uint16_t tx_rd;     // chip side of socket 0, Sn_TX_WR and Sn_RX_RD are the host side in sock[0]
+    uint16_t rx_wr;
+    uint16_t rx_rd;     // Sn_RX_RD as of the last RECV, what Sn_RX_RSR counts from
+    bool sending;
+    uint16_t send_end;
+    int64_t send_done_us;
+    uint32_t fail_sends;
+    bool link_up;
+    sent_frame_t sent[SENT_LOG_LEN];
+    uint32_t sent_head;
+    uint32_t sent_count;
+    fake_w5500_stats_t stats;
+    void (*wire_hook)(void);
+} g_chip;
+
+static uint16_t get16(const uint8_t* reg)
+{
+    return (uint16_t)((reg[0] << 8) | reg[1]);
+}
+
+static void put16(uint8_t* reg, uint16_t value)
+{
+    reg[0] = (uint8_t)(value >> 8);
+    reg[1] = (uint8_t)value;
+}
+
+static uint32_t tx_size(void)
+{
+    return g_chip.sock[0][SN_TXBUF_SIZE] * 1024u;
+}
+
+static uint32_t rx_size(void)
+{
+    return g_chip.sock[0][SN_RXBUF_SIZE] * 1024u;
+}
+
+static void advance_ns(uint64_t ns)
+{
+    g_chip.spare_ns += ns;
+    fake_timer_advance_us((int64_t)(g_chip.spare_ns / 1000));
+    g_chip.spare_ns %= 1000;
+}
+
+/* a frame that made it onto the wire, for fake_w5500_pop_sent(), the test takes them before the log fills up */
+static void log_sent(uint16_t start, uint16_t len)
+{
+    if (g_chip.sent_count >= SENT_LOG_LEN) {
+        g_chip.stats.errors++;
+        return;
+    }
+    sent_frame_t* frame = &g_chip.sent[(g_chip.sent_head + g_chip.sent_count) % SENT_LOG_LEN];
+    uint32_t i = 0;
+    for (i = 0; i < len; ++i) {
+        frame->data[i] = g_chip.tx_mem[(uint16_t)(start + i) & (tx_size() - 1)];
+    }
+    frame->len = len;
+    g_chip.sent_count++;
+}
+
+/* the frame in flight leaves the chip once its wire time is over */
+static void update_send(void)
+{
+    if (!g_chip.sending || esp_timer_get_time() < g_chip.send_done_us) {
+        return;
+    }
+    g_chip.sending = false;
+    if (g_chip.fail_sends > 0) {
+        g_chip.fail_sends--;
+        g_chip.stats.tx_timeouts++;
+        g_chip.sock[0][SN_IR] |= IR_TIMEOUT;
+    } else {
+        log_sent(g_chip.tx_rd, (uint16_t)(g_chip.send_end - g_chip.tx_rd));
+        g_chip.stats.tx_frames++;
+        g_chip.sock[0][SN_IR] |= IR_SEND_OK;
+    }
+    g_chip.tx_rd = g_chip.send_end;
+}
+
+/* the registers the chip computes, as a read sees them */
+static void refresh_sock0(void)
+{
+    uint8_t* reg = g_chip.sock[0];
+    update_send();
+    reg[SN_CR] = 0; // every command is accepted at once
+    put16(&reg[SN_TX_FSR], (uint16_t)(tx_size() - (uint16_t)(get16(&reg[SN_TX_WR]) - g_chip.tx_rd)));
+    put16(&reg[SN_TX_RD], g_chip.tx_rd);
+    put16(&reg[SN_RX_RSR], (uint16_t)(g_chip.rx_wr - g_chip.rx_rd));
+    put16(&reg[SN_RX_WR], g_chip.rx_wr);
+}
+
+static void send(void)
+{
+    const uint16_t end = get16(&g_chip.sock[0][SN_TX_WR]);
+    const uint32_t len = (uint16_t)(end - g_chip.tx_rd);
+    if (g_chip.sending || g_chip.sock[0][SN_SR] != SR_MACRAW || len == 0 || len > sizeof(g_chip.sent[0].data)) {
+        g_chip.stats.errors++; // one SEND at a time, the driver has to wait for SEND_OK
+        return;
+    }
+    g_chip.sending = true;
+    g_chip.send_end = end;
+    const uint64_t wire_ns = (uint64_t)(len + FRAME_OVERHEAD_BYTES) * g_chip.timing.wire_ns_per_byte;
+    g_chip.send_done_us = esp_timer_get_time() + (int64_t)((wire_ns + 999) / 1000);
+}
+
+static void sock0_command(uint8_t command)
+{
+    uint8_t* reg = g_chip.sock[0];
+    switch (command) {
+    case CR_OPEN:
+        reg[SN_SR] = (reg[SN_MR] & 0x0F) == 0x04 ? SR_MACRAW : SR_CLOSED;
+        break;
+    case CR_CLOSE:
+        reg[SN_SR] = SR_CLOSED;
+        g_chip.sending = false;
+        break;
+    case CR_SEND:
+        send();
+        break;
+    case CR_RECV:
+        g_chip.rx_rd = get16(&reg[SN_RX_RD]);
+        if ((uint16_t)(g_chip.rx_wr - g_chip.rx_rd) > rx_size()) {
+            g_chip.stats.errors++; // RX_RD moved past the received data
+        }
+        if (g_chip.rx_wr != g_chip.rx_rd) {
+            reg[SN_IR] |= IR_RECV; // data left, the chip raises RECV again
+        }
+        break;
+    default:
+        g_chip.stats.errors++;
+        break;
+    }
+}
+
+static void write_sock_reg(int sock, uint32_t offset, uint8_t value)
+{
+    uint8_t* reg = g_chip.sock[sock];
+    switch (offset) {
+    case SN_IR:
+        reg[SN_IR] &= (uint8_t)~value; // write 1 to clear
+        break;
+    case SN_CR:
+        if (sock == 0) {
+            sock0_command(value);
+        }
+        break;
+    case SN_SR:
+    case SN_TX_FSR:
+    case SN_TX_FSR + 1:
+    case SN_TX_RD:
+    case SN_TX_RD + 1:
+    case SN_RX_RSR:
+    case SN_RX_RSR + 1:
+    case SN_RX_WR:
+    case SN_RX_WR + 1:
+        g_chip.stats.errors++; // read only
+        break;
+    default:
+        reg[offset] = value;
+        break;
+    }
+}
+
+/* MR.RST: registers and pointers as after power-on, the test's setup and the counters stay */
+static void soft_reset(void)
+{
+    memset(g_chip.common, 0, sizeof(g_chip.common));
+    memset(g_chip.sock, 0, sizeof(g_chip.sock));
+    uint32_t s = 0;
+    for (s = 0; s < SOCK_NUM; ++s) {
+        g_chip.sock[s][SN_RXBUF_SIZE] = 2;
+        g_chip.sock[s][SN_TXBUF_SIZE] = 2;
+    }
+    g_chip.tx_rd = 0;
+    g_chip.rx_wr = 0;
+    g_chip.rx_rd = 0;
+    g_chip.sending = false;
+}
+
+static void write_common_reg(uint32_t offset, uint8_t value)
+{
+    if (offset == MR && (value & MR_RST)) {
+        soft_reset();
+        return;
+    }
+    if (offset == VERSIONR) {
+        g_chip.stats.errors++;
+        return;
+    }
+    g_chip.common[offset] = value;
+}
+
+static uint8_t read_common_reg(uint32_t offset)
+{
+    if (offset == PHYCFGR) {
+        return (uint8_t)(0xB8 | (g_chip.link_up ? 0x07 : 0x06)); // 100 Mbps full duplex, link as set
+    }
+    if (offset == VERSIONR) {
+        return 0x04;
+    }
+    return g_chip.common[offset];
+}
+
+/* one SPI frame: 16-bit offset, control byte with block, direction and mode, then the data */
+static esp_err_t access(uint32_t offset, uint32_t control, uint8_t* data, uint32_t len, bool write)
+{
+    const uint32_t block = (control >> 3) & 0x1F;
+    const uint32_t sock = block >> 2;
+    const bool write_bit = (control >> 2) & 1;
+    uint32_t i = 0;
+
+    g_chip.stats.transactions++;
+    g_chip.stats.bus_bytes += 3 + len;
+    if (g_chip.timing.sclk_hz) {
+        advance_ns(g_chip.timing.trans_overhead_ns + (uint64_t)(3 + len) * 8 * 1000000000u / g_chip.timing.sclk_hz);
+    }
+    if (g_chip.wire_hook != NULL) {
+        g_chip.wire_hook(); // frames that arrived during the transaction
+    }
+    if (write_bit != write || (control & 0x03) != 0 || offset > 0xFFFF) {
+        g_chip.stats.errors++; // wrong direction in the control phase or a fixed length mode
+        return ESP_FAIL;
+    }
+    if (block == 0) {
+        for (i = 0; i < len; ++i) {
+            if (offset + i >= COMMON_REG_SIZE) {
+                g_chip.stats.errors++;
+            } else if (write) {
+                write_common_reg(offset + i, data[i]);
+            } else {
+                data[i] = read_common_reg(offset + i);
+            }
+        }
+        return ESP_OK;
+    }
+    switch (block & 0x03) {
+    case 1: // socket registers
+        if (sock == 0 && !write) {
+            refresh_sock0();
+        }
+        for (i = 0; i < len; ++i) {
+            if (offset + i >= SOCK_REG_SIZE) {
+                g_chip.stats.errors++;
+            } else if (write) {
+                write_sock_reg(sock, offset + i, data[i]);
+            } else {
+                data[i] = g_chip.sock[sock][offset + i];
+            }
+        }
+        return ESP_OK;
+    case 2: // TX memory, only written by the host
+        if (sock != 0 || !write || tx_size() == 0) {
+            g_chip.stats.errors++;
+            return ESP_OK;
+        }
+        for (i = 0; i < len; ++i) {
+            g_chip.tx_mem[(offset + i) & (tx_size() - 1)] = data[i];
+        }
+        return ESP_OK;
+    case 3: // RX memory, only read
+        if (sock != 0 || write || rx_size() == 0) {
+            g_chip.stats.errors++;
+            return ESP_OK;
+        }
+        for (i = 0; i < len; ++i) {
+            data[i] = g_chip.rx_mem[(offset + i) & (rx_size() - 1)];
+        }
+        return ESP_OK;
+    default:
+        g_chip.stats.errors++;
+        return ESP_FAIL;
+    }
+}
+
+void fake_w5500_reset(const fake_w5500_timing_t* timing)
+{
+    memset(&g_chip, 0, sizeof(g_chip));
+    g_chip.timing = *timing;
+    g_chip.link_up = true;
+    soft_reset();
+}
+
+void fake_w5500_set_pointers(uint16_t tx, uint16_t rx)
+{
+    g_chip.tx_rd = tx;
+    put16(&g_chip.sock[0][SN_TX_WR], tx);
+    g_chip.rx_wr = rx;
+    g_chip.rx_rd = rx;
+    put16(&g_chip.sock[0][SN_RX_RD], rx);
+}
+
+bool fake_w5500_receive(const uint8_t* frame, uint32_t len)
+{
+    const uint32_t size = rx_size();
+    const uint32_t used = (uint16_t)(g_chip.rx_wr - g_chip.rx_rd);
+    if (g_chip.sock[0][SN_SR] != SR_MACRAW || used + 2 + len > size) {
+        g_chip.stats.rx_dropped++;
+        return false;
+    }
+    // 2 bytes of length, big endian and including themselves, then the frame
+    const uint8_t header[2] = { (uint8_t)((len + 2) >> 8), (uint8_t)(len + 2) };
+    uint32_t i = 0;
+    for (i = 0; i < 2 + len; ++i) {
+        g_chip.rx_mem[(uint16_t)(g_chip.rx_wr + i) & (size - 1)] = (i < 2) ? header[i] : frame[i - 2];
+    }
+    g_chip.rx_wr = (uint16_t)(g_chip.rx_wr + 2 + len);
+    g_chip.sock[0][SN_IR] |= IR_RECV;
+    g_chip.stats.rx_frames++;
+    return true;
+}
+
+bool fake_w5500_pop_sent(uint8_t* frame, uint32_t* len)
+{
+    update_send();
+    if (g_chip.sent_count == 0) {
+        return false;
+    }
+    const sent_frame_t* sent = &g_chip.sent[g_chip.sent_head];
+    memcpy(frame, sent->data, sent->len);
+    *len = sent->len;
+    g_chip.sent_head = (g_chip.sent_head + 1) % SENT_LOG_LEN;
+    g_chip.sent_count--;
+    return true;
+}
+
+void fake_w5500_set_wire_hook(void (*hook)(void))
+{
+    g_chip.wire_hook = hook;
+}
+
+void fake_w5500_fail_sends(uint32_t count)
+{
+    g_chip.fail_sends = count;
+}
+
+void fake_w5500_set_link(bool up)
+{
+    g_chip.link_up = up;
+}
+
+bool fake_w5500_int_pending(void)
+{
+    update_send();
+    return (g_chip.common[SIMR] & 0x01) && (g_chip.sock[0][SN_IR] & g_chip.sock[0][SN_IMR]);
+}
+
+uint16_t fake_w5500_rx_pending(void)
+{
+    return (uint16_t)(g_chip.rx_wr - g_chip.rx_rd);
+}
+
+const fake_w5500_stats_t* fake_w5500_stats(void)
+{
+    return &g_chip.stats;
+}
+
+/* custom SPI driver: cmd is the address phase, addr the control phase */
+
+static void* spi_init(const void* config)
+{
+    return &g_chip;
+}
+
+static esp_err_t spi_deinit(void* ctx)
+{
+    return ESP_OK;
+}
+
+static esp_err_t spi_read(void* ctx, uint32_t cmd, uint32_t addr, void* data, uint32_t len)
+{
+    return access(cmd, addr, data, len, false);
+}
+
+static esp_err_t spi_write(void* ctx, uint32_t cmd, uint32_t addr, const void* data, uint32_t len)
+{
+    return access(cmd, addr, (uint8_t*)data, len, true);
+}
+
+eth_spi_custom_driver_config_t fake_w5500_spi_driver(void)
+{
+    eth_spi_custom_driver_config_t driver = {
+        .config = NULL,
+        .init = spi_init,
+        .deinit = spi_deinit,
+        .read = spi_read,
+        .write = spi_write,
+    };
+    return driver;
+}
+
+/* spi_master stand-in for the default SPI driver of the MAC, queued transactions are done when queued */
+
+#define SPI_RESULT_QUEUE_LEN 8
+
+struct spi_device_t {
+    spi_transaction_t* done[SPI_RESULT_QUEUE_LEN];
+    uint32_t done_head;
+    uint32_t done_count;
+};
+
+static struct spi_device_t g_device;
+
+esp_err_t spi_bus_add_device(spi_host_device_t host, const spi_device_interface_config_t* config,
+                             spi_device_handle_t* handle)
+{
+    memset(&g_device, 0, sizeof(g_device));
+    *handle = &g_device;
+    return ESP_OK;
+}
+
+esp_err_t spi_bus_remove_device(spi_device_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t handle, spi_transaction_t* trans)
+{
+    const uint32_t len = (uint32_t)trans->length / 8;
+    const bool write = (trans->addr >> 2) & 1;
+    if (write) {
+        const void* data = (trans->flags & SPI_TRANS_USE_TXDATA) ? (const void*)trans->tx_data : trans->tx_buffer;
+        return access(trans->cmd, (uint32_t)trans->addr, (uint8_t*)data, len, true);
+    }
+    void* data = (trans->flags & SPI_TRANS_USE_RXDATA) ? (void*)trans->rx_data : trans->rx_buffer;
+    // DMA writes whole words, an RX buffer of odd address or length is read into a bounce buffer and copied
+    if (!(trans->flags & SPI_TRANS_USE_RXDATA) && (((uintptr_t)data | len) & 3) != 0) {
+        g_chip.stats.bounce_bytes += len;
+    }
+    return access(trans->cmd, (uint32_t)trans->addr, data, len, false);
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t handle, spi_transaction_t* trans, TickType_t wait)
+{
+    if (handle->done_count == SPI_RESULT_QUEUE_LEN) {
+        return ESP_ERR_TIMEOUT;
+    }
+    const esp_err_t ret = spi_device_polling_transmit(handle, trans);
+    handle->done[(handle->done_head + handle->done_count) % SPI_RESULT_QUEUE_LEN] = trans;
+    handle->done_count++;
+    return ret;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t handle, spi_transaction_t** trans, TickType_t wait)
+{
+    if (handle->done_count == 0) {
+        return ESP_ERR_TIMEOUT;
+    }
+    *trans = handle->done[handle->done_head];
+    handle->done_head = (handle->done_head + 1) % SPI_RESULT_QUEUE_LEN;
+    handle->done_count--;
+    return ESP_OK;
+}
+
+esp_err_t spi_device_acquire_bus(spi_device_handle_t handle, TickType_t wait)
+{
+    return ESP_OK;
+}
+
+void spi_device_release_bus(spi_device_handle_t handle)
+{
+}
@@ -0,0 +1,79 @@
+/**
+ * @file fake_w5500.h
+ * @brief Register and buffer model of a W5500 behind the SPI bus, for the host tests of the W5500 MAC driver.
+ *
+ * Modelled are what the MAC RAW socket 0 path of esp_eth_mac_w5500.c touches: reset and VERSIONR, PHYCFGR, the
+ * interrupt and mask registers, socket commands (accepted at once, CR reads back 0), the TX and RX pointers with
+ * their 16-bit wrap-around, and the socket 0 memories, which wrap within the configured buffer size as on the chip.
+ * Every read or write call is one SPI transaction. Other sockets only get their registers.
+ *
+ * Time: every transaction moves the esp_timer.c clock by the bus time of the timing set at reset, a SEND completes
+ * (SEND_OK or TIMEOUT in Sn_IR) once the frame's wire time has passed on that clock.
+ *
+ * The chip is reached either as a custom SPI driver (fake_w5500_spi_driver()) or through the spi_master stand-in
+ * of stubs/driver/spi_master.h, which this file implements.
+ */
+
+#ifndef FAKE_W5500_H
+#define FAKE_W5500_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_eth_mac_spi.h"
+
+#define FAKE_W5500_MEM_SIZE (16 * 1024) // TX and RX memory each
+
+typedef struct {
+    uint32_t sclk_hz;           // SPI clock, 0: the bus takes no time at all
+    uint32_t trans_overhead_ns; // per transaction: CS, driver call, DMA setup
+    uint32_t wire_ns_per_byte;  // 80 at 100 Mbps, preamble, CRC and gap are added per frame
+} fake_w5500_timing_t;
+
+typedef struct {
+    uint32_t transactions; // SPI transactions
+    uint64_t bus_bytes;    // bytes clocked over the bus, 3 bytes of address and control phase included
+    uint32_t rx_frames;    // frames that arrived from the wire and were stored
+    uint32_t rx_dropped;   // frames that arrived while the RX memory had no room for them
+    uint32_t tx_frames;    // frames sent
+    uint32_t tx_timeouts;  // SENDs that ended with TIMEOUT instead of SEND_OK
+    uint64_t bounce_bytes; // spi_master reads the ESP-IDF driver would copy through a DMA buffer of its own
+    uint32_t errors;       // accesses the model does not know or the chip would not accept, a full sent log
+} fake_w5500_stats_t;
+
+/** 36 MHz SPI as on the board, 100 Mbps line */
+#define FAKE_W5500_TIMING_BOARD { .sclk_hz = 36000000, .trans_overhead_ns = 5000, .wire_ns_per_byte = 80 }
+
+/** Power-on state: registers, pointers, counters and the sent log cleared, link up */
+void fake_w5500_reset(const fake_w5500_timing_t* timing);
+
+/** Custom SPI driver talking to the model, for eth_w5500_config_t.custom_spi_driver */
+eth_spi_custom_driver_config_t fake_w5500_spi_driver(void);
+
+/** Sets the socket 0 TX and RX pointers as if that much traffic had passed already, before the socket is opened */
+void fake_w5500_set_pointers(uint16_t tx, uint16_t rx);
+
+/** A frame arrives from the wire, false if the RX memory had no room for it (the chip drops it) */
+bool fake_w5500_receive(const uint8_t* frame, uint32_t len);
+
+/** Called after every transaction, once the clock has moved on by its bus time: the test puts the frames on the wire
+    that are due by then. Cleared by fake_w5500_reset(). */
+void fake_w5500_set_wire_hook(void (*hook)(void));
+
+/** Takes the oldest frame the chip sent, false if there is none, the log holds 64 frames */
+bool fake_w5500_pop_sent(uint8_t* frame, uint32_t* len);
+
+/** The next count SENDs end with TIMEOUT instead of SEND_OK, their frames are lost and not in the sent log */
+void fake_w5500_fail_sends(uint32_t count);
+
+/** Link state reported in PHYCFGR */
+void fake_w5500_set_link(bool up);
+
+/** The INT line is asserted: an unmasked socket interrupt is pending */
+bool fake_w5500_int_pending(void);
+
+/** Bytes received and not yet released with RECV */
+uint16_t fake_w5500_rx_pending(void);
+
+const fake_w5500_stats_t* fake_w5500_stats(void);
+
+#endif // FAKE_W5500_H
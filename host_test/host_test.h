@@ -0,0 +1,31 @@
+/**
+ * @file host_test.h
+ * @brief Minimal checks for the host tests, a failed check ends the test with exit code 1.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { \
+        const long long a_ = (long long)(a); \
+        const long long b_ = (long long)(b); \
+        if (a_ != b_) { \
+            fprintf(stderr, "%s:%d: check failed: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, a_, b_); \
+            exit(1); \
+        } \
+    } while (0)
+
+#endif // HOST_TEST_H
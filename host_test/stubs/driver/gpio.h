@@ -0,0 +1,48 @@
+/* Host stand-in for the ESP-IDF header: there are no pins, the tests run the driver task by hand. */
+#ifndef DRIVER_GPIO_H
+#define DRIVER_GPIO_H
+
+#include "esp_err.h"
+
+typedef enum {
+    GPIO_INTR_NEGEDGE = 2,
+} gpio_int_type_t;
+
+typedef void (*gpio_isr_t)(void *arg);
+
+static inline int gpio_get_level(int gpio)
+{
+    return 1;
+}
+
+static inline esp_err_t gpio_set_intr_type(int gpio, gpio_int_type_t type)
+{
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_intr_enable(int gpio)
+{
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_pullup_en(int gpio)
+{
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_reset_pin(int gpio)
+{
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_isr_handler_add(int gpio, gpio_isr_t handler, void *arg)
+{
+    return ESP_OK;
+}
+
+static inline esp_err_t gpio_isr_handler_remove(int gpio)
+{
+    return ESP_OK;
+}
+
+#endif // DRIVER_GPIO_H
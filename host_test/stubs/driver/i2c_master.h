@@ -0,0 +1,86 @@
+/* Host stand-in for the ESP-IDF header: the queued master API, implemented by fake_i2c.c. */
+#ifndef I2C_MASTER_H
+#define I2C_MASTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include "freertos/FreeRTOS.h"
+
+typedef enum {
+    I2C_ADDR_BIT_LEN_7 = 0,
+} i2c_addr_bit_len_t;
+
+typedef struct i2c_master_bus_t* i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t* i2c_master_dev_handle_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+    uint32_t scl_wait_us;
+    struct {
+        uint32_t disable_ack_check : 1;
+    } flags;
+} i2c_device_config_t;
+
+typedef enum {
+    I2C_EVENT_ALIVE,
+    I2C_EVENT_DONE,
+    I2C_EVENT_NACK,
+    I2C_EVENT_TIMEOUT,
+} i2c_master_event_t;
+
+typedef struct {
+    i2c_master_event_t event;
+} i2c_master_event_data_t;
+
+typedef bool (*i2c_master_callback_t)(
+    i2c_master_dev_handle_t i2c_dev, const i2c_master_event_data_t* evt_data, void* arg);
+
+typedef struct {
+    i2c_master_callback_t on_trans_done;
+} i2c_master_event_callbacks_t;
+
+typedef enum {
+    I2C_MASTER_CMD_START,
+    I2C_MASTER_CMD_WRITE,
+    I2C_MASTER_CMD_READ,
+    I2C_MASTER_CMD_STOP,
+} i2c_master_command_t;
+
+typedef enum {
+    I2C_ACK_VAL = 0,
+    I2C_NACK_VAL = 1,
+} i2c_ack_value_t;
+
+typedef struct {
+    i2c_master_command_t command;
+    union {
+        struct {
+            bool ack_check;
+            uint8_t* data;
+            size_t total_bytes;
+        } write;
+        struct {
+            i2c_ack_value_t ack_value;
+            uint8_t* data;
+            size_t total_bytes;
+        } read;
+    };
+} i2c_operation_job_t;
+
+esp_err_t i2c_master_bus_add_device(
+    i2c_master_bus_handle_t bus_handle, const i2c_device_config_t* dev_config, i2c_master_dev_handle_t* ret_handle);
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle);
+esp_err_t i2c_master_register_event_callbacks(
+    i2c_master_dev_handle_t i2c_dev, const i2c_master_event_callbacks_t* cbs, void* user_data);
+esp_err_t i2c_master_transmit(
+    i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer, size_t write_size, int xfer_timeout_ms);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t i2c_dev, const uint8_t* write_buffer,
+    size_t write_size, uint8_t* read_buffer, size_t read_size, int xfer_timeout_ms);
+esp_err_t i2c_master_execute_defined_operations(
+    i2c_master_dev_handle_t i2c_dev, i2c_operation_job_t* i2c_operation, size_t operation_list_num, int xfer_timeout_ms);
+
+#endif // I2C_MASTER_H
@@ -0,0 +1,7 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef ESP_ATTR_H
+#define ESP_ATTR_H
+
+#define IRAM_ATTR
+
+#endif // ESP_ATTR_H
@@ -0,0 +1,60 @@
+/* Host stand-in for the ESP-IDF header: the mediator and the link state types the W5500 driver uses. */
+#ifndef ESP_ETH_COM_H
+#define ESP_ETH_COM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifndef __containerof
+/* newlib's sys/cdefs.h has it, glibc's doesn't */
+#define __containerof(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+#endif
+
+#define ETH_ADDR_LEN 6
+#define ETH_MAX_PACKET_SIZE 1514
+#define ETH_MIN_PACKET_SIZE 64
+#define ETH_CRC_LEN 4
+
+typedef enum {
+    ETH_LINK_UP,
+    ETH_LINK_DOWN,
+} eth_link_t;
+
+typedef enum {
+    ETH_SPEED_10M,
+    ETH_SPEED_100M,
+} eth_speed_t;
+
+typedef enum {
+    ETH_DUPLEX_HALF,
+    ETH_DUPLEX_FULL,
+} eth_duplex_t;
+
+typedef enum {
+    ETH_STATE_LLINIT,
+    ETH_STATE_DEINIT,
+    ETH_STATE_LINK,
+    ETH_STATE_SPEED,
+    ETH_STATE_PAUSE,
+    ETH_STATE_DUPLEX,
+} esp_eth_state_t;
+
+typedef enum {
+    ESP_ETH_PHY_AUTONEGO_RESTART,
+    ESP_ETH_PHY_AUTONEGO_EN,
+    ESP_ETH_PHY_AUTONEGO_DIS,
+    ESP_ETH_PHY_AUTONEGO_G_STAT,
+} eth_phy_autoneg_cmd_t;
+
+typedef struct esp_eth_mediator_s esp_eth_mediator_t;
+
+struct esp_eth_mediator_s {
+    esp_err_t (*phy_reg_read)(esp_eth_mediator_t *eth, uint32_t phy_addr, uint32_t phy_reg, uint32_t *reg_value);
+    esp_err_t (*phy_reg_write)(esp_eth_mediator_t *eth, uint32_t phy_addr, uint32_t phy_reg, uint32_t reg_value);
+    esp_err_t (*stack_input)(esp_eth_mediator_t *eth, uint8_t *buffer, uint32_t length);
+    esp_err_t (*on_state_changed)(esp_eth_mediator_t *eth, esp_eth_state_t state, void *args);
+};
+
+#endif // ESP_ETH_COM_H
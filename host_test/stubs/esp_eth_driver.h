@@ -0,0 +1,13 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef ESP_ETH_DRIVER_H
+#define ESP_ETH_DRIVER_H
+
+#include "esp_eth_mac.h"
+#include "esp_eth_phy.h"
+
+typedef void *esp_eth_handle_t;
+
+#define ETH_CMD_CUSTOM_MAC_CMDS 0x0FFF
+#define ETH_CMD_CUSTOM_PHY_CMDS 0x1FFF
+
+#endif // ESP_ETH_DRIVER_H
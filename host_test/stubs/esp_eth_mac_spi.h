@@ -0,0 +1,18 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef ESP_ETH_MAC_SPI_H
+#define ESP_ETH_MAC_SPI_H
+
+#include "esp_eth_mac.h"
+#include "driver/spi_master.h"
+
+typedef struct {
+    void *config;
+    void *(*init)(const void *spi_config);
+    esp_err_t (*deinit)(void *spi_ctx);
+    esp_err_t (*read)(void *spi_ctx, uint32_t cmd, uint32_t addr, void *data, uint32_t data_len);
+    esp_err_t (*write)(void *spi_ctx, uint32_t cmd, uint32_t addr, const void *data, uint32_t data_len);
+} eth_spi_custom_driver_config_t;
+
+#define ETH_DEFAULT_SPI { .config = NULL, .init = NULL, .deinit = NULL, .read = NULL, .write = NULL }
+
+#endif // ESP_ETH_MAC_SPI_H
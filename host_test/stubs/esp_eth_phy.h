@@ -0,0 +1,29 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef ESP_ETH_PHY_H
+#define ESP_ETH_PHY_H
+
+#include "esp_eth_com.h"
+
+typedef struct esp_eth_phy_s esp_eth_phy_t;
+
+struct esp_eth_phy_s {
+    esp_err_t (*set_mediator)(esp_eth_phy_t *phy, esp_eth_mediator_t *mediator);
+    esp_err_t (*reset)(esp_eth_phy_t *phy);
+    esp_err_t (*reset_hw)(esp_eth_phy_t *phy);
+    esp_err_t (*init)(esp_eth_phy_t *phy);
+    esp_err_t (*deinit)(esp_eth_phy_t *phy);
+    esp_err_t (*autonego_ctrl)(esp_eth_phy_t *phy, eth_phy_autoneg_cmd_t cmd, bool *autonego_en_stat);
+    esp_err_t (*get_link)(esp_eth_phy_t *phy);
+    esp_err_t (*set_link)(esp_eth_phy_t *phy, eth_link_t link);
+    esp_err_t (*pwrctl)(esp_eth_phy_t *phy, bool enable);
+    esp_err_t (*set_addr)(esp_eth_phy_t *phy, uint32_t addr);
+    esp_err_t (*get_addr)(esp_eth_phy_t *phy, uint32_t *addr);
+    esp_err_t (*advertise_pause_ability)(esp_eth_phy_t *phy, uint32_t ability);
+    esp_err_t (*loopback)(esp_eth_phy_t *phy, bool enable);
+    esp_err_t (*set_speed)(esp_eth_phy_t *phy, eth_speed_t speed);
+    esp_err_t (*set_duplex)(esp_eth_phy_t *phy, eth_duplex_t duplex);
+    esp_err_t (*custom_ioctl)(esp_eth_phy_t *phy, int cmd, void *data);
+    esp_err_t (*del)(esp_eth_phy_t *phy);
+};
+
+#endif // ESP_ETH_PHY_H
@@ -0,0 +1,5 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef ESP_INTR_ALLOC_H
+#define ESP_INTR_ALLOC_H
+
+#endif // ESP_INTR_ALLOC_H
@@ -0,0 +1,13 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef ESP_PRIVATE_GPIO_H
+#define ESP_PRIVATE_GPIO_H
+
+static inline void gpio_func_sel(int gpio, int func)
+{
+}
+
+static inline void gpio_input_enable(int gpio)
+{
+}
+
+#endif // ESP_PRIVATE_GPIO_H
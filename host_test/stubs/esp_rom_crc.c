@@ -0,0 +1,25 @@
+#include "esp_rom_crc.h"
+#include <stdbool.h>
+
+static uint32_t g_table[256];
+static bool g_table_ok;
+
+/* Same result as the ROM function: CRC-32 (IEEE 802.3), reflected, the inversions inside */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len)
+{
+    if (!g_table_ok) {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c >> 1) ^ (0xEDB88320u & (0u - (c & 1u)));
+            }
+            g_table[n] = c;
+        }
+        g_table_ok = true;
+    }
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ g_table[(crc ^ buf[i]) & 0xFF];
+    }
+    return ~crc;
+}
@@ -0,0 +1,59 @@
+#include "esp_timer.h"
+#include <stdlib.h>
+
+struct fake_timer_s {
+    esp_timer_create_args_t args;
+    bool active;
+};
+
+static int64_t g_now_us = 1000000;
+
+int64_t esp_timer_get_time(void)
+{
+    return g_now_us;
+}
+
+void fake_timer_advance_us(int64_t us)
+{
+    g_now_us += us;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle)
+{
+    esp_timer_handle_t timer = calloc(1, sizeof(*timer));
+    if (timer == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    timer->args = *args;
+    *handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    timer->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    timer->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    free(timer);
+    return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer)
+{
+    return timer->active;
+}
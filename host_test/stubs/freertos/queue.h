@@ -0,0 +1,23 @@
+/* Host stand-in for the FreeRTOS header, see freertos_queue.c. */
+#ifndef FREERTOS_QUEUE_H
+#define FREERTOS_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_queue_s* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait);
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+/**
+ * Host only: called when a receive would block on an empty queue, in place of
+ * the interrupts that would fill it on the target. The receive fails the test
+ * if the queue is still empty afterwards, a blocked single thread never wakes.
+ */
+void fake_queue_set_wait_hook(void (*hook)(void));
+
+#endif // FREERTOS_QUEUE_H
@@ -0,0 +1,52 @@
+/* Host stand-in for the FreeRTOS header: one thread, a mutex is never contended. A take of a semaphore that is not
+   given blocks through fake_task_block() of freertos_task.c when the test links it, and fails otherwise. */
+#ifndef FREERTOS_SEMPHR_H
+#define FREERTOS_SEMPHR_H
+
+#include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_semaphore_s {
+    int taken;
+}* SemaphoreHandle_t;
+
+typedef struct fake_semaphore_s StaticSemaphore_t;
+
+void fake_task_block(void) __attribute__((weak));
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return calloc(1, sizeof(struct fake_semaphore_s));
+}
+
+/* taken until given, like a FreeRTOS binary semaphore */
+static inline SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t* buf)
+{
+    buf->taken = 1;
+    return buf;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    (void)sem; // static ones can't be told apart, a mutex or two per test is left to the exit
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    if (sem->taken && wait > 0 && fake_task_block != NULL) {
+        fake_task_block(); // the tasks that would run meanwhile may give it
+    }
+    if (sem->taken) {
+        return pdFALSE;
+    }
+    sem->taken = 1;
+    return pdTRUE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    sem->taken = 0;
+    return pdTRUE;
+}
+
+#endif // FREERTOS_SEMPHR_H
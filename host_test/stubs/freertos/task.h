@@ -0,0 +1,43 @@
+/* Host stand-in for the FreeRTOS header, see freertos_task.c. */
+#ifndef FREERTOS_TASK_H
+#define FREERTOS_TASK_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct fake_task_s* TaskHandle_t;
+typedef void (*TaskFunction_t)(void* arg);
+
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define portYIELD_FROM_ISR() ((void)0)
+
+/* Tasks are never run, the tests call what a task would do themselves. */
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg, UBaseType_t prio,
+                                   TaskHandle_t* handle, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+/* not in freertos_task.c, test_job_sched.c has its own on threads */
+void vTaskSuspend(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+char* pcTaskGetName(TaskHandle_t task);
+
+/* One tick is a millisecond of the esp_timer.c clock, delays move that clock. */
+TickType_t xTaskGetTickCount(void);
+void vTaskDelay(TickType_t ticks);
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait);
+
+/** Host only: the task xTaskGetCurrentTaskHandle() returns from now on, the test's own task by default */
+void fake_task_set_current(TaskHandle_t task);
+
+/**
+ * Host only: called when the current task blocks in vTaskDelay() or in
+ * ulTaskNotifyTake() without a notification, in place of the tasks that would
+ * run meanwhile on the target. The wait ends when the hook returns.
+ */
+void fake_task_set_block_hook(void (*hook)(void));
+
+/** Host only: the current task blocks on something else (a semaphore of semphr.h), the block hook runs */
+void fake_task_block(void);
+
+#endif // FREERTOS_TASK_H
@@ -0,0 +1,85 @@
+#include "freertos/queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct fake_queue_s {
+    uint8_t* items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+static void (*g_wait_hook)(void);
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    queue->items = calloc(length, item_size);
+    if (queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue != NULL) {
+        free(queue->items);
+        free(queue);
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t wait)
+{
+    (void)wait;
+    if (queue->count == queue->length) {
+        return pdFAIL;
+    }
+    memcpy(&queue->items[((queue->head + queue->count) % queue->length) * queue->item_size], item, queue->item_size);
+    queue->count += 1;
+    return pdPASS;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void* item, BaseType_t* woken)
+{
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(queue, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t wait)
+{
+    if (queue->count == 0 && wait != 0 && g_wait_hook != NULL) {
+        g_wait_hook();
+    }
+    if (queue->count == 0) {
+        if (wait == portMAX_DELAY) {
+            fprintf(stderr, "xQueueReceive: waits forever on an empty queue\n");
+            exit(1);
+        }
+        return pdFAIL;
+    }
+    memcpy(item, &queue->items[queue->head * queue->item_size], queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count -= 1;
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+void fake_queue_set_wait_hook(void (*hook)(void))
+{
+    g_wait_hook = hook;
+}
@@ -0,0 +1,103 @@
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include <stdlib.h>
+
+struct fake_task_s {
+    TaskFunction_t fn;
+    void* arg;
+    const char* name;
+    uint32_t notified;
+};
+
+static struct fake_task_s g_main_task;
+static TaskHandle_t g_current = &g_main_task;
+static void (*g_block_hook)(void);
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg, UBaseType_t prio,
+                                   TaskHandle_t* handle, BaseType_t core)
+{
+    TaskHandle_t task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->name = name;
+    *handle = task;
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task != NULL && task != &g_main_task) {
+        free(task);
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return g_current;
+}
+
+char* pcTaskGetName(TaskHandle_t task)
+{
+    task = (task != NULL) ? task : g_current;
+    return (char*)((task->name != NULL) ? task->name : "main");
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+void fake_task_block(void)
+{
+    if (g_block_hook != NULL) {
+        g_block_hook();
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    fake_timer_advance_us((int64_t)ticks * 1000);
+    fake_task_block();
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    task->notified++;
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* woken)
+{
+    task->notified++;
+    if (woken != NULL) {
+        *woken = pdFALSE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    if (g_current->notified == 0 && wait > 0) {
+        fake_task_block();
+        if (g_current->notified == 0 && wait != portMAX_DELAY) {
+            fake_timer_advance_us((int64_t)wait * 1000); // timed out
+        }
+    }
+    const uint32_t count = g_current->notified;
+    if (count > 0) {
+        g_current->notified = clear ? 0 : count - 1;
+    }
+    return count;
+}
+
+void fake_task_set_current(TaskHandle_t task)
+{
+    g_current = (task != NULL) ? task : &g_main_task;
+}
+
+void fake_task_set_block_hook(void (*hook)(void))
+{
+    g_block_hook = hook;
+}
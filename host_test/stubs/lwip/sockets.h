@@ -0,0 +1,10 @@
+/* Host stand-in for the lwIP header: the BSD sockets of the host, lwIP's API is the same. */
+#ifndef LWIP_SOCKETS_H
+#define LWIP_SOCKETS_H
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#endif // LWIP_SOCKETS_H
@@ -0,0 +1,5 @@
+/* Host stand-in for the generated sdkconfig.h: the options the tested modules read. */
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#endif // SDKCONFIG_H
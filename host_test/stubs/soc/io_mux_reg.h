@@ -0,0 +1,7 @@
+/* Host stand-in for the ESP-IDF header. */
+#ifndef SOC_IO_MUX_REG_H
+#define SOC_IO_MUX_REG_H
+
+#define PIN_FUNC_GPIO 2
+
+#endif // SOC_IO_MUX_REG_H
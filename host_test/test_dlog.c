@@ -0,0 +1,121 @@
+/*
+ * dlog: dlog_format() against the C library. A record holds only the format
+ * and the arguments as 64-bit words, dlog_format() has to rebuild every
+ * conversion from that with the right type. For each case the record is
+ * built the way log_printf() builds it (DLOG_ARG) and the result must be
+ * byte for byte what snprintf() gives for the same format and arguments,
+ * the cut at the end of a small buffer included: integers of every length
+ * (int, long, long long, the PRIu32/PRIx32 family), width, precision and
+ * flags, %s, %f and the other doubles, %c, %p and %%.
+ */
+#include "dlog.h"
+#include "host_test.h"
+#include <limits.h>
+#include <string.h>
+
+#define BUF_SIZE DLOG_LINE_MAX
+#define GUARD 0x5A
+
+static char g_expected[BUF_SIZE + 1];
+static char g_got[BUF_SIZE + 1];
+static uint32_t g_cases;
+
+/* the record of a log_printf() call, formatted into a buffer of `size` bytes and compared with snprintf() */
+#define CHECK_FORMAT(size, fmt, ...)                                                                          \
+    check_format(__LINE__, (size), (fmt), DLOG_NARG(__VA_ARGS__),                                              \
+        (const uint64_t[]) { DLOG_CAT(DLOG_MAP_, DLOG_NARG(__VA_ARGS__))(__VA_ARGS__) 0 },                     \
+        snprintf(g_expected, (size), (fmt), ##__VA_ARGS__))
+
+static void check_format(int line, size_t size, const char* fmt, uint32_t nargs, const uint64_t* args, int full)
+{
+    dlog_record_t record = {
+        .fmt = fmt,
+        .nargs = (uint8_t)nargs,
+    };
+    memcpy(record.args, args, nargs * sizeof(args[0]));
+    memset(g_got, GUARD, sizeof(g_got));
+
+    const size_t len = dlog_format(&record, g_got, size);
+    const size_t expected_len = strlen(g_expected);
+    if (len != expected_len || memcmp(g_got, g_expected, expected_len + 1) != 0 || g_got[size] != GUARD) {
+        fprintf(stderr, "line %d: \"%s\" in %zu bytes: got \"%.*s\" (%zu), snprintf \"%s\" (%zu)\n", line, fmt, size,
+            (int)len, g_got, len, g_expected, expected_len);
+        exit(1);
+    }
+    CHECK(full >= 0 && (size_t)full >= expected_len);
+    g_cases++;
+}
+
+static void test_integers(void)
+{
+    CHECK_FORMAT(BUF_SIZE, "%d %d %d", 0, -5, INT_MIN);
+    CHECK_FORMAT(BUF_SIZE, "%i %d", INT_MAX, -1);
+    CHECK_FORMAT(BUF_SIZE, "%u %u", 0u, 4000000000u);
+    CHECK_FORMAT(BUF_SIZE, "%ld %ld %lu", -123456789L, LONG_MIN, ULONG_MAX);
+    CHECK_FORMAT(BUF_SIZE, "%lld %lld %llu", LLONG_MIN, LLONG_MAX, ULLONG_MAX);
+    CHECK_FORMAT(BUF_SIZE, "%" PRIu32 " %" PRIx32 " %" PRIX32 " %" PRId32, UINT32_MAX, (uint32_t)0xdeadbeef,
+        (uint32_t)0xdeadbeef, INT32_MIN);
+    CHECK_FORMAT(BUF_SIZE, "%" PRId64 " %" PRIu64 " %" PRIx64, INT64_MIN, UINT64_MAX, (uint64_t)0x0123456789abcdef);
+    CHECK_FORMAT(BUF_SIZE, "%zu %zd", (size_t)123456, (ssize_t)-42);
+    CHECK_FORMAT(BUF_SIZE, "%o %x %X %#x %#o", 8u, 255u, 255u, 255u, 8u);
+    CHECK_FORMAT(BUF_SIZE, "%hhu %hd", (unsigned char)200, (short)-300);
+    CHECK_FORMAT(BUF_SIZE, "%c%c%c", 'a', 'B', '0');
+}
+
+static void test_width_precision(void)
+{
+    CHECK_FORMAT(BUF_SIZE, "[%5d] [%-5d] [%05d] [%+d] [% d]", 42, 42, 42, 42, 42);
+    CHECK_FORMAT(BUF_SIZE, "[%.3d] [%8.3d] [%-8.3d]", 7, -7, 7);
+    CHECK_FORMAT(BUF_SIZE, "[%08" PRIx32 "] [%-10" PRIu32 "] [%02X]", (uint32_t)0xbeef, (uint32_t)99, 0x5u);
+    CHECK_FORMAT(BUF_SIZE, "[%10s] [%-10s] [%.3s] [%10.2s] [%-6.4s]", "abc", "abc", "abcdef", "abcdef", "abcdef");
+    CHECK_FORMAT(BUF_SIZE, "boot %-12s at %8" PRId64 " us (+%" PRId64 " us)", "got ip", (int64_t)1234567, (int64_t)89);
+}
+
+static void test_strings_doubles(void)
+{
+    CHECK_FORMAT(BUF_SIZE, "%s", "hello");
+    CHECK_FORMAT(BUF_SIZE, "%s=%s", "", "value");
+    CHECK_FORMAT(BUF_SIZE, "%f %f %f", 3.14159, -0.5, 1e10);
+    CHECK_FORMAT(BUF_SIZE, "%.0f %.2f %8.3f %-8.2f| %+.1f", 2.5, -17.125f, 1.5, 2.25, 0.05);
+    CHECK_FORMAT(BUF_SIZE, "%e %E %g %G %a", 12345.678, 0.000123, 1e-5, 1e20, 1.0);
+    CHECK_FORMAT(BUF_SIZE, "%.1f%%", 99.95);
+    CHECK_FORMAT(BUF_SIZE, "%p", (void*)&g_cases);
+}
+
+static void test_percent(void)
+{
+    CHECK_FORMAT(BUF_SIZE, "%%");
+    CHECK_FORMAT(BUF_SIZE, "100%% done");
+    CHECK_FORMAT(BUF_SIZE, "%d%% of %u%%", 50, 8u);
+    CHECK_FORMAT(BUF_SIZE, "no conversion at all");
+}
+
+/* the buffer ends in the literal text, inside a conversion, and right after one */
+static void test_truncation(void)
+{
+    size_t size = 0;
+    for (size = 1; size <= 24; ++size) {
+        CHECK_FORMAT(size, "value=%d units", 123456);
+        CHECK_FORMAT(size, "[%-10s] %05" PRIu32, "name", (uint32_t)42);
+        CHECK_FORMAT(size, "%8.3f|%lld", -1.5, -9000000000LL);
+        CHECK_FORMAT(size, "ab%%cd%%ef%%%x", 0xabcu);
+        CHECK_FORMAT(size, "%s", "a string longer than the buffer");
+    }
+    /* the whole line buffer */
+    static char long_text[2 * BUF_SIZE];
+    memset(long_text, 'x', sizeof(long_text) - 1);
+    CHECK_FORMAT(BUF_SIZE, "%s", long_text);
+    CHECK_FORMAT(BUF_SIZE, "%d %s", 1, long_text);
+}
+
+int main(void)
+{
+    test_integers();
+    test_width_precision();
+    test_strings_doubles();
+    test_percent();
+    test_truncation();
+    printf("%u formats identical to snprintf()\n", g_cases);
+    printf("ok\n");
+    return 0;
+}
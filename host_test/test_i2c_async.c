@@ -0,0 +1,195 @@
+/*
+ * i2c_async on a fake queued bus: in-order completion of several requests in
+ * flight, and the SCL rate control. The device model fails every transaction
+ * above a clock the test sets, and at a chosen rate on top, so the rate is
+ * stepped down, held at I2C_ASYNC_MIN_HZ, stepped up after error-free time,
+ * and a failing faster rate is retried after a doubling wait.
+ */
+#include "i2c_async.h"
+#include "esp_timer.h"
+#include "fake_i2c.h"
+#include "host_test.h"
+
+#define ADDR 0x42
+#define MAX_HZ 400000
+
+typedef struct {
+    uint32_t reliable_hz;   /**< transactions above this clock are NACKed */
+    uint32_t fail_every;    /**< also fail every n-th transaction, 0 for never */
+    uint32_t seen;
+    uint32_t failed;
+} model_t;
+
+static i2c_master_event_t model_fn(
+    void* ctx, uint32_t scl_hz, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len)
+{
+    model_t* m = ctx;
+    m->seen += 1;
+    for (size_t i = 0; i < rx_len; i++) {
+        rx[i] = (uint8_t)(tx[0] + i);
+    }
+    if (scl_hz > m->reliable_hz || (m->fail_every != 0 && m->seen % m->fail_every == 0)) {
+        m->failed += 1;
+        return I2C_EVENT_NACK;
+    }
+    return I2C_EVENT_DONE;
+}
+
+static model_t g_model;
+static i2c_async_dev_t g_dev;
+
+static esp_err_t transfer(void)
+{
+    uint8_t rx[2];
+    i2c_async_req_t req = { .tx = { 0x10 }, .tx_len = 1, .rx = rx, .rx_len = sizeof(rx) };
+    const esp_err_t rc = i2c_async_transfer(&g_dev, &req);
+    if (rc == ESP_OK) {
+        CHECK_EQ(rx[0], 0x10);
+        CHECK_EQ(rx[1], 0x11);
+    }
+    return rc;
+}
+
+static void wait_ms(uint32_t ms)
+{
+    fake_timer_advance_us((int64_t)ms * 1000);
+}
+
+static void test_inflight(void)
+{
+    QueueHandle_t done = xQueueCreate(I2C_ASYNC_DEV_DEPTH, sizeof(i2c_async_req_t*));
+    i2c_async_req_t reqs[I2C_ASYNC_DEV_DEPTH + 1];
+    uint8_t rx[I2C_ASYNC_DEV_DEPTH + 1];
+    for (uint32_t i = 0; i <= I2C_ASYNC_DEV_DEPTH; i++) {
+        reqs[i] = (i2c_async_req_t) { .tx = { (uint8_t)i }, .tx_len = 1, .rx = &rx[i], .rx_len = 1,
+            .done_queue = done };
+    }
+    for (uint32_t i = 0; i < I2C_ASYNC_DEV_DEPTH; i++) {
+        CHECK_EQ(i2c_async_submit(&g_dev, &reqs[i]), ESP_OK);
+    }
+    CHECK_EQ(i2c_async_submit(&g_dev, &reqs[I2C_ASYNC_DEV_DEPTH]), ESP_ERR_INVALID_STATE);
+    CHECK_EQ(g_dev.max_inflight, I2C_ASYNC_DEV_DEPTH);
+    CHECK_EQ(fake_i2c_run(), I2C_ASYNC_DEV_DEPTH);
+    for (uint32_t i = 0; i < I2C_ASYNC_DEV_DEPTH; i++) {
+        i2c_async_req_t* req = NULL;
+        CHECK(xQueueReceive(done, &req, 0) == pdPASS);
+        CHECK(req == &reqs[i]);
+        CHECK_EQ(req->result, ESP_OK);
+        CHECK_EQ(rx[i], i);
+    }
+    CHECK_EQ(g_dev.count, 0);
+    vQueueDelete(done);
+}
+
+static void test_step_down(void)
+{
+    /* every transaction fails above 100 kHz: 400 -> 200 -> 100 kHz, one step per failed transfer */
+    g_model.reliable_hz = 100000;
+    CHECK_EQ(transfer(), ESP_ERR_INVALID_RESPONSE);
+    CHECK_EQ(g_dev.scl_hz, 400000);
+    CHECK_EQ(transfer(), ESP_ERR_INVALID_RESPONSE);
+    CHECK_EQ(g_dev.scl_hz, 200000);
+    CHECK_EQ(transfer(), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, 100000);
+    CHECK_EQ(g_dev.step_downs, 2);
+
+    /* never below the minimum, however many errors */
+    g_model.reliable_hz = 50000;
+    for (uint32_t i = 0; i < 20; i++) {
+        CHECK_EQ(transfer(), ESP_ERR_INVALID_RESPONSE);
+    }
+    CHECK_EQ(g_dev.scl_hz, I2C_ASYNC_MIN_HZ);
+    CHECK_EQ(g_dev.step_downs, 2);
+}
+
+static void test_step_up(void)
+{
+    /* errors stop, the rate climbs back one step per error-free period */
+    g_model.reliable_hz = MAX_HZ;
+    CHECK_EQ(transfer(), ESP_OK);
+    wait_ms(I2C_ASYNC_STEP_UP_MS - 1);
+    CHECK_EQ(transfer(), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, 100000);
+    wait_ms(1);
+    CHECK_EQ(transfer(), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, 200000);
+    CHECK(g_dev.probing);
+    wait_ms(I2C_ASYNC_STEP_UP_MS);
+    CHECK_EQ(transfer(), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, 400000);
+    CHECK_EQ(g_dev.step_ups, 2);
+    /* the configured rate is the ceiling, and a rate that held resets the wait */
+    wait_ms(I2C_ASYNC_STEP_UP_MS);
+    CHECK_EQ(transfer(), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, MAX_HZ);
+    CHECK(!g_dev.probing);
+    CHECK_EQ(g_dev.step_up_wait_ms, I2C_ASYNC_STEP_UP_MS);
+    CHECK_EQ(g_dev.step_ups, 2);
+}
+
+static void test_backoff(void)
+{
+    /* 400 kHz fails for good: each failed probe doubles the wait, up to the maximum */
+    g_model.reliable_hz = 200000;
+    CHECK_EQ(transfer(), ESP_ERR_INVALID_RESPONSE);
+    CHECK_EQ(transfer(), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, 200000);
+
+    uint32_t wait = I2C_ASYNC_STEP_UP_MS;
+    for (uint32_t round = 0; round < 8; round++) {
+        wait_ms(wait - 1);
+        CHECK_EQ(transfer(), ESP_OK);
+        CHECK_EQ(g_dev.scl_hz, 200000);
+        wait_ms(1);
+        CHECK_EQ(transfer(), ESP_ERR_INVALID_RESPONSE); /* the probe at 400 kHz */
+        CHECK_EQ(transfer(), ESP_OK);
+        CHECK_EQ(g_dev.scl_hz, 200000);
+        wait = (wait * 2 > I2C_ASYNC_STEP_UP_MAX_MS) ? I2C_ASYNC_STEP_UP_MAX_MS : wait * 2;
+        CHECK_EQ(g_dev.step_up_wait_ms, wait);
+    }
+    CHECK_EQ(g_dev.step_up_wait_ms, I2C_ASYNC_STEP_UP_MAX_MS);
+}
+
+static void test_error_storm(void)
+{
+    /* many transfers, every 3rd fails at any clock: the rate sits at the minimum, the counters add up */
+    g_model.reliable_hz = MAX_HZ;
+    g_model.fail_every = 3;
+    const uint32_t failed_before = g_dev.failed;
+    const uint32_t submitted_before = g_dev.submitted;
+    const uint32_t model_failed_before = g_model.failed;
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < 3000; i++) {
+        errors += transfer() != ESP_OK;
+        wait_ms(50);
+        CHECK(g_dev.scl_hz >= I2C_ASYNC_MIN_HZ && g_dev.scl_hz <= MAX_HZ);
+    }
+    CHECK_EQ(g_dev.submitted - submitted_before, 3000);
+    CHECK_EQ(g_dev.failed - failed_before, errors);
+    CHECK_EQ(g_model.failed - model_failed_before, errors);
+    CHECK_EQ(g_dev.scl_hz, I2C_ASYNC_MIN_HZ);
+    /* each clock change adds the device again, never with a transaction queued (checked by the fake) */
+    const fake_i2c_stats_t* stats = fake_i2c_stats();
+    CHECK_EQ(stats->devices_added - stats->devices_removed, 1);
+    CHECK_EQ(stats->devices_added, 1 + g_dev.step_downs + g_dev.step_ups);
+    printf("error storm: %u of 3000 failed, step downs=%u ups=%u, scl=%u Hz\n", errors, g_dev.step_downs,
+        g_dev.step_ups, g_dev.scl_hz);
+}
+
+int main(void)
+{
+    g_model.reliable_hz = MAX_HZ;
+    fake_i2c_add_model(ADDR, model_fn, &g_model);
+    CHECK_EQ(i2c_async_dev_init(&g_dev, fake_i2c_bus(), ADDR, MAX_HZ, 100), ESP_OK);
+    CHECK_EQ(g_dev.scl_hz, MAX_HZ);
+
+    test_inflight();
+    test_step_down();
+    test_step_up();
+    test_backoff();
+    test_error_storm();
+
+    i2c_async_dev_deinit(&g_dev);
+    printf("i2c_async: ok\n");
+    return 0;
+}
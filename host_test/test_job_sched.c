@@ -0,0 +1,386 @@
+/*
+ * job_sched: release jitter of the control jobs with and without a receive
+ * flood, on Linux threads instead of the board. There is no W5500 and no
+ * second core here: the numbers are what this host gives, not the target.
+ *
+ * job_sched.c runs unchanged in a "ctrl" thread. The FreeRTOS and esp_timer
+ * calls it makes are served below: a timer thread stands in for the
+ * esp_timer task and wakes the ctrl thread through a task notification
+ * (mutex and condition variable). The jobs of main.c run at a hundredth of
+ * their period and phase (10 ms instead of 1 s, stats at 7 ms instead of
+ * 7.5) and busy-wait for their run time. Each job measures its start delay
+ * after the release.
+ *
+ * The flood is UDP on loopback: one thread sends 1472 byte datagrams as fast
+ * as it can, another receives and copies them, like the driver task and
+ * lwIP under a broadcast storm. Everything shares the sandbox's CPUs, so the
+ * flood competes with the control jobs, on the board it has a core to itself.
+ *
+ * Three runs:
+ * - idle: ctrl at SCHED_FIFO 20 and the timer thread at 22, the priorities
+ *   of the ctrl and esp_timer tasks
+ * - flood: the same priorities under the flood
+ * - flood, ctrl at SCHED_OTHER: the control jobs at the priority of the
+ *   other threads, as when they ran in app_main
+ *
+ * The max also holds the stalls of the virtual machine the tests run in,
+ * which no priority helps against: the 99th percentile is the number to
+ * compare.
+ *
+ * Without permission for SCHED_FIFO every thread stays at SCHED_OTHER and
+ * the test says so. Prints runs, jitter (mean, 99th percentile, max) and
+ * overruns per run.
+ */
+#include "job_sched.h"
+#include "host_test.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define RUN_MS 2000
+#define CTRL_PRIO 20
+#define TIMER_PRIO 22
+#define HIST_BUCKET_US 10
+#define HIST_BUCKETS 5000 /* up to 50 ms */
+#define DATAGRAM 1472
+
+/* ---- FreeRTOS and esp_timer on threads, for job_sched.c ---- */
+
+struct fake_task_s {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notified;
+};
+
+struct fake_timer_s {
+    esp_timer_create_args_t args;
+    int64_t due_us; /* 0 when not armed */
+};
+
+static __thread TaskHandle_t g_self;
+static struct fake_timer_s g_timer;
+static pthread_mutex_t g_timer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_timer_cond;
+
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* one timer, the one of job_sched */
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* handle)
+{
+    g_timer.args = *args;
+    g_timer.due_us = 0;
+    *handle = &g_timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    esp_err_t rc = ESP_OK;
+    pthread_mutex_lock(&g_timer_lock);
+    if (timer->due_us != 0) {
+        rc = ESP_ERR_INVALID_STATE;
+    } else {
+        timer->due_us = esp_timer_get_time() + (int64_t)timeout_us;
+        pthread_cond_signal(&g_timer_cond);
+    }
+    pthread_mutex_unlock(&g_timer_lock);
+    return rc;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    pthread_mutex_lock(&g_timer_lock);
+    timer->due_us = 0;
+    pthread_mutex_unlock(&g_timer_lock);
+    return ESP_OK;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return g_self;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notified++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t wait)
+{
+    TaskHandle_t task = g_self;
+    pthread_mutex_lock(&task->lock);
+    while (task->notified == 0) {
+        pthread_cond_wait(&task->cond, &task->lock);
+    }
+    const uint32_t count = task->notified;
+    task->notified = clear ? 0 : count - 1;
+    pthread_mutex_unlock(&task->lock);
+    return count;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    const struct timespec ts = { .tv_sec = ticks / 1000, .tv_nsec = (long)(ticks % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+}
+
+void vTaskSuspend(TaskHandle_t task)
+{
+    while (true) {
+        pause();
+    }
+}
+
+/* the esp_timer task: runs the callback when the armed time has come */
+static void* timer_thread(void* arg)
+{
+    pthread_mutex_lock(&g_timer_lock);
+    while (true) {
+        if (g_timer.due_us == 0) {
+            pthread_cond_wait(&g_timer_cond, &g_timer_lock);
+            continue;
+        }
+        const int64_t due_us = g_timer.due_us;
+        if (esp_timer_get_time() < due_us) {
+            const struct timespec ts = { .tv_sec = due_us / 1000000, .tv_nsec = (long)(due_us % 1000000) * 1000 };
+            pthread_cond_timedwait(&g_timer_cond, &g_timer_lock, &ts);
+            continue;
+        }
+        g_timer.due_us = 0;
+        pthread_mutex_unlock(&g_timer_lock);
+        g_timer.args.callback(g_timer.args.arg);
+        pthread_mutex_lock(&g_timer_lock);
+    }
+    return NULL;
+}
+
+/* ---- the control jobs ---- */
+
+typedef struct {
+    uint32_t runs;
+    int64_t jitter_sum_us;
+    int64_t jitter_max_us;
+    uint32_t hist[HIST_BUCKETS + 1];
+} run_stats_t;
+
+typedef struct {
+    const char* name;
+    uint32_t period_ms;
+    uint32_t phase_ms;
+    uint32_t work_us;
+} job_def_t;
+
+/* the jobs of main.c at a hundredth of their period */
+static const job_def_t g_job_defs[] = {
+    { "sample", 10, 0, 300 },
+    { "ssr", 10, 5, 100 },
+    { "stats", 300, 7, 50 },
+};
+#define JOBS (sizeof(g_job_defs) / sizeof(g_job_defs[0]))
+
+static job_sched_t g_sched;
+static run_stats_t g_stats[3];
+static _Atomic int g_run = -1;          /* run the jobs count for, -1 while switching */
+static _Atomic uint32_t g_jobs_done;    /* publishes g_stats to the main thread */
+
+static void job(void* arg)
+{
+    const job_def_t* def = arg;
+    const int64_t start_us = esp_timer_get_time();
+    const int64_t jitter_us = start_us - g_sched.release_us;
+    const int run = atomic_load_explicit(&g_run, memory_order_acquire);
+    if (run >= 0) {
+        run_stats_t* stats = &g_stats[run];
+        stats->runs++;
+        stats->jitter_sum_us += jitter_us;
+        if (jitter_us > stats->jitter_max_us) {
+            stats->jitter_max_us = jitter_us;
+        }
+        const int64_t bucket = jitter_us / HIST_BUCKET_US;
+        stats->hist[(bucket < HIST_BUCKETS) ? bucket : HIST_BUCKETS]++;
+    }
+    while (esp_timer_get_time() - start_us < def->work_us) {
+    }
+    atomic_fetch_add_explicit(&g_jobs_done, 1, memory_order_release);
+}
+
+static void* ctrl_thread(void* arg)
+{
+    static struct fake_task_s task = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0 };
+    g_self = &task;
+    job_sched_run(&g_sched);
+    return NULL;
+}
+
+/* ---- the flood ---- */
+
+static _Atomic bool g_flood;
+static _Atomic uint32_t g_flood_received;
+static int g_flood_rx_sock = -1;
+static struct sockaddr_in g_flood_addr;
+
+static void* flood_send_thread(void* arg)
+{
+    static uint8_t datagram[DATAGRAM];
+    const int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CHECK(sock >= 0);
+    while (true) {
+        if (!atomic_load_explicit(&g_flood, memory_order_relaxed)) {
+            vTaskDelay(1);
+            continue;
+        }
+        sendto(sock, datagram, sizeof(datagram), 0, (const struct sockaddr*)&g_flood_addr, sizeof(g_flood_addr));
+    }
+    return NULL;
+}
+
+static void* flood_recv_thread(void* arg)
+{
+    static uint8_t datagram[DATAGRAM];
+    static uint8_t copy[DATAGRAM];
+    while (true) {
+        const ssize_t len = recv(g_flood_rx_sock, datagram, sizeof(datagram), 0);
+        if (len > 0) {
+            memcpy(copy, datagram, (size_t)len);
+            atomic_fetch_add_explicit(&g_flood_received, 1, memory_order_relaxed);
+        }
+    }
+    return NULL;
+}
+
+static void flood_open(void)
+{
+    g_flood_rx_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CHECK(g_flood_rx_sock >= 0);
+    g_flood_addr.sin_family = AF_INET;
+    g_flood_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(g_flood_rx_sock, (const struct sockaddr*)&g_flood_addr, sizeof(g_flood_addr)) == 0);
+    socklen_t addr_len = sizeof(g_flood_addr);
+    CHECK(getsockname(g_flood_rx_sock, (struct sockaddr*)&g_flood_addr, &addr_len) == 0);
+}
+
+/* ---- runs ---- */
+
+static bool set_policy(pthread_t thread, int policy, int prio)
+{
+    const struct sched_param param = { .sched_priority = prio };
+    return pthread_setschedparam(thread, policy, &param) == 0;
+}
+
+static void start_thread(pthread_t* thread, void* (*fn)(void*))
+{
+    CHECK(pthread_create(thread, NULL, fn, NULL) == 0);
+}
+
+static uint32_t percentile_us(const run_stats_t* stats, uint32_t per_mille)
+{
+    const uint64_t limit = ((uint64_t)stats->runs * per_mille + 999) / 1000;
+    uint64_t seen = 0;
+    uint32_t i = 0;
+    for (i = 0; i <= HIST_BUCKETS; ++i) {
+        seen += stats->hist[i];
+        if (seen >= limit) {
+            return (i + 1) * HIST_BUCKET_US;
+        }
+    }
+    return (HIST_BUCKETS + 1) * HIST_BUCKET_US;
+}
+
+static uint32_t overruns(void)
+{
+    uint32_t sum = 0;
+    uint32_t i = 0;
+    for (i = 0; i < g_sched.count; ++i) {
+        sum += g_sched.jobs[i].overruns;
+    }
+    return sum;
+}
+
+/* count the jobs for RUN_MS with or without the flood, prints one line */
+static const run_stats_t* run(int index, const char* name, bool flood)
+{
+    atomic_store(&g_flood, flood);
+    atomic_store(&g_flood_received, 0);
+    vTaskDelay(100); /* the flood gets going, a job in progress ends */
+    const uint32_t overruns_before = overruns();
+    atomic_store_explicit(&g_run, index, memory_order_release);
+    vTaskDelay(RUN_MS);
+    atomic_store_explicit(&g_run, -1, memory_order_release);
+    const uint32_t received = atomic_load(&g_flood_received);
+    atomic_store(&g_flood, false);
+    vTaskDelay(50);
+    atomic_load_explicit(&g_jobs_done, memory_order_acquire);
+
+    const run_stats_t* stats = &g_stats[index];
+    CHECK(stats->runs > 0);
+    printf("%-26s %9u %6u %8.1f %7u %8lld %9u\n", name, (unsigned)((uint64_t)received * 1000 / RUN_MS), stats->runs,
+        (double)stats->jitter_sum_us / stats->runs, percentile_us(stats, 990), (long long)stats->jitter_max_us,
+        overruns() - overruns_before);
+    return stats;
+}
+
+int main(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_timer_cond, &attr);
+
+    CHECK_EQ(job_sched_init(&g_sched), ESP_OK);
+    uint32_t i = 0;
+    for (i = 0; i < JOBS; ++i) {
+        const job_def_t* def = &g_job_defs[i];
+        CHECK_EQ(job_sched_add(&g_sched, def->name, def->period_ms, def->phase_ms, job, (void*)def), ESP_OK);
+    }
+    flood_open();
+
+    pthread_t timer;
+    pthread_t ctrl;
+    pthread_t flood_send;
+    pthread_t flood_recv;
+    start_thread(&timer, timer_thread);
+    start_thread(&flood_recv, flood_recv_thread);
+    start_thread(&flood_send, flood_send_thread);
+    start_thread(&ctrl, ctrl_thread);
+    const bool rt = set_policy(timer, SCHED_FIFO, TIMER_PRIO) && set_policy(ctrl, SCHED_FIFO, CTRL_PRIO);
+    if (!rt) {
+        printf("no SCHED_FIFO here, all threads at SCHED_OTHER\n");
+    }
+
+    /* the releases a run should have: RUN_MS of every job */
+    uint32_t releases = 0;
+    for (i = 0; i < JOBS; ++i) {
+        releases += RUN_MS / g_job_defs[i].period_ms;
+    }
+    printf("%-26s %9s %6s %8s %7s %8s %9s\n", "run (host, not the board)", "flood/s", "runs", "avg us", "p99 us",
+        "max us", "overruns");
+    const run_stats_t* idle = run(0, rt ? "idle, ctrl fifo 20" : "idle", false);
+    const run_stats_t* flood = run(1, rt ? "flood, ctrl fifo 20" : "flood", true);
+    set_policy(ctrl, SCHED_OTHER, 0);
+    run(2, "flood, ctrl other", true);
+
+    /* every release ran, give or take the ones at the edges of a run */
+    CHECK(idle->runs + JOBS * 2 >= releases);
+    if (rt) {
+        /* above the flood the jobs keep their deadlines */
+        CHECK(flood->runs + JOBS * 2 >= releases);
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+ * log_stream: the lines as a collector gets them, over real UDP on localhost.
+ * A listener socket on 127.0.0.1 takes the place of the collector. Lines of
+ * 20 to 255 bytes, and a few too long ones that get cut, go through the ring
+ * many times over. Every datagram must be at most LOG_STREAM_DATAGRAM bytes
+ * and hold whole lines only, and every line must arrive once and in order.
+ * Then the ring overflows without a flush: the refused lines are counted as
+ * dropped and the ones it took still arrive. A send that fails is counted as
+ * a send error, not as a datagram.
+ */
+#include "log_stream.h"
+#include "host_test.h"
+#include <stdarg.h>
+#include <string.h>
+#include <sys/time.h>
+#include "lwip/sockets.h"
+
+#define LINES 3000u
+
+static struct {
+    int sock;
+    uint32_t next;        // number of the next line expected
+    uint32_t datagrams;
+    uint32_t bytes;
+    uint32_t max_len;
+} g_collector;
+
+static int collector_open(uint16_t* port)
+{
+    const int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    CHECK(sock >= 0);
+    struct sockaddr_in addr = { 0 };
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(sock, (const struct sockaddr*)&addr, sizeof(addr)) == 0);
+    socklen_t addr_len = sizeof(addr);
+    CHECK(getsockname(sock, (struct sockaddr*)&addr, &addr_len) == 0);
+    const struct timeval timeout = { .tv_sec = 0, .tv_usec = 200 * 1000 };
+    CHECK(setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == 0);
+    *port = ntohs(addr.sin_port);
+    return sock;
+}
+
+/* line i as written: its number, then filler up to a length of 20 to 255 bytes with the '\n', every 97th too long */
+static uint32_t make_line(uint32_t i, char* line, size_t size)
+{
+    const uint32_t len = (i % 97 == 0) ? 400 : 20 + (i * 37) % 236;
+    const int head = snprintf(line, size, "line %06u ", i);
+    uint32_t j = 0;
+    for (j = (uint32_t)head; j < len - 1; ++j) {
+        line[j] = (char)('a' + (i + j) % 26);
+    }
+    line[len - 1] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+static int stream_printf(log_stream_t* stream, const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const int len = log_stream_vprintf(stream, fmt, args);
+    va_end(args);
+    return len;
+}
+
+/* one line of a datagram, the same as written, cut to LOG_STREAM_LINE_MAX - 1 bytes */
+static void check_line(const char* got, size_t len)
+{
+    static char expected[512];
+    uint32_t expected_len = make_line(g_collector.next, expected, sizeof(expected));
+    if (expected_len > LOG_STREAM_LINE_MAX - 1) {
+        expected_len = LOG_STREAM_LINE_MAX - 1;
+        expected[expected_len - 1] = '\n';
+    }
+    CHECK_EQ(len, expected_len);
+    CHECK(memcmp(got, expected, len) == 0);
+    g_collector.next++;
+}
+
+/* reads what has arrived, datagram by datagram, until nothing comes for a while */
+static void collector_drain(void)
+{
+    static char datagram[65536];
+    while (true) {
+        const ssize_t len = recv(g_collector.sock, datagram, sizeof(datagram), 0);
+        if (len < 0) {
+            return;
+        }
+        CHECK(len > 0 && len <= LOG_STREAM_DATAGRAM);
+        CHECK(datagram[len - 1] == '\n');
+        size_t at = 0;
+        while (at < (size_t)len) {
+            const char* end = memchr(&datagram[at], '\n', (size_t)len - at);
+            check_line(&datagram[at], (size_t)(end - &datagram[at]) + 1);
+            at = (size_t)(end - datagram) + 1;
+        }
+        g_collector.datagrams++;
+        g_collector.bytes += (uint32_t)len;
+        if ((uint32_t)len > g_collector.max_len) {
+            g_collector.max_len = (uint32_t)len;
+        }
+    }
+}
+
+static void test_lines(log_stream_t* stream)
+{
+    static char line[512];
+    uint32_t sent = 0;
+    uint32_t i = 0;
+    for (i = 0; i < LINES; ++i) {
+        const uint32_t len = make_line(i, line, sizeof(line));
+        if (i % 2 == 0) {
+            CHECK(log_stream_write(stream, line, len));
+        } else {
+            CHECK_EQ(stream_printf(stream, "%s", line), len);
+        }
+        /* full datagrams while the ring fills, as the log task does */
+        if (stream->head - stream->tail > LOG_STREAM_BUF_SIZE - LOG_STREAM_LINE_MAX) {
+            sent += log_stream_flush(stream, false);
+            collector_drain();
+        }
+    }
+    sent += log_stream_flush(stream, true);
+    collector_drain();
+    CHECK_EQ(g_collector.next, LINES);
+    CHECK_EQ(stream->lines, LINES);
+    CHECK_EQ(stream->dropped, 0);
+    CHECK_EQ(stream->send_errors, 0);
+    CHECK_EQ(sent, g_collector.datagrams);
+    CHECK_EQ(stream->datagrams, g_collector.datagrams);
+    CHECK_EQ(stream->bytes_sent, g_collector.bytes);
+    CHECK(g_collector.max_len <= LOG_STREAM_DATAGRAM);
+    printf("%u lines in %u datagrams, %.0f bytes per datagram, largest %u\n", LINES, g_collector.datagrams,
+        (double)g_collector.bytes / g_collector.datagrams, g_collector.max_len);
+}
+
+static void test_overflow(log_stream_t* stream)
+{
+    static char line[512];
+    const uint32_t lines_before = stream->lines;
+    uint32_t accepted = 0;
+    uint32_t refused = 0;
+    uint32_t i = 0;
+    for (i = 0; i < 100; ++i) {
+        /* refused lines keep their number, the collector expects only the accepted ones */
+        const uint32_t len = make_line(g_collector.next + accepted, line, sizeof(line));
+        if (log_stream_write(stream, line, len)) {
+            accepted++;
+        } else {
+            refused++;
+        }
+    }
+    CHECK(refused > 0);
+    CHECK_EQ(stream->dropped, refused);
+    CHECK_EQ(stream->lines - lines_before, accepted);
+    CHECK(stream->head - stream->tail <= LOG_STREAM_BUF_SIZE);
+
+    const uint32_t expected = g_collector.next + accepted;
+    log_stream_flush(stream, true);
+    collector_drain();
+    CHECK_EQ(g_collector.next, expected);
+    printf("overflow: %u of 100 lines taken, %u dropped\n", accepted, refused);
+}
+
+static void test_send_error(log_stream_t* stream)
+{
+    static char line[512];
+    const uint32_t datagrams = stream->datagrams;
+    const uint32_t len = make_line(g_collector.next, line, sizeof(line));
+    CHECK(log_stream_write(stream, line, len));
+    /* a socket that is gone: sendto() fails */
+    const int sock = stream->sock;
+    stream->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    close(stream->sock);
+    CHECK_EQ(log_stream_flush(stream, true), 0);
+    CHECK_EQ(stream->send_errors, 1);
+    CHECK_EQ(stream->datagrams, datagrams);
+    CHECK_EQ(stream->head, stream->tail);
+    stream->sock = sock;
+}
+
+int main(void)
+{
+    static log_stream_t stream;
+    uint16_t port = 0;
+    g_collector.sock = collector_open(&port);
+    CHECK_EQ(log_stream_init(&stream, "localhost", port), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(log_stream_init(&stream, "127.0.0.1", port), ESP_OK);
+
+    test_lines(&stream);
+    test_overflow(&stream);
+    test_send_error(&stream);
+    close(stream.sock);
+    close(g_collector.sock);
+    printf("ok\n");
+    return 0;
+}
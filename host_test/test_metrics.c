@@ -0,0 +1,140 @@
+/*
+ * metrics: a scrape renders into the caller's chunk buffer without touching
+ * the heap. malloc, calloc and realloc are wrapped by the linker
+ * (--wrap) and counted while metrics_render() and metrics_finish() run.
+ */
+#include "metrics.h"
+#include "host_test.h"
+#include <string.h>
+
+static uint32_t g_allocs;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size)
+{
+    g_allocs += 1;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size)
+{
+    g_allocs += 1;
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size)
+{
+    g_allocs += 1;
+    return __real_realloc(ptr, size);
+}
+
+typedef struct {
+    char text[16384];
+    size_t len;
+    uint32_t chunks;
+    uint32_t fail_at;       /**< chunk number that fails, 0 for none */
+    bool chunk_cut;         /**< a chunk did not end with a complete line */
+} sink_t;
+
+static esp_err_t sink_fn(void* ctx, const char* data, size_t len)
+{
+    sink_t* sink = ctx;
+    sink->chunks += 1;
+    if (sink->fail_at == sink->chunks) {
+        return ESP_FAIL;
+    }
+    CHECK(sink->len + len <= sizeof(sink->text));
+    memcpy(&sink->text[sink->len], data, len);
+    sink->len += len;
+    if (len == 0 || data[len - 1] != '\n') {
+        sink->chunk_cut = true;
+    }
+    return ESP_OK;
+}
+
+static metrics_values_t sample_values(void)
+{
+    metrics_values_t v = {
+        .uptime_us = 123456789,
+        .th_valid = true,
+        .temp_centi = -1825,
+        .internal_temp_centi = 2101,
+        .ssr_valid = true,
+        .ssr_active = true,
+        .i2c = {
+            { .name = "ssr", .addr = 0x20, .scl_hz = 400000, .transfers = 10, .failed = 1, .step_downs = 2, .step_ups = 3 },
+            { .name = "th", .addr = 0x66, .scl_hz = 100000, .transfers = 20 },
+        },
+        .i2c_count = 2,
+        .eth_valid = true,
+        .eth_rx_bytes = 5000000000ULL,
+        .heap_free = 200000,
+    };
+    return v;
+}
+
+static esp_err_t render(sink_t* sink, char* buf, size_t size, const metrics_values_t* values)
+{
+    metrics_buf_t b;
+    metrics_buf_init(&b, buf, size, sink_fn, sink);
+    metrics_render(&b, values);
+    const esp_err_t err = metrics_finish(&b);
+    CHECK_EQ(b.chunks, sink->chunks);
+    return err;
+}
+
+static void test_no_allocation(void)
+{
+    static char buf[1024];  /* the chunk size of the /metrics handler */
+    static sink_t sink;
+    const metrics_values_t v = sample_values();
+
+    g_allocs = 0;
+    const esp_err_t err = render(&sink, buf, sizeof(buf), &v);
+    const uint32_t allocs = g_allocs;
+    CHECK_EQ(err, ESP_OK);
+    CHECK_EQ(allocs, 0);
+    CHECK(!sink.chunk_cut);
+    CHECK(sink.chunks > 1);
+    sink.text[sink.len] = '\0';
+    CHECK(strstr(sink.text, "freezer_temperature_celsius{probe=\"thermocouple\"} -18.25\n") != NULL);
+    CHECK(strstr(sink.text, "freezer_eth_bytes_total{direction=\"rx\"} 5000000000\n") != NULL);
+    CHECK(strstr(sink.text, "freezer_uptime_seconds 123\n") != NULL);
+    printf("render: %zu bytes in %u chunks, %u allocations\n", sink.len, sink.chunks, allocs);
+}
+
+static void test_small_buffer(void)
+{
+    /* every line still goes out whole, the text is the same as with a large buffer */
+    static char large[8192], small[256];  /* small holds the longest HELP/TYPE pair */
+    static sink_t a, b;
+    const metrics_values_t v = sample_values();
+    CHECK_EQ(render(&a, large, sizeof(large), &v), ESP_OK);
+    CHECK_EQ(render(&b, small, sizeof(small), &v), ESP_OK);
+    CHECK_EQ(a.chunks, 1);
+    CHECK(!b.chunk_cut);
+    CHECK_EQ(a.len, b.len);
+    CHECK(memcmp(a.text, b.text, a.len) == 0);
+}
+
+static void test_sink_error(void)
+{
+    /* the first sink error ends the page, nothing is handed over after it */
+    static char buf[256];
+    static sink_t sink = { .fail_at = 2 };
+    const metrics_values_t v = sample_values();
+    CHECK_EQ(render(&sink, buf, sizeof(buf), &v), ESP_FAIL);
+    CHECK_EQ(sink.chunks, 2);
+}
+
+int main(void)
+{
+    test_no_allocation();
+    test_small_buffer();
+    test_sink_error();
+    printf("metrics: ok\n");
+    return 0;
+}
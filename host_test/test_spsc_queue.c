@@ -0,0 +1,190 @@
+/*
+ * spsc_queue: single-thread behaviour, then one producer and one consumer
+ * thread moving sequence-numbered items, which must all arrive exactly once
+ * and in order. Prints the throughput of the threaded run.
+ */
+#include "spsc_queue.h"
+#include "host_test.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct {
+    uint32_t seq;
+    uint32_t check;         /**< derived from seq, catches a torn copy */
+    uint8_t pad[24];
+} item_t;
+
+#define THREAD_ITEMS 2000000u
+#define THREAD_CAPACITY 64
+
+static item_t make_item(uint32_t seq)
+{
+    item_t item = { .seq = seq, .check = seq * 2654435761u };
+    memset(item.pad, (int)(seq & 0xFF), sizeof(item.pad));
+    return item;
+}
+
+static void check_item(const item_t* item, uint32_t seq)
+{
+    CHECK_EQ(item->seq, seq);
+    CHECK_EQ(item->check, seq * 2654435761u);
+    for (size_t i = 0; i < sizeof(item->pad); i++) {
+        CHECK_EQ(item->pad[i], seq & 0xFF);
+    }
+}
+
+static void test_init(void)
+{
+    spsc_queue_t q;
+    static item_t storage[8];
+    CHECK_EQ(spsc_queue_init(&q, storage, sizeof(item_t), 6), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(spsc_queue_init(&q, storage, sizeof(item_t), 0), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(spsc_queue_init(&q, storage, 0, 8), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(spsc_queue_init(&q, NULL, sizeof(item_t), 8), ESP_ERR_INVALID_ARG);
+    CHECK_EQ(spsc_queue_init(&q, storage, sizeof(item_t), 8), ESP_OK);
+    CHECK_EQ(spsc_queue_count(&q), 0);
+}
+
+static void test_single_thread(void)
+{
+    spsc_queue_t q;
+    static item_t storage[8];
+    CHECK_EQ(spsc_queue_init(&q, storage, sizeof(item_t), 8), ESP_OK);
+
+    item_t item;
+    CHECK(!spsc_queue_pop(&q, &item));
+
+    /* fill, overflow, drain: the refused pushes are counted and lose nothing queued */
+    for (uint32_t i = 0; i < 8; i++) {
+        item = make_item(i);
+        CHECK(spsc_queue_push(&q, &item));
+    }
+    CHECK_EQ(spsc_queue_count(&q), 8);
+    item = make_item(99);
+    CHECK(!spsc_queue_push(&q, &item));
+    CHECK(!spsc_queue_push(&q, &item));
+    CHECK_EQ(q.dropped, 2);
+    for (uint32_t i = 0; i < 8; i++) {
+        CHECK(spsc_queue_pop(&q, &item));
+        check_item(&item, i);
+    }
+    CHECK(!spsc_queue_pop(&q, &item));
+
+    /* interleaved, so the indexes wrap around the storage many times */
+    uint32_t pushed = 100, popped = 100;
+    for (uint32_t round = 0; round < 1000; round++) {
+        for (uint32_t n = 0; n < round % 8 + 1; n++) {
+            item = make_item(pushed);
+            CHECK(spsc_queue_push(&q, &item));
+            pushed += 1;
+        }
+        CHECK_EQ(spsc_queue_count(&q), pushed - popped);
+        while (spsc_queue_pop(&q, &item)) {
+            check_item(&item, popped);
+            popped += 1;
+        }
+        CHECK_EQ(popped, pushed);
+    }
+    CHECK_EQ(q.dropped, 2);
+}
+
+static void test_index_wrap(void)
+{
+    /* head and tail are free-running counters, they must survive the 32-bit overflow */
+    spsc_queue_t q;
+    static item_t storage[4];
+    CHECK_EQ(spsc_queue_init(&q, storage, sizeof(item_t), 4), ESP_OK);
+    const uint32_t start = UINT32_MAX - 5;
+    atomic_store(&q.head, start);
+    atomic_store(&q.tail, start);
+    q.tail_seen = start;
+    q.head_seen = start;
+
+    item_t item;
+    for (uint32_t i = 0; i < 4; i++) {
+        item = make_item(i);
+        CHECK(spsc_queue_push(&q, &item));
+    }
+    CHECK(!spsc_queue_push(&q, &item));
+    for (uint32_t i = 0; i < 4; i++) {
+        CHECK(spsc_queue_pop(&q, &item));
+        check_item(&item, i);
+        item = make_item(i + 4);
+        CHECK(spsc_queue_push(&q, &item));
+    }
+    CHECK_EQ(spsc_queue_count(&q), 4);
+    for (uint32_t i = 4; i < 8; i++) {
+        CHECK(spsc_queue_pop(&q, &item));
+        check_item(&item, i);
+    }
+    CHECK_EQ(spsc_queue_count(&q), 0);
+}
+
+static spsc_queue_t g_queue;
+static item_t g_storage[THREAD_CAPACITY];
+static uint64_t g_full_retries;
+
+static void* producer(void* arg)
+{
+    uint64_t retries = 0;
+    for (uint32_t i = 0; i < THREAD_ITEMS; i++) {
+        const item_t item = make_item(i);
+        while (!spsc_queue_push(&g_queue, &item)) {
+            retries += 1;
+            sched_yield();  /* lets the consumer run on a host with a single CPU */
+        }
+    }
+    g_full_retries = retries;
+    return NULL;
+}
+
+static void* consumer(void* arg)
+{
+    item_t item;
+    for (uint32_t i = 0; i < THREAD_ITEMS; i++) {
+        while (!spsc_queue_pop(&g_queue, &item)) {
+            sched_yield();
+        }
+        check_item(&item, i);
+    }
+    return NULL;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void test_threads(void)
+{
+    CHECK_EQ(spsc_queue_init(&g_queue, g_storage, sizeof(item_t), THREAD_CAPACITY), ESP_OK);
+
+    pthread_t prod, cons;
+    const double start = now_s();
+    CHECK_EQ(pthread_create(&cons, NULL, consumer, NULL), 0);
+    CHECK_EQ(pthread_create(&prod, NULL, producer, NULL), 0);
+    CHECK_EQ(pthread_join(prod, NULL), 0);
+    CHECK_EQ(pthread_join(cons, NULL), 0);
+    const double elapsed = now_s() - start;
+
+    CHECK_EQ(spsc_queue_count(&g_queue), 0);
+    /* the producer retried instead of dropping, every refused push is still counted */
+    CHECK_EQ(g_queue.dropped, (uint32_t)g_full_retries);
+    printf("threads: %u items of %zu bytes in %.3f s, %.1f M items/s, %" PRIu64 " pushes to a full queue\n",
+           THREAD_ITEMS, sizeof(item_t), elapsed, THREAD_ITEMS / elapsed / 1e6, g_full_retries);
+}
+
+int main(void)
+{
+    test_init();
+    test_single_thread();
+    test_index_wrap();
+    test_threads();
+    printf("spsc_queue: ok\n");
+    return 0;
+}
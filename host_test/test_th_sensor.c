@@ -0,0 +1,116 @@
+/*
+ * th_sensor: a snapshot against a fake KMeter is three write-read
+ * transactions of one register byte each, queued back to back, and the
+ * caller gets one completion for them. A NACK on any of them fails the
+ * snapshot and leaves nothing behind for the next one.
+ */
+#include "th_sensor.h"
+#include "fake_i2c.h"
+#include "host_test.h"
+#include <string.h>
+
+typedef struct {
+    uint8_t regs[256];
+    int nack_reg;           /**< register whose read is NACKed, -1 for none */
+    uint32_t reads[256];    /**< transactions per register */
+    uint32_t bytes;         /**< bytes read in total */
+} kmeter_t;
+
+static i2c_master_event_t kmeter_fn(
+    void* ctx, uint32_t scl_hz, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len)
+{
+    kmeter_t* k = ctx;
+    CHECK_EQ(tx_len, 1);
+    k->reads[tx[0]] += 1;
+    if (tx[0] == k->nack_reg) {
+        return I2C_EVENT_NACK;
+    }
+    CHECK(tx[0] + rx_len <= sizeof(k->regs));
+    memcpy(rx, &k->regs[tx[0]], rx_len);
+    k->bytes += (uint32_t)rx_len;
+    return I2C_EVENT_DONE;
+}
+
+static kmeter_t g_kmeter = { .nack_reg = -1 };
+static th_t g_th;
+
+static void set_reg32(uint8_t reg, int32_t value)
+{
+    memcpy(&g_kmeter.regs[reg], &value, sizeof(value));
+}
+
+static void test_snapshot(void)
+{
+    set_reg32(KMETER_TEMP_VAL_REG, -1825);
+    set_reg32(KMETER_INTERNAL_TEMP_VAL_REG, 2101);
+    g_kmeter.regs[KMETER_KMETER_ERROR_STATUS_REG] = 0;
+
+    const uint32_t before = fake_i2c_stats()->transactions;
+    const th_result_t r = th_read_snapshot(&g_th);
+    CHECK_EQ(r.tag, TH_STATUS_OK);
+    CHECK(r.value.snapshot.temp_c == -18.25f);
+    CHECK(r.value.snapshot.internal_temp_c == 21.01f);
+    CHECK_EQ(r.value.snapshot.error_status, 0);
+
+    /* three transactions on the bus, one per field, 9 bytes read, all queued before the first completed */
+    CHECK_EQ(fake_i2c_stats()->transactions - before, TH_SNAPSHOT_READS);
+    CHECK_EQ(g_th.transactions, TH_SNAPSHOT_READS);
+    CHECK_EQ(g_kmeter.reads[KMETER_TEMP_VAL_REG], 1);
+    CHECK_EQ(g_kmeter.reads[KMETER_INTERNAL_TEMP_VAL_REG], 1);
+    CHECK_EQ(g_kmeter.reads[KMETER_KMETER_ERROR_STATUS_REG], 1);
+    CHECK_EQ(g_kmeter.bytes, 9);
+    CHECK_EQ(fake_i2c_stats()->max_queued, TH_SNAPSHOT_READS);
+}
+
+static void test_snapshot_async(void)
+{
+    QueueHandle_t done = xQueueCreate(8, sizeof(i2c_async_req_t*));
+    g_kmeter.regs[KMETER_KMETER_ERROR_STATUS_REG] = 0x03;
+    const uint32_t before = fake_i2c_stats()->transactions;
+
+    CHECK_EQ(th_read_snapshot_async(&g_th, done).tag, TH_STATUS_OK);
+    CHECK_EQ(th_read_snapshot_async(&g_th, done).tag, TH_STATUS_ARG_ERR); /* one in flight at a time */
+    CHECK_EQ(fake_i2c_queued(), TH_SNAPSHOT_READS);
+    fake_i2c_run();
+
+    /* one completion for the caller */
+    CHECK_EQ(uxQueueMessagesWaiting(done), 1);
+    i2c_async_req_t* req = NULL;
+    CHECK(xQueueReceive(done, &req, 0) == pdPASS);
+    CHECK(req->ctx == &g_th);
+    const th_result_t r = th_snapshot_result(&g_th);
+    CHECK_EQ(r.tag, TH_STATUS_OK);
+    CHECK_EQ(r.value.snapshot.error_status, 0x03);
+    CHECK_EQ(fake_i2c_stats()->transactions - before, TH_SNAPSHOT_READS);
+    vQueueDelete(done);
+}
+
+static void test_snapshot_nack(void)
+{
+    /* the middle read fails: the snapshot fails, the next one starts clean */
+    g_kmeter.nack_reg = KMETER_INTERNAL_TEMP_VAL_REG;
+    th_result_t r = th_read_snapshot(&g_th);
+    CHECK_EQ(r.tag, TH_STATUS_I2C_ERR);
+    CHECK_EQ(r.value.esp_code, ESP_ERR_INVALID_RESPONSE);
+
+    g_kmeter.nack_reg = -1;
+    g_kmeter.regs[KMETER_KMETER_ERROR_STATUS_REG] = 0;
+    r = th_read_snapshot(&g_th);
+    CHECK_EQ(r.tag, TH_STATUS_OK);
+    CHECK(r.value.snapshot.temp_c == -18.25f);
+    CHECK_EQ(fake_i2c_queued(), 0);
+}
+
+int main(void)
+{
+    fake_i2c_add_model(KMETER_DEFAULT_ADDR, kmeter_fn, &g_kmeter);
+    CHECK_EQ(th_init(&g_th, fake_i2c_bus(), KMETER_DEFAULT_ADDR, 100, 100000).tag, TH_STATUS_OK);
+
+    test_snapshot();
+    test_snapshot_async();
+    test_snapshot_nack();
+
+    CHECK_EQ(th_deinit(&g_th).tag, TH_STATUS_OK);
+    printf("th_sensor: ok\n");
+    return 0;
+}
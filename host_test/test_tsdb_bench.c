@@ -0,0 +1,232 @@
+/*
+ * tsdb: compression on a day of 1 Hz samples. The trace is synthetic, no
+ * recording of the board: a freezer at about -18 degC whose compressor runs
+ * 15 of every 40 minutes, read by the KMeter in steps of 0.25 degC, with an
+ * occasional one-step flicker. The SSR series is either the 1 s test toggle
+ * of main.c or the compressor state a real control would give.
+ *
+ * Every series is stored twice, with the two timestamps the telemetry task
+ * could give a sample:
+ * - completion: `esp_timer_get_time()` when the I2C read was over, 0.5 to
+ *   3 ms after the release, then converted to wall clock milliseconds
+ * - release: the release time of the sample job, converted and rounded to
+ *   the sample period, as main.c does now
+ *
+ * Prints bits per sample for each and checks that every sample reads back.
+ *
+ * Then three boots on the same partition without a time source: each one's
+ * clock starts at the same wall time again. A query of one boot epoch must
+ * return that boot's samples only, in order.
+ */
+#include "tsdb.h"
+#include "fake_partition.h"
+#include "host_test.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SECTORS 128
+#define PERIOD_MS 1000
+#define SAMPLES (24u * 3600u)           /* a day at 1 Hz */
+#define CYCLE_S (40u * 60u)
+#define COMPRESSOR_ON_S (15u * 60u)
+#define WALL_BASE_MS 1760000000000      /* wall clock at esp_timer 0 */
+#define BOOTS 3
+#define BOOT_SAMPLES 3000u              /* a boot spans more than one page */
+
+typedef enum {
+    SERIES_TEMP = 0,
+    SERIES_SSR_TOGGLE,
+    SERIES_SSR_DUTY,
+    SERIES_COUNT,
+} series_kind_t;
+
+typedef enum {
+    STAMP_COMPLETION = 0,
+    STAMP_RELEASE,
+    STAMP_COUNT,
+} stamp_kind_t;
+
+static const char* g_series_names[SERIES_COUNT] = { "temperature", "ssr toggle", "ssr duty" };
+static const char* g_stamp_names[STAMP_COUNT] = { "completion", "release" };
+
+static uint32_t g_rng = 12345;
+
+static uint32_t rng_next(void)
+{
+    g_rng = g_rng * 1664525u + 1013904223u;
+    return g_rng >> 8;
+}
+
+/* 0.01 degC, quantized to the 0.25 degC steps of the sensor */
+static int32_t temp_at(uint32_t i)
+{
+    const uint32_t s = i % CYCLE_S;
+    int32_t centi = 0;
+    if (s < COMPRESSOR_ON_S) {
+        centi = -1700 - (int32_t)(s * 250 / COMPRESSOR_ON_S);                        /* -17.0 down to -19.5 */
+    } else {
+        centi = -1950 + (int32_t)((s - COMPRESSOR_ON_S) * 250 / (CYCLE_S - COMPRESSOR_ON_S)); /* and back up */
+    }
+    if (rng_next() % 16 == 0) {
+        centi += (rng_next() % 2 == 0) ? 25 : -25;
+    }
+    return (centi >= 0 ? centi + 12 : centi - 12) / 25 * 25;
+}
+
+static int32_t value_at(series_kind_t kind, uint32_t i)
+{
+    switch (kind) {
+    case SERIES_TEMP:
+        return temp_at(i);
+    case SERIES_SSR_TOGGLE:
+        return (int32_t)(i % 2);
+    default:
+        return (i % CYCLE_S < COMPRESSOR_ON_S) ? 1 : 0;
+    }
+}
+
+/* Wall clock milliseconds of an esp_timer time, truncated like app_wall_ms() */
+static int64_t wall_ms(int64_t at_us)
+{
+    return WALL_BASE_MS + at_us / 1000;
+}
+
+static int64_t stamp_at(stamp_kind_t kind, uint32_t i)
+{
+    const int64_t release_us = 5000000 + (int64_t)i * PERIOD_MS * 1000;
+    if (kind == STAMP_COMPLETION) {
+        return wall_ms(release_us + 500 + (int64_t)(rng_next() % 2500));
+    }
+    /* app_wall_ms() reads two clocks, the result can be a millisecond off */
+    const int64_t at_ms = wall_ms(release_us) + (int64_t)(rng_next() % 3) - 1;
+    return (at_ms + PERIOD_MS / 2) / PERIOD_MS * PERIOD_MS;
+}
+
+typedef struct {
+    int64_t t_ms[SAMPLES];
+    int32_t value[SAMPLES];
+    uint32_t count;
+    bool mismatch;
+} trace_t;
+
+static trace_t g_trace;
+
+static bool visit(void* ctx, int64_t t_ms, int32_t value)
+{
+    trace_t* trace = ctx;
+    if (trace->count >= SAMPLES || trace->t_ms[trace->count] != t_ms || trace->value[trace->count] != value) {
+        trace->mismatch = true;
+        return false;
+    }
+    trace->count++;
+    return true;
+}
+
+/* Stores one series on an erased partition, returns hundredths of a bit per sample */
+static uint32_t run(const esp_partition_t* part, series_kind_t series, stamp_kind_t stamp)
+{
+    static tsdb_t db;
+    memset(fake_partition_data(part), 0xFF, (size_t)SECTORS * TSDB_PAGE_SIZE);
+    CHECK_EQ(tsdb_init(&db, "tsdb").tag, TSDB_STATUS_OK);
+
+    g_rng = 12345;
+    uint32_t i = 0;
+    for (i = 0; i < SAMPLES; ++i) {
+        g_trace.value[i] = value_at(series, i);
+        g_trace.t_ms[i] = stamp_at(stamp, i);
+        CHECK_EQ(tsdb_append(&db, 0, g_trace.t_ms[i], g_trace.value[i]).tag, TSDB_STATUS_OK);
+    }
+    const uint32_t centibits = tsdb_centibits_per_sample(&db);
+    CHECK_EQ(tsdb_flush(&db).tag, TSDB_STATUS_OK);
+
+    g_trace.count = 0;
+    g_trace.mismatch = false;
+    CHECK_EQ(tsdb_query(&db, 0, db.boot, INT64_MIN, INT64_MAX, visit, &g_trace).tag, TSDB_STATUS_OK);
+    CHECK(!g_trace.mismatch);
+    CHECK_EQ(g_trace.count, SAMPLES);
+    CHECK_EQ(db.corrupt_pages, 0);
+    return centibits;
+}
+
+/* The samples of one boot: the same times in every boot, values that tell the boots apart */
+static void make_boot_trace(uint32_t boot)
+{
+    uint32_t i = 0;
+    for (i = 0; i < BOOT_SAMPLES; ++i) {
+        g_trace.t_ms[i] = (int64_t)i * PERIOD_MS;
+        g_trace.value[i] = (int32_t)(boot * 100000 + (i * 7919) % 4000);
+    }
+}
+
+static void query_boot(tsdb_t* db, uint32_t boot)
+{
+    make_boot_trace(boot);
+    g_trace.count = 0;
+    g_trace.mismatch = false;
+    CHECK_EQ(tsdb_query(db, 0, boot, INT64_MIN, INT64_MAX, visit, &g_trace).tag, TSDB_STATUS_OK);
+    CHECK(!g_trace.mismatch);
+    CHECK_EQ(g_trace.count, BOOT_SAMPLES);
+}
+
+/* Every boot's clock starts at 0, a query by boot epoch keeps them apart */
+static void run_boots(const esp_partition_t* part)
+{
+    static tsdb_t db;
+    memset(fake_partition_data(part), 0xFF, (size_t)SECTORS * TSDB_PAGE_SIZE);
+    uint32_t boot = 0;
+    for (boot = 0; boot < BOOTS; ++boot) {
+        CHECK_EQ(tsdb_init(&db, "tsdb").tag, TSDB_STATUS_OK);
+        CHECK_EQ(db.boot, boot);
+        make_boot_trace(boot);
+        uint32_t i = 0;
+        for (i = 0; i < BOOT_SAMPLES; ++i) {
+            CHECK_EQ(tsdb_append(&db, 0, g_trace.t_ms[i], g_trace.value[i]).tag, TSDB_STATUS_OK);
+        }
+        CHECK(db.pages_closed > 0);
+        /* the last boot keeps its page in RAM, the others end with a flush */
+        if (boot + 1 < BOOTS) {
+            CHECK_EQ(tsdb_flush(&db).tag, TSDB_STATUS_OK);
+        }
+    }
+    for (boot = 0; boot < BOOTS; ++boot) {
+        query_boot(&db, boot);
+    }
+    /* a boot without pages, and a range inside one boot */
+    g_trace.count = 0;
+    CHECK_EQ(tsdb_query(&db, 0, BOOTS, INT64_MIN, INT64_MAX, visit, &g_trace).tag, TSDB_STATUS_OK);
+    CHECK_EQ(g_trace.count, 0);
+    CHECK_EQ(db.corrupt_pages, 0);
+    printf("%u boots of %u samples from the same start time, each queried apart\n", BOOTS, BOOT_SAMPLES);
+}
+
+int main(void)
+{
+    const esp_partition_t* part = fake_partition_add("tsdb", SECTORS * TSDB_PAGE_SIZE);
+    fake_partition_power_cut(FAKE_PARTITION_NO_CUT);
+
+    uint32_t centibits[SERIES_COUNT][STAMP_COUNT];
+    printf("%-12s %12s %12s  (bit/sample, %u samples)\n", "series", g_stamp_names[0], g_stamp_names[1], SAMPLES);
+    uint32_t s = 0;
+    for (s = 0; s < SERIES_COUNT; ++s) {
+        uint32_t k = 0;
+        for (k = 0; k < STAMP_COUNT; ++k) {
+            centibits[s][k] = run(part, (series_kind_t)s, (stamp_kind_t)k);
+        }
+        printf("%-12s %9u.%02u %9u.%02u\n", g_series_names[s], centibits[s][0] / 100, centibits[s][0] % 100,
+            centibits[s][1] / 100, centibits[s][1] % 100);
+    }
+
+    /* a jittered stamp costs most samples a delta-of-delta of 1 + 2 + 7 bits */
+    for (s = 0; s < SERIES_COUNT; ++s) {
+        CHECK(centibits[s][STAMP_COMPLETION] >= 800);
+        CHECK(centibits[s][STAMP_RELEASE] < centibits[s][STAMP_COMPLETION]);
+    }
+    /* on time, an unchanged value is 1 bit, a changed one 1 + 1 + 2 + 6 */
+    CHECK(centibits[SERIES_SSR_DUTY][STAMP_RELEASE] < 110);
+    CHECK(centibits[SERIES_TEMP][STAMP_RELEASE] < 300);
+    CHECK_EQ(centibits[SERIES_SSR_TOGGLE][STAMP_RELEASE], 1000);
+
+    run_boots(part);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * W5500 MAC: emac_w5500_receive_batch() (CONFIG_ETH_W5500_RX_BATCH, 4 KB batch buffer) on the fake chip.
+ *
+ * Several frames arrive before the driver task runs, so one RSR snapshot covers all of them. The RX pointers
+ * start close to the end of the 16 KB RX memory, so frames wrap around it: once with the 2-byte length header
+ * split over the end, once with the payload split, once together with the wrap-around of the 16-bit pointers.
+ * Bursts of full-size frames are larger than the batch buffer, the frame that does not fit has to be picked up
+ * whole by the next batch.
+ *
+ * The stack has to get every frame once, complete and in order. Prints SPI transactions per frame for every
+ * burst size.
+ */
+#include "esp_eth_mac_w5500.c"
+#include "w5500_harness.h"
+#include <stdio.h>
+
+#define FRAMES 960 // a multiple of every burst size
+
+typedef struct {
+    const char* name;
+    uint16_t rx_ptr;
+} start_t;
+
+static uint32_t g_received;
+static uint32_t g_burst_len; // every frame of the burst that long, 0 for a mix
+
+static uint32_t frame_len(uint32_t i)
+{
+    static const uint32_t lens[] = { 60, ETH_MAX_PACKET_SIZE, 342, 61, 590, 98, 1023, 64 };
+    return g_burst_len ? g_burst_len : lens[i % (sizeof(lens) / sizeof(lens[0]))];
+}
+
+static void make_frame(uint32_t i, uint8_t* frame, uint32_t len)
+{
+    uint32_t j = 0;
+    for (j = 0; j < len; ++j) {
+        frame[j] = (uint8_t)(i * 29 + j * 11);
+    }
+}
+
+static void on_frame(const uint8_t* frame, uint32_t len)
+{
+    static uint8_t expected[ETH_MAX_PACKET_SIZE];
+    CHECK_EQ(len, frame_len(g_received));
+    make_frame(g_received, expected, len);
+    CHECK(memcmp(frame, expected, len) == 0);
+    g_received++;
+}
+
+/* transactions per frame, FRAMES frames arriving burst at a time */
+static double run(const start_t* start, uint32_t burst, uint32_t burst_len)
+{
+    static uint8_t frame[ETH_MAX_PACKET_SIZE];
+    const fake_w5500_timing_t timing = FAKE_W5500_TIMING_BOARD;
+    const harness_config_t config = { .int_mode = true, .rx_ptr = start->rx_ptr, .on_frame = on_frame };
+    esp_eth_mac_t* mac = harness_start(&config, &timing);
+    const uint32_t transactions = fake_w5500_stats()->transactions;
+    g_received = 0;
+    g_burst_len = burst_len;
+
+    uint32_t i = 0;
+    for (i = 0; i < FRAMES; i += burst) {
+        uint32_t k = 0;
+        for (k = i; k < i + burst; ++k) {
+            make_frame(k, frame, frame_len(k));
+            CHECK(fake_w5500_receive(frame, frame_len(k)));
+        }
+        harness_run_task();
+        CHECK_EQ(g_received, i + burst);
+        CHECK_EQ(fake_w5500_rx_pending(), 0);
+    }
+    const uint32_t trans = fake_w5500_stats()->transactions - transactions;
+    CHECK_EQ(fake_w5500_stats()->rx_dropped, 0);
+    CHECK_EQ(g_harness.emac->frame_stats.rx_frames, FRAMES);
+    CHECK_EQ(g_harness.emac->frame_stats.rx_dropped, 0);
+    harness_stop(mac);
+    return (double)trans / FRAMES;
+}
+
+int main(void)
+{
+    // RX memory is 16 KB, so a pointer's offset in it is its low 14 bits
+    static const start_t starts[] = {
+        { "header", 0x3FFF },  // the first length header is split over the end of the memory
+        { "payload", 0x3FE0 }, // the first payload is split
+        { "pointer", 0xFFE0 }, // the same, while the 16-bit pointers wrap around too
+    };
+    static const uint32_t bursts[] = { 1, 2, 4, 8 };
+
+    printf("%-8s %-7s %8s  (%u frames of 60 to 1514 bytes)\n", "start", "burst", "trans/fr", FRAMES);
+    uint32_t s = 0;
+    for (s = 0; s < sizeof(starts) / sizeof(starts[0]); ++s) {
+        uint32_t b = 0;
+        for (b = 0; b < sizeof(bursts) / sizeof(bursts[0]); ++b) {
+            const double per_frame = run(&starts[s], bursts[b], 0);
+            printf("%-8s %-7u %8.2f\n", starts[s].name, bursts[b], per_frame);
+        }
+        // 8 full-size frames are 12 KB, three times the batch buffer
+        const double full = run(&starts[s], 8, ETH_MAX_PACKET_SIZE);
+        printf("%-8s %-7s %8.2f\n", starts[s].name, "8x1514", full);
+        // one snapshot of several frames costs less than a snapshot per frame
+        CHECK(run(&starts[s], 4, 0) < run(&starts[s], 1, 0));
+    }
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * W5500 MAC: how much of a receive burst the socket 0 RX memory absorbs, for every MAC RAW buffer size the chip
+ * takes (2, 4, 8 and 16 KB), on the fake chip at 36 MHz SPI.
+ *
+ * Frames arrive back-to-back at 100 Mbps (fake_w5500_set_wire_hook(), so also while the driver is busy on the
+ * bus) and are read by the driver task as it gets to them. Reading a frame takes longer than receiving it, a
+ * burst has to be held by the RX memory until the driver catches up: what does not fit is dropped by the chip.
+ *
+ * The stack has to get the frames that were not dropped complete and in order. Prints the drops per burst and
+ * buffer size, a larger buffer must never drop more.
+ */
+#include "esp_eth_mac_w5500.c"
+#include "w5500_harness.h"
+#include <stdio.h>
+
+#define WIRE_OVERHEAD_BYTES 24 // preamble, CRC and inter-frame gap
+#define WIRE_NS_PER_BYTE 80    // 100 Mbps
+
+typedef struct {
+    const char* name;
+    uint32_t len;
+    uint32_t count;
+} burst_t;
+
+static struct {
+    uint32_t len;
+    uint32_t count;
+    uint32_t sent;     // frames put on the wire so far
+    int64_t next_ns;   // when the next one has arrived completely
+    uint32_t received; // frames passed to the stack
+    int64_t last;      // index of the last one, -1 for none
+} g_wire;
+
+static void make_frame(uint32_t index, uint8_t* frame, uint32_t len)
+{
+    uint32_t j = 0;
+    memcpy(frame, &index, sizeof(index));
+    for (j = sizeof(index); j < len; ++j) {
+        frame[j] = (uint8_t)(index * 7 + j * 13);
+    }
+}
+
+/* the frames due by now arrive, the chip drops those it has no room for */
+static void wire_deliver(void)
+{
+    static uint8_t frame[ETH_MAX_PACKET_SIZE];
+    while (g_wire.sent < g_wire.count && esp_timer_get_time() * 1000 >= g_wire.next_ns) {
+        make_frame(g_wire.sent, frame, g_wire.len);
+        fake_w5500_receive(frame, g_wire.len);
+        g_wire.sent++;
+        g_wire.next_ns += (int64_t)(g_wire.len + WIRE_OVERHEAD_BYTES) * WIRE_NS_PER_BYTE;
+    }
+}
+
+/* frames may be missing, but the ones that made it are complete and in order */
+static void on_frame(const uint8_t* frame, uint32_t len)
+{
+    static uint8_t expected[ETH_MAX_PACKET_SIZE];
+    uint32_t index = 0;
+    CHECK_EQ(len, g_wire.len);
+    memcpy(&index, frame, sizeof(index));
+    CHECK((int64_t)index > g_wire.last && index < g_wire.sent);
+    make_frame(index, expected, len);
+    CHECK(memcmp(frame, expected, len) == 0);
+    g_wire.last = index;
+    g_wire.received++;
+}
+
+/* frames the chip dropped */
+static uint32_t run(uint8_t buf_kb, const burst_t* burst)
+{
+    const fake_w5500_timing_t timing = FAKE_W5500_TIMING_BOARD;
+    const harness_config_t config = { .int_mode = true, .macraw_buf_kb = buf_kb, .on_frame = on_frame };
+    esp_eth_mac_t* mac = harness_start(&config, &timing);
+    memset(&g_wire, 0, sizeof(g_wire));
+    g_wire.len = burst->len;
+    g_wire.count = burst->count;
+    g_wire.next_ns = esp_timer_get_time() * 1000 + (int64_t)(burst->len + WIRE_OVERHEAD_BYTES) * WIRE_NS_PER_BYTE;
+    g_wire.last = -1;
+    fake_w5500_set_wire_hook(wire_deliver);
+
+    while (g_wire.sent < g_wire.count || fake_w5500_int_pending()) {
+        wire_deliver();
+        if (fake_w5500_int_pending()) {
+            harness_run_task();
+        } else {
+            fake_timer_advance_us(1);
+        }
+    }
+    const uint32_t dropped = fake_w5500_stats()->rx_dropped;
+    CHECK_EQ(fake_w5500_rx_pending(), 0);
+    CHECK_EQ(g_wire.received + dropped, burst->count);
+    CHECK_EQ(g_harness.emac->frame_stats.rx_dropped, 0);
+    harness_stop(mac);
+    return dropped;
+}
+
+int main(void)
+{
+    static const uint8_t buf_kb[] = { 2, 4, 8, 16 };
+    static const burst_t bursts[] = {
+        { "8x1514", ETH_MAX_PACKET_SIZE, 8 },
+        { "16x1514", ETH_MAX_PACKET_SIZE, 16 },
+        { "32x1514", ETH_MAX_PACKET_SIZE, 32 },
+        { "64x64", 64, 64 },
+        { "256x64", 64, 256 },
+        { "1024x64", 64, 1024 },
+    };
+    const uint32_t num_bufs = sizeof(buf_kb) / sizeof(buf_kb[0]);
+    const uint32_t num_bursts = sizeof(bursts) / sizeof(bursts[0]);
+    uint32_t dropped[sizeof(bursts) / sizeof(bursts[0])][sizeof(buf_kb) / sizeof(buf_kb[0])] = { { 0 } };
+
+    printf("%-8s", "burst");
+    uint32_t k = 0;
+    for (k = 0; k < num_bufs; ++k) {
+        printf(" %5u KB", buf_kb[k]);
+    }
+    printf("  (frames dropped)\n");
+    uint32_t b = 0;
+    for (b = 0; b < num_bursts; ++b) {
+        printf("%-8s", bursts[b].name);
+        for (k = 0; k < num_bufs; ++k) {
+            dropped[b][k] = run(buf_kb[k], &bursts[b]);
+            printf(" %8u", dropped[b][k]);
+            if (k > 0) {
+                CHECK(dropped[b][k] <= dropped[b][k - 1]);
+            }
+        }
+        printf("\n");
+    }
+    // 8 full frames fit in 16 KB even if the driver reads none of them in time
+    CHECK_EQ(dropped[0][num_bufs - 1], 0);
+    // the full buffer absorbs bursts the smallest one can't
+    CHECK(dropped[1][num_bufs - 1] < dropped[1][0]);
+    CHECK(dropped[4][num_bufs - 1] < dropped[4][0]);
+    printf("ok\n");
+    return 0;
+}
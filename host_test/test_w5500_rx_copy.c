@@ -0,0 +1,129 @@
+/*
+ * W5500 MAC: bytes copied per received frame, on the fake chip behind the driver's default SPI driver (the
+ * spi_master stand-in). Built once per receive path (CMakeLists.txt):
+ *
+ * - test_w5500_rx_copy: the payload is read straight into the buffer passed to the stack, malloc per frame
+ * - test_w5500_rx_copy_pool: the same into a buffer of the RX pool (CONFIG_ETH_W5500_RX_POOL)
+ * - test_w5500_rx_copy_batch: all pending data is read into the batch buffer at once and every frame is copied
+ *   out of it (CONFIG_ETH_W5500_RX_BATCH)
+ *
+ * Counted while the driver task receives: bytes passed to memcpy and malloc calls (wrapped by the linker), bytes
+ * the ESP-IDF SPI master would copy through a DMA buffer of its own (fake_w5500.c), SPI transactions. Frames
+ * arrive in bursts of four, the stack has to get every one of them complete and in order.
+ */
+#include "esp_eth_mac_w5500.c"
+#include "w5500_harness.h"
+#include <stdio.h>
+
+#define FRAMES 1200
+#define BURST 4
+#define REG_COPY_MAX 16 // per frame, register values copied out of SPI_TRANS_USE_RXDATA transactions
+
+static bool g_counting;
+static uint64_t g_copied;
+static uint32_t g_mallocs;
+static uint32_t g_received;
+
+void* __real_memcpy(void* dst, const void* src, size_t n);
+void* __real_malloc(size_t size);
+
+void* __wrap_memcpy(void* dst, const void* src, size_t n)
+{
+    if (g_counting) {
+        g_copied += n;
+    }
+    return __real_memcpy(dst, src, n);
+}
+
+void* __wrap_malloc(size_t size)
+{
+    if (g_counting) {
+        g_mallocs += 1;
+    }
+    return __real_malloc(size);
+}
+
+static uint32_t frame_len(uint32_t i)
+{
+    // odd lengths too, the driver pads its reads to whole words
+    static const uint32_t lens[] = { 60, ETH_MAX_PACKET_SIZE, 342, 61, 590, ETH_MAX_PACKET_SIZE, 98, 1023 };
+    return lens[i % (sizeof(lens) / sizeof(lens[0]))];
+}
+
+static void make_frame(uint32_t i, uint8_t* frame, uint32_t len)
+{
+    uint32_t j = 0;
+    for (j = 0; j < len; ++j) {
+        frame[j] = (uint8_t)(i * 17 + j * 3);
+    }
+}
+
+/* the stack gets the frames in the order they arrived */
+static void on_frame(const uint8_t* frame, uint32_t len)
+{
+    static uint8_t expected[ETH_MAX_PACKET_SIZE];
+    CHECK_EQ(len, frame_len(g_received));
+    make_frame(g_received, expected, len);
+    CHECK(memcmp(frame, expected, len) == 0);
+    g_received++;
+}
+
+int main(void)
+{
+#if CONFIG_ETH_W5500_RX_BATCH
+    const char* path = "batch";
+#elif CONFIG_ETH_W5500_RX_POOL
+    const char* path = "pool";
+#else
+    const char* path = "direct";
+#endif
+    static uint8_t frame[ETH_MAX_PACKET_SIZE];
+    const fake_w5500_timing_t timing = FAKE_W5500_TIMING_BOARD;
+    const harness_config_t config = { .int_mode = true, .spi_master = true, .on_frame = on_frame };
+    esp_eth_mac_t* mac = harness_start(&config, &timing);
+    const uint32_t transactions = fake_w5500_stats()->transactions;
+    uint64_t payload = 0;
+
+    uint32_t i = 0;
+    for (i = 0; i < FRAMES; i += BURST) {
+        uint32_t k = 0;
+        for (k = i; k < i + BURST; ++k) {
+            make_frame(k, frame, frame_len(k));
+            CHECK(fake_w5500_receive(frame, frame_len(k)));
+            payload += frame_len(k);
+        }
+        g_counting = true;
+        harness_run_task();
+        g_counting = false;
+        CHECK_EQ(g_received, i + BURST);
+        CHECK_EQ(fake_w5500_rx_pending(), 0);
+    }
+    const uint32_t trans = fake_w5500_stats()->transactions - transactions;
+    const uint64_t bounced = fake_w5500_stats()->bounce_bytes;
+    CHECK_EQ(g_harness.emac->frame_stats.rx_frames, FRAMES);
+    CHECK_EQ(g_harness.emac->frame_stats.rx_dropped, 0);
+
+    printf("%-8s %12s %10s %8s %9s %8s  (%u frames, %" PRIu64 " payload bytes/frame)\n", "path", "memcpy B/fr",
+        "x payload", "bounced", "malloc/fr", "trans/fr", FRAMES, payload / FRAMES);
+    printf("%-8s %12" PRIu64 " %10.2f %8" PRIu64 " %9.2f %8.2f\n", path, g_copied / FRAMES, (double)g_copied / payload,
+        bounced, (double)g_mallocs / FRAMES, (double)trans / FRAMES);
+
+    // the SPI master never bounces a payload read, all reads go into word aligned and padded buffers
+    CHECK_EQ(bounced, 0);
+#if CONFIG_ETH_W5500_RX_BATCH
+    // one copy per payload byte, out of the batch buffer
+    CHECK(g_copied >= payload && g_copied <= payload + (uint64_t)REG_COPY_MAX * FRAMES);
+    CHECK_EQ(g_mallocs, FRAMES);
+#else
+    // no copy of the payload at all, only register values
+    CHECK(g_copied <= (uint64_t)REG_COPY_MAX * FRAMES);
+#if CONFIG_ETH_W5500_RX_POOL
+    CHECK_EQ(g_mallocs, 0);
+#else
+    CHECK_EQ(g_mallocs, FRAMES);
+#endif
+#endif
+    harness_stop(mac);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * W5500 MAC: SPI lock overhead per frame of the driver's default SPI driver (spi_master stand-in) on the fake chip.
+ * Built twice (CMakeLists.txt):
+ *
+ * - test_w5500_spi_lock: every access takes and gives the SPI mutex, from the transmitting task as well as from
+ *   the driver task
+ * - test_w5500_spi_owner: CONFIG_ETH_W5500_SPI_SINGLE_OWNER, only the driver task accesses the chip, a transmit
+ *   from another task is handed over to it as a whole
+ *
+ * Frames are sent from the test's own task (lwIP on the target) and received by the driver task. Counted from
+ * ETH_W5500_CMD_G_SPI_STATS per frame: mutex takes (lock_takes) and hand-overs (owner_requests). lock_us can't be
+ * measured here: the mutex stand-in takes no time on the model clock, on the target it is the FreeRTOS
+ * take and give.
+ */
+#include "esp_eth_mac_w5500.c"
+#include "w5500_harness.h"
+#include <stdio.h>
+
+#define FRAMES 500
+
+static uint32_t g_received;
+
+static uint32_t frame_len(uint32_t i)
+{
+    static const uint32_t lens[] = { 60, ETH_MAX_PACKET_SIZE, 342, 98, 590 };
+    return lens[i % (sizeof(lens) / sizeof(lens[0]))];
+}
+
+static void make_frame(uint32_t i, uint8_t* frame, uint32_t len)
+{
+    uint32_t j = 0;
+    for (j = 0; j < len; ++j) {
+        frame[j] = (uint8_t)(i * 23 + j * 9);
+    }
+}
+
+static void on_frame(const uint8_t* frame, uint32_t len)
+{
+    static uint8_t expected[ETH_MAX_PACKET_SIZE];
+    CHECK_EQ(len, frame_len(g_received));
+    make_frame(g_received, expected, len);
+    CHECK(memcmp(frame, expected, len) == 0);
+    g_received++;
+}
+
+static eth_w5500_spi_stats_t spi_stats(esp_eth_mac_t* mac)
+{
+    eth_w5500_spi_stats_t stats;
+    CHECK_EQ(mac->custom_ioctl(mac, ETH_W5500_CMD_G_SPI_STATS, &stats), ESP_OK);
+    return stats;
+}
+
+static void print_phase(const char* name, const eth_w5500_spi_stats_t* before, const eth_w5500_spi_stats_t* after)
+{
+    printf("%-4s %12.2f %14.2f %16.1f\n", name, (double)(after->lock_takes - before->lock_takes) / FRAMES,
+        (double)(after->owner_requests - before->owner_requests) / FRAMES,
+        (double)(after->owner_wait_us - before->owner_wait_us) / FRAMES);
+}
+
+int main(void)
+{
+    static uint8_t frame[ETH_MAX_PACKET_SIZE];
+    static uint8_t sent[ETH_MAX_PACKET_SIZE];
+    const fake_w5500_timing_t timing = FAKE_W5500_TIMING_BOARD;
+    const harness_config_t config = { .int_mode = true, .spi_master = true, .on_frame = on_frame };
+    esp_eth_mac_t* mac = harness_start(&config, &timing);
+    uint32_t len = 0;
+
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    printf("single owner: mutex takes and hand-overs per frame (%u frames)\n", FRAMES);
+#else
+    printf("SPI mutex: mutex takes and hand-overs per frame (%u frames)\n", FRAMES);
+#endif
+    printf("%-4s %12s %14s %16s\n", "path", "lock_takes", "owner_requests", "owner_wait_us");
+    const eth_w5500_spi_stats_t start = spi_stats(mac);
+    uint32_t checked = 0;
+    uint32_t i = 0;
+    for (i = 0; i <= FRAMES; ++i) {
+        if (i < FRAMES) {
+            make_frame(i, frame, frame_len(i));
+            CHECK_EQ(mac->transmit(mac, frame, frame_len(i)), ESP_OK);
+            harness_run_task();
+        } else {
+            while (g_harness.emac->tx_ring.count > 0) {
+                harness_block();
+            }
+        }
+        while (fake_w5500_pop_sent(sent, &len)) {
+            CHECK_EQ(len, frame_len(checked));
+            make_frame(checked, frame, len);
+            CHECK(memcmp(sent, frame, len) == 0);
+            checked++;
+        }
+    }
+    CHECK_EQ(checked, FRAMES);
+    const eth_w5500_spi_stats_t tx = spi_stats(mac);
+    print_phase("tx", &start, &tx);
+
+    for (i = 0; i < FRAMES; ++i) {
+        make_frame(i, frame, frame_len(i));
+        CHECK(fake_w5500_receive(frame, frame_len(i)));
+        harness_run_task();
+    }
+    CHECK_EQ(g_received, FRAMES);
+    const eth_w5500_spi_stats_t rx = spi_stats(mac);
+    print_phase("rx", &tx, &rx);
+
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    // no mutex at all, one hand-over per transmitted frame and none for received ones
+    CHECK_EQ(rx.lock_takes, 0);
+    CHECK_EQ(tx.owner_requests - start.owner_requests, FRAMES);
+    CHECK_EQ(rx.owner_requests, tx.owner_requests);
+#else
+    // a mutex take per batch of accesses, in both directions (5 per sent, 6 per received frame), nothing handed over
+    CHECK(tx.lock_takes - start.lock_takes > 4 * FRAMES);
+    CHECK(rx.lock_takes - tx.lock_takes >= 6 * FRAMES);
+    CHECK_EQ(rx.owner_requests, 0);
+#endif
+    harness_stop(mac);
+    printf("ok\n");
+    return 0;
+}
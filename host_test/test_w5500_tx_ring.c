@@ -0,0 +1,173 @@
+/*
+ * W5500 MAC: the TX ring of the interrupt mode (emac_w5500_transmit_queued(), w5500_tx_ring_kick(),
+ * w5500_tx_ring_retire()) on the fake chip, 36 MHz SPI and a 100 Mbps line.
+ *
+ * - stream: the driver task gets to run after every frame, the pointers start 4 KB before their 16-bit
+ *   wrap-around and the frames wrap around the 16 KB TX memory many times
+ * - timeout: as stream, but the chip ends a few SENDs with TIMEOUT, those frames are retired as lost and the
+ *   ones behind them still go out
+ * - full slots: the sender never yields, short frames fill all ring slots and it has to wait for SEND_OK
+ * - full memory: as full slots, with 2 KB TX memory and full-size frames, only one frame fits at a time
+ *
+ * Every frame that is not lost has to leave the chip once, complete and in order.
+ */
+#include "esp_eth_mac_w5500.c"
+#include "w5500_harness.h"
+#include <stdio.h>
+
+#define FRAMES 2000
+#define TX_PTR_START 0xF000 // 4 KB before the 16-bit pointers wrap around
+#define LOST_MAX 8
+
+typedef struct {
+    const char* name;
+    bool stream;          // the driver task runs after every frame, otherwise only while the sender is blocked
+    uint8_t macraw_buf_kb;
+    uint32_t fixed_len;   // every frame that long, 0 for a mix of 60 to 1514 bytes
+    uint32_t fail_at[2];  // two SENDs end with TIMEOUT from these frames on, 0 for none
+} ring_case_t;
+
+typedef struct {
+    uint32_t lost[LOST_MAX];
+    uint32_t lost_count;
+    uint32_t checked;
+    uint32_t blocked;
+} ring_state_t;
+
+static const fake_w5500_timing_t g_timing = FAKE_W5500_TIMING_BOARD;
+static ring_state_t g_state;
+
+static uint32_t frame_len(const ring_case_t* test, uint32_t i)
+{
+    static const uint32_t lens[] = { 60, ETH_MAX_PACKET_SIZE, 590, 98, ETH_MAX_PACKET_SIZE, 342, 60, 60 };
+    return test->fixed_len ? test->fixed_len : lens[i % (sizeof(lens) / sizeof(lens[0]))];
+}
+
+static void make_frame(uint32_t i, uint8_t* frame, uint32_t len)
+{
+    uint32_t j = 0;
+    for (j = 0; j < len; ++j) {
+        frame[j] = (uint8_t)(i * 13 + j * 5);
+    }
+}
+
+static bool is_lost(uint32_t i)
+{
+    uint32_t k = 0;
+    for (k = 0; k < g_state.lost_count; ++k) {
+        if (g_state.lost[k] == i) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* the frames the chip sent so far are the next ones in order, lost ones skipped */
+static void check_sent(const ring_case_t* test)
+{
+    static uint8_t expected[ETH_MAX_PACKET_SIZE];
+    static uint8_t sent[ETH_MAX_PACKET_SIZE];
+    uint32_t len = 0;
+    while (fake_w5500_pop_sent(sent, &len)) {
+        while (is_lost(g_state.checked)) {
+            g_state.checked++;
+        }
+        CHECK_EQ(len, frame_len(test, g_state.checked));
+        make_frame(g_state.checked, expected, len);
+        CHECK(memcmp(sent, expected, len) == 0);
+        g_state.checked++;
+    }
+}
+
+static void check_ring(void)
+{
+    const emac_w5500_tx_ring_t* ring = &g_harness.emac->tx_ring;
+    CHECK(ring->count <= W5500_TX_RING_LEN);
+    CHECK((uint16_t)(ring->wr - ring->rd) <= ring->mem_size);
+    CHECK(ring->busy == (ring->count > 0));
+}
+
+/* the sender waits for room in the ring */
+static void count_block(void)
+{
+    g_state.blocked++;
+    harness_block();
+}
+
+static void drain(void)
+{
+    while (g_harness.emac->tx_ring.count > 0) {
+        harness_block();
+    }
+}
+
+static void run(const ring_case_t* test)
+{
+    static uint8_t frame[ETH_MAX_PACKET_SIZE];
+    const harness_config_t config = { .int_mode = true, .macraw_buf_kb = test->macraw_buf_kb, .tx_ptr = TX_PTR_START };
+    esp_eth_mac_t* mac = harness_start(&config, &g_timing);
+    fake_task_set_block_hook(count_block);
+    memset(&g_state, 0, sizeof(g_state));
+    const uint32_t transactions = fake_w5500_stats()->transactions;
+    const int64_t start = esp_timer_get_time();
+    uint64_t bytes = 0;
+
+    uint32_t i = 0;
+    for (i = 0; i < FRAMES; ++i) {
+        if (test->fail_at[0] && (i == test->fail_at[0] || i == test->fail_at[1])) {
+            // nothing in flight, so the next two SENDs are those of this frame and the next one
+            drain();
+            fake_w5500_fail_sends(2);
+            g_state.lost[g_state.lost_count++] = i;
+            g_state.lost[g_state.lost_count++] = i + 1;
+        }
+        make_frame(i, frame, frame_len(test, i));
+        CHECK_EQ(mac->transmit(mac, frame, frame_len(test, i)), ESP_OK);
+        bytes += frame_len(test, i);
+        check_ring();
+        if (test->stream) {
+            harness_run_task();
+        }
+        check_sent(test);
+    }
+    drain();
+    const int64_t elapsed_us = esp_timer_get_time() - start;
+    const uint32_t trans = fake_w5500_stats()->transactions - transactions;
+    check_sent(test);
+    while (is_lost(g_state.checked)) {
+        g_state.checked++;
+    }
+    CHECK_EQ(g_state.checked, FRAMES);
+    CHECK_EQ(fake_w5500_stats()->tx_frames + fake_w5500_stats()->tx_timeouts, FRAMES);
+    CHECK_EQ(fake_w5500_stats()->tx_timeouts, g_state.lost_count);
+    CHECK_EQ(g_harness.emac->frame_stats.tx_errors, g_state.lost_count);
+    // the 16-bit pointers wrapped around, and the frames wrapped around the TX memory
+    CHECK(bytes > 0x10000 - TX_PTR_START);
+    CHECK(bytes > 2 * (uint64_t)g_harness.emac->tx_ring.mem_size);
+
+    const uint32_t centi_trans = (uint32_t)((uint64_t)trans * 100 / FRAMES);
+    printf("%-12s %4u %7u %5u.%02u %9u %7u\n", test->name, g_state.lost_count, g_state.blocked, centi_trans / 100,
+        centi_trans % 100, (uint32_t)((int64_t)FRAMES * 1000000 / elapsed_us), (uint32_t)(bytes * 8 / (uint64_t)elapsed_us));
+    harness_stop(mac);
+}
+
+int main(void)
+{
+    static const ring_case_t stream = { .name = "stream", .stream = true };
+    static const ring_case_t timeout = { .name = "timeout", .stream = true, .fail_at = { 100, 1001 } };
+    static const ring_case_t full_slots = { .name = "full slots", .fixed_len = 60 };
+    static const ring_case_t full_memory = { .name = "full memory", .macraw_buf_kb = 2, .fixed_len = ETH_MAX_PACKET_SIZE };
+
+    printf("%-12s %4s %7s %8s %9s %7s  (%u frames)\n", "case", "lost", "blocked", "trans/fr", "frames/s", "Mbit/s", FRAMES);
+    run(&stream);
+    CHECK_EQ(g_state.blocked, 0);
+    run(&timeout);
+    /* once the ring is full every SEND_OK makes room for exactly one more frame, so the sender waits once per frame:
+       more waits would be wake-ups without room, a missed wake-up would fail the transmit */
+    run(&full_slots);
+    CHECK_EQ(g_state.blocked, FRAMES - W5500_TX_RING_LEN);
+    run(&full_memory);
+    CHECK_EQ(g_state.blocked, FRAMES - 1);
+    printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file w5500_harness.h
+ * @brief The W5500 MAC driver on the fake chip of fake_w5500.c, for the host tests of the driver.
+ *
+ * Include after esp_eth_mac_w5500.c, the test reaches the driver's static functions that way. There is no driver
+ * task: harness_run_task() does what it would do after a wake-up, and a caller blocking in the driver (waiting for
+ * room in the TX ring, yielding in a command poll) runs it in the meantime, while the chip's clock moves on.
+ */
+
+#ifndef W5500_HARNESS_H
+#define W5500_HARNESS_H
+
+#include "fake_w5500.h"
+#include "freertos/task.h"
+#include "host_test.h"
+
+#define HARNESS_INT_GPIO 4
+#define HARNESS_POLL_PERIOD_MS 10
+#define HARNESS_TASK_ROUNDS_MAX 10000 // a driver task still busy after that many rounds is stuck
+
+typedef struct {
+    bool int_mode;          // INT line wired (SEND_OK interrupt driven, TX ring), otherwise polled
+    bool spi_master;        // the driver's default SPI driver on the spi_master stand-in, otherwise a custom driver
+    uint8_t macraw_buf_kb;  // socket 0 TX and RX memory, 0 for the Kconfig default
+    uint16_t tx_ptr;        // socket 0 pointers when the socket opens, to start close to a wrap-around
+    uint16_t rx_ptr;
+    void (*on_frame)(const uint8_t* frame, uint32_t len); // frames passed to the stack, freed afterwards
+} harness_config_t;
+
+static struct {
+    esp_eth_mediator_t mediator;
+    emac_w5500_t* emac;
+    void (*on_frame)(const uint8_t* frame, uint32_t len);
+} g_harness;
+
+static esp_err_t harness_stack_input(esp_eth_mediator_t* eth, uint8_t* buffer, uint32_t length)
+{
+    if (g_harness.on_frame != NULL) {
+        g_harness.on_frame(buffer, length);
+    }
+    esp_eth_mac_w5500_free_rx_buf(NULL, buffer);
+    return ESP_OK;
+}
+
+static esp_err_t harness_on_state_changed(esp_eth_mediator_t* eth, esp_eth_state_t state, void* args)
+{
+    return ESP_OK;
+}
+
+/* emac_w5500_task for as long as it gets woken: by the INT line, or by another task handing it a request
+   (CONFIG_ETH_W5500_SPI_SINGLE_OWNER), false if it had nothing to do */
+static bool harness_run_task(void)
+{
+    const TaskHandle_t caller = xTaskGetCurrentTaskHandle();
+    uint32_t rounds = 0;
+    fake_task_set_current(g_harness.emac->rx_task_hdl);
+    while (ulTaskNotifyTake(pdTRUE, 0) > 0 || fake_w5500_int_pending()) {
+        CHECK(++rounds < HARNESS_TASK_ROUNDS_MAX);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+        w5500_owner_serve(g_harness.emac);
+#endif
+        if (fake_w5500_int_pending()) {
+            w5500_service(g_harness.emac);
+        }
+    }
+    fake_task_set_current(caller);
+    return rounds > 0;
+}
+
+/* the caller waits, the chip sends and receives meanwhile and the driver task handles what it signals */
+static void harness_block(void)
+{
+    if (xTaskGetCurrentTaskHandle() == g_harness.emac->rx_task_hdl) {
+        return; // the driver task itself waits, for SEND_OK of a full TX ring, nothing else runs on the host
+    }
+    if (harness_run_task()) {
+        return;
+    }
+    uint32_t us = 0;
+    for (us = 0; us < 1000 && !fake_w5500_int_pending(); ++us) {
+        fake_timer_advance_us(1);
+    }
+    harness_run_task();
+}
+
+/* a new MAC on a chip fresh from power-on, initialized, at 100 Mbps with the link up and socket 0 open */
+static esp_eth_mac_t* harness_start(const harness_config_t* config, const fake_w5500_timing_t* timing)
+{
+    fake_w5500_reset(timing);
+    static spi_device_interface_config_t devcfg = { .mode = 0, .clock_speed_hz = 36000000, .queue_size = 20 };
+    eth_w5500_config_t w5500_config = {
+        .int_gpio_num = config->int_mode ? HARNESS_INT_GPIO : -1,
+        .poll_period_ms = config->int_mode ? 0 : HARNESS_POLL_PERIOD_MS,
+        .sock_buf = ETH_W5500_DEFAULT_SOCK_BUF_CONFIG(),
+    };
+    if (config->spi_master) {
+        w5500_config.spi_host_id = SPI2_HOST;
+        w5500_config.spi_devcfg = &devcfg;
+    } else {
+        w5500_config.custom_spi_driver = fake_w5500_spi_driver();
+    }
+    if (config->macraw_buf_kb) {
+        w5500_config.sock_buf.rx_size_kb[0] = config->macraw_buf_kb;
+        w5500_config.sock_buf.tx_size_kb[0] = config->macraw_buf_kb;
+    }
+    eth_mac_config_t mac_config = ETH_MAC_DEFAULT_CONFIG();
+    esp_eth_mac_t* mac = esp_eth_mac_new_w5500(&w5500_config, &mac_config);
+    CHECK(mac != NULL);
+    g_harness.emac = __containerof(mac, emac_w5500_t, parent);
+    g_harness.on_frame = config->on_frame;
+    g_harness.mediator.stack_input = harness_stack_input;
+    g_harness.mediator.on_state_changed = harness_on_state_changed;
+    fake_task_set_block_hook(harness_block);
+
+    CHECK_EQ(mac->set_mediator(mac, &g_harness.mediator), ESP_OK);
+    CHECK_EQ(mac->init(mac), ESP_OK);
+    fake_w5500_set_pointers(config->tx_ptr, config->rx_ptr);
+    CHECK_EQ(mac->set_speed(mac, ETH_SPEED_100M), ESP_OK);
+    CHECK_EQ(mac->set_link(mac, ETH_LINK_UP), ESP_OK);
+    return mac;
+}
+
+static void harness_stop(esp_eth_mac_t* mac)
+{
+    CHECK_EQ(fake_w5500_stats()->errors, 0);
+    /* the PHY driver finds its MAC through the mediator, link reporting goes to the driver task in interrupt mode only */
+    eth_link_t link = ETH_LINK_UP;
+    const bool watched = g_harness.emac->int_gpio_num >= 0;
+    CHECK_EQ(w5500_link_take_over(&g_harness.mediator, &link), watched ? ESP_OK : ESP_ERR_NOT_SUPPORTED);
+    CHECK(!watched || link == g_harness.emac->link_reported);
+    CHECK_EQ(g_harness.emac->link_push, watched);
+    w5500_link_hand_back(&g_harness.mediator);
+    CHECK(!g_harness.emac->link_push);
+    CHECK_EQ(mac->deinit(mac), ESP_OK);
+    CHECK_EQ(mac->del(mac), ESP_OK);
+    CHECK_EQ(w5500_link_take_over(&g_harness.mediator, &link), ESP_ERR_NOT_SUPPORTED);
+    fake_task_set_block_hook(NULL);
+    g_harness.emac = NULL;
+}
+
+#endif // W5500_HARNESS_H
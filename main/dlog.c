@@ -0,0 +1,229 @@
+#include "dlog.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+_Static_assert(sizeof(void*) != 4 || sizeof(dlog_record_t) == 96, "dlog_record_t layout changed");
+
+static dlog_ring_t* g_rings[DLOG_RINGS_MAX];
+static _Atomic uint32_t g_ring_count = 0;
+static portMUX_TYPE g_attach_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* one consumer, the line buffer of the log task */
+static char g_line[DLOG_LINE_MAX];
+
+static const char g_level_chars[] = { 'N', 'E', 'W', 'I', 'D', 'V' };
+
+esp_err_t dlog_attach(dlog_ring_t* ring)
+{
+    if (!ring) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t rc = spsc_queue_init(&ring->queue, ring->items, sizeof(ring->items[0]), DLOG_RING_LEN);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    ring->owner = xTaskGetCurrentTaskHandle();
+    ring->calls = 0;
+    ring->cycles_sum = 0;
+    ring->cycles_max = 0;
+    ring->dropped_seen = 0;
+
+    portENTER_CRITICAL(&g_attach_lock);
+    const uint32_t count = atomic_load_explicit(&g_ring_count, memory_order_relaxed);
+    if (count < DLOG_RINGS_MAX) {
+        g_rings[count] = ring;
+        /* the ring is set up before a caller or the log task can see it */
+        atomic_store_explicit(&g_ring_count, count + 1, memory_order_release);
+    } else {
+        rc = ESP_ERR_NO_MEM;
+    }
+    portEXIT_CRITICAL(&g_attach_lock);
+    return rc;
+}
+
+static dlog_ring_t* dlog_find_ring(TaskHandle_t task)
+{
+    const uint32_t count = atomic_load_explicit(&g_ring_count, memory_order_acquire);
+    uint32_t i = 0;
+    for (i = 0; i < count; ++i) {
+        if (g_rings[i]->owner == task) {
+            return g_rings[i];
+        }
+    }
+    return NULL;
+}
+
+static void dlog_print(const dlog_record_t* record, char* buf, size_t size)
+{
+    dlog_format(record, buf, size);
+    const char level_char = (record->level < sizeof(g_level_chars)) ? g_level_chars[record->level] : '?';
+    esp_log_write((esp_log_level_t)record->level, record->tag, "%c (%lu) %s: %s\n", level_char,
+        (unsigned long)(record->at_us / 1000), record->tag, buf);
+}
+
+void dlog_write(esp_log_level_t level, const char* tag, const char* fmt, uint32_t nargs, const uint64_t* args)
+{
+    const uint32_t start = esp_cpu_get_cycle_count();
+    dlog_record_t record = {
+        .at_us = esp_timer_get_time(),
+        .tag = tag,
+        .fmt = fmt,
+        .level = (uint8_t)level,
+        .nargs = (uint8_t)((nargs < DLOG_ARGS_MAX) ? nargs : DLOG_ARGS_MAX),
+    };
+    memcpy(record.args, args, record.nargs * sizeof(record.args[0]));
+
+    dlog_ring_t* ring = dlog_find_ring(xTaskGetCurrentTaskHandle());
+#if CONFIG_APP_LOG_DEFERRED
+    if (ring) {
+        spsc_queue_push(&ring->queue, &record);
+    } else {
+        char line[DLOG_LINE_MAX];
+        dlog_print(&record, line, sizeof(line));
+    }
+#else
+    char line[DLOG_LINE_MAX];
+    dlog_print(&record, line, sizeof(line));
+#endif
+
+    if (ring) {
+        const uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        ring->calls += 1;
+        ring->cycles_sum += cycles;
+        if (cycles > ring->cycles_max) {
+            ring->cycles_max = cycles;
+        }
+    }
+}
+
+uint32_t dlog_flush(void)
+{
+    const uint32_t count = atomic_load_explicit(&g_ring_count, memory_order_acquire);
+    uint32_t printed = 0;
+    uint32_t i = 0;
+    for (i = 0; i < count; ++i) {
+        dlog_ring_t* ring = g_rings[i];
+        dlog_record_t record;
+        while (spsc_queue_pop(&ring->queue, &record)) {
+            dlog_print(&record, g_line, sizeof(g_line));
+            printed += 1;
+        }
+        /* written by the owner, a stale value is reported on the next call */
+        const uint32_t dropped = ring->queue.dropped;
+        if (dropped != ring->dropped_seen) {
+            ESP_LOGW("dlog", "%s: %lu records dropped, ring full", pcTaskGetName(ring->owner),
+                (unsigned long)(dropped - ring->dropped_seen));
+            ring->dropped_seen = dropped;
+        }
+    }
+    return printed;
+}
+
+/* Copy one conversion, "%-9s" or "%" PRId64, and print it with the argument cast to the type it names */
+static int dlog_format_arg(char* out, size_t size, const char* spec, size_t spec_len, uint64_t arg)
+{
+    char conv_fmt[16];
+    if (spec_len >= sizeof(conv_fmt)) {
+        return snprintf(out, size, "?");
+    }
+    memcpy(conv_fmt, spec, spec_len);
+    conv_fmt[spec_len] = '\0';
+
+    const char conv = spec[spec_len - 1];
+    const char len1 = (spec_len >= 3) ? spec[spec_len - 2] : '\0';
+    const char len2 = (spec_len >= 4) ? spec[spec_len - 3] : '\0';
+    const bool is_ll = (len1 == 'l' && len2 == 'l') || len1 == 'j';
+    const bool is_l = !is_ll && len1 == 'l';
+    const bool is_z = len1 == 'z' || len1 == 't';
+
+    switch (conv) {
+    case 'd':
+    case 'i':
+        if (is_ll) {
+            return snprintf(out, size, conv_fmt, (long long)arg);
+        } else if (is_l) {
+            return snprintf(out, size, conv_fmt, (long)arg);
+        } else if (is_z) {
+            return snprintf(out, size, conv_fmt, (ssize_t)arg);
+        }
+        return snprintf(out, size, conv_fmt, (int)arg);
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        if (is_ll) {
+            return snprintf(out, size, conv_fmt, (unsigned long long)arg);
+        } else if (is_l) {
+            return snprintf(out, size, conv_fmt, (unsigned long)arg);
+        } else if (is_z) {
+            return snprintf(out, size, conv_fmt, (size_t)arg);
+        }
+        return snprintf(out, size, conv_fmt, (unsigned)arg);
+    case 'c':
+        return snprintf(out, size, conv_fmt, (int)arg);
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A': {
+        double value;
+        memcpy(&value, &arg, sizeof(value));
+        return snprintf(out, size, conv_fmt, value);
+    }
+    case 's':
+        return snprintf(out, size, conv_fmt, (const char*)(uintptr_t)arg);
+    case 'p':
+        return snprintf(out, size, conv_fmt, (void*)(uintptr_t)arg);
+    default:
+        return snprintf(out, size, "?");
+    }
+}
+
+size_t dlog_format(const dlog_record_t* record, char* buf, size_t size)
+{
+    if (size == 0) {
+        return 0;
+    }
+    const char* p = record->fmt;
+    size_t pos = 0;
+    uint32_t arg = 0;
+    while (*p != '\0' && pos + 1 < size) {
+        if (*p != '%') {
+            buf[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            buf[pos++] = '%';
+            p += 2;
+            continue;
+        }
+
+        const char* spec = p++;
+        while (*p != '\0' && strchr("-+ #0123456789.hljzt", *p) != NULL) {
+            ++p;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        ++p;
+        int n = 0;
+        if (arg < record->nargs) {
+            n = dlog_format_arg(&buf[pos], size - pos, spec, (size_t)(p - spec), record->args[arg]);
+        } else {
+            n = snprintf(&buf[pos], size - pos, "?");
+        }
+        arg += 1;
+        if (n > 0) {
+            pos += ((size_t)n < size - pos) ? (size_t)n : size - pos - 1;
+        }
+    }
+    buf[pos] = '\0';
+    return pos;
+}
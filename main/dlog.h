@@ -0,0 +1,154 @@
+/**
+ * @file dlog.h
+ * @brief Deferred logging: the caller stores the format string and raw arguments, another task formats.
+ *
+ * `log_printf(level, tag, fmt, ...)` copies a pointer to the format string
+ * (its ID: the literal stays in flash), a timestamp and every argument as a
+ * 64-bit word into a record. A task that owns a ring pushes the record into
+ * it, no formatting, no UART write, no lock. The log task calls
+ * `dlog_flush()` to format the records and write them with `esp_log_write()`,
+ * timestamped with the time of the call. Tasks without a ring format inline.
+ *
+ * Since only pointers are stored, `%s` arguments must be strings that outlive
+ * the record: literals, `esp_err_to_name()`, names in static tables. At most
+ * `DLOG_ARGS_MAX` arguments, no `*` width or precision.
+ *
+ * With `CONFIG_APP_LOG_DEFERRED` off every call formats inline, the cycle
+ * counters of a ring then show what logging costs without the ring.
+ */
+
+#ifndef DLOG_H
+#define DLOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <esp_err.h>
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "spsc_queue.h"
+
+/** Arguments one call can pass */
+#define DLOG_ARGS_MAX 9
+/** Records one ring holds, a power of two */
+#define DLOG_RING_LEN 32
+/** Rings, tasks that log deferred */
+#define DLOG_RINGS_MAX 4
+/** Longest formatted message, longer ones are cut */
+#define DLOG_LINE_MAX 192
+
+/**
+ * @brief One call as stored, 96 bytes.
+ */
+typedef struct dlog_record_s {
+    int64_t at_us;       /**< `esp_timer_get_time()` of the call */
+    const char *tag;
+    const char *fmt;
+    uint8_t level;       /**< `esp_log_level_t` */
+    uint8_t nargs;
+    uint16_t reserved;
+    uint64_t args[DLOG_ARGS_MAX]; /**< integers sign-extended, doubles as their bits, pointers */
+} dlog_record_t;
+
+/**
+ * @brief Ring of one logging task, the log task is the consumer.
+ */
+typedef struct dlog_ring_s {
+    spsc_queue_t queue;
+    _Alignas(SPSC_QUEUE_CACHE_LINE) dlog_record_t items[DLOG_RING_LEN];
+    TaskHandle_t owner;
+    uint32_t calls;         /**< `log_printf()` calls of the owner (producer) */
+    uint64_t cycles_sum;    /**< CPU cycles spent in them (producer) */
+    uint32_t cycles_max;
+    uint32_t dropped_seen;  /**< `queue.dropped` when last reported (consumer) */
+} dlog_ring_t;
+
+/**
+ * @brief Give the calling task a ring, its later calls are deferred.
+ *
+ * @return ESP_ERR_NO_MEM when `DLOG_RINGS_MAX` rings are in use
+ */
+esp_err_t dlog_attach(dlog_ring_t *ring);
+
+/**
+ * @brief Store or, for a task without a ring, print one call. Use `log_printf()`.
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt, uint32_t nargs, const uint64_t *args);
+
+/**
+ * @brief Format and print the waiting records of all rings, log task only.
+ *
+ * Reports records a full ring has dropped since the last call.
+ *
+ * @return records printed
+ */
+uint32_t dlog_flush(void);
+
+/**
+ * @brief Format the message of a record, like `snprintf()`.
+ */
+size_t dlog_format(const dlog_record_t *record, char *buf, size_t size);
+
+static inline uint64_t dlog_arg_i(int64_t value)
+{
+    return (uint64_t)value;
+}
+
+static inline uint64_t dlog_arg_f(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline uint64_t dlog_arg_p(const void *value)
+{
+    return (uint64_t)(uintptr_t)value;
+}
+
+/* never called, lets the compiler check the format against the arguments */
+static inline __attribute__((format(printf, 1, 2))) void dlog_check_format(const char *fmt, ...)
+{
+    (void)fmt;
+}
+
+#define DLOG_ARG(x) _Generic((x),                                           \
+    float: dlog_arg_f, double: dlog_arg_f,                                  \
+    char *: dlog_arg_p, const char *: dlog_arg_p,                           \
+    void *: dlog_arg_p, const void *: dlog_arg_p,                           \
+    default: dlog_arg_i)(x)
+
+#define DLOG_NARG_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, n, ...) n
+#define DLOG_NARG(...) DLOG_NARG_(0, ##__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+
+#define DLOG_MAP_0()
+#define DLOG_MAP_1(a) DLOG_ARG(a),
+#define DLOG_MAP_2(a, ...) DLOG_ARG(a), DLOG_MAP_1(__VA_ARGS__)
+#define DLOG_MAP_3(a, ...) DLOG_ARG(a), DLOG_MAP_2(__VA_ARGS__)
+#define DLOG_MAP_4(a, ...) DLOG_ARG(a), DLOG_MAP_3(__VA_ARGS__)
+#define DLOG_MAP_5(a, ...) DLOG_ARG(a), DLOG_MAP_4(__VA_ARGS__)
+#define DLOG_MAP_6(a, ...) DLOG_ARG(a), DLOG_MAP_5(__VA_ARGS__)
+#define DLOG_MAP_7(a, ...) DLOG_ARG(a), DLOG_MAP_6(__VA_ARGS__)
+#define DLOG_MAP_8(a, ...) DLOG_ARG(a), DLOG_MAP_7(__VA_ARGS__)
+#define DLOG_MAP_9(a, ...) DLOG_ARG(a), DLOG_MAP_8(__VA_ARGS__)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+
+/**
+ * @brief Central log call, same format rules as `ESP_LOGx()` plus the ones above.
+ *
+ * @param level `ESP_LOG_ERROR` .. `ESP_LOG_VERBOSE`, levels above `CONFIG_LOG_MAXIMUM_LEVEL` compile to nothing
+ */
+#define log_printf(level, tag, fmt, ...)                                                              \
+    do {                                                                                              \
+        if ((level) <= CONFIG_LOG_MAXIMUM_LEVEL) {                                                    \
+            if (0) {                                                                                  \
+                dlog_check_format(fmt, ##__VA_ARGS__);                                                \
+            }                                                                                         \
+            const uint64_t dlog_args_[] = { DLOG_CAT(DLOG_MAP_, DLOG_NARG(__VA_ARGS__))(__VA_ARGS__) 0 }; \
+            dlog_write((level), (tag), (fmt), DLOG_NARG(__VA_ARGS__), dlog_args_);                    \
+        }                                                                                             \
+    } while (0)
+
+#endif // DLOG_H
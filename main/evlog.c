@@ -0,0 +1,349 @@
+#include "evlog.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <string.h>
+
+typedef struct evlog_sector_hdr_s {
+    uint32_t magic;
+    uint32_t seq;      /**< increases with every sector opened */
+    uint32_t crc;      /**< CRC-32 of magic and seq */
+    uint32_t reserved;
+} evlog_sector_hdr_t;
+
+static const uint32_t g_sector_magic = 0x31475645; /* "EVG1" */
+
+#define EVLOG_SLOTS ((EVLOG_SECTOR_SIZE - sizeof(evlog_sector_hdr_t)) / sizeof(evlog_frame_t))
+/* frames read at once by evlog_read() */
+#define EVLOG_READ_CHUNK 8
+
+_Static_assert(sizeof(evlog_frame_t) == 24, "evlog_frame_t layout changed");
+_Static_assert(sizeof(evlog_sector_hdr_t) == 16, "evlog_sector_hdr_t layout changed");
+
+static evlog_result_t flash_err(esp_err_t rc)
+{
+    evlog_result_t res = { .tag = EVLOG_STATUS_FLASH_ERR };
+    res.value.esp_code = rc;
+    return res;
+}
+
+static size_t slot_offset(uint32_t sector, uint32_t slot)
+{
+    return (size_t)sector * EVLOG_SECTOR_SIZE + sizeof(evlog_sector_hdr_t) + (size_t)slot * sizeof(evlog_frame_t);
+}
+
+static uint32_t frame_crc(const evlog_frame_t* frame)
+{
+    return esp_rom_crc32_le(0, (const uint8_t*)frame, offsetof(evlog_frame_t, crc));
+}
+
+static uint32_t hdr_crc(const evlog_sector_hdr_t* hdr)
+{
+    return esp_rom_crc32_le(0, (const uint8_t*)hdr, offsetof(evlog_sector_hdr_t, crc));
+}
+
+static bool is_erased(const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    size_t i = 0;
+    for (i = 0; i < len; ++i) {
+        if (bytes[i] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static esp_err_t read_hdr(const evlog_t* self, uint32_t sector, bool* valid, uint32_t* seq)
+{
+    evlog_sector_hdr_t hdr;
+    const esp_err_t rc = esp_partition_read(self->part, (size_t)sector * EVLOG_SECTOR_SIZE, &hdr, sizeof(hdr));
+    *valid = rc == ESP_OK && hdr.magic == g_sector_magic && hdr.crc == hdr_crc(&hdr);
+    *seq = hdr.seq;
+    return rc;
+}
+
+static esp_err_t read_frame(const evlog_t* self, uint32_t sector, uint32_t slot, evlog_frame_t* frame)
+{
+    return esp_partition_read(self->part, slot_offset(sector, slot), frame, sizeof(*frame));
+}
+
+/* Move to the next sector: erase it, then write its header. A reset in between leaves no valid header. */
+static esp_err_t open_next_sector(evlog_t* self)
+{
+    const uint32_t sector = (self->sector + 1) % self->sectors;
+    esp_err_t rc = esp_partition_erase_range(self->part, (size_t)sector * EVLOG_SECTOR_SIZE, EVLOG_SECTOR_SIZE);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    self->sectors_erased += 1;
+
+    evlog_sector_hdr_t hdr = {
+        .magic = g_sector_magic,
+        .seq = self->sector_seq + 1,
+        .reserved = UINT32_MAX,
+    };
+    hdr.crc = hdr_crc(&hdr);
+    rc = esp_partition_write(self->part, (size_t)sector * EVLOG_SECTOR_SIZE, &hdr, sizeof(hdr));
+    /* move on even if the header write failed, the sector is no longer what it held */
+    self->sector = sector;
+    self->sector_seq = hdr.seq;
+    self->slot = (rc == ESP_OK) ? 0 : EVLOG_SLOTS;
+    return rc;
+}
+
+/* Slots are filled in order, so the written ones (valid or torn) come first and the erased ones after */
+static esp_err_t find_end(const evlog_t* self, uint32_t sector, uint32_t* end)
+{
+    uint32_t lo = 0;
+    uint32_t hi = EVLOG_SLOTS;
+    while (lo < hi) {
+        const uint32_t mid = lo + (hi - lo) / 2;
+        evlog_frame_t frame;
+        const esp_err_t rc = read_frame(self, sector, mid, &frame);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        if (is_erased(&frame, sizeof(frame))) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    *end = lo;
+    return ESP_OK;
+}
+
+/* Sequence number of the last intact record before slot `end`, counts the torn ones after it */
+static esp_err_t find_last_seq(evlog_t* self, uint32_t sector, uint32_t end, bool* found, uint32_t* seq)
+{
+    *found = false;
+    uint32_t slot = end;
+    while (slot > 0) {
+        slot -= 1;
+        evlog_frame_t frame;
+        const esp_err_t rc = read_frame(self, sector, slot, &frame);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        if (frame.crc == frame_crc(&frame)) {
+            *found = true;
+            *seq = frame.seq;
+            return ESP_OK;
+        }
+        self->torn += 1;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t find_free_slot(evlog_t* self)
+{
+    esp_err_t rc = find_end(self, self->sector, &self->slot);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    /* continue the record numbers after the last intact record. A reset right after a sector was opened, or
+     * during its first write, leaves it without one: that record is then in a sector before it. */
+    uint32_t sector = self->sector;
+    uint32_t sector_seq = self->sector_seq;
+    uint32_t end = self->slot;
+    uint32_t k = 0;
+    for (k = 0; k < self->sectors; ++k) {
+        bool found = false;
+        uint32_t seq = 0;
+        rc = find_last_seq(self, sector, end, &found, &seq);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        if (found) {
+            self->next_seq = seq + 1;
+            break;
+        }
+        /* only an older sector holds earlier records, the ring ends at the first one that is not */
+        sector = (sector + self->sectors - 1) % self->sectors;
+        bool valid = false;
+        rc = read_hdr(self, sector, &valid, &seq);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+        if (!valid || seq >= sector_seq) {
+            break;
+        }
+        sector_seq = seq;
+        rc = find_end(self, sector, &end);
+        if (rc != ESP_OK) {
+            return rc;
+        }
+    }
+    return ESP_OK;
+}
+
+evlog_result_t evlog_init(evlog_t* self, const char* label)
+{
+    evlog_result_t res = { .tag = EVLOG_STATUS_OK };
+    if (!self || !label) {
+        res.tag = EVLOG_STATUS_ARG_ERR;
+        return res;
+    }
+    memset(self, 0, sizeof(*self));
+
+    self->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (self->part == NULL || self->part->size < 2 * EVLOG_SECTOR_SIZE) {
+        res.tag = EVLOG_STATUS_NO_PARTITION;
+        return res;
+    }
+    self->sectors = self->part->size / EVLOG_SECTOR_SIZE;
+
+    /* an empty log starts in sector 0 with the first write */
+    self->sector = self->sectors - 1;
+    self->slot = EVLOG_SLOTS;
+
+    bool found = false;
+    uint32_t sector = 0;
+    for (sector = 0; sector < self->sectors; ++sector) {
+        bool valid = false;
+        uint32_t seq = 0;
+        const esp_err_t rc = read_hdr(self, sector, &valid, &seq);
+        if (rc != ESP_OK) {
+            return flash_err(rc);
+        }
+        if (valid && (!found || seq > self->sector_seq)) {
+            found = true;
+            self->sector = sector;
+            self->sector_seq = seq;
+        }
+    }
+
+    if (found) {
+        const esp_err_t rc = find_free_slot(self);
+        if (rc != ESP_OK) {
+            return flash_err(rc);
+        }
+    }
+    return res;
+}
+
+evlog_result_t evlog_append(evlog_t* self, const evlog_record_t* record)
+{
+    evlog_result_t res = { .tag = EVLOG_STATUS_OK };
+    if (!self || self->part == NULL || !record || record->type == UINT16_MAX) {
+        res.tag = EVLOG_STATUS_ARG_ERR;
+        return res;
+    }
+
+    evlog_frame_t* frame = &self->batch[self->pending];
+    frame->t_ms = record->t_ms;
+    frame->seq = self->next_seq;
+    frame->type = record->type;
+    frame->arg = record->arg;
+    frame->value = record->value;
+    frame->crc = frame_crc(frame);
+    self->next_seq += 1;
+    self->pending += 1;
+    self->appended += 1;
+
+    if (self->pending == EVLOG_BATCH) {
+        return evlog_sync(self);
+    }
+    return res;
+}
+
+evlog_result_t evlog_sync(evlog_t* self)
+{
+    evlog_result_t res = { .tag = EVLOG_STATUS_OK };
+    if (!self || self->part == NULL) {
+        res.tag = EVLOG_STATUS_ARG_ERR;
+        return res;
+    }
+
+    uint32_t done = 0;
+    while (done < self->pending) {
+        esp_err_t rc = ESP_OK;
+        if (self->slot == EVLOG_SLOTS) {
+            rc = open_next_sector(self);
+        }
+        if (rc == ESP_OK) {
+            uint32_t count = self->pending - done;
+            if (count > EVLOG_SLOTS - self->slot) {
+                count = EVLOG_SLOTS - self->slot;
+            }
+            rc = esp_partition_write(
+                self->part, slot_offset(self->sector, self->slot), &self->batch[done], count * sizeof(evlog_frame_t));
+            /* never program these slots again, whether the write finished or not */
+            self->slot += count;
+            if (rc != ESP_OK) {
+                self->dropped += count;
+            }
+            done += count;
+        } else {
+            self->dropped += self->pending - done;
+            done = self->pending;
+        }
+        if (rc != ESP_OK) {
+            res = flash_err(rc);
+        }
+    }
+    self->pending = 0;
+    return res;
+}
+
+evlog_result_t evlog_read(evlog_t* self, evlog_visit_fn_t fn, void* ctx)
+{
+    evlog_result_t res = { .tag = EVLOG_STATUS_OK };
+    if (!self || self->part == NULL || !fn) {
+        res.tag = EVLOG_STATUS_ARG_ERR;
+        return res;
+    }
+
+    uint32_t k = 0;
+    /* sectors are used in ring order, the one after the current sector is the oldest */
+    for (k = 1; k <= self->sectors; ++k) {
+        const uint32_t sector = (self->sector + k) % self->sectors;
+        bool valid = false;
+        uint32_t seq = 0;
+        esp_err_t rc = read_hdr(self, sector, &valid, &seq);
+        if (rc != ESP_OK) {
+            return flash_err(rc);
+        }
+        if (!valid) {
+            continue;
+        }
+
+        uint32_t slot = 0;
+        while (slot < EVLOG_SLOTS) {
+            evlog_frame_t frames[EVLOG_READ_CHUNK];
+            uint32_t count = EVLOG_SLOTS - slot;
+            if (count > EVLOG_READ_CHUNK) {
+                count = EVLOG_READ_CHUNK;
+            }
+            rc = esp_partition_read(self->part, slot_offset(sector, slot), frames, count * sizeof(frames[0]));
+            if (rc != ESP_OK) {
+                return flash_err(rc);
+            }
+            uint32_t i = 0;
+            for (i = 0; i < count; ++i) {
+                if (is_erased(&frames[i], sizeof(frames[i]))) {
+                    slot = EVLOG_SLOTS;
+                    break;
+                }
+                if (frames[i].crc != frame_crc(&frames[i])) {
+                    self->torn += 1;
+                    continue;
+                }
+                const evlog_record_t record = {
+                    .t_ms = frames[i].t_ms,
+                    .type = frames[i].type,
+                    .arg = frames[i].arg,
+                    .value = frames[i].value,
+                };
+                if (!fn(ctx, frames[i].seq, &record)) {
+                    return res;
+                }
+            }
+            if (slot < EVLOG_SLOTS) {
+                slot += count;
+            }
+        }
+    }
+    return res;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file evlog.h
+ * @brief Append-only event log on a raw flash partition.
+ *
+ * The partition is a ring of 4 KB sectors. A sector starts with a header that
+ * holds its sequence number, then fixed-size records, each with its own
+ * CRC-32. Records are only ever programmed into erased flash and a sector is
+ * only erased when the log moves into it, so every sector is erased once per
+ * pass over the ring.
+ *
+ * Appended records wait in RAM and are written together by `evlog_sync()`
+ * (or when `EVLOG_BATCH` are waiting), one flash write per batch.
+ *
+ * At boot the sector headers give the newest sector, then a binary search
+ * over its slots finds the first erased one, the next write position. A
+ * record torn by a reset fails its CRC, is skipped by readers and not
+ * overwritten.
+ *
+ * The API follows the project's tagged-union result pattern: functions return
+ * `evlog_result_t` which carries both a status tag and any error code.
+ */
+
+#ifndef EVLOG_H
+#define EVLOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "esp_partition.h"
+
+/** Sector size, the erase unit */
+#define EVLOG_SECTOR_SIZE 4096
+/** Records kept in RAM before they are written */
+#define EVLOG_BATCH 16
+
+/**
+ * @brief Status tags for event log operations.
+ */
+typedef enum evlog_status_tag_e {
+    EVLOG_STATUS_OK = 0,
+    EVLOG_STATUS_FLASH_ERR,
+    EVLOG_STATUS_ARG_ERR,
+    EVLOG_STATUS_NO_PARTITION,
+} evlog_status_tag_t;
+
+/**
+ * @brief Event types, stored in the log: only append new values.
+ */
+typedef enum evlog_type_e {
+    EVLOG_BOOT = 1,       /**< value: `esp_reset_reason()` */
+    EVLOG_SSR_SET,        /**< value: 1 on, 0 off (not logged for the 1 s test toggle) */
+    EVLOG_SSR_STATUS,     /**< SSR I2C status changed, arg: `ssr_status_tag_t`, value: esp_err_t */
+    EVLOG_TH_STATUS,      /**< thermocouple status changed, arg: `th_status_tag_t`, value: esp_err_t or error_status */
+    EVLOG_DOOR,           /**< value: 1 open, 0 closed (no door switch is wired yet) */
+    EVLOG_DEFROST,        /**< value: 1 start, 0 end (no defrost heater is wired yet) */
+} evlog_type_t;
+
+/**
+ * @brief One event as appended and read back.
+ */
+typedef struct evlog_record_s {
+    int64_t t_ms;   /**< wall-clock time */
+    uint16_t type;  /**< `evlog_type_t` */
+    uint16_t arg;
+    int32_t value;
+} evlog_record_t;
+
+/**
+ * @brief Record as stored, a multiple of the 4-byte flash write unit.
+ */
+typedef struct evlog_frame_s {
+    int64_t t_ms;
+    uint32_t seq;   /**< increases with every record, a gap means records were lost */
+    uint16_t type;
+    uint16_t arg;
+    int32_t value;
+    uint32_t crc;   /**< CRC-32 of the frame up to here */
+} evlog_frame_t;
+
+typedef struct evlog_s {
+    const esp_partition_t *part;
+    uint32_t sectors;
+    uint32_t sector;             /**< sector written to */
+    uint32_t sector_seq;         /**< its sequence number */
+    uint32_t slot;               /**< next free record slot in it */
+    uint32_t next_seq;           /**< sequence number of the next record */
+    evlog_frame_t batch[EVLOG_BATCH];
+    uint32_t pending;            /**< records in `batch` */
+    uint32_t appended;           /**< records since boot */
+    uint32_t dropped;            /**< records lost to flash errors */
+    uint32_t sectors_erased;
+    uint32_t torn;               /**< records skipped because of a CRC mismatch, at boot and by reads */
+} evlog_t;
+
+/**
+ * @brief Tagged-union return for event log calls.
+ */
+typedef struct evlog_result_s {
+    evlog_status_tag_t tag;
+    union {
+        esp_err_t esp_code; /**< underlying flash error when tag is FLASH_ERR */
+        uint32_t reserved;
+    } value;
+} evlog_result_t;
+
+/**
+ * @brief Called for every record, oldest first. Return false to stop.
+ */
+typedef bool (*evlog_visit_fn_t)(void *ctx, uint32_t seq, const evlog_record_t *record);
+
+/**
+ * @brief Find the write position on a data partition.
+ *
+ * Reads one header per sector and O(log n) record slots of the newest one.
+ *
+ * @param label partition label, `EVLOG_STATUS_NO_PARTITION` if there is none
+ */
+evlog_result_t evlog_init(evlog_t *self, const char *label);
+
+/**
+ * @brief Add a record, written with the next `evlog_sync()` or once the batch is full.
+ *
+ * The log has a single writer, all calls must come from one task.
+ */
+evlog_result_t evlog_append(evlog_t *self, const evlog_record_t *record);
+
+/**
+ * @brief Write the records waiting in RAM.
+ */
+evlog_result_t evlog_sync(evlog_t *self);
+
+/**
+ * @brief Visit the records on flash, oldest first. Call from the writing task.
+ */
+evlog_result_t evlog_read(evlog_t *self, evlog_visit_fn_t fn, void *ctx);
+
+#endif // EVLOG_H
@@ -0,0 +1,246 @@
+#include "i2c_async.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include <string.h>
+
+/* Called from the I2C ISR once per transaction of the device. The driver runs
+ * the transactions in queue order, so the oldest request in flight is the one
+ * that finished. */
+static bool IRAM_ATTR on_trans_done(
+    i2c_master_dev_handle_t dev, const i2c_master_event_data_t* evt_data, void* arg)
+{
+    (void)dev;
+    i2c_async_dev_t* self = (i2c_async_dev_t*)arg;
+    if (evt_data->event == I2C_EVENT_ALIVE) {
+        return false;
+    }
+
+    i2c_async_req_t* req = NULL;
+    portENTER_CRITICAL_ISR(&self->lock);
+    if (self->count > 0) {
+        req = self->inflight[self->head];
+        self->head = (self->head + 1) & (I2C_ASYNC_DEV_DEPTH - 1);
+        self->count -= 1;
+        if (evt_data->event != I2C_EVENT_DONE) {
+            self->failed += 1;
+            self->errors_seen += 1;
+        }
+    }
+    portEXIT_CRITICAL_ISR(&self->lock);
+    if (req == NULL) {
+        return false;
+    }
+
+    if (evt_data->event == I2C_EVENT_DONE) {
+        req->result = ESP_OK;
+    } else {
+        req->result = (evt_data->event == I2C_EVENT_NACK) ? ESP_ERR_INVALID_RESPONSE : ESP_ERR_TIMEOUT;
+    }
+
+    BaseType_t woken = pdFALSE;
+    xQueueSendFromISR(req->done_queue, &req, &woken);
+    return woken == pdTRUE;
+}
+
+/* Add the device to the bus with the given clock and take over its completions */
+static esp_err_t add_device(i2c_async_dev_t* self, uint32_t scl_hz)
+{
+    const i2c_device_config_t dev_cfg = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = self->addr,
+        .scl_speed_hz = scl_hz,
+    };
+    esp_err_t rc = i2c_master_bus_add_device(self->bus, &dev_cfg, &self->dev);
+    if (rc != ESP_OK) {
+        self->dev = NULL;
+        return rc;
+    }
+    const i2c_master_event_callbacks_t cbs = { .on_trans_done = on_trans_done };
+    rc = i2c_master_register_event_callbacks(self->dev, &cbs, self);
+    if (rc != ESP_OK) {
+        i2c_master_bus_rm_device(self->dev);
+        self->dev = NULL;
+        return rc;
+    }
+    self->scl_hz = scl_hz;
+    return ESP_OK;
+}
+
+/* Pick the SCL clock for the next transactions, only called with no request in flight */
+static void adjust_speed(i2c_async_dev_t* self)
+{
+    const int64_t now_us = esp_timer_get_time();
+    uint32_t errors = 0;
+    portENTER_CRITICAL(&self->lock);
+    errors = self->errors_seen;
+    self->errors_seen = 0;
+    portEXIT_CRITICAL(&self->lock);
+
+    uint32_t target_hz = self->scl_hz;
+    if (errors > 0) {
+        self->stable_since_us = now_us;
+        if (self->probing) {
+            /* the faster rate did not hold, try it less often */
+            self->step_up_wait_ms = self->step_up_wait_ms * 2;
+            if (self->step_up_wait_ms > I2C_ASYNC_STEP_UP_MAX_MS) {
+                self->step_up_wait_ms = I2C_ASYNC_STEP_UP_MAX_MS;
+            }
+            self->probing = false;
+        }
+        if (self->scl_hz / 2 >= I2C_ASYNC_MIN_HZ) {
+            target_hz = self->scl_hz / 2;
+        }
+    } else if (now_us - self->stable_since_us >= (int64_t)self->step_up_wait_ms * 1000) {
+        if (self->probing) {
+            /* the faster rate held for a full period */
+            self->probing = false;
+            self->step_up_wait_ms = I2C_ASYNC_STEP_UP_MS;
+        }
+        if (self->scl_hz < self->max_hz) {
+            target_hz = self->scl_hz * 2;
+            if (target_hz > self->max_hz) {
+                target_hz = self->max_hz;
+            }
+            self->probing = true;
+        }
+        self->stable_since_us = now_us;
+    }
+
+    if (self->dev != NULL && target_hz == self->scl_hz) {
+        return;
+    }
+    /* the clock is fixed per device handle, add the device again */
+    if (self->dev != NULL) {
+        if (i2c_master_bus_rm_device(self->dev) != ESP_OK) {
+            return;
+        }
+        self->dev = NULL;
+    }
+    const uint32_t old_hz = self->scl_hz;
+    if (add_device(self, target_hz) != ESP_OK) {
+        /* stay on the old clock, or try again with the next request */
+        add_device(self, old_hz);
+        return;
+    }
+    if (target_hz < old_hz) {
+        self->step_downs += 1;
+    } else if (target_hz > old_hz) {
+        self->step_ups += 1;
+    }
+}
+
+esp_err_t i2c_async_dev_init(
+    i2c_async_dev_t* self, i2c_master_bus_handle_t bus, uint16_t addr, uint32_t scl_hz, uint32_t timeout_ms)
+{
+    if (!self || bus == NULL || scl_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(self, 0, sizeof(*self));
+    self->bus = bus;
+    self->addr = addr;
+    self->timeout_ms = timeout_ms;
+    self->max_hz = scl_hz;
+    self->step_up_wait_ms = I2C_ASYNC_STEP_UP_MS;
+    self->stable_since_us = esp_timer_get_time();
+    portMUX_INITIALIZE(&self->lock);
+
+    self->sync_queue = xQueueCreate(I2C_ASYNC_DEV_DEPTH, sizeof(i2c_async_req_t*));
+    if (self->sync_queue == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t rc = add_device(self, scl_hz);
+    if (rc != ESP_OK) {
+        vQueueDelete(self->sync_queue);
+        self->sync_queue = NULL;
+    }
+    return rc;
+}
+
+void i2c_async_dev_deinit(i2c_async_dev_t* self)
+{
+    if (!self) {
+        return;
+    }
+    if (self->dev != NULL) {
+        i2c_master_bus_rm_device(self->dev);
+    }
+    if (self->sync_queue != NULL) {
+        vQueueDelete(self->sync_queue);
+    }
+    memset(self, 0, sizeof(*self));
+}
+
+esp_err_t i2c_async_submit(i2c_async_dev_t* self, i2c_async_req_t* req)
+{
+    if (!self || self->bus == NULL || !req || req->done_queue == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (req->ops == NULL && (req->tx_len == 0 || req->tx_len > I2C_ASYNC_TX_MAX)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* only the submitter adds requests, so an empty ring stays empty until this one is queued */
+    if (self->count == 0) {
+        adjust_speed(self);
+    }
+    if (self->dev == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    /* take the slot before queueing, the transaction may finish before the driver call returns */
+    portENTER_CRITICAL(&self->lock);
+    if (self->count == I2C_ASYNC_DEV_DEPTH) {
+        portEXIT_CRITICAL(&self->lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    self->inflight[(self->head + self->count) & (I2C_ASYNC_DEV_DEPTH - 1)] = req;
+    self->count += 1;
+    if (self->count > self->max_inflight) {
+        self->max_inflight = self->count;
+    }
+    portEXIT_CRITICAL(&self->lock);
+
+    req->result = ESP_ERR_INVALID_STATE; /* pending */
+    esp_err_t rc = ESP_FAIL;
+    const int timeout_ms = (int)self->timeout_ms;
+    if (req->ops != NULL) {
+        rc = i2c_master_execute_defined_operations(self->dev, req->ops, req->ops_num, timeout_ms);
+    } else if (req->rx != NULL) {
+        rc = i2c_master_transmit_receive(self->dev, req->tx, req->tx_len, req->rx, req->rx_len, timeout_ms);
+    } else {
+        rc = i2c_master_transmit(self->dev, req->tx, req->tx_len, timeout_ms);
+    }
+
+    if (rc != ESP_OK) {
+        /* not queued, no completion comes for it. It is the newest entry, there is one submitter per device. */
+        portENTER_CRITICAL(&self->lock);
+        self->count -= 1;
+        self->failed += 1;
+        portEXIT_CRITICAL(&self->lock);
+        req->result = rc;
+        return rc;
+    }
+    self->submitted += 1;
+    return ESP_OK;
+}
+
+esp_err_t i2c_async_transfer(i2c_async_dev_t* self, i2c_async_req_t* req)
+{
+    if (!self || !req) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    req->done_queue = self->sync_queue;
+    esp_err_t rc = i2c_async_submit(self, req);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    /* the driver reports every queued transaction, at the latest with a timeout
+     * event, and `req` must outlive it, so wait without a limit */
+    i2c_async_req_t* done = NULL;
+    while (done != req) {
+        xQueueReceive(self->sync_queue, &done, portMAX_DELAY);
+    }
+    return req->result;
+}
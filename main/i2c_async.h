@@ -0,0 +1,123 @@
+/**
+ * @file i2c_async.h
+ * @brief Non-blocking I2C transactions on top of the master driver's queued mode.
+ *
+ * When the bus is created with `trans_queue_depth > 0`, `i2c_master_transmit*()`
+ * only queue the transaction and return, the driver reports completion from its
+ * ISR. This module keeps the requests of one device in submission order, matches
+ * every completion to its request and posts the request to the queue named in
+ * it. A single task can so keep several devices busy and wait on one queue for
+ * whichever finishes first.
+ *
+ * On a queued bus every transaction completes asynchronously, so the blocking
+ * device APIs (`ssr_*`, `th_*`) use `i2c_async_transfer()` as well.
+ *
+ * The SCL clock is chosen per device. It starts at the configured rate, a
+ * NACK or timeout halves it (down to `I2C_ASYNC_MIN_HZ`), and after
+ * `I2C_ASYNC_STEP_UP_MS` without errors the next faster rate is tried again.
+ * A faster rate that fails again is retried after twice the time, up to
+ * `I2C_ASYNC_STEP_UP_MAX_MS`. The driver fixes the clock per device handle,
+ * so the device is added again with the new rate, while none of its requests
+ * are in flight.
+ */
+
+#ifndef I2C_ASYNC_H
+#define I2C_ASYNC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "driver/i2c_master.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+/** Requests one device can have in flight, a power of two */
+#define I2C_ASYNC_DEV_DEPTH 4
+/** Bytes written before the optional read (register address and data) */
+#define I2C_ASYNC_TX_MAX 4
+/** Slowest SCL clock the rate is lowered to */
+#define I2C_ASYNC_MIN_HZ 100000
+/** Error-free time before a faster SCL clock is tried */
+#define I2C_ASYNC_STEP_UP_MS 10000
+/** Longest wait before trying again a rate that failed before */
+#define I2C_ASYNC_STEP_UP_MAX_MS 320000
+
+/**
+ * @brief One I2C transaction.
+ *
+ * The request and every buffer it points to must stay valid until it has been
+ * posted to `done_queue`.
+ */
+typedef struct i2c_async_req_s {
+    uint8_t tx[I2C_ASYNC_TX_MAX]; /**< bytes written first */
+    size_t tx_len;
+    uint8_t *rx;                  /**< read after a repeated START, NULL for a write only */
+    size_t rx_len;
+    i2c_operation_job_t *ops;     /**< own operation list instead of tx/rx, NULL if unused */
+    size_t ops_num;
+    QueueHandle_t done_queue;     /**< receives the `i2c_async_req_t *` when the transaction is over */
+    void *ctx;                    /**< owner of the request, for the task reading `done_queue` */
+    esp_err_t result;             /**< ESP_OK, ESP_ERR_INVALID_RESPONSE on NACK or ESP_ERR_TIMEOUT */
+} i2c_async_req_t;
+
+/**
+ * @brief Per-device state, embedded in the device driver object.
+ *
+ * Requests of one device must be submitted from one task at a time.
+ */
+typedef struct i2c_async_dev_s {
+    i2c_master_bus_handle_t bus;
+    i2c_master_dev_handle_t dev;                     /**< NULL while the device could not be added again */
+    uint16_t addr;                                   /**< 7-bit address */
+    uint32_t timeout_ms;
+    portMUX_TYPE lock;                               /**< guards the in-flight ring against the ISR */
+    i2c_async_req_t *inflight[I2C_ASYNC_DEV_DEPTH]; /**< oldest at `head` */
+    uint32_t head;
+    uint32_t count;
+    QueueHandle_t sync_queue;                        /**< completion queue of `i2c_async_transfer()` */
+    uint32_t submitted;                              /**< transactions queued to the driver */
+    uint32_t failed;                                 /**< completed with NACK or timeout, or not queued */
+    uint32_t max_inflight;                           /**< high-water mark of `count` */
+    uint32_t max_hz;                                 /**< configured SCL clock, the fastest rate tried */
+    uint32_t scl_hz;                                 /**< SCL clock in use */
+    uint32_t errors_seen;                            /**< failures since the last rate decision (ISR) */
+    int64_t stable_since_us;                         /**< last rate change or failure */
+    uint32_t step_up_wait_ms;                        /**< error-free time before the next faster rate */
+    bool probing;                                    /**< running on a faster rate not yet proven */
+    uint32_t step_downs;                             /**< rate lowered after an error */
+    uint32_t step_ups;                               /**< faster rate tried */
+} i2c_async_dev_t;
+
+/**
+ * @brief Add a device to a queued bus and register the completion callback.
+ *
+ * @param addr 7-bit device address
+ * @param scl_hz fastest SCL clock for the device, the rate it starts with
+ * @param timeout_ms transaction timeout handed to the driver
+ */
+esp_err_t i2c_async_dev_init(i2c_async_dev_t *self, i2c_master_bus_handle_t bus, uint16_t addr,
+                             uint32_t scl_hz, uint32_t timeout_ms);
+
+/**
+ * @brief Remove the device from the bus, no request may be in flight.
+ */
+void i2c_async_dev_deinit(i2c_async_dev_t *self);
+
+/**
+ * @brief Queue a transaction and return without waiting for it.
+ *
+ * @return ESP_OK when queued, the request then always comes back through
+ *         `done_queue`. ESP_ERR_INVALID_STATE when `I2C_ASYNC_DEV_DEPTH`
+ *         requests are in flight, or the driver error when it refused the
+ *         transaction (the request is not posted then).
+ */
+esp_err_t i2c_async_submit(i2c_async_dev_t *self, i2c_async_req_t *req);
+
+/**
+ * @brief Queue a transaction and block until it is over.
+ *
+ * @return result of the transaction
+ */
+esp_err_t i2c_async_transfer(i2c_async_dev_t *self, i2c_async_req_t *req);
+
+#endif // I2C_ASYNC_H
@@ -0,0 +1,79 @@
+#include "i2c_topology.h"
+#include "nvs_blob.h"
+
+static const char* g_nvs_namespace = "i2c_topo";
+static const char* g_nvs_key = "scan";
+
+/* bump when i2c_topology_t changes */
+static const uint32_t g_blob_version = 1;
+
+static i2c_topology_result_t nvs_err(esp_err_t rc)
+{
+    i2c_topology_result_t res = { .tag = I2C_TOPOLOGY_STATUS_NVS_ERR };
+    res.value.esp_code = rc;
+    return res;
+}
+
+void i2c_topology_add(i2c_topology_t* self, uint8_t addr)
+{
+    if (!self || addr > 0x7F) {
+        return;
+    }
+    self->present[addr / 32] |= (uint32_t)1 << (addr % 32);
+}
+
+bool i2c_topology_has(const i2c_topology_t* self, uint8_t addr)
+{
+    if (!self || addr > 0x7F) {
+        return false;
+    }
+    return (self->present[addr / 32] & ((uint32_t)1 << (addr % 32))) != 0;
+}
+
+uint32_t i2c_topology_count(const i2c_topology_t* self)
+{
+    uint32_t count = 0;
+    uint32_t i = 0;
+    if (!self) {
+        return 0;
+    }
+    for (i = 0; i < 4; ++i) {
+        count += (uint32_t)__builtin_popcount(self->present[i]);
+    }
+    return count;
+}
+
+i2c_topology_result_t i2c_topology_load(i2c_topology_t* out)
+{
+    i2c_topology_result_t res = { .tag = I2C_TOPOLOGY_STATUS_OK };
+    if (!out) {
+        res.tag = I2C_TOPOLOGY_STATUS_ARG_ERR;
+        return res;
+    }
+
+    esp_err_t rc = nvs_blob_load(g_nvs_namespace, g_nvs_key, g_blob_version, out, sizeof(*out));
+    if (rc == ESP_ERR_NVS_NOT_FOUND) {
+        res.tag = I2C_TOPOLOGY_STATUS_NOT_FOUND;
+        return res;
+    }
+    if (rc != ESP_OK) {
+        return nvs_err(rc);
+    }
+    return res;
+}
+
+i2c_topology_result_t i2c_topology_store(const i2c_topology_t* topology)
+{
+    i2c_topology_result_t res = { .tag = I2C_TOPOLOGY_STATUS_OK };
+    if (!topology) {
+        res.tag = I2C_TOPOLOGY_STATUS_ARG_ERR;
+        return res;
+    }
+
+    /* the bus rarely changes, most scans store what is already there and nvs_blob_store() writes nothing */
+    esp_err_t rc = nvs_blob_store(g_nvs_namespace, g_nvs_key, g_blob_version, topology, sizeof(*topology));
+    if (rc != ESP_OK) {
+        return nvs_err(rc);
+    }
+    return res;
+}
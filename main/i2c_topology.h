@@ -0,0 +1,80 @@
+/**
+ * @file i2c_topology.h
+ * @brief Set of 7-bit I2C addresses found on the bus, cached in NVS.
+ *
+ * A full bus scan probes over a hundred addresses and each absent or slow
+ * device costs a probe timeout. The result of the last full scan is kept in
+ * NVS, so a boot only has to confirm the expected devices against it.
+ * The API follows the project's tagged-union result pattern: functions return
+ * `i2c_topology_result_t` which carries both a status tag and any error code.
+ */
+
+#ifndef I2C_TOPOLOGY_H
+#define I2C_TOPOLOGY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+/** First and last address a full scan probes, the rest is reserved */
+#define I2C_TOPOLOGY_ADDR_FIRST 0x03
+#define I2C_TOPOLOGY_ADDR_LAST 0x77
+
+/**
+ * @brief Status tags for topology cache operations.
+ */
+typedef enum i2c_topology_status_tag_e {
+    I2C_TOPOLOGY_STATUS_OK = 0,
+    I2C_TOPOLOGY_STATUS_NVS_ERR,
+    I2C_TOPOLOGY_STATUS_ARG_ERR,
+    I2C_TOPOLOGY_STATUS_NOT_FOUND,
+} i2c_topology_status_tag_t;
+
+/**
+ * @brief Addresses present on the bus, one bit per 7-bit address.
+ */
+typedef struct i2c_topology_s {
+    uint32_t present[4]; /**< bit (addr % 32) of word (addr / 32) */
+} i2c_topology_t;
+
+/**
+ * @brief Tagged-union return for topology cache calls.
+ */
+typedef struct i2c_topology_result_s {
+    i2c_topology_status_tag_t tag;
+    union {
+        esp_err_t esp_code; /**< underlying NVS error when tag is NVS_ERR */
+        uint32_t reserved;
+    } value;
+} i2c_topology_result_t;
+
+/**
+ * @brief Mark an address as present.
+ */
+void i2c_topology_add(i2c_topology_t *self, uint8_t addr);
+
+/**
+ * @brief Whether an address is present.
+ */
+bool i2c_topology_has(const i2c_topology_t *self, uint8_t addr);
+
+/**
+ * @brief Number of addresses present.
+ */
+uint32_t i2c_topology_count(const i2c_topology_t *self);
+
+/**
+ * @brief Read the topology of the last full scan.
+ *
+ * `nvs_flash_init()` must have been called.
+ *
+ * @return i2c_topology_result_t `I2C_TOPOLOGY_STATUS_NOT_FOUND` if no scan is stored
+ */
+i2c_topology_result_t i2c_topology_load(i2c_topology_t *out);
+
+/**
+ * @brief Store a full scan result, flash is only written when it differs from the stored one.
+ */
+i2c_topology_result_t i2c_topology_store(const i2c_topology_t *topology);
+
+#endif /* I2C_TOPOLOGY_H */
@@ -0,0 +1,124 @@
+#include "job_sched.h"
+#include <string.h>
+
+static void on_deadline(void* arg)
+{
+    job_sched_t* self = (job_sched_t*)arg;
+    xTaskNotifyGive(self->task);
+}
+
+esp_err_t job_sched_init(job_sched_t* self)
+{
+    if (!self) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(self, 0, sizeof(*self));
+
+    const esp_timer_create_args_t args = {
+        .callback = on_deadline,
+        .arg = self,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "job_sched",
+    };
+    return esp_timer_create(&args, &self->timer);
+}
+
+esp_err_t job_sched_add(job_sched_t* self, const char* name, uint32_t period_ms, uint32_t phase_ms,
+    job_sched_fn_t fn, void* ctx)
+{
+    if (!self || !name || !fn || period_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (self->count == JOB_SCHED_JOBS_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    job_sched_job_t* job = &self->jobs[self->count];
+    memset(job, 0, sizeof(*job));
+    job->name = name;
+    job->fn = fn;
+    job->ctx = ctx;
+    job->period_us = (int64_t)period_ms * 1000;
+    job->next_us = (int64_t)phase_ms * 1000;
+    self->count += 1;
+    return ESP_OK;
+}
+
+static void run_job(job_sched_t* self, job_sched_job_t* job, int64_t start_us)
+{
+    const int64_t jitter_us = start_us - job->next_us;
+    self->done = false;
+    job->fn(job->ctx);
+    const int64_t end_us = esp_timer_get_time();
+
+    job->runs += 1;
+    job->jitter_sum_us += jitter_us;
+    if (jitter_us > job->jitter_max_us) {
+        job->jitter_max_us = jitter_us;
+    }
+    if (end_us - start_us > job->exec_max_us) {
+        job->exec_max_us = end_us - start_us;
+    }
+
+    if (self->done) {
+        /* never due again, and never the nearest deadline */
+        job->next_us = INT64_MAX;
+        return;
+    }
+    job->next_us += job->period_us;
+    if (job->next_us <= end_us) {
+        /* drop the missed releases, the job keeps its phase */
+        const int64_t missed = (end_us - job->next_us) / job->period_us + 1;
+        job->overruns += (uint32_t)missed;
+        job->next_us += missed * job->period_us;
+    }
+}
+
+void job_sched_run(job_sched_t* self)
+{
+    uint32_t i = 0;
+    self->task = xTaskGetCurrentTaskHandle();
+    const int64_t start_us = esp_timer_get_time();
+    for (i = 0; i < self->count; ++i) {
+        self->jobs[i].next_us += start_us;
+    }
+
+    while (true) {
+        int64_t now_us = esp_timer_get_time();
+        for (i = 0; i < self->count; ++i) {
+            if (self->jobs[i].next_us <= now_us) {
+                self->release_us = self->jobs[i].next_us;
+                run_job(self, &self->jobs[i], now_us);
+                now_us = esp_timer_get_time();
+            }
+        }
+
+        int64_t wake_us = INT64_MAX;
+        for (i = 0; i < self->count; ++i) {
+            if (self->jobs[i].next_us < wake_us) {
+                wake_us = self->jobs[i].next_us;
+            }
+        }
+        if (wake_us == INT64_MAX) {
+            /* no jobs, or all done */
+            vTaskSuspend(NULL);
+            continue;
+        }
+        if (wake_us <= now_us) {
+            continue;
+        }
+
+        /* a wake-up without a due job (stale notification) just arms the timer again */
+        esp_timer_stop(self->timer);
+        if (esp_timer_start_once(self->timer, (uint64_t)(wake_us - now_us)) != ESP_OK) {
+            vTaskDelay(1);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+void job_sched_done(job_sched_t* self)
+{
+    self->done = true;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file job_sched.h
+ * @brief Periodic jobs released at absolute deadlines from one task.
+ *
+ * Every job has a period and a phase. Its deadlines are fixed multiples of
+ * the period from the start of `job_sched_run()`, so the time a job takes
+ * does not shift the next release. The task sleeps on a one-shot `esp_timer`
+ * armed for the nearest deadline, which resolves microseconds instead of the
+ * FreeRTOS tick (`vTaskDelay()` rounds to 10 ms at `CONFIG_FREERTOS_HZ=100`).
+ *
+ * A job still running at its next deadline skips the releases it missed and
+ * keeps its phase, each skipped release counts as an overrun. A job that has
+ * nothing left to do ends itself with `job_sched_done()`.
+ */
+
+#ifndef JOB_SCHED_H
+#define JOB_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/** Jobs one scheduler can hold */
+#define JOB_SCHED_JOBS_MAX 8
+
+typedef void (*job_sched_fn_t)(void *ctx);
+
+/**
+ * @brief One periodic job and its timing statistics.
+ */
+typedef struct job_sched_job_s {
+    const char *name;
+    job_sched_fn_t fn;
+    void *ctx;
+    int64_t period_us;
+    int64_t next_us;       /**< next release, relative to the start until `job_sched_run()` */
+    uint32_t runs;
+    uint32_t overruns;     /**< releases skipped because the job was still running */
+    int64_t jitter_sum_us; /**< sum of the start delays after the release */
+    int64_t jitter_max_us; /**< longest start delay after a release */
+    int64_t exec_max_us;   /**< longest run of `fn` */
+} job_sched_job_t;
+
+/**
+ * @brief Scheduler state, jobs run in the task that calls `job_sched_run()`.
+ */
+typedef struct job_sched_s {
+    job_sched_job_t jobs[JOB_SCHED_JOBS_MAX];
+    uint32_t count;
+    esp_timer_handle_t timer; /**< wakes the task at the nearest deadline */
+    TaskHandle_t task;
+    int64_t release_us;       /**< deadline the running job was released for, `esp_timer_get_time()` time */
+    bool done;                /**< the running job called `job_sched_done()` */
+} job_sched_t;
+
+/**
+ * @brief Create the wake-up timer of an empty scheduler.
+ */
+esp_err_t job_sched_init(job_sched_t *self);
+
+/**
+ * @brief Add a job before `job_sched_run()`.
+ *
+ * @param name label for the statistics, must stay valid
+ * @param period_ms time between releases
+ * @param phase_ms first release after the start, spreads jobs with the same period apart
+ * @return ESP_ERR_NO_MEM when `JOB_SCHED_JOBS_MAX` jobs are added
+ */
+esp_err_t job_sched_add(job_sched_t *self, const char *name, uint32_t period_ms, uint32_t phase_ms,
+                        job_sched_fn_t fn, void *ctx);
+
+/**
+ * @brief Run the jobs in the calling task, does not return.
+ *
+ * Jobs due at the same time run in the order they were added.
+ */
+void job_sched_run(job_sched_t *self);
+
+/**
+ * @brief Called by a running job: it is not released again, its statistics stay.
+ */
+void job_sched_done(job_sched_t *self);
+
+#endif // JOB_SCHED_H
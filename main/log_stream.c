@@ -0,0 +1,143 @@
+#include "log_stream.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_timer.h"
+#include "lwip/sockets.h"
+
+esp_err_t log_stream_init(log_stream_t* self, const char* host, uint16_t port)
+{
+    if (!self || !host) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    struct in_addr addr;
+    if (inet_pton(AF_INET, host, &addr) != 1) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(self, 0, sizeof(*self));
+    portMUX_INITIALIZE(&self->lock);
+    self->sock = -1;
+    self->addr = addr.s_addr;
+    self->port = port;
+    return ESP_OK;
+}
+
+/* Copy one line into the ring, under `lock` */
+static bool log_stream_put(log_stream_t* self, const char* line, size_t len)
+{
+    if (len > LOG_STREAM_BUF_SIZE - (self->head - self->tail)) {
+        self->dropped += 1;
+        return false;
+    }
+    const uint32_t at = self->head % LOG_STREAM_BUF_SIZE;
+    const size_t first = (len < LOG_STREAM_BUF_SIZE - at) ? len : LOG_STREAM_BUF_SIZE - at;
+    memcpy(&self->buf[at], line, first);
+    memcpy(self->buf, line + first, len - first);
+    self->head += len;
+    self->lines += 1;
+    return true;
+}
+
+bool log_stream_write(log_stream_t* self, const char* line, size_t len)
+{
+    const int64_t start_us = esp_timer_get_time();
+    portENTER_CRITICAL(&self->lock);
+    if (len > LOG_STREAM_LINE_MAX - 1) {
+        /* cut, but still a line */
+        len = LOG_STREAM_LINE_MAX - 1;
+        memcpy(self->line, line, len - 1);
+        self->line[len - 1] = '\n';
+        line = self->line;
+    }
+    const bool ok = log_stream_put(self, line, len);
+    self->busy_us += esp_timer_get_time() - start_us;
+    portEXIT_CRITICAL(&self->lock);
+    return ok;
+}
+
+int log_stream_vprintf(log_stream_t* self, const char* fmt, va_list args)
+{
+    const int64_t start_us = esp_timer_get_time();
+    portENTER_CRITICAL(&self->lock);
+    /* one line buffer for all writers, so it is only used under the lock */
+    const int len = vsnprintf(self->line, sizeof(self->line), fmt, args);
+    if (len >= 0) {
+        size_t n = (size_t)len;
+        if (n >= sizeof(self->line)) {
+            /* cut, but still a line */
+            n = sizeof(self->line) - 1;
+            self->line[n - 1] = '\n';
+        }
+        log_stream_put(self, self->line, n);
+    }
+    self->busy_us += esp_timer_get_time() - start_us;
+    portEXIT_CRITICAL(&self->lock);
+    return len;
+}
+
+/* Copy the next datagram out of the ring, ending at a line end unless the rest fits */
+static size_t log_stream_take(log_stream_t* self, uint32_t avail)
+{
+    size_t len = (avail < LOG_STREAM_DATAGRAM) ? avail : LOG_STREAM_DATAGRAM;
+    const uint32_t at = self->tail % LOG_STREAM_BUF_SIZE;
+    const size_t first = (len < LOG_STREAM_BUF_SIZE - at) ? len : LOG_STREAM_BUF_SIZE - at;
+    memcpy(self->datagram, &self->buf[at], first);
+    memcpy(&self->datagram[first], self->buf, len - first);
+
+    if (avail > len) {
+        size_t end = len;
+        while (end > 0 && self->datagram[end - 1] != '\n') {
+            --end;
+        }
+        if (end > 0) {
+            len = end;
+        }
+    }
+    return len;
+}
+
+uint32_t log_stream_flush(log_stream_t* self, bool partial)
+{
+    const int64_t start_us = esp_timer_get_time();
+    if (self->sock < 0) {
+        self->sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (self->sock < 0) {
+            return 0;
+        }
+    }
+    struct sockaddr_in to = { 0 };
+    to.sin_family = AF_INET;
+    to.sin_port = htons(self->port);
+    to.sin_addr.s_addr = self->addr;
+
+    uint32_t sent = 0;
+    while (true) {
+        portENTER_CRITICAL(&self->lock);
+        const uint32_t avail = self->head - self->tail;
+        portEXIT_CRITICAL(&self->lock);
+        if (avail == 0 || (avail < LOG_STREAM_DATAGRAM && !partial)) {
+            break;
+        }
+
+        /* writers only add after head, the bytes up to head stay as they are while they are copied */
+        const size_t len = log_stream_take(self, avail);
+        const bool ok = sendto(self->sock, self->datagram, len, 0, (const struct sockaddr*)&to, sizeof(to)) >= 0;
+
+        portENTER_CRITICAL(&self->lock);
+        self->tail += len;
+        if (ok) {
+            self->datagrams += 1;
+            self->bytes_sent += len;
+        } else {
+            self->send_errors += 1;
+        }
+        portEXIT_CRITICAL(&self->lock);
+        if (ok) {
+            sent += 1;
+        }
+    }
+
+    portENTER_CRITICAL(&self->lock);
+    self->busy_us += esp_timer_get_time() - start_us;
+    portEXIT_CRITICAL(&self->lock);
+    return sent;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file log_stream.h
+ * @brief Log lines batched into UDP datagrams for a remote collector.
+ *
+ * Any task hands in formatted lines with `log_stream_write()`, or has them
+ * formatted with `log_stream_vprintf()`, they are copied into a byte ring
+ * under a spinlock. One sender task calls
+ * `log_stream_flush()`, which cuts the ring into datagrams of up to
+ * `LOG_STREAM_DATAGRAM` bytes at line ends and sends them, so a collector
+ * gets whole lines and one datagram carries many of them. A line that does
+ * not fit into the ring is dropped and counted, the writer never waits.
+ *
+ * The payload is plain text, one line per `\n`: `nc -klu <port>` shows it.
+ */
+
+#ifndef LOG_STREAM_H
+#define LOG_STREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <esp_err.h>
+#include "freertos/FreeRTOS.h"
+
+/** Byte ring, a power of two */
+#define LOG_STREAM_BUF_SIZE 4096
+/** UDP payload that fills a 1500 byte MTU */
+#define LOG_STREAM_DATAGRAM 1472
+/** Line buffer, longer lines are cut to `LOG_STREAM_LINE_MAX` - 1 bytes ending with `\n` */
+#define LOG_STREAM_LINE_MAX 256
+
+typedef struct log_stream_s {
+    uint8_t buf[LOG_STREAM_BUF_SIZE];
+    uint32_t head;          /**< bytes written, under `lock` */
+    uint32_t tail;          /**< bytes sent, written by the sender under `lock` */
+    portMUX_TYPE lock;
+    char line[LOG_STREAM_LINE_MAX]; /**< a line being formatted or cut, under `lock` */
+    uint8_t datagram[LOG_STREAM_DATAGRAM];
+    int sock;
+    uint32_t addr;          /**< collector IPv4, network order */
+    uint16_t port;
+    uint32_t lines;
+    uint32_t dropped;       /**< lines refused because the ring was full */
+    uint32_t datagrams;
+    uint32_t bytes_sent;
+    uint32_t send_errors;
+    int64_t busy_us;        /**< time spent copying and sending */
+} log_stream_t;
+
+/**
+ * @brief Set up an empty stream. No socket yet, lines are kept until the first flush.
+ *
+ * @param host collector IPv4 address, dotted
+ * @return ESP_ERR_INVALID_ARG when `host` is not an IPv4 address
+ */
+esp_err_t log_stream_init(log_stream_t *self, const char *host, uint16_t port);
+
+/**
+ * @brief Queue one formatted line, any task, not from an ISR.
+ *
+ * A line longer than `LOG_STREAM_LINE_MAX` - 1 bytes is cut and ends with `\n`.
+ *
+ * @return false when the ring is full, the line is dropped and counted
+ */
+bool log_stream_write(log_stream_t *self, const char *line, size_t len);
+
+/**
+ * @brief Format one line straight into the stream, any task, not from an ISR.
+ *
+ * Formats under the spinlock into the stream's own line buffer, so callers need
+ * no buffer on their stack. A line longer than `LOG_STREAM_LINE_MAX` - 1 is cut
+ * and ends with `\n`. A line that does not fit into the ring is dropped and counted.
+ *
+ * @return what vsnprintf() returns: the length of the whole line, negative on a format error
+ */
+int log_stream_vprintf(log_stream_t *self, const char *fmt, va_list args);
+
+/**
+ * @brief Send the queued lines, sender task only. Opens the socket on first use.
+ *
+ * @param partial also send a datagram that is not full, otherwise only full ones go out
+ * @return datagrams sent, failed sends not counted
+ */
+uint32_t log_stream_flush(log_stream_t *self, bool partial);
+
+#endif // LOG_STREAM_H
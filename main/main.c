@@ -1,5 +1,12 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
 
 #include "driver/gpio.h"
 #include "driver/i2c_master.h"
@@ -7,21 +14,48 @@
 #include "driver/rmt_rx.h"
 #include "driver/rmt_tx.h"
 #include "driver/spi_master.h"
+#include "dlog.h"
+#include "esp_attr.h"
 #include "esp_check.h"
 #include "esp_err.h"
 #include "esp_eth.h"
 #include "esp_eth_mac_w5500.h"
 #include "esp_eth_phy_w5500.h"
 #include "esp_event.h"
+#include "esp_heap_caps.h"
+#if CONFIG_APP_METRICS
+#include "esp_http_server.h"
+#endif
 #include "esp_log.h"
 #include "esp_mac.h"
 #include "esp_netif.h"
+#include "esp_netif_net_stack.h"
 #include "esp_random.h"
 #include "esp_system.h"
 #include "esp_timer.h"
+#include "evlog.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "i2c_async.h"
+#include "i2c_topology.h"
+#include "job_sched.h"
+#include "log_stream.h"
+#include "metrics.h"
 #include "led_strip.h"
+#include "lwip/dhcp.h"
+#include "lwip/etharp.h"
+#if CONFIG_APP_NET_FLOOD_TEST
+#include <errno.h>
+#include "lwip/sockets.h"
+#endif
+#include "net_lease.h"
+#include "nvs_flash.h"
+#include "sample_ring.h"
+#include "spsc_queue.h"
 #include "ssr_control.h"
 #include "th_sensor.h"
+#include "tsdb.h"
 
 static const char* g_log_tag = "app_main";
 
@@ -39,19 +73,79 @@ static const gpio_num_t g_pin_i2c_scl = GPIO_NUM_17;
 
 static const i2c_port_t g_i2c_port = I2C_NUM_0;
 static const uint32_t g_i2c_clk_hz = 400000;
+/* fastest SCL clock per device, lowered on errors by the async layer */
+static const uint32_t g_ssr_scl_hz = 400000;
+static const uint32_t g_th_scl_hz = 400000;
 
 static const int g_i2c_probe_timeout_ms = 20;
+/* the full scan probes one address per release of its job, between the jobs that use the bus */
+static const uint32_t g_i2c_scan_period_ms = 100;
+static const uint32_t g_i2c_scan_phase_ms = 25;
+/* transactions the I2C driver queues, this makes the bus asynchronous (see i2c_async.h) */
+static const size_t g_i2c_trans_queue_depth = 8;
 
 static const int g_led_period_us = 500 * 1000; /* LED blink period in microseconds */
 static esp_eth_handle_t g_eth_handle = NULL;
+static esp_netif_t* g_netif = NULL;
+
+/* Where the current IPv4 address came from */
+typedef enum app_ip_source_e {
+    APP_IP_SOURCE_DHCP = 0,
+    APP_IP_SOURCE_CACHE,
+    APP_IP_SOURCE_STATIC,
+} app_ip_source_t;
+
+static app_ip_source_t g_ip_source = APP_IP_SOURCE_DHCP;
+static int64_t g_got_ip_us = 0;
+
+#if CONFIG_APP_NET_LEASE_CACHE
+/* Cached lease: probe its address a few times after link-up, use it if nobody answers, renew it with DHCP later.
+ * The probes are spaced closer than RFC 5227 asks (1-2 s), a host on the wired segment answers within milliseconds. */
+ESP_EVENT_DEFINE_BASE(APP_NET_EVENT);
+enum {
+    APP_NET_EVENT_LEASE_CHECK, /* lease timer expired, handled in the event loop task */
+};
+static net_lease_t g_net_lease = { 0 };
+static esp_timer_handle_t g_lease_timer = NULL;
+static bool g_lease_probing = false;
+static uint32_t g_lease_probes = 0;
+static const uint32_t g_lease_probe_count = 3;
+static const int g_lease_probe_period_us = 100 * 1000;
+#endif
 
 static bool g_led_state = false;
 static esp_timer_handle_t g_led_timer = NULL;
 
 static i2c_master_bus_handle_t g_i2c_bus = NULL;
+static QueueHandle_t g_i2c_done_queue = NULL; /* completed requests of the sampling loop */
 
 static led_strip_handle_t led_strip = NULL;
 
+/* Boot stage timestamps, recorded by app_main and the Ethernet bring-up task */
+enum { APP_BOOT_STAGES_MAX = 16 };
+
+typedef struct app_boot_stage_s {
+    const char* name;
+    int64_t at_us;
+} app_boot_stage_t;
+
+static app_boot_stage_t g_boot_stages[APP_BOOT_STAGES_MAX];
+static uint32_t g_boot_stage_count = 0;
+static portMUX_TYPE g_boot_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static const uint32_t g_eth_init_stack_size = 4096;
+static TaskHandle_t g_boot_task = NULL;
+
+/* Last commanded SSR state. RTC memory is not cleared by resets other than power-on
+ * (brown-out, watchdog, panic), so the relay can be put back right after such a reset. */
+typedef struct app_ssr_saved_s {
+    uint32_t magic;
+    bool active;
+} app_ssr_saved_t;
+
+static RTC_NOINIT_ATTR app_ssr_saved_t g_ssr_saved;
+static const uint32_t g_ssr_saved_magic = 0x53535231; /* "SSR1" */
+
 led_strip_handle_t configure_led(void)
 {
     /* LED strip common configuration */
@@ -96,6 +190,8 @@ typedef enum app_status_tag_e {
     APP_STATUS_ETH_ATTACH_ERR,
     APP_STATUS_ETH_START_ERR,
     APP_STATUS_I2C_BUS_NEW_ERR,
+    APP_STATUS_NVS_INIT_ERR,
+    APP_STATUS_SCHED_ERR,
 } app_status_tag_t;
 
 typedef struct app_status_s {
@@ -106,6 +202,99 @@ typedef struct app_status_s {
     } value;
 } app_status_t;
 
+/* devices and latest readings shared by the scheduled jobs */
+typedef struct app_ctrl_s {
+    th_t* th;
+    ssr_t* ssr;
+    th_result_t th_r;
+    ssr_result_t ssr_r;
+    uint8_t th_logged;  /* status last put in the event log */
+    uint8_t ssr_logged;
+} app_ctrl_t;
+
+/* latest readings for the other tasks, written by the sample job only */
+typedef struct app_live_s {
+    _Atomic uint32_t samples; /* cycles published, the fields below are set once it is not 0 */
+    _Atomic int32_t temp_centi;
+    _Atomic int32_t internal_temp_centi;
+    _Atomic uint32_t th_status; /* TH_STATUS_SENSOR_ERR when the thermocouple reading is invalid */
+    _Atomic uint32_t ssr_status;
+    _Atomic bool ssr_active;
+} app_live_t;
+
+static ssr_t g_ssr;
+static th_t g_th;
+static app_ctrl_t g_ctrl;
+static app_live_t g_live;
+static job_sched_t g_sched;
+
+/* control on the APP core, networking and logging on the PRO core */
+static const BaseType_t g_ctrl_core = 1;
+static const BaseType_t g_net_core = 0;
+static const UBaseType_t g_ctrl_task_priority = 20; /* below esp_timer (22), above lwIP (18) and w5500 (15) */
+static const uint32_t g_ctrl_stack_size = 4096;
+static const UBaseType_t g_telemetry_task_priority = 2;
+static const uint32_t g_telemetry_stack_size = 4096;
+
+static sample_ring_t g_telemetry_ring; /* control task -> telemetry task */
+
+/* log lines of the control task, formatted by the log task */
+static dlog_ring_t g_ctrl_log;
+static bool g_log_task_ok = false;
+static const UBaseType_t g_log_task_priority = 1;
+static const uint32_t g_log_stack_size = 4096;
+static const uint32_t g_log_period_ms = 50;
+#if CONFIG_APP_LOG_DEFERRED
+static const char* g_log_mode = "deferred";
+#else
+static const char* g_log_mode = "inline";
+#endif
+
+#if CONFIG_APP_LOG_UDP
+static log_stream_t g_log_stream;
+static bool g_log_stream_ok = false;
+static vprintf_like_t g_log_vprintf_uart = vprintf;
+static const int64_t g_log_stream_period_us = 1000 * 1000; /* longest wait of a datagram that is not full */
+#endif
+
+/* history of the temperature (0.01 C) and the SSR state (0/1) */
+static tsdb_t g_tsdb;
+static bool g_tsdb_ok = false;
+static const char* g_tsdb_label = "tsdb";
+static const uint8_t g_tsdb_series_temp = 0;
+static const uint8_t g_tsdb_series_ssr = 1;
+static const int64_t g_tsdb_flush_us = (int64_t)CONFIG_APP_TSDB_FLUSH_S * 1000 * 1000;
+
+/* freezer events, written by the telemetry task only */
+static evlog_t g_evlog;
+static bool g_evlog_ok = false;
+static const char* g_evlog_label = "evlog";
+static const int64_t g_evlog_sync_us = 5 * 1000 * 1000;
+#define APP_EVENT_QUEUE_LEN 32
+static evlog_record_t g_event_items[APP_EVENT_QUEUE_LEN];
+static spsc_queue_t g_event_queue; /* control task -> telemetry task */
+
+#if CONFIG_APP_METRICS
+static httpd_handle_t g_metrics_server = NULL;
+static const UBaseType_t g_metrics_task_priority = 3;
+static const uint32_t g_metrics_stack_size = 4096;
+static char g_metrics_chunk[1024]; /* one response chunk, the server runs one handler at a time */
+static metrics_values_t g_metrics_values;
+#endif
+
+#if CONFIG_APP_NET_FLOOD_TEST
+static const UBaseType_t g_flood_task_priority = 10;
+static const uint32_t g_flood_stack_size = 3072;
+static const uint16_t g_flood_port = 9; /* discard */
+static const uint32_t g_flood_burst = 32; /* datagrams between one-tick sleeps */
+static uint32_t g_flood_sent = 0;
+#endif
+
+static const uint32_t g_sample_period_ms = 1000;
+static const uint32_t g_ssr_toggle_period_ms = 1000;
+static const uint32_t g_telemetry_period_ms = 1000;
+static const uint32_t g_stats_period_ms = 30 * 1000;
+
 static const uint8_t g_i2c_expected_ids[] = {
     0x50, /* the AC-SSR m5stack*/
     0x66, /* the KMeterISO m5stack */
@@ -115,6 +304,290 @@ static const uint8_t g_i2c_expected_ids[] = {
 static void got_ip_event_handler(
     void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data);
 
+static void app_boot_mark(const char* name)
+{
+    const int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&g_boot_lock);
+    if (g_boot_stage_count < APP_BOOT_STAGES_MAX) {
+        g_boot_stages[g_boot_stage_count].name = name;
+        g_boot_stages[g_boot_stage_count].at_us = now;
+        g_boot_stage_count += 1;
+    }
+    portEXIT_CRITICAL(&g_boot_lock);
+}
+
+static void app_boot_log(void)
+{
+    int64_t prev_us = 0;
+    uint32_t i = 0;
+    for (i = 0; i < g_boot_stage_count; ++i) {
+        ESP_LOGI(g_log_tag, "boot %-12s at %8" PRId64 " us (+%" PRId64 " us)", g_boot_stages[i].name,
+            g_boot_stages[i].at_us, g_boot_stages[i].at_us - prev_us);
+        prev_us = g_boot_stages[i].at_us;
+    }
+}
+
+static app_status_t app_init_nvs(void)
+{
+    esp_err_t rc = nvs_flash_init();
+    if (rc == ESP_ERR_NVS_NO_FREE_PAGES || rc == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        /* partition full or written by a newer layout, start over */
+        rc = nvs_flash_erase();
+        if (rc == ESP_OK) {
+            rc = nvs_flash_init();
+        }
+    }
+    if (rc != ESP_OK) {
+        return (app_status_t) { .tag = APP_STATUS_NVS_INIT_ERR, .value = { .esp_code = rc } };
+    }
+    return (app_status_t) { .tag = APP_STATUS_OK, .value = { .reserved = 0 } };
+}
+
+static const char* app_ip_source_name(app_ip_source_t source)
+{
+    switch (source) {
+    case APP_IP_SOURCE_CACHE:
+        return "cached lease";
+    case APP_IP_SOURCE_STATIC:
+        return "static";
+    default:
+        return "dhcp";
+    }
+}
+
+/* Use a fixed address, the interface reports it as soon as the link is up */
+static esp_err_t app_net_apply_static(esp_netif_t* netif, const esp_netif_ip_info_t* ip_info, uint32_t dns)
+{
+    esp_err_t rc = esp_netif_dhcpc_stop(netif);
+    if (rc != ESP_OK && rc != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+        return rc;
+    }
+    rc = esp_netif_set_ip_info(netif, ip_info);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (dns != 0) {
+        esp_netif_dns_info_t dns_info = { 0 };
+        dns_info.ip.type = ESP_IPADDR_TYPE_V4;
+        dns_info.ip.u_addr.ip4.addr = dns;
+        rc = esp_netif_set_dns_info(netif, ESP_NETIF_DNS_MAIN, &dns_info);
+    }
+    return rc;
+}
+
+#if CONFIG_APP_NET_LEASE_CACHE
+/* runs in the lwIP thread, the DHCP client state belongs to it */
+static esp_err_t app_net_read_lease_time(void* ctx)
+{
+    net_lease_t* lease = (net_lease_t*)ctx;
+    struct netif* lwip_netif = esp_netif_get_netif_impl(g_netif);
+    const struct dhcp* dhcp = lwip_netif != NULL ? netif_dhcp_data(lwip_netif) : NULL;
+    lease->lease_s = dhcp != NULL ? dhcp->offered_t0_lease : 0;
+    return ESP_OK;
+}
+
+static void app_net_store_lease(const esp_netif_ip_info_t* ip_info)
+{
+    net_lease_t lease = {
+        .ip = ip_info->ip.addr,
+        .netmask = ip_info->netmask.addr,
+        .gw = ip_info->gw.addr,
+        .dns = 0,
+        .lease_s = 0,
+    };
+    esp_netif_dns_info_t dns_info = { 0 };
+    if (esp_netif_get_dns_info(g_netif, ESP_NETIF_DNS_MAIN, &dns_info) == ESP_OK
+        && dns_info.ip.type == ESP_IPADDR_TYPE_V4) {
+        lease.dns = dns_info.ip.u_addr.ip4.addr;
+    }
+    esp_netif_tcpip_exec(app_net_read_lease_time, &lease);
+
+    const net_lease_result_t r = net_lease_store(&lease);
+    if (r.tag != NET_LEASE_STATUS_OK) {
+        ESP_LOGW(g_log_tag, "lease cache store failed: tag=%d err=%s", (int)r.tag,
+            esp_err_to_name(r.value.esp_code));
+    }
+}
+
+/* runs in the lwIP thread. The address is not on the netif yet, so the ARP
+ * request etharp_query() sends is an RFC 5227 probe with sender 0.0.0.0 and
+ * changes no other host's cache. A reply completes the pending entry. */
+static esp_err_t app_net_arp_probe(void* ctx)
+{
+    bool* conflict = (bool*)ctx;
+    struct netif* lwip_netif = esp_netif_get_netif_impl(g_netif);
+    if (lwip_netif == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const ip4_addr_t ip = { .addr = g_net_lease.ip };
+    struct eth_addr* eth_ret = NULL;
+    const ip4_addr_t* ip_ret = NULL;
+    *conflict = etharp_find_addr(lwip_netif, &ip, &eth_ret, &ip_ret) >= 0;
+    if (!*conflict) {
+        etharp_query(lwip_netif, &ip, NULL);
+    }
+    return ESP_OK;
+}
+
+/* runs in the esp_timer task, which also releases the control loop's jobs
+ * (job_sched): hand over to the event loop task, never block here */
+static void app_net_lease_timer_cb(void* arg)
+{
+    (void)arg;
+    esp_event_post(APP_NET_EVENT, APP_NET_EVENT_LEASE_CHECK, NULL, 0, 0);
+}
+
+static void app_net_lease_fallback(void)
+{
+    esp_timer_stop(g_lease_timer);
+    const net_lease_result_t r = net_lease_erase();
+    if (r.tag != NET_LEASE_STATUS_OK) {
+        ESP_LOGW(g_log_tag, "lease cache erase failed: err=%s", esp_err_to_name(r.value.esp_code));
+    }
+    g_ip_source = APP_IP_SOURCE_DHCP;
+    esp_netif_dhcpc_start(g_netif);
+}
+
+/* event loop task, starts probing once the link is up */
+static void app_net_lease_link_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    if (g_ip_source == APP_IP_SOURCE_CACHE && !g_lease_probing) {
+        g_lease_probing = true;
+        esp_timer_start_periodic(g_lease_timer, g_lease_probe_period_us);
+    }
+}
+
+/* event loop task, one step per lease timer expiry: probe, use the address, renew */
+static void app_net_lease_check_handler(void* arg, esp_event_base_t event_base, int32_t event_id, void* event_data)
+{
+    if (g_ip_source != APP_IP_SOURCE_CACHE) {
+        return; /* an expiry queued before the fallback */
+    }
+    if (g_lease_probes > g_lease_probe_count) {
+        /* renewal due: the DHCP client asks the server for the same address (INIT-REBOOT) */
+        ESP_LOGI(g_log_tag, "renewing cached lease with dhcp");
+        g_ip_source = APP_IP_SOURCE_DHCP;
+        esp_netif_dhcpc_start(g_netif);
+        return;
+    }
+
+    bool conflict = false;
+    esp_netif_tcpip_exec(app_net_arp_probe, &conflict);
+    if (conflict) {
+        ESP_LOGW(g_log_tag, "cached address in use by another host, falling back to dhcp");
+        app_net_lease_fallback();
+        return;
+    }
+
+    g_lease_probes += 1;
+    if (g_lease_probes > g_lease_probe_count) {
+        esp_timer_stop(g_lease_timer);
+        const esp_netif_ip_info_t ip_info = {
+            .ip = { .addr = g_net_lease.ip },
+            .netmask = { .addr = g_net_lease.netmask },
+            .gw = { .addr = g_net_lease.gw },
+        };
+        const esp_err_t rc = app_net_apply_static(g_netif, &ip_info, g_net_lease.dns);
+        if (rc != ESP_OK) {
+            ESP_LOGW(g_log_tag, "cached lease not applied: %s, falling back to dhcp", esp_err_to_name(rc));
+            app_net_lease_fallback();
+            return;
+        }
+        uint32_t renew_s = g_net_lease.lease_s / 2;
+        if (renew_s == 0 || renew_s > CONFIG_APP_NET_LEASE_RENEW_MAX_S) {
+            renew_s = CONFIG_APP_NET_LEASE_RENEW_MAX_S;
+        }
+        ESP_LOGI(g_log_tag, "cached lease " IPSTR " unused by others, renewing in %lu s", IP2STR(&ip_info.ip),
+            (unsigned long)renew_s);
+        esp_timer_start_once(g_lease_timer, (uint64_t)renew_s * 1000 * 1000);
+    }
+}
+
+static bool app_net_use_cached_lease(esp_netif_t* netif)
+{
+    const net_lease_result_t r = net_lease_load(&g_net_lease);
+    if (r.tag != NET_LEASE_STATUS_OK) {
+        if (r.tag == NET_LEASE_STATUS_NVS_ERR) {
+            ESP_LOGW(g_log_tag, "lease cache read failed: err=%s", esp_err_to_name(r.value.esp_code));
+        }
+        return false;
+    }
+
+    const esp_timer_create_args_t args = {
+        .callback = &app_net_lease_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "lease_check",
+        .skip_unhandled_events = true,
+    };
+    esp_err_t rc = esp_timer_create(&args, &g_lease_timer);
+    if (rc == ESP_OK) {
+        rc = esp_event_handler_register(ETH_EVENT, ETHERNET_EVENT_CONNECTED, &app_net_lease_link_handler, NULL);
+    }
+    if (rc == ESP_OK) {
+        rc = esp_event_handler_register(
+            APP_NET_EVENT, APP_NET_EVENT_LEASE_CHECK, &app_net_lease_check_handler, NULL);
+    }
+    if (rc == ESP_OK) {
+        /* no DHCP on link-up, the address is set once the probes found it free */
+        rc = esp_netif_dhcpc_stop(netif);
+        if (rc == ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+            rc = ESP_OK;
+        }
+    }
+    if (rc == ESP_OK) {
+        const esp_ip4_addr_t ip = { .addr = g_net_lease.ip };
+        ESP_LOGI(g_log_tag, "cached lease " IPSTR ", probing it after link-up", IP2STR(&ip));
+        return true;
+    }
+    ESP_LOGW(g_log_tag, "cached lease not used: %s", esp_err_to_name(rc));
+    return false;
+}
+#endif
+
+/* Static address, cached lease or DHCP, see the "Application network" menu */
+static esp_err_t app_net_start_ip(esp_netif_t* netif)
+{
+#if CONFIG_APP_NET_IP_STATIC
+    esp_netif_ip_info_t ip_info = { 0 };
+    esp_ip4_addr_t dns = { 0 };
+    esp_err_t rc = esp_netif_str_to_ip4(CONFIG_APP_NET_STATIC_IP, &ip_info.ip);
+    if (rc == ESP_OK) {
+        rc = esp_netif_str_to_ip4(CONFIG_APP_NET_STATIC_NETMASK, &ip_info.netmask);
+    }
+    if (rc == ESP_OK) {
+        rc = esp_netif_str_to_ip4(CONFIG_APP_NET_STATIC_GW, &ip_info.gw);
+    }
+    if (rc == ESP_OK && CONFIG_APP_NET_STATIC_DNS[0] != '\0') {
+        rc = esp_netif_str_to_ip4(CONFIG_APP_NET_STATIC_DNS, &dns);
+    }
+    if (rc != ESP_OK) {
+        ESP_LOGE(g_log_tag, "invalid static address configuration");
+        return rc;
+    }
+    g_ip_source = APP_IP_SOURCE_STATIC;
+    return app_net_apply_static(netif, &ip_info, dns.addr);
+#else
+#if CONFIG_APP_NET_LEASE_CACHE
+    if (app_net_use_cached_lease(netif)) {
+        g_ip_source = APP_IP_SOURCE_CACHE;
+        return ESP_OK;
+    }
+#endif
+    g_ip_source = APP_IP_SOURCE_DHCP;
+    return esp_netif_dhcpc_start(netif);
+#endif
+}
+
+#if CONFIG_ETH_W5500_RX_POOL
+/* transmit_wrap of the netif driver config: the stack's own buffer is not needed, the frame is copied to the chip */
+static esp_err_t app_eth_transmit_wrap(void* h, void* buffer, size_t len, void* netstack_buffer)
+{
+    (void)netstack_buffer;
+    return esp_eth_transmit(h, buffer, len);
+}
+#endif
+
 static app_status_t app_init_eth_w5500(void)
 {
     esp_err_t rc = esp_netif_init();
@@ -133,6 +606,7 @@ static app_status_t app_init_eth_w5500(void)
         return (
             app_status_t) { .tag = APP_STATUS_NETIF_INIT_ERR, .value = { .esp_code = ESP_FAIL } };
     }
+    g_netif = netif;
 
     const spi_bus_config_t spi_bus_cfg = {
         .miso_io_num = g_pin_spi_miso,
@@ -154,6 +628,7 @@ static app_status_t app_init_eth_w5500(void)
     if (rc != ESP_OK) {
         return (app_status_t) { .tag = APP_STATUS_SPI_BUS_INIT_ERR, .value = { .esp_code = rc } };
     }
+    app_boot_mark("spi bus");
 
     spi_device_interface_config_t dev_cfg = {
         .command_bits = 16,
@@ -168,6 +643,7 @@ static app_status_t app_init_eth_w5500(void)
     w5500_cfg.int_gpio_num = g_pin_eth_int;
 
     eth_mac_config_t mac_cfg = ETH_MAC_DEFAULT_CONFIG();
+    mac_cfg.flags |= ETH_MAC_FLAG_PIN_TO_CORE; /* w5500_tsk stays on the core of this task */
     esp_eth_mac_t* mac = esp_eth_mac_new_w5500(&w5500_cfg, &mac_cfg);
     if (mac == NULL) {
         return (app_status_t) { .tag = APP_STATUS_ETH_MAC_ERR, .value = { .esp_code = ESP_FAIL } };
@@ -181,12 +657,14 @@ static app_status_t app_init_eth_w5500(void)
         return (app_status_t) { .tag = APP_STATUS_ETH_PHY_ERR, .value = { .esp_code = ESP_FAIL } };
     }
 
+    /* the default link check period: link changes are reported by the W5500 driver task as soon as it sees them */
     esp_eth_config_t eth_cfg = ETH_DEFAULT_CONFIG(mac, phy);
     rc = esp_eth_driver_install(&eth_cfg, &g_eth_handle);
     if (rc != ESP_OK) {
         return (
             app_status_t) { .tag = APP_STATUS_ETH_DRV_INSTALL_ERR, .value = { .esp_code = rc } };
     }
+    app_boot_mark("w5500 reset");
 
     /* Ensure the MAC address is set on the MAC and the netif before
      * attaching. */
@@ -220,14 +698,37 @@ static app_status_t app_init_eth_w5500(void)
         return (app_status_t) { .tag = APP_STATUS_ETH_ATTACH_ERR, .value = { .esp_code = rc } };
     }
 
-    /* Register IP event handler and start DHCP client on the ethernet
-     * interface */
+#if CONFIG_ETH_W5500_RX_POOL
+    /* RX frames live in the W5500 buffer pool, lwIP must hand them back there instead of free().
+     * esp_netif_set_driver_config() overwrites all four fields of esp_netif_driver_ifconfig_t (handle, transmit,
+     * transmit_wrap, driver_free_rx_buffer), so the ones the glue set in its post_attach are set again here. Fields
+     * as in esp_netif_types.h of ESP-IDF v6.0, the target; from the IDF documentation, the IDF sources are not part
+     * of this tree. Recheck them when moving to another IDF version. */
+    const esp_netif_iodriver_handle eth_io_driver = esp_netif_get_io_driver(netif);
+    if (eth_io_driver != g_eth_handle) {
+        /* the glue did not set the Ethernet driver as handle, esp_eth_transmit() would get something else */
+        return (app_status_t) { .tag = APP_STATUS_ETH_ATTACH_ERR, .value = { .esp_code = ESP_ERR_INVALID_STATE } };
+    }
+    const esp_netif_driver_ifconfig_t eth_driver_cfg = {
+        .handle = eth_io_driver, /* the glue's driver handle */
+        .transmit = esp_eth_transmit,
+        .transmit_wrap = app_eth_transmit_wrap,
+        .driver_free_rx_buffer = esp_eth_mac_w5500_free_rx_buf,
+    };
+    rc = esp_netif_set_driver_config(netif, &eth_driver_cfg);
+    if (rc != ESP_OK) {
+        return (app_status_t) { .tag = APP_STATUS_ETH_ATTACH_ERR, .value = { .esp_code = rc } };
+    }
+#endif
+
+    /* Register IP event handler and configure the address (static, cached
+     * lease or DHCP) on the ethernet interface */
     rc = esp_event_handler_register(IP_EVENT, IP_EVENT_ETH_GOT_IP, &got_ip_event_handler, netif);
     if (rc != ESP_OK) {
         return (app_status_t) { .tag = APP_STATUS_EVENT_LOOP_ERR, .value = { .esp_code = rc } };
     }
 
-    rc = esp_netif_dhcpc_start(netif);
+    rc = app_net_start_ip(netif);
     if (rc != ESP_OK) {
         return (app_status_t) { .tag = APP_STATUS_NETIF_INIT_ERR, .value = { .esp_code = rc } };
     }
@@ -236,6 +737,7 @@ static app_status_t app_init_eth_w5500(void)
     if (rc != ESP_OK) {
         return (app_status_t) { .tag = APP_STATUS_ETH_START_ERR, .value = { .esp_code = rc } };
     }
+    app_boot_mark("eth started");
 
     return (app_status_t) { .tag = APP_STATUS_OK, .value = { .reserved = 0 } };
 }
@@ -254,9 +756,31 @@ static void got_ip_event_handler(
     esp_netif_ip_info_t ip_info = event->ip_info;
     ESP_LOGI(g_log_tag, "Ethernet got IP: " IPSTR, IP2STR(&ip_info.ip));
 
-    /* Optionally, stop DHCP if you want to switch to static later:
-     * esp_netif_dhcpc_stop(netif);
-     */
+    if (g_got_ip_us == 0) {
+        /* time-to-IP, counted from boot like the other boot stages */
+        g_got_ip_us = esp_timer_get_time();
+        ESP_LOGI(g_log_tag, "boot %-12s at %8" PRId64 " us (%s)", "got ip", g_got_ip_us,
+            app_ip_source_name(g_ip_source));
+    }
+
+#if CONFIG_APP_NET_LEASE_CACHE
+    if (g_ip_source == APP_IP_SOURCE_DHCP) {
+        app_net_store_lease(&ip_info);
+    }
+#endif
+
+#if CONFIG_ETH_W5500_OFFLOAD
+    /* hardware sockets on the W5500 answer on the same address as lwIP */
+    const eth_w5500_ip_info_t w5500_ip_info = {
+        .ip = ip_info.ip.addr,
+        .netmask = ip_info.netmask.addr,
+        .gw = ip_info.gw.addr,
+    };
+    const esp_err_t ip_rc = esp_eth_ioctl(g_eth_handle, ETH_W5500_CMD_S_IP_INFO, (void*)&w5500_ip_info);
+    if (ip_rc != ESP_OK) {
+        ESP_LOGW(g_log_tag, "esp_eth_ioctl(ETH_W5500_CMD_S_IP_INFO) returned %s", esp_err_to_name(ip_rc));
+    }
+#endif
 }
 
 static void app_log_status(const char* label, app_status_t status)
@@ -279,10 +803,16 @@ static app_status_t app_init_i2c(void)
         .clk_source = I2C_CLK_SRC_DEFAULT,
         .glitch_ignore_cnt = 7,
         .intr_priority = 0,
-        .trans_queue_depth = 0,
+        .trans_queue_depth = g_i2c_trans_queue_depth,
         .flags.enable_internal_pullup = true,
     };
 
+    g_i2c_done_queue = xQueueCreate(g_i2c_trans_queue_depth, sizeof(i2c_async_req_t*));
+    if (g_i2c_done_queue == NULL) {
+        return (
+            app_status_t) { .tag = APP_STATUS_I2C_BUS_NEW_ERR, .value = { .esp_code = ESP_ERR_NO_MEM } };
+    }
+
     const esp_err_t rc = i2c_new_master_bus(&cfg, &g_i2c_bus);
     if (rc != ESP_OK) {
         return (app_status_t) { .tag = APP_STATUS_I2C_BUS_NEW_ERR, .value = { .esp_code = rc } };
@@ -301,42 +831,105 @@ static bool app_i2c_probe_addr(uint8_t addr)
     return rc == ESP_OK;
 }
 
-static bool app_i2c_contains_u8(const uint8_t* items, uint32_t count, uint8_t target)
+static void app_i2c_report_expected(const i2c_topology_t* found)
 {
     uint32_t i = 0;
-    for (i = 0; i < count; ++i) {
-        if (items[i] == target) {
-            return true;
-        }
+    for (i = 0; i < (uint32_t)sizeof(g_i2c_expected_ids); ++i) {
+        const uint8_t expected = g_i2c_expected_ids[i];
+        const bool present = i2c_topology_has(found, expected);
+        log_printf(ESP_LOG_INFO, g_log_tag, "i2c expected id=0x%02X => %s", expected, present ? "MATCH" : "MISSING");
     }
-    return false;
 }
 
-static void app_i2c_scan_and_report(void)
+/* Full scan of every address, one probe per step. Absent or stuck devices cost a probe timeout each, so it
+ * runs as a job of the control task: the sample and SSR jobs never find a probe on the bus, the scan never
+ * finds their transactions on it. */
+static struct {
+    bool pending;          /* the cached topology is missing or out of date */
+    uint8_t addr;          /* next address to probe, 0 before the first */
+    i2c_topology_t found;
+} g_i2c_scan;
+
+/* Probe the next address, true once the scan is over and its result stored */
+static bool app_i2c_scan_step(void)
 {
-    uint8_t found_ids[128] = { 0 };
-    uint32_t found_count = 0;
-    uint8_t addr = 0;
+    if (g_i2c_scan.addr == 0) {
+        log_printf(ESP_LOG_INFO, g_log_tag, "i2c scan start: port=%d sda=%d scl=%d clk=%lu", (int)g_i2c_port,
+            (int)g_pin_i2c_sda, (int)g_pin_i2c_scl, (unsigned long)g_i2c_clk_hz);
+        g_i2c_scan.addr = I2C_TOPOLOGY_ADDR_FIRST;
+    }
+    const uint8_t addr = g_i2c_scan.addr;
+    if (app_i2c_probe_addr(addr)) {
+        i2c_topology_add(&g_i2c_scan.found, addr);
+        log_printf(ESP_LOG_INFO, g_log_tag, "i2c found id=0x%02X", addr);
+    }
+    g_i2c_scan.addr += 1;
+    if (addr < I2C_TOPOLOGY_ADDR_LAST) {
+        return false;
+    }
+
+    log_printf(ESP_LOG_INFO, g_log_tag, "i2c scan done: %u device(s)",
+        (unsigned)i2c_topology_count(&g_i2c_scan.found));
+    app_i2c_report_expected(&g_i2c_scan.found);
+    const i2c_topology_result_t rc = i2c_topology_store(&g_i2c_scan.found);
+    if (rc.tag != I2C_TOPOLOGY_STATUS_OK) {
+        log_printf(ESP_LOG_WARN, g_log_tag, "i2c topology store failed: tag=%d err=%s", (int)rc.tag,
+            esp_err_to_name(rc.value.esp_code));
+    }
+    g_i2c_scan.pending = false;
+    return true;
+}
+
+/* The whole scan at once, only where no other task uses the bus */
+static void app_i2c_full_scan(void)
+{
+    while (g_i2c_scan.pending && !app_i2c_scan_step()) {
+    }
+}
 
-    ESP_LOGI(g_log_tag, "i2c scan start: port=%d sda=%d scl=%d clk=%lu", (int)g_i2c_port,
-        (int)g_pin_i2c_sda, (int)g_pin_i2c_scl, (unsigned long)g_i2c_clk_hz);
+static void app_job_i2c_scan(void* arg)
+{
+    (void)arg;
+    if (app_i2c_scan_step()) {
+        job_sched_done(&g_sched);
+    }
+}
 
-    for (addr = 0x03; addr <= 0x77; ++addr) {
-        if (app_i2c_probe_addr(addr)) {
-            found_ids[found_count] = addr;
-            found_count += 1;
-            ESP_LOGI(g_log_tag, "i2c found id=0x%02X", addr);
+/* Boot only probes the expected devices. When they agree with the cached topology
+ * of the last full scan, that is the report; otherwise a full scan is left pending for the control task. */
+static void app_i2c_probe_and_report(void)
+{
+    i2c_topology_t probed = { 0 };
+    uint32_t i = 0;
+    for (i = 0; i < (uint32_t)sizeof(g_i2c_expected_ids); ++i) {
+        if (app_i2c_probe_addr(g_i2c_expected_ids[i])) {
+            i2c_topology_add(&probed, g_i2c_expected_ids[i]);
         }
     }
 
-    ESP_LOGI(g_log_tag, "i2c scan done: %u device(s)", (unsigned)found_count);
+    i2c_topology_t cached = { 0 };
+    const i2c_topology_result_t load_rc = i2c_topology_load(&cached);
+    bool matches = load_rc.tag == I2C_TOPOLOGY_STATUS_OK;
+    for (i = 0; matches && i < (uint32_t)sizeof(g_i2c_expected_ids); ++i) {
+        const uint8_t expected = g_i2c_expected_ids[i];
+        matches = i2c_topology_has(&probed, expected) == i2c_topology_has(&cached, expected);
+    }
 
-    for (addr = 0; addr < (uint8_t)(sizeof(g_i2c_expected_ids)); ++addr) {
-        const uint8_t expected = g_i2c_expected_ids[addr];
-        const bool present = app_i2c_contains_u8(found_ids, found_count, expected);
-        ESP_LOGI(
-            g_log_tag, "i2c expected id=0x%02X => %s", expected, present ? "MATCH" : "MISSING");
+    if (matches) {
+        ESP_LOGI(g_log_tag, "i2c topology cached: %u device(s)", (unsigned)i2c_topology_count(&cached));
+        for (i = I2C_TOPOLOGY_ADDR_FIRST; i <= I2C_TOPOLOGY_ADDR_LAST; ++i) {
+            if (i2c_topology_has(&cached, (uint8_t)i)) {
+                ESP_LOGI(g_log_tag, "i2c cached id=0x%02X", (unsigned)i);
+            }
+        }
+        app_i2c_report_expected(&probed);
+        return;
     }
+
+    ESP_LOGI(g_log_tag, "i2c topology %s, full scan after boot",
+        (load_rc.tag == I2C_TOPOLOGY_STATUS_OK) ? "changed" : "not cached");
+    app_i2c_report_expected(&probed);
+    g_i2c_scan.pending = true;
 }
 
 static app_status_t app_init_led(void)
@@ -395,39 +988,628 @@ static app_status_t app_init_led_timer(void)
     return (app_status_t) { .tag = APP_STATUS_OK, .value = { .reserved = 0 } };
 }
 
-void app_main(void)
+static app_status_t g_eth_init_status;
+
+/* W5500 bring-up spends most of its time waiting for resets, so it runs beside the I2C and SSR bring-up */
+static void app_task_eth_init(void* arg)
 {
-    const app_status_t led_rc = app_init_led();
-    if (led_rc.tag != APP_STATUS_OK) {
-        app_log_status("led_init", led_rc);
+    (void)arg;
+    g_eth_init_status = app_init_eth_w5500();
+    xTaskNotifyGive(g_boot_task);
+    vTaskDelete(NULL);
+}
+
+static ssr_result_t app_ssr_set_active(ssr_t* ssr, bool active)
+{
+    /* remember the intent even if the write fails, a restore after reset retries it */
+    g_ssr_saved.active = active;
+    g_ssr_saved.magic = g_ssr_saved_magic;
+    return ssr_set_active(ssr, active);
+}
+
+/* Put the SSR back into its last commanded state. After power-on there is none, then keep what the SSR reports. */
+static ssr_result_t app_ssr_restore(ssr_t* ssr)
+{
+    if (g_ssr_saved.magic == g_ssr_saved_magic) {
+        ESP_LOGI(g_log_tag, "ssr restore active=%s", g_ssr_saved.active ? "true" : "false");
+        return app_ssr_set_active(ssr, g_ssr_saved.active);
+    }
+
+    const ssr_result_t r = ssr_get_active(ssr);
+    if (r.tag == SSR_STATUS_OK) {
+        g_ssr_saved.active = r.value.active;
+        g_ssr_saved.magic = g_ssr_saved_magic;
+    }
+    return r;
+}
+
+static void app_i2c_log_stats(const char* name, const i2c_async_dev_t* dev)
+{
+    const uint32_t err_permille = (dev->submitted > 0) ? (uint32_t)((uint64_t)dev->failed * 1000 / dev->submitted) : 0;
+    log_printf(ESP_LOG_INFO, g_log_tag,
+        "i2c %s 0x%02X scl=%lu/%lu Hz xfers=%lu failed=%lu (%lu permille) down=%lu up=%lu", name,
+        (unsigned)dev->addr, (unsigned long)dev->scl_hz, (unsigned long)dev->max_hz,
+        (unsigned long)dev->submitted, (unsigned long)dev->failed, (unsigned long)err_permille,
+        (unsigned long)dev->step_downs, (unsigned long)dev->step_ups);
+}
+
+/* Start the thermocouple snapshot and the SSR state read together: both are
+ * queued on the bus at once and the task sleeps until the last one is done. */
+static void app_i2c_sample(th_t* th, ssr_t* ssr, th_result_t* th_out, ssr_result_t* ssr_out)
+{
+    uint32_t pending = 0;
+    *th_out = th_read_snapshot_async(th, g_i2c_done_queue);
+    if (th_out->tag == TH_STATUS_OK) {
+        pending += 1;
+    }
+    *ssr_out = ssr_get_active_async(ssr, g_i2c_done_queue);
+    if (ssr_out->tag == SSR_STATUS_OK) {
+        pending += 1;
+    }
+
+    while (pending > 0) {
+        i2c_async_req_t* done = NULL;
+        if (xQueueReceive(g_i2c_done_queue, &done, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        pending -= 1;
+        if (done->ctx == th) {
+            *th_out = th_snapshot_result(th);
+        } else if (done->ctx == ssr) {
+            *ssr_out = ssr_async_result(ssr);
+        }
+    }
+}
+
+/* Wall-clock time of a sample. Without a time source the clock starts at 0 on power-on. */
+static int64_t app_wall_ms(int64_t at_us)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    const int64_t now_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    return now_ms - (esp_timer_get_time() - at_us) / 1000;
+}
+
+/* Queue an event for the log, control task only. A full queue drops it, counted in `dropped`. */
+static void app_event(evlog_type_t type, uint16_t arg, int32_t value)
+{
+    const evlog_record_t record = {
+        .t_ms = app_wall_ms(esp_timer_get_time()),
+        .type = (uint16_t)type,
+        .arg = arg,
+        .value = value,
+    };
+    spsc_queue_push(&g_event_queue, &record);
+}
+
+/* Only status changes go to the event log, a sensor that stays down is one event */
+static void app_log_status_events(app_ctrl_t* ctrl)
+{
+    const th_snapshot_t* snap = &ctrl->th_r.value.snapshot;
+    const bool th_ok = ctrl->th_r.tag == TH_STATUS_OK;
+    const uint8_t th_status = (th_ok && snap->error_status != 0) ? TH_STATUS_SENSOR_ERR : (uint8_t)ctrl->th_r.tag;
+    if (th_status != ctrl->th_logged) {
+        const int32_t value = th_ok ? snap->error_status
+            : (ctrl->th_r.tag == TH_STATUS_I2C_ERR) ? ctrl->th_r.value.esp_code : 0;
+        app_event(EVLOG_TH_STATUS, th_status, value);
+        ctrl->th_logged = th_status;
+    }
+
+    const uint8_t ssr_status = (uint8_t)ctrl->ssr_r.tag;
+    if (ssr_status != ctrl->ssr_logged) {
+        app_event(EVLOG_SSR_STATUS, ssr_status, (ctrl->ssr_r.tag == SSR_STATUS_I2C_ERR) ? ctrl->ssr_r.value.esp_code : 0);
+        ctrl->ssr_logged = ssr_status;
+    }
+}
+
+/* Split one cycle into sample records. A set error_status means the thermocouple reading is invalid. */
+static void app_publish_samples(const app_ctrl_t* ctrl, int64_t at_us)
+{
+    const th_snapshot_t* snap = &ctrl->th_r.value.snapshot;
+    const bool th_ok = ctrl->th_r.tag == TH_STATUS_OK;
+    sample_t sample = { .at_us = at_us };
+
+    sample.channel = SAMPLE_CH_TEMP;
+    sample.status = (th_ok && snap->error_status != 0) ? TH_STATUS_SENSOR_ERR : (uint8_t)ctrl->th_r.tag;
+    sample.value = th_ok ? snap->temp_c : 0.0f;
+    sample_ring_push(&g_telemetry_ring, &sample);
+
+    sample.channel = SAMPLE_CH_INTERNAL_TEMP;
+    sample.status = (uint8_t)ctrl->th_r.tag;
+    sample.value = th_ok ? snap->internal_temp_c : 0.0f;
+    sample_ring_push(&g_telemetry_ring, &sample);
+
+    sample.channel = SAMPLE_CH_SSR;
+    sample.status = (uint8_t)ctrl->ssr_r.tag;
+    sample.value = (ctrl->ssr_r.tag == SSR_STATUS_OK && ctrl->ssr_r.value.active) ? 1.0f : 0.0f;
+    sample_ring_push(&g_telemetry_ring, &sample);
+}
+
+static void app_publish_live(const app_ctrl_t* ctrl)
+{
+    const th_snapshot_t* snap = &ctrl->th_r.value.snapshot;
+    const bool th_ok = ctrl->th_r.tag == TH_STATUS_OK;
+    const uint32_t th_status = (th_ok && snap->error_status != 0) ? TH_STATUS_SENSOR_ERR : (uint32_t)ctrl->th_r.tag;
+    atomic_store_explicit(&g_live.th_status, th_status, memory_order_relaxed);
+    if (th_ok) {
+        atomic_store_explicit(&g_live.temp_centi, (int32_t)lroundf(snap->temp_c * 100.0f), memory_order_relaxed);
+        atomic_store_explicit(
+            &g_live.internal_temp_centi, (int32_t)lroundf(snap->internal_temp_c * 100.0f), memory_order_relaxed);
+    }
+    atomic_store_explicit(&g_live.ssr_status, (uint32_t)ctrl->ssr_r.tag, memory_order_relaxed);
+    atomic_store_explicit(
+        &g_live.ssr_active, ctrl->ssr_r.tag == SSR_STATUS_OK && ctrl->ssr_r.value.active, memory_order_relaxed);
+    atomic_fetch_add_explicit(&g_live.samples, 1, memory_order_release);
+}
+
+static void app_job_sample(void* arg)
+{
+    app_ctrl_t* ctrl = (app_ctrl_t*)arg;
+    app_i2c_sample(ctrl->th, ctrl->ssr, &ctrl->th_r, &ctrl->ssr_r); // snapshot and ssr state in flight together
+
+    /* the release time, not the I2C completion: its jitter would cost every sample a timestamp in the history */
+    app_publish_samples(ctrl, g_sched.release_us);
+    app_publish_live(ctrl);
+    app_log_status_events(ctrl);
+}
+
+/* The toggle is a test pattern, not a control decision: it is not logged as an event, the SSR state of every
+ * second is in the history already. One event per toggle would wrap the event log in under an hour. */
+static void app_job_ssr_toggle(void* arg)
+{
+    app_ctrl_t* ctrl = (app_ctrl_t*)arg;
+    const bool active = !g_ssr_saved.active;
+    const ssr_result_t r = app_ssr_set_active(ctrl->ssr, active);
+    if (r.tag != SSR_STATUS_OK) {
+        log_printf(ESP_LOG_WARN, g_log_tag, "ssr_set_active err tag=%d", (int)r.tag);
+    }
+}
+
+static void app_log_sample(const sample_t* sample)
+{
+    if (sample->channel == SAMPLE_CH_SSR) {
+        if (sample->status == SSR_STATUS_OK) {
+            ESP_LOGI(g_log_tag, "ssr active=%s", (sample->value != 0.0f) ? "true" : "false");
+        } else {
+            ESP_LOGW(g_log_tag, "ssr_get_active err tag=%d", (int)sample->status);
+        }
+        return;
+    }
+
+    const char* name = (sample->channel == SAMPLE_CH_TEMP) ? "temp" : "internal";
+    if (sample->status == TH_STATUS_OK) {
+        ESP_LOGI(g_log_tag, "th %s=%f C", name, sample->value);
+    } else {
+        ESP_LOGW(g_log_tag, "th %s err tag=%d", name, (int)sample->status);
+    }
+}
+
+/* History time of a sample: the wall-clock time rounded to the sample period. A sample on time then stores
+ * no timestamp at all, a delta-of-delta of 0. */
+static int64_t app_history_ms(int64_t at_us)
+{
+    const int64_t period_ms = g_sample_period_ms;
+    return (app_wall_ms(at_us) + period_ms / 2) / period_ms * period_ms;
+}
+
+static void app_store_sample(const sample_t* sample)
+{
+    if (!g_tsdb_ok || sample->status != 0) {
+        /* failed readings leave a gap */
         return;
     }
+    tsdb_result_t r = { .tag = TSDB_STATUS_OK };
+    if (sample->channel == SAMPLE_CH_TEMP) {
+        r = tsdb_append(&g_tsdb, g_tsdb_series_temp, app_history_ms(sample->at_us), (int32_t)lroundf(sample->value * 100.0f));
+    } else if (sample->channel == SAMPLE_CH_SSR) {
+        r = tsdb_append(&g_tsdb, g_tsdb_series_ssr, app_history_ms(sample->at_us), (sample->value != 0.0f) ? 1 : 0);
+    }
+    if (r.tag != TSDB_STATUS_OK) {
+        ESP_LOGW(g_log_tag, "tsdb_append err tag=%d err=%s", (int)r.tag, esp_err_to_name(r.value.esp_code));
+    }
+}
+
+static void app_flush_history(void)
+{
+    const tsdb_result_t r = tsdb_flush(&g_tsdb);
+    if (r.tag != TSDB_STATUS_OK) {
+        ESP_LOGW(g_log_tag, "tsdb_flush err tag=%d err=%s", (int)r.tag, esp_err_to_name(r.value.esp_code));
+    }
+    const uint32_t centibits = tsdb_centibits_per_sample(&g_tsdb);
+    ESP_LOGI(g_log_tag, "tsdb pages written=%lu full=%lu corrupt=%lu, %lu.%02lu bit/sample", (unsigned long)g_tsdb.pages_written,
+        (unsigned long)g_tsdb.pages_closed, (unsigned long)g_tsdb.corrupt_pages, (unsigned long)(centibits / 100),
+        (unsigned long)(centibits % 100));
+    if (g_evlog_ok) {
+        ESP_LOGI(g_log_tag, "evlog appended=%lu erased=%lu torn=%lu dropped=%lu queue dropped=%lu",
+            (unsigned long)g_evlog.appended, (unsigned long)g_evlog.sectors_erased, (unsigned long)g_evlog.torn,
+            (unsigned long)g_evlog.dropped, (unsigned long)g_event_queue.dropped);
+    }
+}
+
+static void app_store_events(void)
+{
+    evlog_record_t record;
+    while (spsc_queue_pop(&g_event_queue, &record)) {
+        if (!g_evlog_ok) {
+            continue;
+        }
+        const evlog_result_t r = evlog_append(&g_evlog, &record);
+        if (r.tag != EVLOG_STATUS_OK) {
+            ESP_LOGW(g_log_tag, "evlog_append err tag=%d err=%s", (int)r.tag, esp_err_to_name(r.value.esp_code));
+        }
+    }
+}
+
+static void app_sync_events(void)
+{
+    const evlog_result_t r = evlog_sync(&g_evlog);
+    if (r.tag != EVLOG_STATUS_OK) {
+        ESP_LOGW(g_log_tag, "evlog_sync err tag=%d err=%s", (int)r.tag, esp_err_to_name(r.value.esp_code));
+    }
+}
 
-    const app_status_t timer_rc = app_init_led_timer();
-    if (timer_rc.tag != APP_STATUS_OK) {
-        app_log_status("timer_init", timer_rc);
+/* Formatting, the UART write and the flash writes run here, on the network core
+ * and at low priority, the control task only copies the samples into the ring */
+static void app_task_telemetry(void* arg)
+{
+    (void)arg;
+    int64_t flushed_us = esp_timer_get_time();
+    int64_t synced_us = flushed_us;
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(g_telemetry_period_ms));
+        sample_t sample;
+        while (sample_ring_pop(&g_telemetry_ring, &sample)) {
+            app_log_sample(&sample);
+            app_store_sample(&sample);
+        }
+        app_store_events();
+        /* events are rare, a few seconds in RAM batches a burst into one write */
+        if (g_evlog_ok && g_evlog.pending > 0 && esp_timer_get_time() - synced_us >= g_evlog_sync_us) {
+            app_sync_events();
+            synced_us = esp_timer_get_time();
+        }
+        if (g_tsdb_ok && esp_timer_get_time() - flushed_us >= g_tsdb_flush_us) {
+            app_flush_history();
+            flushed_us = esp_timer_get_time();
+        }
+    }
+}
+
+#if CONFIG_APP_NET_FLOOD_TEST
+/* Network load for latency tests. One tick of sleep per burst lets the idle task of the core run. */
+static void app_task_net_flood(void* arg)
+{
+    (void)arg;
+    static uint8_t payload[1472]; /* fills a 1500 byte MTU */
+    const int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        ESP_LOGE(g_log_tag, "flood socket failed: errno=%d", errno);
+        vTaskDelete(NULL);
         return;
     }
+    const int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_BROADCAST, &on, sizeof(on));
+
+    struct sockaddr_in to = { 0 };
+    to.sin_family = AF_INET;
+    to.sin_port = htons(g_flood_port);
+    to.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+    while (true) {
+        uint32_t i = 0;
+        for (i = 0; i < g_flood_burst; ++i) {
+            if (sendto(sock, payload, sizeof(payload), 0, (const struct sockaddr*)&to, sizeof(to)) > 0) {
+                g_flood_sent += 1;
+            }
+        }
+        vTaskDelay(1);
+    }
+}
+#endif
+
+#if CONFIG_APP_METRICS
+static void app_metrics_collect_i2c(metrics_i2c_t* out, const char* name, const i2c_async_dev_t* dev)
+{
+    out->name = name;
+    out->addr = (uint8_t)dev->addr;
+    out->scl_hz = dev->scl_hz;
+    out->transfers = dev->submitted;
+    out->failed = dev->failed;
+    out->step_downs = dev->step_downs;
+    out->step_ups = dev->step_ups;
+}
+
+/* Only copies, a scrape reads no I2C device, the readings are the ones of the last sample job */
+static void app_metrics_collect(metrics_values_t* values)
+{
+    memset(values, 0, sizeof(*values));
+    values->uptime_us = esp_timer_get_time();
+
+    if (atomic_load_explicit(&g_live.samples, memory_order_acquire) > 0) {
+        values->th_valid = true;
+        values->th_status = (uint8_t)atomic_load_explicit(&g_live.th_status, memory_order_relaxed);
+        values->temp_centi = atomic_load_explicit(&g_live.temp_centi, memory_order_relaxed);
+        values->internal_temp_centi = atomic_load_explicit(&g_live.internal_temp_centi, memory_order_relaxed);
+        values->ssr_valid = true;
+        values->ssr_status = (uint8_t)atomic_load_explicit(&g_live.ssr_status, memory_order_relaxed);
+        values->ssr_active = atomic_load_explicit(&g_live.ssr_active, memory_order_relaxed);
+    }
+
+    app_metrics_collect_i2c(&values->i2c[0], "ssr", &g_ssr.async);
+    app_metrics_collect_i2c(&values->i2c[1], "th", &g_th.async);
+    values->i2c_count = 2;
+
+    eth_w5500_frame_stats_t frames;
+    eth_w5500_link_stats_t link;
+    if (g_eth_handle != NULL && esp_eth_ioctl(g_eth_handle, ETH_W5500_CMD_G_FRAME_STATS, &frames) == ESP_OK
+        && esp_eth_ioctl(g_eth_handle, ETH_W5500_CMD_G_LINK_STATS, &link) == ESP_OK) {
+        values->eth_valid = true;
+        values->eth_rx_frames = frames.rx_frames;
+        values->eth_rx_bytes = frames.rx_bytes;
+        values->eth_rx_dropped = frames.rx_dropped;
+        values->eth_tx_frames = frames.tx_frames;
+        values->eth_tx_bytes = frames.tx_bytes;
+        values->eth_tx_errors = frames.tx_errors;
+        values->eth_link_flaps = link.flaps;
+    }
+
+    values->heap_free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    values->heap_min_free = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    values->heap_internal_free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    values->heap_internal_min_free = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    values->heap_internal_largest = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+}
+
+static esp_err_t app_metrics_send_chunk(void* ctx, const char* data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t*)ctx, data, (ssize_t)len);
+}
+
+static esp_err_t app_http_metrics(httpd_req_t* req)
+{
+    httpd_resp_set_type(req, "text/plain; version=0.0.4; charset=utf-8");
+    app_metrics_collect(&g_metrics_values);
+
+    metrics_buf_t buf;
+    metrics_buf_init(&buf, g_metrics_chunk, sizeof(g_metrics_chunk), app_metrics_send_chunk, req);
+    metrics_render(&buf, &g_metrics_values);
+    esp_err_t rc = metrics_finish(&buf);
+    if (rc == ESP_OK) {
+        rc = httpd_resp_send_chunk(req, NULL, 0);
+    }
+    return rc;
+}
 
-    const app_status_t eth_rc = app_init_eth_w5500();
-    if (eth_rc.tag != APP_STATUS_OK) {
-        app_log_status("eth_w5500_init", eth_rc);
+/* One small server on the network core, a scrape at a time: the page goes out from one static chunk buffer */
+static void app_init_metrics(void)
+{
+    httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.server_port = CONFIG_APP_METRICS_PORT;
+    config.core_id = g_net_core;
+    config.task_priority = g_metrics_task_priority;
+    config.stack_size = g_metrics_stack_size;
+    config.max_open_sockets = 2;
+    config.max_uri_handlers = 1;
+    config.lru_purge_enable = true;
+
+    esp_err_t rc = httpd_start(&g_metrics_server, &config);
+    if (rc == ESP_OK) {
+        static const httpd_uri_t uri = {
+            .uri = "/metrics",
+            .method = HTTP_GET,
+            .handler = app_http_metrics,
+        };
+        rc = httpd_register_uri_handler(g_metrics_server, &uri);
+    }
+    if (rc != ESP_OK) {
+        ESP_LOGW(g_log_tag, "metrics server not started: %s", esp_err_to_name(rc));
         return;
     }
+    ESP_LOGI(g_log_tag, "metrics on http port %d /metrics", CONFIG_APP_METRICS_PORT);
+}
+#endif
+
+#if CONFIG_APP_LOG_UDP
+/* Every log line, of ESP_LOGx() and of the log task, goes to the UART and the stream. The stream formats it
+ * into its own line buffer, the caller's stack carries no copy of the line. */
+static int app_log_vprintf(const char* fmt, va_list args)
+{
+    va_list copy;
+    va_copy(copy, args);
+    log_stream_vprintf(&g_log_stream, fmt, copy);
+    va_end(copy);
+    return g_log_vprintf_uart(fmt, args);
+}
+#endif
+
+/* Formats the log lines the control task stored and sends the log stream,
+ * on the network core and below the telemetry task */
+static void app_task_log(void* arg)
+{
+    (void)arg;
+#if CONFIG_APP_LOG_UDP
+    int64_t streamed_us = esp_timer_get_time();
+#endif
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(g_log_period_ms));
+        dlog_flush();
+#if CONFIG_APP_LOG_UDP
+        /* nothing goes out before the first address, the lines wait in the ring */
+        if (g_log_stream_ok && g_got_ip_us != 0) {
+            const bool partial = esp_timer_get_time() - streamed_us >= g_log_stream_period_us;
+            log_stream_flush(&g_log_stream, partial);
+            if (partial) {
+                streamed_us = esp_timer_get_time();
+            }
+        }
+#endif
+    }
+}
+
+/* Without the log task the control task logs inline, a ring would only fill up */
+static void app_attach_ctrl_log(void)
+{
+    if (g_log_task_ok && dlog_attach(&g_ctrl_log) != ESP_OK) {
+        ESP_LOGW(g_log_tag, "dlog_attach failed, control task logs inline");
+    }
+}
+
+static void app_task_ctrl(void* arg)
+{
+    app_attach_ctrl_log();
+    job_sched_run((job_sched_t*)arg);
+}
+
+static void app_job_stats(void* arg)
+{
+    const app_ctrl_t* ctrl = (const app_ctrl_t*)arg;
+    uint32_t i = 0;
+    app_i2c_log_stats("ssr", &ctrl->ssr->async);
+    app_i2c_log_stats("th", &ctrl->th->async);
+    log_printf(ESP_LOG_INFO, g_log_tag, "th xfers=%lu, samples pushed=%lu dropped=%lu",
+        (unsigned long)ctrl->th->transactions, (unsigned long)g_telemetry_ring.pushed, (unsigned long)g_telemetry_ring.queue.dropped);
+    if (g_ctrl_log.calls > 0) {
+        log_printf(ESP_LOG_INFO, g_log_tag, "log %s calls=%lu cycles avg=%lu max=%lu", g_log_mode,
+            (unsigned long)g_ctrl_log.calls, (unsigned long)(g_ctrl_log.cycles_sum / g_ctrl_log.calls),
+            (unsigned long)g_ctrl_log.cycles_max);
+    }
+#if CONFIG_APP_NET_FLOOD_TEST
+    log_printf(ESP_LOG_INFO, g_log_tag, "flood sent=%lu", (unsigned long)g_flood_sent);
+#endif
+#if CONFIG_APP_LOG_UDP
+    /* share of one core since boot, in hundredths of a percent */
+    const uint32_t stream_cpu = (uint32_t)(g_log_stream.busy_us * 10000 / esp_timer_get_time());
+    log_printf(ESP_LOG_INFO, g_log_tag,
+        "logudp lines=%lu dropped=%lu datagrams=%lu bytes=%lu errors=%lu cpu=%lu.%02lu%%",
+        (unsigned long)g_log_stream.lines, (unsigned long)g_log_stream.dropped,
+        (unsigned long)g_log_stream.datagrams, (unsigned long)g_log_stream.bytes_sent,
+        (unsigned long)g_log_stream.send_errors, (unsigned long)(stream_cpu / 100), (unsigned long)(stream_cpu % 100));
+#endif
+    for (i = 0; i < g_sched.count; ++i) {
+        const job_sched_job_t* job = &g_sched.jobs[i];
+        const int64_t jitter_avg_us = (job->runs > 0) ? job->jitter_sum_us / job->runs : 0;
+        log_printf(ESP_LOG_INFO, g_log_tag,
+            "sched %-9s runs=%lu overruns=%lu jitter avg=%" PRId64 " max=%" PRId64 " us exec max=%" PRId64 " us",
+            job->name, (unsigned long)job->runs, (unsigned long)job->overruns, jitter_avg_us,
+            job->jitter_max_us, job->exec_max_us);
+    }
+}
+
+/* The phases keep jobs with the same period apart, one does not start late behind another */
+static app_status_t app_init_sched(app_ctrl_t* ctrl)
+{
+    esp_err_t rc = sample_ring_init(&g_telemetry_ring);
+    if (rc == ESP_OK) {
+        rc = spsc_queue_init(&g_event_queue, g_event_items, sizeof(g_event_items[0]), APP_EVENT_QUEUE_LEN);
+    }
+    if (rc == ESP_OK) {
+        rc = job_sched_init(&g_sched);
+    }
+    if (rc == ESP_OK) {
+        rc = job_sched_add(&g_sched, "sample", g_sample_period_ms, 0, app_job_sample, ctrl);
+    }
+    if (rc == ESP_OK) {
+        rc = job_sched_add(&g_sched, "ssr", g_ssr_toggle_period_ms, 500, app_job_ssr_toggle, ctrl);
+    }
+    if (rc == ESP_OK) {
+        rc = job_sched_add(&g_sched, "stats", g_stats_period_ms, 750, app_job_stats, ctrl);
+    }
+    if (rc == ESP_OK && g_i2c_scan.pending) {
+        /* released between the other jobs, a probe timeout ends before the next of them */
+        rc = job_sched_add(&g_sched, "i2c_scan", g_i2c_scan_period_ms, g_i2c_scan_phase_ms, app_job_i2c_scan, NULL);
+    }
+    if (rc != ESP_OK) {
+        return (app_status_t) { .tag = APP_STATUS_SCHED_ERR, .value = { .esp_code = rc } };
+    }
+    return (app_status_t) { .tag = APP_STATUS_OK, .value = { .reserved = 0 } };
+}
+
+void app_main(void)
+{
+    app_boot_mark("app_main");
+#if CONFIG_APP_LOG_UDP
+    /* first, so the boot log is streamed as well */
+    g_log_stream_ok = log_stream_init(&g_log_stream, CONFIG_APP_LOG_UDP_HOST, CONFIG_APP_LOG_UDP_PORT) == ESP_OK;
+    if (g_log_stream_ok) {
+        g_log_vprintf_uart = esp_log_set_vprintf(app_log_vprintf);
+    } else {
+        ESP_LOGW(g_log_tag, "log collector \"%s\" is no IPv4 address, no log stream", CONFIG_APP_LOG_UDP_HOST);
+    }
+#endif
+    g_log_task_ok = xTaskCreatePinnedToCore(app_task_log, "log", g_log_stack_size, NULL, g_log_task_priority, NULL,
+                        g_net_core)
+        == pdPASS;
+    if (!g_log_task_ok) {
+        ESP_LOGW(g_log_tag, "log task not created, the control task logs inline");
+    }
+    /* the lease cache (and the DHCP client restoring its address) needs NVS before ethernet comes up */
+    const app_status_t nvs_rc = app_init_nvs();
+    if (nvs_rc.tag != APP_STATUS_OK) {
+        app_log_status("nvs_init", nvs_rc);
+    }
+    g_boot_task = xTaskGetCurrentTaskHandle();
+    const bool eth_async = xTaskCreatePinnedToCore(app_task_eth_init, "eth_init", g_eth_init_stack_size, NULL,
+                               uxTaskPriorityGet(NULL), NULL, g_net_core)
+        == pdPASS;
+    if (!eth_async) {
+        ESP_LOGW(g_log_tag, "eth_init task not created, bringing up ethernet in sequence");
+        g_eth_init_status = app_init_eth_w5500();
+    }
 
     const app_status_t i2c_rc = app_init_i2c();
+    app_boot_mark("i2c bus");
+
+    ssr_result_t r = { .tag = SSR_STATUS_ARG_ERR, .value = { .reserved = 0 } };
+
+    if (i2c_rc.tag == APP_STATUS_OK) {
+        r = ssr_init(&g_ssr, g_i2c_bus, 0x50, 200, g_ssr_scl_hz);
+        if (r.tag == SSR_STATUS_OK) {
+            const ssr_result_t restore_r = app_ssr_restore(&g_ssr);
+            if (restore_r.tag != SSR_STATUS_OK) {
+                ESP_LOGW(g_log_tag, "ssr restore err tag=%d", (int)restore_r.tag);
+            }
+        }
+        app_boot_mark("ssr restored");
+    }
+
+    /* the LED is only a heartbeat, carry on without it */
+    const app_status_t led_rc = app_init_led();
+    if (led_rc.tag != APP_STATUS_OK) {
+        app_log_status("led_init", led_rc);
+    } else {
+        const app_status_t timer_rc = app_init_led_timer();
+        if (timer_rc.tag != APP_STATUS_OK) {
+            app_log_status("timer_init", timer_rc);
+        }
+    }
+    app_boot_mark("led");
+
+    if (i2c_rc.tag == APP_STATUS_OK) {
+        app_i2c_probe_and_report();
+        app_boot_mark("i2c probe");
+    }
+
+    if (eth_async) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    app_boot_mark("eth ready");
+    app_boot_log();
+
+    /* keep controlling the SSR without a network */
+    if (g_eth_init_status.tag != APP_STATUS_OK) {
+        app_log_status("eth_w5500_init", g_eth_init_status);
+    }
+#if CONFIG_APP_METRICS
+    else {
+        app_init_metrics();
+    }
+#endif
+
     if (i2c_rc.tag != APP_STATUS_OK) {
         app_log_status("i2c_init", i2c_rc);
         return;
     }
 
-    app_i2c_scan_and_report();
-
-    ssr_t ssr = { 0 };
-    th_t th = { 0 };
-
-    ssr_result_t r = ssr_init(&ssr, g_i2c_bus, 0x50, 200);
-    th_result_t th_r = th_init(&th, g_i2c_bus, 0x66, 200);
+    th_result_t th_r = th_init(&g_th, g_i2c_bus, 0x66, 200, g_th_scl_hz);
 
     if (r.tag != SSR_STATUS_OK) {
         if (r.tag == SSR_STATUS_I2C_ERR) {
@@ -436,8 +1618,10 @@ void app_main(void)
         } else {
             ESP_LOGE(g_log_tag, "ssr_init failed: tag=%d", (int)r.tag);
         }
+        /* no control task, nothing else uses the bus */
+        app_i2c_full_scan();
     } else {
-        r = ssr_get_active(&ssr);
+        r = ssr_get_active(&g_ssr);
         if (r.tag == SSR_STATUS_OK) {
             ESP_LOGI(g_log_tag, "ssr active=%s", r.value.active ? "true" : "false");
         } else if (r.tag == SSR_STATUS_I2C_ERR) {
@@ -445,8 +1629,9 @@ void app_main(void)
         } else {
             ESP_LOGW(g_log_tag, "ssr_get_active err tag=%d", (int)r.tag);
         }
+        g_ctrl.ssr_r = r;
 
-        r = ssr_get_version(&ssr);
+        r = ssr_get_version(&g_ssr);
         if (r.tag == SSR_STATUS_OK) {
             ESP_LOGI(g_log_tag, "ssr version=0x%02X", r.value.version);
 
@@ -455,66 +1640,64 @@ void app_main(void)
         } else {
             ESP_LOGW(g_log_tag, "ssr_get_version err tag=%d", (int)r.tag);
         }
-        while (true) {
-
-            th_r = th_get_temp_c(&th); // get float using string read + conversion
-
-            if (th_r.tag == TH_STATUS_OK) {
-                ESP_LOGI(g_log_tag, "sth temp=%f C", th_r.value.temp_c);
-            } else if (th_r.tag == TH_STATUS_I2C_ERR) {
-                ESP_LOGW(
-                    g_log_tag, "sth_get_temp_c i2c err=%s", esp_err_to_name(th_r.value.esp_code));
-            } else if (th_r.tag == TH_STATUS_SENSOR_ERR) {
-                ESP_LOGW(
-                    g_log_tag, "sth_get_temp_c sensor error, status=0x%08X", th_r.value.status);
-            } else {
-                ESP_LOGW(g_log_tag, "sth_get_temp_c err tag=%d", (int)th_r.tag);
-            }
-
-            th_r = th_get_temp_c_float(&th); // get float using direct raw read
-
-            if (th_r.tag == TH_STATUS_OK) {
-                ESP_LOGI(g_log_tag, "th tempf=%f C", th_r.value.temp_c);
-            } else if (th_r.tag == TH_STATUS_I2C_ERR) {
-                ESP_LOGW(
-                    g_log_tag, "th_get_temp_c i2c err=%s", esp_err_to_name(th_r.value.esp_code));
-            } else if (th_r.tag == TH_STATUS_SENSOR_ERR) {
-                ESP_LOGW(g_log_tag, "th_get_temp_c sensor error, status=0x%08X", th_r.value.status);
-            } else {
-                ESP_LOGW(g_log_tag, "th_get_temp_c err tag=%d", (int)th_r.tag);
-            }
-
-            r = ssr_get_active(&ssr);
-            if (r.tag == SSR_STATUS_OK) {
-                ESP_LOGI(g_log_tag, "ssr active=%s", r.value.active ? "true" : "false");
-            } else {
-                ESP_LOGW(g_log_tag, "ssr_get_active err tag=%d", (int)r.tag);
-            }
-
-            vTaskDelay(pdMS_TO_TICKS(1000));
-
-            r = ssr_set_active(&ssr, !r.value.active);
-            if (r.tag != SSR_STATUS_OK) {
-                ESP_LOGW(g_log_tag, "ssr_set_active err tag=%d", (int)r.tag);
-            }
-            ESP_LOGI(g_log_tag, "toggled ssr active state, sleeping 1s...");
-            r = ssr_get_active(&ssr);
-            if (r.tag == SSR_STATUS_OK) {
-                ESP_LOGI(g_log_tag, "ssr active=%s", r.value.active ? "true" : "false");
-            } else {
-                ESP_LOGW(g_log_tag, "ssr_get_active err tag=%d", (int)r.tag);
-            }
-
-            vTaskDelay(pdMS_TO_TICKS(1000));
 
-            r = ssr_set_active(&ssr, !r.value.active);
-            if (r.tag != SSR_STATUS_OK) {
-                ESP_LOGW(g_log_tag, "ssr_set_active err tag=%d", (int)r.tag);
-            }
-            ESP_LOGI(g_log_tag, "toggled ssr active state, sleeping 1s...");
+        g_ctrl.th = &g_th;
+        g_ctrl.ssr = &g_ssr;
+        g_ctrl.th_r = th_r;
+        const app_status_t sched_rc = app_init_sched(&g_ctrl);
+        if (sched_rc.tag != APP_STATUS_OK) {
+            app_log_status("sched_init", sched_rc);
+            ssr_deinit(&g_ssr);
+            app_i2c_full_scan();
+            return;
+        }
+        const tsdb_result_t tsdb_rc = tsdb_init(&g_tsdb, g_tsdb_label);
+        g_tsdb_ok = tsdb_rc.tag == TSDB_STATUS_OK;
+        if (g_tsdb_ok) {
+            /* history timestamps restart with the clock, a query needs this epoch */
+            ESP_LOGI(g_log_tag, "tsdb boot epoch=%lu", (unsigned long)g_tsdb.boot);
+        } else {
+            ESP_LOGW(g_log_tag, "tsdb_init err tag=%d err=%s, no history", (int)tsdb_rc.tag,
+                esp_err_to_name(tsdb_rc.value.esp_code));
+        }
+        /* the telemetry task is not running yet, app_main is the only writer here */
+        const evlog_result_t evlog_rc = evlog_init(&g_evlog, g_evlog_label);
+        g_evlog_ok = evlog_rc.tag == EVLOG_STATUS_OK;
+        if (g_evlog_ok) {
+            const evlog_record_t boot = {
+                .t_ms = app_wall_ms(esp_timer_get_time()),
+                .type = EVLOG_BOOT,
+                .value = (int32_t)esp_reset_reason(),
+            };
+            evlog_append(&g_evlog, &boot);
+            app_sync_events();
+            ESP_LOGI(g_log_tag, "evlog sector=%lu slot=%lu seq=%lu torn=%lu", (unsigned long)g_evlog.sector,
+                (unsigned long)g_evlog.slot, (unsigned long)g_evlog.next_seq, (unsigned long)g_evlog.torn);
+        } else {
+            ESP_LOGW(g_log_tag, "evlog_init err tag=%d err=%s, no event log", (int)evlog_rc.tag,
+                esp_err_to_name(evlog_rc.value.esp_code));
+        }
+        if (xTaskCreatePinnedToCore(app_task_telemetry, "telemetry", g_telemetry_stack_size, NULL,
+                g_telemetry_task_priority, NULL, g_net_core)
+            != pdPASS) {
+            ESP_LOGW(g_log_tag, "telemetry task not created, samples are not logged");
+        }
+#if CONFIG_APP_NET_FLOOD_TEST
+        if (xTaskCreatePinnedToCore(app_task_net_flood, "net_flood", g_flood_stack_size, NULL,
+                g_flood_task_priority, NULL, g_net_core)
+            != pdPASS) {
+            ESP_LOGW(g_log_tag, "net_flood task not created");
+        }
+#endif
+        if (xTaskCreatePinnedToCore(app_task_ctrl, "ctrl", g_ctrl_stack_size, &g_sched, g_ctrl_task_priority,
+                NULL, g_ctrl_core)
+            != pdPASS) {
+            ESP_LOGW(g_log_tag, "ctrl task not created, running the jobs in app_main");
+            vTaskPrioritySet(NULL, g_ctrl_task_priority);
+            app_attach_ctrl_log();
+            job_sched_run(&g_sched);
         }
-        ssr_deinit(&ssr);
     }
 
-    ESP_LOGI(g_log_tag, "running: led timer=%lld us + i2c scan done + w5500 up", g_led_period_us);
+    ESP_LOGI(g_log_tag, "running: led timer=%lld us + i2c probe done + w5500 up", g_led_period_us);
 }
@@ -0,0 +1,172 @@
+#include "metrics.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+
+void metrics_buf_init(metrics_buf_t* self, char* data, size_t size, metrics_sink_fn_t sink, void* ctx)
+{
+    self->data = data;
+    self->size = size;
+    self->len = 0;
+    self->sink = sink;
+    self->ctx = ctx;
+    self->err = (data != NULL && size > 1) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    self->chunks = 0;
+}
+
+static void metrics_flush(metrics_buf_t* self)
+{
+    if (self->len == 0 || self->err != ESP_OK) {
+        return;
+    }
+    self->err = self->sink(self->ctx, self->data, self->len);
+    self->len = 0;
+    self->chunks += 1;
+}
+
+void metrics_printf(metrics_buf_t* self, const char* fmt, ...)
+{
+    uint32_t attempt = 0;
+    for (attempt = 0; attempt < 2 && self->err == ESP_OK; ++attempt) {
+        const size_t room = self->size - self->len;
+        va_list args;
+        va_start(args, fmt);
+        const int n = vsnprintf(&self->data[self->len], room, fmt, args);
+        va_end(args);
+        if (n < 0) {
+            return;
+        }
+        if ((size_t)n < room) {
+            self->len += (size_t)n;
+            return;
+        }
+        if (self->len == 0) {
+            /* longer than the whole buffer, keep it cut but still a line of its own */
+            self->data[self->size - 2] = '\n';
+            self->len = self->size - 1;
+            return;
+        }
+        /* drops the cut copy, the line is printed again into the empty buffer */
+        metrics_flush(self);
+    }
+}
+
+esp_err_t metrics_finish(metrics_buf_t* self)
+{
+    metrics_flush(self);
+    return self->err;
+}
+
+static void metrics_family(metrics_buf_t* self, const char* name, const char* type, const char* help)
+{
+    metrics_printf(self, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/* 0.01 units as a decimal, -1825 is "-18.25" */
+static void metrics_centi(metrics_buf_t* self, const char* name, const char* labels, int32_t centi)
+{
+    const uint32_t abs_centi = (centi < 0) ? (uint32_t)(-(int64_t)centi) : (uint32_t)centi;
+    metrics_printf(self, "%s%s %s%lu.%02lu\n", name, labels, (centi < 0) ? "-" : "",
+        (unsigned long)(abs_centi / 100), (unsigned long)(abs_centi % 100));
+}
+
+static void metrics_render_sensors(metrics_buf_t* self, const metrics_values_t* values)
+{
+    /* a failed reading leaves the temperature out, the status says why */
+    if (values->th_valid && values->th_status == 0) {
+        metrics_family(self, "freezer_temperature_celsius", "gauge", "Latest temperature reading.");
+        metrics_centi(self, "freezer_temperature_celsius", "{probe=\"thermocouple\"}", values->temp_centi);
+        metrics_centi(self, "freezer_temperature_celsius", "{probe=\"internal\"}", values->internal_temp_centi);
+    }
+    if (values->th_valid || values->ssr_valid) {
+        metrics_family(self, "freezer_device_status", "gauge", "Status tag of the latest read, 0 is OK.");
+    }
+    if (values->th_valid) {
+        metrics_printf(self, "freezer_device_status{device=\"th\"} %u\n", (unsigned)values->th_status);
+    }
+    if (values->ssr_valid) {
+        metrics_printf(self, "freezer_device_status{device=\"ssr\"} %u\n", (unsigned)values->ssr_status);
+        if (values->ssr_status == 0) {
+            metrics_family(self, "freezer_ssr_active", "gauge", "SSR state read back, 1 is on.");
+            metrics_printf(self, "freezer_ssr_active %u\n", values->ssr_active ? 1u : 0u);
+        }
+    }
+}
+
+static void metrics_i2c_line(metrics_buf_t* self, const char* name, const metrics_i2c_t* dev, uint32_t value)
+{
+    metrics_printf(self, "%s{device=\"%s\",addr=\"0x%02X\"} %lu\n", name, dev->name, (unsigned)dev->addr,
+        (unsigned long)value);
+}
+
+static void metrics_render_i2c(metrics_buf_t* self, const metrics_values_t* values)
+{
+    const uint32_t count = (values->i2c_count < METRICS_I2C_MAX) ? values->i2c_count : METRICS_I2C_MAX;
+    uint32_t i = 0;
+
+    metrics_family(self, "freezer_i2c_transfers_total", "counter", "I2C transactions submitted.");
+    for (i = 0; i < count; ++i) {
+        metrics_i2c_line(self, "freezer_i2c_transfers_total", &values->i2c[i], values->i2c[i].transfers);
+    }
+    metrics_family(self, "freezer_i2c_errors_total", "counter", "I2C transactions failed (NACK, timeout).");
+    for (i = 0; i < count; ++i) {
+        metrics_i2c_line(self, "freezer_i2c_errors_total", &values->i2c[i], values->i2c[i].failed);
+    }
+    metrics_family(self, "freezer_i2c_clock_step_downs_total", "counter", "SCL clock lowered after an error.");
+    for (i = 0; i < count; ++i) {
+        metrics_i2c_line(self, "freezer_i2c_clock_step_downs_total", &values->i2c[i], values->i2c[i].step_downs);
+    }
+    metrics_family(self, "freezer_i2c_clock_step_ups_total", "counter", "SCL clock raised again.");
+    for (i = 0; i < count; ++i) {
+        metrics_i2c_line(self, "freezer_i2c_clock_step_ups_total", &values->i2c[i], values->i2c[i].step_ups);
+    }
+    metrics_family(self, "freezer_i2c_clock_hz", "gauge", "SCL clock in use.");
+    for (i = 0; i < count; ++i) {
+        metrics_i2c_line(self, "freezer_i2c_clock_hz", &values->i2c[i], values->i2c[i].scl_hz);
+    }
+}
+
+static void metrics_render_eth(metrics_buf_t* self, const metrics_values_t* values)
+{
+    if (!values->eth_valid) {
+        return;
+    }
+    metrics_family(self, "freezer_eth_frames_total", "counter", "W5500 frames to and from the TCP/IP stack.");
+    metrics_printf(self, "freezer_eth_frames_total{direction=\"rx\"} %lu\n", (unsigned long)values->eth_rx_frames);
+    metrics_printf(self, "freezer_eth_frames_total{direction=\"tx\"} %lu\n", (unsigned long)values->eth_tx_frames);
+    metrics_family(self, "freezer_eth_bytes_total", "counter", "Bytes of those frames.");
+    metrics_printf(self, "freezer_eth_bytes_total{direction=\"rx\"} %" PRIu64 "\n", values->eth_rx_bytes);
+    metrics_printf(self, "freezer_eth_bytes_total{direction=\"tx\"} %" PRIu64 "\n", values->eth_tx_bytes);
+    metrics_family(
+        self, "freezer_eth_frames_dropped_total", "counter", "Frames lost (rx) or refused (tx) by the W5500 driver.");
+    metrics_printf(
+        self, "freezer_eth_frames_dropped_total{direction=\"rx\"} %lu\n", (unsigned long)values->eth_rx_dropped);
+    metrics_printf(
+        self, "freezer_eth_frames_dropped_total{direction=\"tx\"} %lu\n", (unsigned long)values->eth_tx_errors);
+    metrics_family(self, "freezer_eth_link_flaps_total", "counter", "Ethernet link changes.");
+    metrics_printf(self, "freezer_eth_link_flaps_total %lu\n", (unsigned long)values->eth_link_flaps);
+}
+
+static void metrics_render_heap(metrics_buf_t* self, const metrics_values_t* values)
+{
+    metrics_family(self, "freezer_heap_free_bytes", "gauge", "Free heap.");
+    metrics_printf(self, "freezer_heap_free_bytes{caps=\"8bit\"} %lu\n", (unsigned long)values->heap_free);
+    metrics_printf(self, "freezer_heap_free_bytes{caps=\"internal\"} %lu\n", (unsigned long)values->heap_internal_free);
+    metrics_family(self, "freezer_heap_min_free_bytes", "gauge", "Lowest free heap since boot.");
+    metrics_printf(self, "freezer_heap_min_free_bytes{caps=\"8bit\"} %lu\n", (unsigned long)values->heap_min_free);
+    metrics_printf(
+        self, "freezer_heap_min_free_bytes{caps=\"internal\"} %lu\n", (unsigned long)values->heap_internal_min_free);
+    metrics_family(self, "freezer_heap_largest_free_block_bytes", "gauge", "Largest free block of internal memory.");
+    metrics_printf(self, "freezer_heap_largest_free_block_bytes{caps=\"internal\"} %lu\n",
+        (unsigned long)values->heap_internal_largest);
+}
+
+void metrics_render(metrics_buf_t* self, const metrics_values_t* values)
+{
+    metrics_family(self, "freezer_uptime_seconds", "gauge", "Time since boot.");
+    metrics_printf(self, "freezer_uptime_seconds %" PRId64 "\n", values->uptime_us / 1000000);
+    metrics_render_sensors(self, values);
+    metrics_render_i2c(self, values);
+    metrics_render_eth(self, values);
+    metrics_render_heap(self, values);
+}
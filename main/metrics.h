@@ -0,0 +1,104 @@
+/**
+ * @file metrics.h
+ * @brief Prometheus text exposition rendered into a fixed buffer, sent in chunks.
+ *
+ * The page is written into a buffer owned by the caller. When the next line
+ * does not fit, the buffer is handed to a sink (an HTTP chunk) and reused,
+ * so a page of any length needs neither `malloc()` nor more than one buffer.
+ * Values are integers, fractions are printed from fixed point: no floating
+ * point formatting, which in newlib may allocate.
+ *
+ * The values are collected by the caller into a `metrics_values_t` first,
+ * rendering reads nothing else.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+/** I2C devices one page shows */
+#define METRICS_I2C_MAX 2
+
+/**
+ * @brief Takes a full buffer, e.g. `httpd_resp_send_chunk()`.
+ */
+typedef esp_err_t (*metrics_sink_fn_t)(void *ctx, const char *data, size_t len);
+
+typedef struct metrics_buf_s {
+    char *data;
+    size_t size;
+    size_t len;
+    metrics_sink_fn_t sink;
+    void *ctx;
+    esp_err_t err;     /**< first sink error, nothing is rendered after it */
+    uint32_t chunks;   /**< buffers handed to the sink */
+} metrics_buf_t;
+
+typedef struct metrics_i2c_s {
+    const char *name;
+    uint8_t addr;
+    uint32_t scl_hz;
+    uint32_t transfers;
+    uint32_t failed;
+    uint32_t step_downs;
+    uint32_t step_ups;
+} metrics_i2c_t;
+
+/**
+ * @brief Everything one page shows.
+ */
+typedef struct metrics_values_s {
+    int64_t uptime_us;
+    bool th_valid;              /**< a reading was taken, the fields below are set */
+    uint8_t th_status;          /**< `th_status_tag_t`, `TH_STATUS_SENSOR_ERR` for an invalid thermocouple reading */
+    int32_t temp_centi;         /**< thermocouple, 0.01 C */
+    int32_t internal_temp_centi;
+    bool ssr_valid;
+    uint8_t ssr_status;         /**< `ssr_status_tag_t` */
+    bool ssr_active;
+    metrics_i2c_t i2c[METRICS_I2C_MAX];
+    uint32_t i2c_count;
+    bool eth_valid;             /**< the counters below were read from the driver */
+    uint32_t eth_rx_frames;
+    uint64_t eth_rx_bytes;
+    uint32_t eth_rx_dropped;
+    uint32_t eth_tx_frames;
+    uint64_t eth_tx_bytes;
+    uint32_t eth_tx_errors;
+    uint32_t eth_link_flaps;
+    uint32_t heap_free;         /**< all 8-bit capable memory */
+    uint32_t heap_min_free;
+    uint32_t heap_internal_free;
+    uint32_t heap_internal_min_free;
+    uint32_t heap_internal_largest;
+} metrics_values_t;
+
+/**
+ * @brief Start rendering into `data`.
+ */
+void metrics_buf_init(metrics_buf_t *self, char *data, size_t size, metrics_sink_fn_t sink, void *ctx);
+
+/**
+ * @brief Append one formatted line, handing the buffer to the sink first when it does not fit.
+ *
+ * A line longer than the whole buffer is cut.
+ */
+void metrics_printf(metrics_buf_t *self, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Hand the rest of the buffer to the sink.
+ *
+ * @return the first sink error, ESP_OK if there was none
+ */
+esp_err_t metrics_finish(metrics_buf_t *self);
+
+/**
+ * @brief Render the page, call `metrics_finish()` afterwards.
+ */
+void metrics_render(metrics_buf_t *self, const metrics_values_t *values);
+
+#endif // METRICS_H
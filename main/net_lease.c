@@ -0,0 +1,63 @@
+#include "net_lease.h"
+#include "nvs_blob.h"
+
+static const char* g_nvs_namespace = "net_lease";
+static const char* g_nvs_key = "ipv4";
+
+/* bump when net_lease_t changes */
+static const uint32_t g_blob_version = 1;
+
+static net_lease_result_t nvs_err(esp_err_t rc)
+{
+    net_lease_result_t res = { .tag = NET_LEASE_STATUS_NVS_ERR };
+    res.value.esp_code = rc;
+    return res;
+}
+
+net_lease_result_t net_lease_load(net_lease_t* out)
+{
+    net_lease_result_t res = { .tag = NET_LEASE_STATUS_OK };
+    if (!out) {
+        res.tag = NET_LEASE_STATUS_ARG_ERR;
+        return res;
+    }
+
+    net_lease_t lease = { 0 };
+    esp_err_t rc = nvs_blob_load(g_nvs_namespace, g_nvs_key, g_blob_version, &lease, sizeof(lease));
+    if (rc == ESP_ERR_NVS_NOT_FOUND || (rc == ESP_OK && (lease.ip == 0 || lease.netmask == 0))) {
+        res.tag = NET_LEASE_STATUS_NOT_FOUND;
+        return res;
+    }
+    if (rc != ESP_OK) {
+        return nvs_err(rc);
+    }
+
+    *out = lease;
+    return res;
+}
+
+net_lease_result_t net_lease_store(const net_lease_t* lease)
+{
+    net_lease_result_t res = { .tag = NET_LEASE_STATUS_OK };
+    if (!lease || lease->ip == 0) {
+        res.tag = NET_LEASE_STATUS_ARG_ERR;
+        return res;
+    }
+
+    /* a renewal mostly hands out the same lease again, nvs_blob_store() then writes nothing */
+    esp_err_t rc = nvs_blob_store(g_nvs_namespace, g_nvs_key, g_blob_version, lease, sizeof(*lease));
+    if (rc != ESP_OK) {
+        return nvs_err(rc);
+    }
+    return res;
+}
+
+net_lease_result_t net_lease_erase(void)
+{
+    net_lease_result_t res = { .tag = NET_LEASE_STATUS_OK };
+    esp_err_t rc = nvs_blob_erase(g_nvs_namespace, g_nvs_key);
+    if (rc != ESP_OK) {
+        return nvs_err(rc);
+    }
+    return res;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file net_lease.h
+ * @brief Persistent copy of the last IPv4 lease (NVS).
+ *
+ * The lease the DHCP client obtained is kept in NVS so the next boot can use
+ * the same address, netmask, gateway and DNS server before DHCP has answered.
+ * The API follows the project's tagged-union result pattern: functions return
+ * `net_lease_result_t` which carries both a status tag and any error code.
+ */
+
+#ifndef NET_LEASE_H
+#define NET_LEASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+
+/**
+ * @brief Status tags for lease cache operations.
+ */
+typedef enum net_lease_status_tag_e {
+    NET_LEASE_STATUS_OK = 0,
+    NET_LEASE_STATUS_NVS_ERR,
+    NET_LEASE_STATUS_ARG_ERR,
+    NET_LEASE_STATUS_NOT_FOUND,
+} net_lease_status_tag_t;
+
+/**
+ * @brief One IPv4 lease, addresses in network byte order as in `esp_ip4_addr_t`.
+ */
+typedef struct net_lease_s {
+    uint32_t ip;
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t dns;     /**< main DNS server, 0 if none */
+    uint32_t lease_s; /**< lease time granted by the server, 0 if unknown */
+} net_lease_t;
+
+/**
+ * @brief Tagged-union return for lease cache calls.
+ */
+typedef struct net_lease_result_s {
+    net_lease_status_tag_t tag;
+    union {
+        esp_err_t esp_code; /**< underlying NVS error when tag is NVS_ERR */
+        uint32_t reserved;
+    } value;
+} net_lease_result_t;
+
+/**
+ * @brief Read the cached lease.
+ *
+ * `nvs_flash_init()` must have been called.
+ *
+ * @param out lease read from NVS
+ * @return net_lease_result_t `NET_LEASE_STATUS_NOT_FOUND` if no usable lease is stored
+ */
+net_lease_result_t net_lease_load(net_lease_t *out);
+
+/**
+ * @brief Store a lease, flash is only written when it differs from the stored one.
+ */
+net_lease_result_t net_lease_store(const net_lease_t *lease);
+
+/**
+ * @brief Forget the cached lease, e.g. after its address turned out to be in use.
+ */
+net_lease_result_t net_lease_erase(void);
+
+#endif /* NET_LEASE_H */
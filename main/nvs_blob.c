@@ -0,0 +1,96 @@
+#include "nvs_blob.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Internal helper: read the blob of `len` struct bytes into `buf`, version first */
+static esp_err_t read_blob(nvs_handle_t nvs, const char* key, uint8_t* buf, size_t len)
+{
+    size_t got = sizeof(uint32_t) + len;
+    esp_err_t rc = nvs_get_blob(nvs, key, buf, &got);
+    if (rc == ESP_OK && got != sizeof(uint32_t) + len) {
+        rc = ESP_ERR_NVS_NOT_FOUND;
+    }
+    return rc;
+}
+
+static bool blob_version_is(const uint8_t* buf, uint32_t version)
+{
+    uint32_t stored = 0;
+    memcpy(&stored, buf, sizeof(stored));
+    return stored == version;
+}
+
+esp_err_t nvs_blob_load(const char* ns, const char* key, uint32_t version, void* out, size_t len)
+{
+    if (!ns || !key || !out || len == 0 || len > NVS_BLOB_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    /* the namespace is created with the first store, until then it is ESP_ERR_NVS_NOT_FOUND */
+    nvs_handle_t nvs = 0;
+    esp_err_t rc = nvs_open(ns, NVS_READONLY, &nvs);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    uint8_t buf[sizeof(uint32_t) + NVS_BLOB_MAX_LEN] = { 0 };
+    rc = read_blob(nvs, key, buf, len);
+    nvs_close(nvs);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    if (!blob_version_is(buf, version)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    memcpy(out, &buf[sizeof(uint32_t)], len);
+    return ESP_OK;
+}
+
+esp_err_t nvs_blob_store(const char* ns, const char* key, uint32_t version, const void* data, size_t len)
+{
+    if (!ns || !key || !data || len == 0 || len > NVS_BLOB_MAX_LEN) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs = 0;
+    esp_err_t rc = nvs_open(ns, NVS_READWRITE, &nvs);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+
+    /* mostly the same struct is stored again, do not wear the flash for it */
+    uint8_t buf[sizeof(uint32_t) + NVS_BLOB_MAX_LEN] = { 0 };
+    if (read_blob(nvs, key, buf, len) == ESP_OK && blob_version_is(buf, version)
+        && memcmp(&buf[sizeof(uint32_t)], data, len) == 0) {
+        nvs_close(nvs);
+        return ESP_OK;
+    }
+
+    memcpy(buf, &version, sizeof(version));
+    memcpy(&buf[sizeof(uint32_t)], data, len);
+    rc = nvs_set_blob(nvs, key, buf, sizeof(uint32_t) + len);
+    if (rc == ESP_OK) {
+        rc = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return rc;
+}
+
+esp_err_t nvs_blob_erase(const char* ns, const char* key)
+{
+    if (!ns || !key) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    nvs_handle_t nvs = 0;
+    esp_err_t rc = nvs_open(ns, NVS_READWRITE, &nvs);
+    if (rc != ESP_OK) {
+        return rc;
+    }
+    rc = nvs_erase_key(nvs, key);
+    if (rc == ESP_OK) {
+        rc = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    return (rc == ESP_ERR_NVS_NOT_FOUND) ? ESP_OK : rc;
+}
@@ -0,0 +1,41 @@
+/**
+ * @file nvs_blob.h
+ * @brief One versioned struct per NVS key.
+ *
+ * The stored blob is a `uint32_t` version followed by the bytes of the
+ * struct. A blob of another version or size reads as missing, so a module
+ * bumps its version when its struct changes and the old blob is ignored.
+ * `nvs_flash_init()` must have been called.
+ */
+
+#ifndef NVS_BLOB_H
+#define NVS_BLOB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include "nvs.h"
+
+/** Largest struct a blob holds */
+#define NVS_BLOB_MAX_LEN 64
+
+/**
+ * @brief Read the struct stored under `ns` / `key`.
+ *
+ * @return ESP_OK with `out` filled, `ESP_ERR_NVS_NOT_FOUND` when there is no
+ *         namespace, no key or a blob of another version or size (`out` is
+ *         left as is), or the NVS error
+ */
+esp_err_t nvs_blob_load(const char *ns, const char *key, uint32_t version, void *out, size_t len);
+
+/**
+ * @brief Store a struct, flash is only written when it differs from the stored one.
+ */
+esp_err_t nvs_blob_store(const char *ns, const char *key, uint32_t version, const void *data, size_t len);
+
+/**
+ * @brief Remove the blob, ESP_OK when there was none.
+ */
+esp_err_t nvs_blob_erase(const char *ns, const char *key);
+
+#endif /* NVS_BLOB_H */
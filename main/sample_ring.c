@@ -0,0 +1,26 @@
+#include "sample_ring.h"
+
+_Static_assert(sizeof(sample_t) == 16, "sample_t layout changed");
+
+esp_err_t sample_ring_init(sample_ring_t* self)
+{
+    if (!self) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    self->pushed = 0;
+    return spsc_queue_init(&self->queue, self->items, sizeof(self->items[0]), SAMPLE_RING_LEN);
+}
+
+bool sample_ring_push(sample_ring_t* self, const sample_t* sample)
+{
+    if (!spsc_queue_push(&self->queue, sample)) {
+        return false;
+    }
+    self->pushed += 1;
+    return true;
+}
+
+bool sample_ring_pop(sample_ring_t* self, sample_t* sample)
+{
+    return spsc_queue_pop(&self->queue, sample);
+}
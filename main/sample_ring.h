@@ -0,0 +1,70 @@
+/**
+ * @file sample_ring.h
+ * @brief Fixed-size sensor sample records passed from the acquisition task to one consumer.
+ *
+ * A ring is an `spsc_queue_t` with its storage embedded: the acquisition job
+ * pushes, one publisher (log, network, storage) pops, neither takes a mutex.
+ * Every consumer gets a ring of its own. Records are 16 bytes, two per cache
+ * line on the ESP32-S3, and the ring storage starts on a line boundary.
+ */
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "spsc_queue.h"
+
+/** Records one ring holds, a power of two */
+#define SAMPLE_RING_LEN 64
+
+/**
+ * @brief What a sample measures.
+ */
+typedef enum sample_channel_e {
+    SAMPLE_CH_TEMP = 0,      /**< thermocouple temperature in C, status is a `th_status_tag_t` */
+    SAMPLE_CH_INTERNAL_TEMP, /**< KMeterISO die temperature in C, status is a `th_status_tag_t` */
+    SAMPLE_CH_SSR,           /**< SSR read back, 1.0 on and 0.0 off, status is an `ssr_status_tag_t` */
+} sample_channel_t;
+
+/**
+ * @brief One reading. `value` is only meaningful when `status` is 0 (`*_STATUS_OK`).
+ */
+typedef struct sample_s {
+    int64_t at_us;   /**< release time of the sample job, `esp_timer_get_time()` time */
+    float value;
+    uint8_t channel; /**< `sample_channel_t` */
+    uint8_t status;  /**< status tag of the driver call */
+    uint16_t reserved;
+} sample_t;
+
+/**
+ * @brief Ring of samples for one consumer.
+ */
+typedef struct sample_ring_s {
+    spsc_queue_t queue;
+    _Alignas(SPSC_QUEUE_CACHE_LINE) sample_t items[SAMPLE_RING_LEN];
+    uint32_t pushed; /**< samples accepted (producer) */
+} sample_ring_t;
+
+/**
+ * @brief Set up an empty ring.
+ */
+esp_err_t sample_ring_init(sample_ring_t *self);
+
+/**
+ * @brief Add a sample, acquisition task only.
+ *
+ * @return false when the ring is full, the sample is dropped and counted in `queue.dropped`
+ */
+bool sample_ring_push(sample_ring_t *self, const sample_t *sample);
+
+/**
+ * @brief Take the oldest sample, consumer task only.
+ *
+ * @return false when the ring is empty
+ */
+bool sample_ring_pop(sample_ring_t *self, sample_t *sample);
+
+#endif // SAMPLE_RING_H
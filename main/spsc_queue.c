@@ -0,0 +1,55 @@
+#include "spsc_queue.h"
+#include <string.h>
+
+esp_err_t spsc_queue_init(spsc_queue_t* self, void* storage, size_t item_size, uint32_t capacity)
+{
+    if (!self || !storage || item_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    self->items = (uint8_t*)storage;
+    self->item_size = item_size;
+    self->capacity = capacity;
+    atomic_init(&self->head, 0);
+    self->tail_seen = 0;
+    self->dropped = 0;
+    atomic_init(&self->tail, 0);
+    self->head_seen = 0;
+    return ESP_OK;
+}
+
+bool spsc_queue_push(spsc_queue_t* self, const void* item)
+{
+    const uint32_t head = atomic_load_explicit(&self->head, memory_order_relaxed);
+    if (head - self->tail_seen == self->capacity) {
+        /* acquire: the consumer has finished reading the slot before it moved tail past it */
+        self->tail_seen = atomic_load_explicit(&self->tail, memory_order_acquire);
+        if (head - self->tail_seen == self->capacity) {
+            self->dropped += 1;
+            return false;
+        }
+    }
+    memcpy(&self->items[(head & (self->capacity - 1)) * self->item_size], item, self->item_size);
+    /* release: the item is written before the consumer can see the new head */
+    atomic_store_explicit(&self->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool spsc_queue_pop(spsc_queue_t* self, void* item)
+{
+    const uint32_t tail = atomic_load_explicit(&self->tail, memory_order_relaxed);
+    if (self->head_seen == tail) {
+        self->head_seen = atomic_load_explicit(&self->head, memory_order_acquire);
+        if (self->head_seen == tail) {
+            return false;
+        }
+    }
+    memcpy(item, &self->items[(tail & (self->capacity - 1)) * self->item_size], self->item_size);
+    atomic_store_explicit(&self->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t spsc_queue_count(const spsc_queue_t* self)
+{
+    const uint32_t tail = atomic_load_explicit(&self->tail, memory_order_acquire);
+    return atomic_load_explicit(&self->head, memory_order_acquire) - tail;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file spsc_queue.h
+ * @brief Lock-free queue of fixed-size items between one producer and one consumer.
+ *
+ * Only the producer writes `head` and only the consumer writes `tail`, so
+ * neither side takes a lock or enters a critical section and neither can
+ * block or raise the priority of the other. The two tasks may run on
+ * different cores. A push to a full queue fails and is counted, it never
+ * waits for the consumer.
+ *
+ * Each side keeps its own index and a copy of the other side's index on a
+ * cache line of its own, and only reloads the other index when the copy says
+ * the queue is full (producer) or empty (consumer). A push or pop then mostly
+ * touches no line the other side writes to.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include "sdkconfig.h"
+
+#ifdef CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#define SPSC_QUEUE_CACHE_LINE CONFIG_ESP32S3_DATA_CACHE_LINE_SIZE
+#else
+#define SPSC_QUEUE_CACHE_LINE 64
+#endif
+
+/**
+ * @brief Queue state, the item storage is provided by the owner.
+ */
+typedef struct spsc_queue_s {
+    uint8_t *items;
+    size_t item_size;
+    uint32_t capacity;      /**< items, a power of two */
+
+    _Alignas(SPSC_QUEUE_CACHE_LINE) _Atomic uint32_t head; /**< items pushed, written by the producer */
+    uint32_t tail_seen;     /**< `tail` when the producer last read it */
+    uint32_t dropped;       /**< pushes refused because the queue was full (producer) */
+
+    _Alignas(SPSC_QUEUE_CACHE_LINE) _Atomic uint32_t tail; /**< items popped, written by the consumer */
+    uint32_t head_seen;     /**< `head` when the consumer last read it */
+} spsc_queue_t;
+
+/**
+ * @brief Set up an empty queue.
+ *
+ * @param storage `capacity * item_size` bytes, must outlive the queue
+ * @param capacity number of items, a power of two
+ */
+esp_err_t spsc_queue_init(spsc_queue_t *self, void *storage, size_t item_size, uint32_t capacity);
+
+/**
+ * @brief Copy an item in, producer only.
+ *
+ * @return false when the queue is full, the item is dropped then
+ */
+bool spsc_queue_push(spsc_queue_t *self, const void *item);
+
+/**
+ * @brief Copy the oldest item out, consumer only.
+ *
+ * @return false when the queue is empty
+ */
+bool spsc_queue_pop(spsc_queue_t *self, void *item);
+
+/**
+ * @brief Items waiting, the consumer can pop at least this many.
+ */
+uint32_t spsc_queue_count(const spsc_queue_t *self);
+
+#endif // SPSC_QUEUE_H
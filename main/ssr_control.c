@@ -22,10 +22,8 @@ static ssr_result_t read_reg(ssr_t *self, uint8_t reg)
     }
     uint8_t out = 0;
     /* Prefer using a device-handle if present */
-    esp_err_t ret = ESP_FAIL;
-    if (self->dev != NULL) {
-        ret = i2c_master_transmit_receive(self->dev, &reg, 1, &out, 1, pdMS_TO_TICKS(self->timeout_ms));
-    } 
+    i2c_async_req_t req = { .tx = { reg }, .tx_len = 1, .rx = &out, .rx_len = 1 };
+    esp_err_t ret = i2c_async_transfer(&self->async, &req);
 
     if (ret != ESP_OK) {
         res.tag = SSR_STATUS_I2C_ERR;
@@ -51,11 +49,8 @@ static ssr_result_t write_reg(ssr_t *self, uint8_t reg, uint8_t val)
         res.tag = SSR_STATUS_ARG_ERR;
         return res;
     }
-    uint8_t buf[2] = { reg, val };
-    esp_err_t ret = ESP_FAIL;
-    if (self->dev != NULL) {
-        ret = i2c_master_transmit(self->dev, buf, sizeof(buf), pdMS_TO_TICKS(self->timeout_ms));
-    } 
+    i2c_async_req_t req = { .tx = { reg, val }, .tx_len = 2 };
+    esp_err_t ret = i2c_async_transfer(&self->async, &req);
     if (ret != ESP_OK) {
         res.tag = SSR_STATUS_I2C_ERR;
         res.value.esp_code = ret;
@@ -65,25 +60,23 @@ static ssr_result_t write_reg(ssr_t *self, uint8_t reg, uint8_t val)
     return res;
 }
 
-ssr_result_t ssr_init(ssr_t *self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms)
+ssr_result_t ssr_init(ssr_t *self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms,
+                      uint32_t scl_hz)
 {
     ssr_result_t res = { .tag = SSR_STATUS_OK, .value.reserved = 0 };
     if (!self || i2c_addr == 0) {
         res.tag = SSR_STATUS_ARG_ERR;
         return res;
     }
+    memset(self, 0, sizeof(*self));
     self->i2c_bus = i2c_bus;
     self->i2c_addr = i2c_addr;
     self->timeout_ms = (timeout_ms == 0) ? 200u : timeout_ms;
-    self->dev = NULL;
 
-    /* Create a device handle on the bus for this 7-bit address */
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = i2c_addr,
-        .scl_speed_hz = 100000,
-    };
-    esp_err_t add_rc = i2c_master_bus_add_device(i2c_bus, &dev_cfg, &self->dev);
+    /* Create a device handle on the bus for this 7-bit address. The bus queues
+     * transactions, completions come back through the async layer. */
+    esp_err_t add_rc = i2c_async_dev_init(
+        &self->async, i2c_bus, i2c_addr, (scl_hz == 0) ? 100000u : scl_hz, self->timeout_ms);
     if (add_rc != ESP_OK) {
         res.tag = SSR_STATUS_I2C_ERR;
         res.value.esp_code = add_rc;
@@ -102,8 +95,8 @@ ssr_result_t ssr_deinit(ssr_t *self)
         return res;
     }
     /* remove device from bus if added */
-    if (self->dev != NULL && self->i2c_bus != NULL) {
-        i2c_master_bus_rm_device(self->dev);
+    if (self->initialized) {
+        i2c_async_dev_deinit(&self->async);
     }
     memset(self, 0, sizeof(*self));
     return res;
@@ -128,3 +121,70 @@ ssr_result_t ssr_get_version(ssr_t *self)
 {
     return read_reg(self, 0xFE);
 }
+
+/**
+ * @internal
+ * @brief Queue the prepared `self->req` to `done_queue`.
+ */
+static ssr_result_t submit_req(ssr_t *self, QueueHandle_t done_queue)
+{
+    ssr_result_t res = { .tag = SSR_STATUS_OK, .value.reserved = 0 };
+    self->req.done_queue = done_queue;
+    self->req.ctx = self;
+    esp_err_t ret = i2c_async_submit(&self->async, &self->req);
+    if (ret != ESP_OK) {
+        res.tag = SSR_STATUS_I2C_ERR;
+        res.value.esp_code = ret;
+        return res;
+    }
+    self->req_pending = true;
+    return res;
+}
+
+ssr_result_t ssr_get_active_async(ssr_t *self, QueueHandle_t done_queue)
+{
+    ssr_result_t res = { .tag = SSR_STATUS_OK, .value.reserved = 0 };
+    if (!self || !self->initialized || done_queue == NULL || self->req_pending) {
+        res.tag = SSR_STATUS_ARG_ERR;
+        return res;
+    }
+    memset(&self->req, 0, sizeof(self->req));
+    self->req.tx[0] = 0x00;
+    self->req.tx_len = 1;
+    self->req.rx = &self->rx;
+    self->req.rx_len = 1;
+    return submit_req(self, done_queue);
+}
+
+ssr_result_t ssr_set_active_async(ssr_t *self, bool active, QueueHandle_t done_queue)
+{
+    ssr_result_t res = { .tag = SSR_STATUS_OK, .value.reserved = 0 };
+    if (!self || !self->initialized || done_queue == NULL || self->req_pending) {
+        res.tag = SSR_STATUS_ARG_ERR;
+        return res;
+    }
+    memset(&self->req, 0, sizeof(self->req));
+    self->req.tx[0] = 0x00;
+    self->req.tx[1] = active ? 1 : 0;
+    self->req.tx_len = 2;
+    self->req_active = active;
+    return submit_req(self, done_queue);
+}
+
+ssr_result_t ssr_async_result(ssr_t *self)
+{
+    ssr_result_t res = { .tag = SSR_STATUS_OK, .value.reserved = 0 };
+    if (!self || !self->initialized) {
+        res.tag = SSR_STATUS_ARG_ERR;
+        return res;
+    }
+    self->req_pending = false;
+    if (self->req.result != ESP_OK) {
+        res.tag = SSR_STATUS_I2C_ERR;
+        res.value.esp_code = self->req.result;
+        return res;
+    }
+    /* a read leaves the state in rx, a write reports what was written */
+    res.value.active = (self->req.rx != NULL) ? (self->rx != 0) : self->req_active;
+    return res;
+}
@@ -14,6 +14,7 @@
 #include <stdbool.h>
 #include <esp_err.h>
 #include "driver/i2c_master.h"
+#include "i2c_async.h"
 
 /**
  * @brief Status tag for SSR operations.
@@ -40,14 +41,22 @@ typedef enum ssr_status_tag_e {
 typedef struct ssr_t {
     /** Handle to the I2C master bus returned by `i2c_new_master_bus()` */
     i2c_master_bus_handle_t i2c_bus;
-    /** Device handle returned by `i2c_master_bus_add_device()` (may be NULL) */
-    i2c_master_dev_handle_t dev; /* device handle created on init */
     /** 7-bit I2C device address */
     uint8_t i2c_addr;
     /** Transaction timeout in milliseconds */
     uint32_t timeout_ms;
     /** Internal flag indicating successful initialization */
     bool initialized;
+    /** Device handle, SCL rate and in-flight requests of the device */
+    i2c_async_dev_t async;
+    /** Request of `ssr_get_active_async()` / `ssr_set_active_async()`, it outlives the call */
+    i2c_async_req_t req;
+    /** Byte read by the asynchronous state read */
+    uint8_t rx;
+    /** State written by the pending `ssr_set_active_async()` */
+    bool req_active;
+    /** An asynchronous request has been started and its result not yet taken */
+    bool req_pending;
 } ssr_t;
 
 /** Generic tagged-union result used by SSR APIs. */
@@ -79,9 +88,12 @@ typedef struct ssr_result_s {
  * @param i2c_bus I2C master bus handle (from `i2c_new_master_bus()`).
  * @param i2c_addr 7-bit I2C device address.
  * @param timeout_ms Transaction timeout in milliseconds (0 -> default 200ms).
+ * @param scl_hz Fastest SCL clock for the device (0 -> 100 kHz). It is lowered
+ *        after errors and raised again later, see i2c_async.h.
  * @return ssr_result_t Tagged result; on I2C errors `value.esp_code` is set.
  */
-ssr_result_t ssr_init(ssr_t *self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms);
+ssr_result_t ssr_init(ssr_t *self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms,
+                      uint32_t scl_hz);
 
 /**
  * Deinitialize/cleanup an `ssr_t` object. Safe to call on partially-initialized objects.
@@ -124,4 +136,31 @@ ssr_result_t ssr_set_active(ssr_t *self, bool active);
  */
 ssr_result_t ssr_get_version(ssr_t *self);
 
+/**
+ * @brief Start reading the on/off state and return without waiting for it.
+ *
+ * When the transaction is over, the request (`i2c_async_req_t *` with
+ * `ctx == self`) is posted to `done_queue`, then `ssr_async_result()` gives
+ * the state. One asynchronous request can be in flight per SSR.
+ *
+ * @param self Initialized `ssr_t` instance.
+ * @param done_queue Queue of `i2c_async_req_t *`.
+ * @return ssr_result_t `SSR_STATUS_OK` when started.
+ */
+ssr_result_t ssr_get_active_async(ssr_t *self, QueueHandle_t done_queue);
+
+/**
+ * @brief Start writing the on/off state and return without waiting for it.
+ *
+ * Completion is reported like for `ssr_get_active_async()`.
+ */
+ssr_result_t ssr_set_active_async(ssr_t *self, bool active, QueueHandle_t done_queue);
+
+/**
+ * @brief Result of the asynchronous request after it came out of its queue.
+ *
+ * @return ssr_result_t On success `value.active` holds the state read or written.
+ */
+ssr_result_t ssr_async_result(ssr_t *self);
+
 #endif // SSR_CONTROL_H
@@ -73,13 +73,9 @@ static th_result_t read_regs(th_t* self, uint8_t reg, uint8_t* out, size_t len)
         return res;
     }
 
-    esp_err_t rc = ESP_FAIL;
-    if (self->dev != NULL) {
-        rc = i2c_master_transmit_receive(
-            self->dev, &reg, 1, out, len, pdMS_TO_TICKS(self->timeout_ms));
-    } else {
-        rc = ESP_ERR_INVALID_ARG;
-    }
+    i2c_async_req_t req = { .tx = { reg }, .tx_len = 1, .rx = out, .rx_len = len };
+    self->transactions += 1;
+    esp_err_t rc = i2c_async_transfer(&self->async, &req);
 
     if (rc != ESP_OK) {
         res.tag = TH_STATUS_I2C_ERR;
@@ -113,7 +109,7 @@ static th_result_t read_regs(th_t* self, uint8_t reg, uint8_t* out, size_t len)
 // }
 
 th_result_t th_init(
-    th_t* self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms)
+    th_t* self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms, uint32_t scl_hz)
 {
     th_result_t res = { .tag = TH_STATUS_OK };
     if (!self || i2c_addr == 0) {
@@ -124,15 +120,19 @@ th_result_t th_init(
     self->i2c_bus = i2c_bus;
     self->i2c_addr = i2c_addr;
     self->timeout_ms = (timeout_ms == 0) ? 200u : timeout_ms;
-    self->dev = NULL;
 
-    i2c_device_config_t dev_cfg = {
-        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
-        .device_address = i2c_addr,
-        .scl_speed_hz = 100000,
-    };
-    esp_err_t add_rc = i2c_master_bus_add_device(i2c_bus, &dev_cfg, &self->dev);
+    self->snap_queue = xQueueCreate(TH_SNAPSHOT_READS, sizeof(i2c_async_req_t*));
+    if (self->snap_queue == NULL) {
+        res.tag = TH_STATUS_I2C_ERR;
+        res.value.esp_code = ESP_ERR_NO_MEM;
+        return res;
+    }
+
+    esp_err_t add_rc = i2c_async_dev_init(
+        &self->async, i2c_bus, i2c_addr, (scl_hz == 0) ? 100000u : scl_hz, self->timeout_ms);
     if (add_rc != ESP_OK) {
+        vQueueDelete(self->snap_queue);
+        self->snap_queue = NULL;
         res.tag = TH_STATUS_I2C_ERR;
         res.value.esp_code = add_rc;
         return res;
@@ -150,8 +150,11 @@ th_result_t th_deinit(th_t* self)
         return res;
     }
     /* remove device from bus if added */
-    if (self->dev != NULL && self->i2c_bus != NULL) {
-        i2c_master_bus_rm_device(self->dev);
+    if (self->initialized) {
+        i2c_async_dev_deinit(&self->async);
+    }
+    if (self->snap_queue != NULL) {
+        vQueueDelete(self->snap_queue);
     }
     memset(self, 0, sizeof(*self));
     return res;
@@ -206,3 +209,123 @@ th_result_t th_get_temp_c_float(th_t* self)
     res.value.temp_c = temp;
     return res;
 }
+
+/* Internal helper: fill the snapshot requests of `self`, only the last one completes to `done_queue` */
+static void snapshot_prepare(th_t* self, QueueHandle_t done_queue)
+{
+    static const uint8_t regs[TH_SNAPSHOT_READS] = {
+        KMETER_TEMP_VAL_REG,
+        KMETER_INTERNAL_TEMP_VAL_REG,
+        KMETER_KMETER_ERROR_STATUS_REG,
+    };
+    static const uint8_t offsets[TH_SNAPSHOT_READS] = { 0, 4, 8 };
+    static const uint8_t lens[TH_SNAPSHOT_READS] = { 4, 4, 1 };
+
+    uint32_t i = 0;
+    for (i = 0; i < TH_SNAPSHOT_READS; ++i) {
+        i2c_async_req_t* req = &self->snap_req[i];
+        memset(req, 0, sizeof(*req));
+        req->tx[0] = regs[i];
+        req->tx_len = 1;
+        req->rx = &self->snap_raw[offsets[i]];
+        req->rx_len = lens[i];
+        req->done_queue = (i == TH_SNAPSHOT_READS - 1) ? done_queue : self->snap_queue;
+        req->ctx = self;
+    }
+}
+
+/* Internal helper: queue the prepared snapshot requests. When one is refused
+ * the ones before it are in flight already, wait for them (at most the driver
+ * timeout each) so the requests are free again. */
+static esp_err_t snapshot_submit(th_t* self)
+{
+    uint32_t i = 0;
+    for (i = 0; i < TH_SNAPSHOT_READS; ++i) {
+        const esp_err_t rc = i2c_async_submit(&self->async, &self->snap_req[i]);
+        if (rc != ESP_OK) {
+            uint32_t k = 0;
+            for (k = 0; k < i; ++k) {
+                i2c_async_req_t* done = NULL;
+                xQueueReceive(self->snap_queue, &done, portMAX_DELAY);
+            }
+            return rc;
+        }
+        self->transactions += 1;
+    }
+    return ESP_OK;
+}
+
+th_result_t th_snapshot_result(th_t* self)
+{
+    th_result_t res = { .tag = TH_STATUS_OK };
+    if (!self || !self->initialized) {
+        res.tag = TH_STATUS_ARG_ERR;
+        return res;
+    }
+    self->snap_pending = false;
+    /* the device runs its transactions in order, the earlier ones are over as well */
+    i2c_async_req_t* done = NULL;
+    while (xQueueReceive(self->snap_queue, &done, 0) == pdTRUE) {
+    }
+    uint32_t i = 0;
+    for (i = 0; i < TH_SNAPSHOT_READS; ++i) {
+        if (self->snap_req[i].result != ESP_OK) {
+            res.tag = TH_STATUS_I2C_ERR;
+            res.value.esp_code = self->snap_req[i].result;
+            return res;
+        }
+    }
+
+    /* both temperatures are signed int32, 0.01 deg C, same byte order as th_get_temp_c_float() */
+    int32_t temp = 0;
+    int32_t internal = 0;
+    memcpy(&temp, &self->snap_raw[0], sizeof(temp));
+    memcpy(&internal, &self->snap_raw[4], sizeof(internal));
+
+    res.value.snapshot.temp_c = ((float)temp) / 100.0f;
+    res.value.snapshot.internal_temp_c = ((float)internal) / 100.0f;
+    res.value.snapshot.error_status = self->snap_raw[8];
+    return res;
+}
+
+th_result_t th_read_snapshot_async(th_t* self, QueueHandle_t done_queue)
+{
+    th_result_t res = { .tag = TH_STATUS_OK };
+    if (!self || !self->initialized || done_queue == NULL || self->snap_pending) {
+        res.tag = TH_STATUS_ARG_ERR;
+        return res;
+    }
+
+    snapshot_prepare(self, done_queue);
+    esp_err_t rc = snapshot_submit(self);
+    if (rc != ESP_OK) {
+        res.tag = TH_STATUS_I2C_ERR;
+        res.value.esp_code = rc;
+        return res;
+    }
+    self->snap_pending = true;
+    return res;
+}
+
+th_result_t th_read_snapshot(th_t* self)
+{ /* temp, internal temp and status, queued back to back */
+    th_result_t res = { .tag = TH_STATUS_OK };
+    if (!self || !self->initialized || self->snap_pending) {
+        res.tag = TH_STATUS_ARG_ERR;
+        return res;
+    }
+
+    /* all three complete to the snapshot queue, wait for the last */
+    snapshot_prepare(self, self->snap_queue);
+    esp_err_t rc = snapshot_submit(self);
+    if (rc != ESP_OK) {
+        res.tag = TH_STATUS_I2C_ERR;
+        res.value.esp_code = rc;
+        return res;
+    }
+    i2c_async_req_t* done = NULL;
+    while (done != &self->snap_req[TH_SNAPSHOT_READS - 1]) {
+        xQueueReceive(self->snap_queue, &done, portMAX_DELAY);
+    }
+    return th_snapshot_result(self);
+}
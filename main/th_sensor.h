@@ -15,6 +15,7 @@
 #include <stdbool.h>
 #include <esp_err.h>
 #include "driver/i2c_master.h"
+#include "i2c_async.h"
 
 #define KMETER_DEFAULT_ADDR                        0x66 /* 1 byte */
 #define KMETER_TEMP_VAL_REG                        0x00 /* 4 bytes: float */
@@ -26,6 +27,9 @@
 #define KMETER_INTERNAL_TEMP_FAHRENHEIT_STRING_REG 0x60
 #define KMETER_FIRMWARE_VERSION_REG                0xFE
 #define KMETER_I2C_ADDRESS_REG                     0xFF
+
+/* register reads of a snapshot, one transaction each */
+#define TH_SNAPSHOT_READS 3
 /**
  * @brief Status tags for thermocouple operations.
  */
@@ -41,12 +45,27 @@ typedef enum th_status_tag_e {
  */
 typedef struct th_t {
     i2c_master_bus_handle_t i2c_bus;
-    i2c_master_dev_handle_t dev; /**< device handle created on init (may be NULL) */
     uint8_t i2c_addr;    /**< 7-bit I2C address */
     uint32_t timeout_ms; /**< transaction timeout */
+    uint32_t transactions; /**< I2C transactions issued so far, for bus load accounting */
     bool initialized;
+    i2c_async_dev_t async; /**< device handle, SCL rate and in-flight requests */
+    /* snapshot requests, kept here since they outlive `th_read_snapshot_async()` */
+    i2c_async_req_t snap_req[TH_SNAPSHOT_READS];
+    QueueHandle_t snap_queue; /**< completions of the snapshot requests the caller does not wait for */
+    uint8_t snap_raw[9];
+    bool snap_pending;
 } th_t;
 
+/**
+ * @brief All readings of one sample, see `th_read_snapshot`.
+ */
+typedef struct th_snapshot_s {
+    float temp_c;          /**< thermocouple temperature (register 0x00) */
+    float internal_temp_c; /**< module / cold junction temperature (register 0x10) */
+    uint8_t error_status;  /**< register 0x20, 0 when the thermocouple reading is valid */
+} th_snapshot_t;
+
 /**
  * @brief Tagged-union return for thermocouple API calls.
  */
@@ -58,6 +77,7 @@ typedef struct th_result_s {
         char str_c[8];      /**< string buffer for string results */
         uint8_t version;    /**< returned by `th_get_version` */
         uint32_t status;    /**< device status code */
+        th_snapshot_t snapshot; /**< returned by `th_read_snapshot` */
     } value;
 } th_result_t;
 
@@ -65,15 +85,18 @@ typedef struct th_result_s {
  * @brief Initialize a `th_t` instance and create a device handle on the bus.
  *
  * The function attempts to add a device to `i2c_bus` for `i2c_addr`. On
- * success the created device handle is stored in `self->dev`.
+ * success the device handle is kept in `self->async`, which also lowers the
+ * SCL clock after errors and raises it again later (see i2c_async.h).
  *
  * @param self user-allocated `th_t` instance
  * @param i2c_bus I2C master bus handle from `i2c_new_master_bus()`
  * @param i2c_addr 7-bit I2C address (use 0x66 by default)
  * @param timeout_ms transaction timeout in milliseconds (0 -> default 200ms)
+ * @param scl_hz fastest SCL clock for the device (0 -> 100 kHz)
  * @return th_result_t tagged result; on I2C error `value.esp_code` is set
  */
-th_result_t th_init(th_t *self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms);
+th_result_t th_init(th_t *self, i2c_master_bus_handle_t i2c_bus, uint8_t i2c_addr, uint32_t timeout_ms,
+                    uint32_t scl_hz);
 
 /**
  * @brief Deinitialize a `th_t` instance and release device handles.
@@ -93,6 +116,37 @@ th_result_t th_get_temp_c_str(th_t *self);
 th_result_t th_get_temp_c(th_t *self); // read string data and convert to float
 th_result_t th_get_temp_c_float(th_t *self); // read raw data from registers and convert to float
 
+/**
+ * @brief Read temperature, internal temperature and error status in one go.
+ *
+ * The three register reads are queued back to back as one write-read
+ * transaction each, the driver runs them one after the other and the caller
+ * waits for the last only. Only the 9 bytes of the fields are read (no
+ * 8-byte string registers).
+ *
+ * @return th_result_t `value.snapshot` on success. A nonzero
+ *         `snapshot.error_status` is returned as is, the caller decides whether
+ *         to use the temperature.
+ */
+th_result_t th_read_snapshot(th_t *self);
+
+/**
+ * @brief Start a snapshot read and return without waiting for it.
+ *
+ * When the last of its transactions is over, one request (`i2c_async_req_t *`
+ * with `ctx == self`) is posted to `done_queue`. Then call
+ * `th_snapshot_result()`. One snapshot can be in flight per sensor.
+ *
+ * @param done_queue queue of `i2c_async_req_t *`
+ * @return th_result_t `TH_STATUS_OK` when started
+ */
+th_result_t th_read_snapshot_async(th_t *self, QueueHandle_t done_queue);
+
+/**
+ * @brief Result of the snapshot started by `th_read_snapshot_async()`, same as `th_read_snapshot()`.
+ */
+th_result_t th_snapshot_result(th_t *self);
+
 /**
  * @brief Read device version (register 0xFE assumed).
  */
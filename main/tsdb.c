@@ -0,0 +1,393 @@
+#include "tsdb.h"
+#include "esp_rom_crc.h"
+#include <string.h>
+
+static const uint32_t g_page_magic = 0x31445354; /* "TSD1" */
+static const uint8_t g_page_version = 2;
+
+/* longest encoding of one sample: flag, 3+32 bit timestamp, 3+32 bit value */
+static const uint32_t g_sample_bits_max = 1 + 35 + 35;
+static const uint32_t g_page_data_bits = TSDB_PAGE_DATA * 8;
+
+_Static_assert(sizeof(tsdb_page_hdr_t) == 48, "tsdb_page_hdr_t layout changed");
+_Static_assert(sizeof(tsdb_page_t) == TSDB_PAGE_SIZE, "tsdb_page_t must fill a sector");
+
+static tsdb_result_t flash_err(esp_err_t rc)
+{
+    tsdb_result_t res = { .tag = TSDB_STATUS_FLASH_ERR };
+    res.value.esp_code = rc;
+    return res;
+}
+
+static bool fits(int64_t v, uint32_t bits)
+{
+    const int64_t half = (int64_t)1 << (bits - 1);
+    return v >= -half && v < half;
+}
+
+static void put_bits(tsdb_page_t* page, uint32_t value, uint32_t n)
+{
+    uint32_t pos = page->hdr.bits;
+    uint32_t i = 0;
+    for (i = n; i > 0; --i) {
+        if ((value >> (i - 1)) & 1u) {
+            page->data[pos >> 3] |= (uint8_t)(0x80u >> (pos & 7));
+        }
+        pos += 1;
+    }
+    page->hdr.bits = pos;
+}
+
+static uint32_t get_bits(const tsdb_page_t* page, uint32_t* pos, uint32_t n)
+{
+    uint32_t value = 0;
+    uint32_t i = 0;
+    for (i = 0; i < n; ++i) {
+        const uint32_t bit = (page->data[*pos >> 3] >> (7 - (*pos & 7))) & 1u;
+        value = (value << 1) | bit;
+        *pos += 1;
+    }
+    return value;
+}
+
+static int32_t sign_extend(uint32_t value, uint32_t bits)
+{
+    const uint32_t sign = 1u << (bits - 1);
+    return (int32_t)((value ^ sign) - sign);
+}
+
+static void open_page(tsdb_t* self, tsdb_writer_t* w, uint8_t series, int64_t t_ms, int32_t value)
+{
+    memset(&w->page, 0, sizeof(w->page));
+    w->page.hdr.magic = g_page_magic;
+    w->page.hdr.version = g_page_version;
+    w->page.hdr.seq = self->next_seq;
+    w->page.hdr.boot = self->boot;
+    w->page.hdr.series = series;
+    w->page.hdr.count = 1;
+    w->page.hdr.t_first_ms = t_ms;
+    w->page.hdr.t_last_ms = t_ms;
+    w->page.hdr.v_first = value;
+    w->slot = self->next_slot;
+    w->open = true;
+    w->dirty = true;
+    w->prev_t_ms = t_ms;
+    w->prev_delta_ms = 0;
+    w->prev_v = value;
+
+    self->next_seq += 1;
+    self->next_slot = (self->next_slot + 1) % self->slots;
+}
+
+static esp_err_t write_page(tsdb_t* self, tsdb_writer_t* w)
+{
+    tsdb_page_hdr_t* hdr = &w->page.hdr;
+    const size_t data_len = (hdr->bits + 7) / 8;
+    hdr->crc = 0;
+    uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)hdr, sizeof(*hdr));
+    hdr->crc = esp_rom_crc32_le(crc, w->page.data, data_len);
+
+    const size_t offset = (size_t)w->slot * TSDB_PAGE_SIZE;
+    esp_err_t rc = esp_partition_erase_range(self->part, offset, TSDB_PAGE_SIZE);
+    if (rc == ESP_OK) {
+        /* the sector is erased to 0xFF, only the used part is programmed */
+        const size_t len = (sizeof(*hdr) + data_len + 3) & ~(size_t)3;
+        rc = esp_partition_write(self->part, offset, &w->page, len);
+    }
+    if (rc == ESP_OK) {
+        w->dirty = false;
+        self->pages_written += 1;
+    }
+    return rc;
+}
+
+/* Encode against the previous sample, false when the page has no room or the time step does not fit */
+static bool encode_sample(tsdb_writer_t* w, int64_t t_ms, int32_t value)
+{
+    const int64_t delta = t_ms - w->prev_t_ms;
+    if (delta < 0 || delta > (int64_t)UINT32_MAX || w->page.hdr.count == UINT16_MAX
+        || w->page.hdr.bits + g_sample_bits_max > g_page_data_bits) {
+        return false;
+    }
+    const int64_t dod = delta - w->prev_delta_ms;
+    const int64_t dv = (int64_t)value - w->prev_v;
+    tsdb_page_t* page = &w->page;
+
+    if (dod == 0 && dv == 0) {
+        put_bits(page, 0, 1);
+    } else {
+        put_bits(page, 1, 1);
+
+        if (dod == 0) {
+            put_bits(page, 0, 1);
+        } else if (fits(dod, 7)) {
+            put_bits(page, 2, 2);
+            put_bits(page, (uint32_t)dod & 0x7F, 7);
+        } else if (fits(dod, 12)) {
+            put_bits(page, 6, 3);
+            put_bits(page, (uint32_t)dod & 0xFFF, 12);
+        } else {
+            /* the plain delta, a delta-of-delta could need 33 bits */
+            put_bits(page, 7, 3);
+            put_bits(page, (uint32_t)delta, 32);
+        }
+
+        if (dv == 0) {
+            put_bits(page, 0, 1);
+        } else if (fits(dv, 6)) {
+            put_bits(page, 2, 2);
+            put_bits(page, (uint32_t)dv & 0x3F, 6);
+        } else if (fits(dv, 12)) {
+            put_bits(page, 6, 3);
+            put_bits(page, (uint32_t)dv & 0xFFF, 12);
+        } else {
+            /* the value itself, a delta could need 33 bits */
+            put_bits(page, 7, 3);
+            put_bits(page, (uint32_t)value, 32);
+        }
+    }
+
+    page->hdr.count += 1;
+    page->hdr.t_last_ms = t_ms;
+    w->prev_delta_ms = delta;
+    w->prev_t_ms = t_ms;
+    w->prev_v = value;
+    w->dirty = true;
+    return true;
+}
+
+/* Read a bucketed field: '0', '10'+short, '110'+mid or '111'+32. Sets *plain for the 32-bit form. */
+static int32_t decode_field(const tsdb_page_t* page, uint32_t* pos, uint32_t short_bits, bool* plain)
+{
+    *plain = false;
+    if (get_bits(page, pos, 1) == 0) {
+        return 0;
+    }
+    if (get_bits(page, pos, 1) == 0) {
+        return sign_extend(get_bits(page, pos, short_bits), short_bits);
+    }
+    if (get_bits(page, pos, 1) == 0) {
+        return sign_extend(get_bits(page, pos, 12), 12);
+    }
+    *plain = true;
+    return (int32_t)get_bits(page, pos, 32);
+}
+
+static bool decode_page(const tsdb_page_t* page, int64_t from_ms, int64_t to_ms, tsdb_visit_fn_t fn, void* ctx)
+{
+    int64_t t_ms = page->hdr.t_first_ms;
+    int64_t delta = 0;
+    int32_t value = page->hdr.v_first;
+    uint32_t pos = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < page->hdr.count; ++i) {
+        if (i > 0 && pos < page->hdr.bits && get_bits(page, &pos, 1) == 1) {
+            bool plain = false;
+            const int32_t t_field = decode_field(page, &pos, 7, &plain);
+            delta = plain ? (int64_t)(uint32_t)t_field : delta + t_field;
+            const int32_t v_field = decode_field(page, &pos, 6, &plain);
+            value = plain ? v_field : (int32_t)((int64_t)value + v_field);
+        }
+        if (i > 0) {
+            t_ms += delta;
+        }
+        if (t_ms > to_ms) {
+            return true;
+        }
+        if (t_ms >= from_ms && !fn(ctx, t_ms, value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool page_hdr_valid(const tsdb_page_hdr_t* hdr)
+{
+    return hdr->magic == g_page_magic && hdr->version == g_page_version && hdr->series < TSDB_SERIES_MAX
+        && hdr->count > 0 && hdr->bits <= g_page_data_bits;
+}
+
+tsdb_result_t tsdb_init(tsdb_t* self, const char* label)
+{
+    tsdb_result_t res = { .tag = TSDB_STATUS_OK };
+    if (!self || !label) {
+        res.tag = TSDB_STATUS_ARG_ERR;
+        return res;
+    }
+    memset(self, 0, sizeof(*self));
+
+    self->part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (self->part == NULL || self->part->size < 2 * TSDB_PAGE_SIZE) {
+        res.tag = TSDB_STATUS_NO_PARTITION;
+        return res;
+    }
+    self->slots = self->part->size / TSDB_PAGE_SIZE;
+
+    /* the page opened last has the highest sequence number and the latest boot, the ring continues after it */
+    bool found = false;
+    uint32_t max_seq = 0;
+    uint32_t slot = 0;
+    for (slot = 0; slot < self->slots; ++slot) {
+        tsdb_page_hdr_t hdr;
+        const esp_err_t rc = esp_partition_read(self->part, (size_t)slot * TSDB_PAGE_SIZE, &hdr, sizeof(hdr));
+        if (rc != ESP_OK) {
+            return flash_err(rc);
+        }
+        if (page_hdr_valid(&hdr) && (!found || hdr.seq > max_seq)) {
+            found = true;
+            max_seq = hdr.seq;
+            self->next_seq = hdr.seq + 1;
+            self->next_slot = (slot + 1) % self->slots;
+            self->boot = hdr.boot + 1;
+        }
+    }
+
+    self->lock = xSemaphoreCreateMutex();
+    if (self->lock == NULL) {
+        res.tag = TSDB_STATUS_NO_MEM;
+    }
+    return res;
+}
+
+tsdb_result_t tsdb_append(tsdb_t* self, uint8_t series, int64_t t_ms, int32_t value)
+{
+    tsdb_result_t res = { .tag = TSDB_STATUS_OK };
+    if (!self || self->lock == NULL || series >= TSDB_SERIES_MAX) {
+        res.tag = TSDB_STATUS_ARG_ERR;
+        return res;
+    }
+
+    xSemaphoreTake(self->lock, portMAX_DELAY);
+    tsdb_writer_t* w = &self->writers[series];
+    if (w->open && !encode_sample(w, t_ms, value)) {
+        /* page full, or a time step it cannot hold */
+        self->pages_closed += 1;
+        self->bits_closed += w->page.hdr.bits;
+        self->samples_closed += w->page.hdr.count;
+        w->open = false;
+        const esp_err_t rc = write_page(self, w);
+        if (rc != ESP_OK) {
+            res = flash_err(rc);
+        }
+    }
+    if (!w->open) {
+        open_page(self, w, series, t_ms, value);
+    }
+    xSemaphoreGive(self->lock);
+    return res;
+}
+
+tsdb_result_t tsdb_flush(tsdb_t* self)
+{
+    tsdb_result_t res = { .tag = TSDB_STATUS_OK };
+    uint32_t i = 0;
+    if (!self || self->lock == NULL) {
+        res.tag = TSDB_STATUS_ARG_ERR;
+        return res;
+    }
+
+    xSemaphoreTake(self->lock, portMAX_DELAY);
+    for (i = 0; i < TSDB_SERIES_MAX; ++i) {
+        tsdb_writer_t* w = &self->writers[i];
+        if (w->open && w->dirty) {
+            const esp_err_t rc = write_page(self, w);
+            if (rc != ESP_OK) {
+                res = flash_err(rc);
+            }
+        }
+    }
+    xSemaphoreGive(self->lock);
+    return res;
+}
+
+static bool slot_is_open(const tsdb_t* self, uint32_t slot)
+{
+    uint32_t i = 0;
+    for (i = 0; i < TSDB_SERIES_MAX; ++i) {
+        if (self->writers[i].open && self->writers[i].slot == slot) {
+            return true;
+        }
+    }
+    return false;
+}
+
+tsdb_result_t tsdb_query(
+    tsdb_t* self, uint8_t series, uint32_t boot, int64_t from_ms, int64_t to_ms, tsdb_visit_fn_t fn, void* ctx)
+{
+    tsdb_result_t res = { .tag = TSDB_STATUS_OK };
+    if (!self || self->lock == NULL || series >= TSDB_SERIES_MAX || !fn) {
+        res.tag = TSDB_STATUS_ARG_ERR;
+        return res;
+    }
+
+    xSemaphoreTake(self->lock, portMAX_DELAY);
+    bool more = true;
+    uint32_t k = 0;
+    /* oldest sector first, the pages of a series in one boot follow in time order */
+    for (k = 0; more && k < self->slots; ++k) {
+        const uint32_t slot = (self->next_slot + k) % self->slots;
+        /* an open page is newer in RAM, or its sector still holds a page about to be replaced */
+        if (slot_is_open(self, slot)) {
+            continue;
+        }
+        const size_t offset = (size_t)slot * TSDB_PAGE_SIZE;
+        tsdb_page_hdr_t* hdr = &self->scratch.hdr;
+        esp_err_t rc = esp_partition_read(self->part, offset, hdr, sizeof(*hdr));
+        if (rc != ESP_OK) {
+            res = flash_err(rc);
+            break;
+        }
+        if (!page_hdr_valid(hdr) || hdr->series != series || hdr->boot != boot || hdr->t_last_ms < from_ms
+            || hdr->t_first_ms > to_ms) {
+            continue;
+        }
+
+        const size_t data_len = (hdr->bits + 7) / 8;
+        rc = esp_partition_read(self->part, offset + sizeof(*hdr), self->scratch.data, data_len);
+        if (rc != ESP_OK) {
+            res = flash_err(rc);
+            break;
+        }
+        const uint32_t crc_stored = hdr->crc;
+        hdr->crc = 0;
+        uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)hdr, sizeof(*hdr));
+        crc = esp_rom_crc32_le(crc, self->scratch.data, data_len);
+        if (crc != crc_stored) {
+            /* e.g. a reset while the sector was rewritten */
+            self->corrupt_pages += 1;
+            continue;
+        }
+        more = decode_page(&self->scratch, from_ms, to_ms, fn, ctx);
+    }
+
+    const tsdb_writer_t* w = &self->writers[series];
+    if (more && res.tag == TSDB_STATUS_OK && w->open && w->page.hdr.boot == boot && w->page.hdr.t_last_ms >= from_ms
+        && w->page.hdr.t_first_ms <= to_ms) {
+        decode_page(&w->page, from_ms, to_ms, fn, ctx);
+    }
+    xSemaphoreGive(self->lock);
+    return res;
+}
+
+uint32_t tsdb_centibits_per_sample(tsdb_t* self)
+{
+    uint64_t bits = 0;
+    uint64_t samples = 0;
+    uint32_t i = 0;
+    if (!self || self->lock == NULL) {
+        return 0;
+    }
+
+    xSemaphoreTake(self->lock, portMAX_DELAY);
+    bits = self->bits_closed;
+    samples = self->samples_closed;
+    for (i = 0; i < TSDB_SERIES_MAX; ++i) {
+        if (self->writers[i].open) {
+            bits += self->writers[i].page.hdr.bits;
+            samples += self->writers[i].page.hdr.count;
+        }
+    }
+    xSemaphoreGive(self->lock);
+    return (samples > 0) ? (uint32_t)(bits * 100 / samples) : 0;
+}
@@ -0,0 +1,165 @@
+/**
+ * @file tsdb.h
+ * @brief Compressed history of integer series on a raw flash partition.
+ *
+ * Every series fills a 4 KB page in RAM. A full page is written to the next
+ * sector of the partition, which is used as a ring: the oldest page is
+ * overwritten first. `tsdb_flush()` also writes the pages still filling, to
+ * their own sectors. A reset loses the samples since the last flush, and
+ * the whole page when it happens while that page is rewritten.
+ *
+ * Samples are bit-packed, Gorilla style, against the previous sample of the page:
+ * - a sample at the usual interval with an unchanged value is one `0` bit
+ * - otherwise `1`, then the timestamp as delta-of-delta and the value as a
+ *   delta, each in the shortest of 1, 2+7 (2+6 for values), 3+12 or 3+32 bits
+ *
+ * The page header holds the series and the first and last timestamp, so a
+ * query by time range reads only the headers of the other pages and decodes
+ * the pages it needs.
+ *
+ * Timestamps are only comparable within one boot: without a time source the
+ * wall clock starts at 0 again on every power-on. Every `tsdb_init()` starts
+ * a new boot epoch, stored in each page header, and a query covers one epoch.
+ *
+ * The API follows the project's tagged-union result pattern: functions return
+ * `tsdb_result_t` which carries both a status tag and any error code.
+ */
+
+#ifndef TSDB_H
+#define TSDB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <esp_err.h>
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/** Series one store keeps */
+#define TSDB_SERIES_MAX 2
+/** Page size, one flash sector */
+#define TSDB_PAGE_SIZE 4096
+
+/**
+ * @brief Status tags for store operations.
+ */
+typedef enum tsdb_status_tag_e {
+    TSDB_STATUS_OK = 0,
+    TSDB_STATUS_FLASH_ERR,
+    TSDB_STATUS_ARG_ERR,
+    TSDB_STATUS_NO_PARTITION,
+    TSDB_STATUS_NO_MEM,
+} tsdb_status_tag_t;
+
+/**
+ * @brief Page header as stored at the start of a sector.
+ */
+typedef struct tsdb_page_hdr_s {
+    uint32_t magic;
+    uint32_t seq;        /**< increases with every page opened, survives a reboot */
+    uint32_t boot;       /**< boot epoch the page was written in, its timestamps belong to that boot */
+    uint8_t version;
+    uint8_t series;
+    uint16_t count;      /**< samples in the page */
+    uint32_t bits;       /**< encoded data after the header */
+    uint32_t reserved;   /**< 0 */
+    int64_t t_first_ms;
+    int64_t t_last_ms;
+    int32_t v_first;
+    uint32_t crc;        /**< CRC-32 of the header with `crc` = 0, then the data */
+} tsdb_page_hdr_t;
+
+#define TSDB_PAGE_DATA (TSDB_PAGE_SIZE - sizeof(tsdb_page_hdr_t))
+
+typedef struct tsdb_page_s {
+    tsdb_page_hdr_t hdr;
+    uint8_t data[TSDB_PAGE_DATA];
+} tsdb_page_t;
+
+/**
+ * @brief Page a series is filling and the encoder state for it.
+ */
+typedef struct tsdb_writer_s {
+    tsdb_page_t page;
+    bool open;
+    bool dirty;          /**< samples added since the page was last written */
+    uint32_t slot;       /**< sector the page goes to */
+    int64_t prev_t_ms;
+    int64_t prev_delta_ms;
+    int32_t prev_v;
+} tsdb_writer_t;
+
+typedef struct tsdb_s {
+    const esp_partition_t *part;
+    uint32_t slots;            /**< sectors in the partition */
+    uint32_t next_slot;        /**< sector of the next page opened, holds the oldest page */
+    uint32_t next_seq;
+    uint32_t boot;             /**< epoch of this boot, one more than the newest page on flash */
+    tsdb_writer_t writers[TSDB_SERIES_MAX];
+    tsdb_page_t scratch;       /**< page being decoded by a query */
+    SemaphoreHandle_t lock;
+    uint32_t pages_written;    /**< sector writes, full pages and flushes */
+    uint32_t pages_closed;     /**< full pages */
+    uint64_t bits_closed;      /**< encoded bits of the full pages */
+    uint32_t samples_closed;
+    uint32_t corrupt_pages;    /**< pages skipped by queries because of a CRC mismatch */
+} tsdb_t;
+
+/**
+ * @brief Tagged-union return for store calls.
+ */
+typedef struct tsdb_result_s {
+    tsdb_status_tag_t tag;
+    union {
+        esp_err_t esp_code; /**< underlying flash error when tag is FLASH_ERR */
+        uint32_t reserved;
+    } value;
+} tsdb_result_t;
+
+/**
+ * @brief Called for every sample in the queried range, oldest first.
+ *
+ * Runs with the store locked, it must not call the store. Return false to stop.
+ */
+typedef bool (*tsdb_visit_fn_t)(void *ctx, int64_t t_ms, int32_t value);
+
+/**
+ * @brief Open the store on a data partition and find the newest page.
+ *
+ * Reads only the page headers, one per sector. Starts a new boot epoch
+ * (`boot`), once per boot.
+ *
+ * @param label partition label, `TSDB_STATUS_NO_PARTITION` if there is none
+ */
+tsdb_result_t tsdb_init(tsdb_t *self, const char *label);
+
+/**
+ * @brief Add a sample to a series.
+ *
+ * Timestamps of a series should not decrease, a step back starts a new page.
+ * A full page is written to flash right away.
+ *
+ * @param series 0 .. `TSDB_SERIES_MAX - 1`
+ */
+tsdb_result_t tsdb_append(tsdb_t *self, uint8_t series, int64_t t_ms, int32_t value);
+
+/**
+ * @brief Write the pages still filling that have new samples.
+ */
+tsdb_result_t tsdb_flush(tsdb_t *self);
+
+/**
+ * @brief Visit the samples of a series with `from_ms <= t <= to_ms` stored in one boot, in time order.
+ *
+ * @param boot boot epoch, `self->boot` for the samples since this boot; older
+ *             epochs count down from it, a boot without samples has no pages
+ */
+tsdb_result_t tsdb_query(tsdb_t *self, uint8_t series, uint32_t boot, int64_t from_ms, int64_t to_ms,
+                         tsdb_visit_fn_t fn, void *ctx);
+
+/**
+ * @brief Encoded size per sample so far, in hundredths of a bit.
+ */
+uint32_t tsdb_centibits_per_sample(tsdb_t *self);
+
+#endif // TSDB_H
@@ -9,11 +9,51 @@
 
 #include "esp_eth_com.h"
 #include "esp_eth_mac_spi.h"
+#include "esp_eth_driver.h"
+#include "sdkconfig.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define ETH_W5500_SOCK_NUM (8) /*!< Number of W5500 hardware sockets */
+
+/**
+ * @brief Split of the W5500 TX and RX memory (16 KB each) between the hardware sockets
+ *
+ * Socket 0 runs in MAC RAW mode and carries all lwIP traffic, its RX buffer absorbs bursts of incoming frames
+ * while the driver task is busy, its TX buffer holds the queued outgoing frames. Sockets 1..7 are only used for
+ * offloaded UDP/TCP endpoints (CONFIG_ETH_W5500_OFFLOAD), a socket without memory can't be offloaded.
+ *
+ */
+typedef struct {
+    uint8_t rx_size_kb[ETH_W5500_SOCK_NUM]; /*!< RX buffer size per socket in KB: 0, 1, 2, 4, 8 or 16, 16 KB in total at most */
+    uint8_t tx_size_kb[ETH_W5500_SOCK_NUM]; /*!< TX buffer size per socket in KB: 0, 1, 2, 4, 8 or 16, 16 KB in total at most */
+} eth_w5500_sock_buf_config_t;
+
+#if CONFIG_ETH_W5500_OFFLOAD
+#define ETH_W5500_OFFLOAD_BUF_KB(s) ((s) <= CONFIG_ETH_W5500_OFFLOAD_SOCK_NUM ? CONFIG_ETH_W5500_OFFLOAD_SOCK_BUF_KB : 0)
+#else
+#define ETH_W5500_OFFLOAD_BUF_KB(s) (0)
+#endif
+
+/**
+ * @brief Default socket buffer split, taken from Kconfig
+ *
+ */
+#define ETH_W5500_DEFAULT_SOCK_BUF_KB                                                      \
+    {                                                                                      \
+        CONFIG_ETH_W5500_MACRAW_BUF_KB, ETH_W5500_OFFLOAD_BUF_KB(1), ETH_W5500_OFFLOAD_BUF_KB(2), \
+        ETH_W5500_OFFLOAD_BUF_KB(3), ETH_W5500_OFFLOAD_BUF_KB(4), ETH_W5500_OFFLOAD_BUF_KB(5),    \
+        ETH_W5500_OFFLOAD_BUF_KB(6), ETH_W5500_OFFLOAD_BUF_KB(7)                                 \
+    }
+
+#define ETH_W5500_DEFAULT_SOCK_BUF_CONFIG()             \
+    {                                                   \
+        .rx_size_kb = ETH_W5500_DEFAULT_SOCK_BUF_KB,    \
+        .tx_size_kb = ETH_W5500_DEFAULT_SOCK_BUF_KB,    \
+    }
+
 /**
  * @brief W5500 specific configuration
  *
@@ -24,6 +64,7 @@ typedef struct {
     spi_host_device_t spi_host_id;                      /*!< SPI peripheral (this field is invalid when custom SPI driver is defined) */
     spi_device_interface_config_t *spi_devcfg;          /*!< SPI device configuration (this field is invalid when custom SPI driver is defined) */
     eth_spi_custom_driver_config_t custom_spi_driver;   /*!< Custom SPI driver definitions */
+    eth_w5500_sock_buf_config_t sock_buf;               /*!< Split of the TX/RX memory between the hardware sockets */
 } eth_w5500_config_t;
 
 /**
@@ -37,8 +78,238 @@ typedef struct {
         .spi_host_id = spi_host,                \
         .spi_devcfg = spi_devcfg_p,             \
         .custom_spi_driver = ETH_DEFAULT_SPI,   \
+        .sock_buf = ETH_W5500_DEFAULT_SOCK_BUF_CONFIG(), \
     }
 
+/**
+ * @brief W5500 specific IO commands, use them with `esp_eth_ioctl()`
+ *
+ */
+typedef enum {
+    ETH_W5500_CMD_G_RX_POOL_STATS = ETH_CMD_CUSTOM_MAC_CMDS, /*!< Get RX buffer pool statistics, data is `eth_w5500_rx_pool_stats_t *` */
+    ETH_W5500_CMD_G_CMD_STATS,                               /*!< Get socket command completion statistics, data is `eth_w5500_cmd_stats_t *` */
+    ETH_W5500_CMD_S_CMD_SPIN_US,                             /*!< Set busy-poll budget of socket commands in us, data is `uint32_t *` */
+    ETH_W5500_CMD_G_SPI_STATS,                               /*!< Get SPI bus usage per driver path, data is `eth_w5500_spi_stats_t *` */
+    ETH_W5500_CMD_S_IP_INFO,                                 /*!< Set IP configuration used by offloaded sockets, data is `eth_w5500_ip_info_t *` */
+    ETH_W5500_CMD_G_LINK_STATS,                              /*!< Get link monitoring statistics, data is `eth_w5500_link_stats_t *` */
+    ETH_W5500_CMD_G_FRAME_STATS,                             /*!< Get frame counters of the MAC socket, data is `eth_w5500_frame_stats_t *` */
+} eth_w5500_io_cmd_t;
+
+/**
+ * @brief Driver paths the SPI bus usage is accounted to
+ *
+ */
+typedef enum {
+    ETH_W5500_SPI_PATH_CTRL, /*!< Configuration, PHY access and socket open/close */
+    ETH_W5500_SPI_PATH_TX,   /*!< Frame transmission */
+    ETH_W5500_SPI_PATH_RX,   /*!< Frame reception */
+    ETH_W5500_SPI_PATH_IRQ,  /*!< Interrupt status handling */
+    ETH_W5500_SPI_PATH_MAX,
+} eth_w5500_spi_path_t;
+
+/**
+ * @brief SPI bus usage of one driver path
+ *
+ */
+typedef struct {
+    uint32_t batches;      /*!< Locked bus accesses, each covering one or more transactions */
+    uint32_t transactions; /*!< SPI transactions */
+    uint64_t bus_hold_us;  /*!< Time spent in bus accesses, including waiting for the bus lock */
+} eth_w5500_spi_path_stats_t;
+
+/**
+ * @brief SPI bus usage statistics
+ *
+ */
+typedef struct {
+    eth_w5500_spi_path_stats_t path[ETH_W5500_SPI_PATH_MAX]; /*!< Indexed by `eth_w5500_spi_path_t` */
+    uint32_t lock_takes;     /*!< SPI lock acquisitions of the default SPI driver, none with a single SPI owner */
+    uint64_t lock_us;        /*!< Time spent taking and giving the SPI lock */
+    uint32_t owner_requests; /*!< Accesses and frames other tasks handed over to the driver task (CONFIG_ETH_W5500_SPI_SINGLE_OWNER) */
+    uint64_t owner_wait_us;  /*!< Time the other tasks waited for their requests to be served */
+} eth_w5500_spi_stats_t;
+
+#define ETH_W5500_CMD_POLL_HIST_LEN (8) /*!< Number of buckets in the socket command poll histogram */
+
+/**
+ * @brief Socket command completion statistics
+ *
+ * Bucket n of the histogram counts commands that needed 2^n to 2^(n+1)-1 reads of the command register
+ * until the W5500 accepted them, the last bucket counts everything above.
+ *
+ */
+typedef struct {
+    uint32_t poll_hist[ETH_W5500_CMD_POLL_HIST_LEN]; /*!< Commands by number of command register reads */
+    uint32_t yielded;                                /*!< Commands that outlasted the busy-poll budget and gave up the CPU */
+    uint32_t timeouts;                               /*!< Commands not accepted within their timeout */
+    uint32_t max_us;                                 /*!< Longest time from issuing a command to its completion */
+} eth_w5500_cmd_stats_t;
+
+/**
+ * @brief Link monitoring statistics
+ *
+ * The W5500 has no link change interrupt, the driver task samples PHYCFGR along with its interrupt handling
+ * (at most every 100 ms). Latency is the time from the driver noticing a link change until the PHY driver
+ * reported it to the Ethernet core.
+ *
+ */
+typedef struct {
+    uint32_t flaps;           /*!< Link changes seen */
+    uint32_t last_latency_us; /*!< Report latency of the last link change */
+    uint32_t max_latency_us;  /*!< Longest report latency */
+    uint32_t ip_conflicts;    /*!< ARP requests from another host using our IP address (offloaded sockets only) */
+    uint32_t unreachable;     /*!< ICMP destination unreachable received for offloaded UDP sockets */
+} eth_w5500_link_stats_t;
+
+/**
+ * @brief Frame counters of the MAC raw socket (the traffic of the TCP/IP stack, offloaded sockets not included)
+ *
+ */
+typedef struct {
+    uint32_t rx_frames;  /*!< Frames passed to the stack */
+    uint64_t rx_bytes;   /*!< Bytes of those frames */
+    uint32_t rx_dropped; /*!< Frames lost for lack of a buffer, truncated, unreadable or badly framed */
+    uint32_t tx_frames;  /*!< Frames accepted for sending */
+    uint64_t tx_bytes;   /*!< Bytes of those frames */
+    uint32_t tx_errors;  /*!< Frames refused (TX memory full, link down or a bus error) or ended by a SEND TIMEOUT */
+} eth_w5500_frame_stats_t;
+
+/**
+ * @brief Usage statistics of one RX buffer pool class
+ *
+ */
+typedef struct {
+    uint32_t capacity;   /*!< Number of buffers in the class */
+    uint32_t in_use;     /*!< Buffers currently held by the driver or the TCP/IP stack */
+    uint32_t high_water; /*!< Highest number of buffers in use at once */
+    uint32_t alloc_fail; /*!< Allocations that found the class empty */
+    float avg_in_use;    /*!< Average number of buffers in use, sampled at every allocation */
+} eth_w5500_rx_pool_class_stats_t;
+
+/**
+ * @brief RX buffer pool statistics (CONFIG_ETH_W5500_RX_POOL)
+ *
+ */
+typedef struct {
+    eth_w5500_rx_pool_class_stats_t small; /*!< Buffers for frames up to 256 bytes */
+    eth_w5500_rx_pool_class_stats_t large; /*!< Full-MTU buffers */
+} eth_w5500_rx_pool_stats_t;
+
+/**
+ * @brief IPv4 configuration of the W5500 itself, needed by offloaded sockets (CONFIG_ETH_W5500_OFFLOAD)
+ *
+ * Addresses are in network byte order, as in `esp_ip4_addr_t`. Use the address the TCP/IP stack got,
+ * the W5500 and lwIP share the MAC address and IP address.
+ *
+ */
+typedef struct {
+    uint32_t ip;      /*!< IP address */
+    uint32_t netmask; /*!< Subnet mask */
+    uint32_t gw;      /*!< Gateway address */
+} eth_w5500_ip_info_t;
+
+/**
+ * @brief Type of an offloaded socket
+ *
+ */
+typedef enum {
+    ETH_W5500_SOCK_UDP,        /*!< UDP socket */
+    ETH_W5500_SOCK_TCP_CLIENT, /*!< TCP connection to `peer_ip`:`peer_port` */
+    ETH_W5500_SOCK_TCP_SERVER, /*!< TCP socket listening on `local_port`, listens again after the peer disconnects */
+} eth_w5500_sock_type_t;
+
+/**
+ * @brief Data received on an offloaded socket, called from the W5500 driver task
+ *
+ * @param sock: socket the data was received on
+ * @param data: received datagram (UDP) or part of the stream (TCP), valid during the call only
+ * @param len: length of data
+ * @param peer_ip: sender IP address in network byte order
+ * @param peer_port: sender port
+ * @param arg: user argument from the socket configuration
+ */
+typedef void (*eth_w5500_sock_recv_cb_t)(int sock, const uint8_t *data, uint32_t len, uint32_t peer_ip, uint16_t peer_port, void *arg);
+
+/**
+ * @brief Configuration of an offloaded socket
+ *
+ */
+typedef struct {
+    eth_w5500_sock_type_t type;       /*!< Socket type */
+    uint16_t local_port;              /*!< Local port, traffic to this port is no longer seen by lwIP */
+    uint32_t peer_ip;                 /*!< Peer IP address in network byte order (TCP client only) */
+    uint16_t peer_port;               /*!< Peer port (TCP client only) */
+    eth_w5500_sock_recv_cb_t on_recv; /*!< Receive callback, may be NULL for send-only sockets */
+    void *arg;                        /*!< User argument of the receive callback */
+} eth_w5500_sock_config_t;
+
+/**
+* @brief Open a UDP or TCP socket handled by the W5500 hardware TCP/IP stack (CONFIG_ETH_W5500_OFFLOAD)
+*
+* Socket 0 keeps serving lwIP in MAC RAW mode, the offloaded sockets take the frames addressed to their ports.
+* The Ethernet driver has to be started and the IP configuration set with `ETH_W5500_CMD_S_IP_INFO`.
+* Sockets are closed when the driver is stopped.
+*
+* @param mac: W5500 MAC instance
+* @param config: socket configuration
+* @param[out] sock: socket number
+*
+* @return
+*      - ESP_OK: socket opened
+*      - ESP_ERR_INVALID_ARG: invalid argument
+*      - ESP_ERR_NO_MEM: all offload sockets are in use
+*      - ESP_ERR_NOT_SUPPORTED: CONFIG_ETH_W5500_OFFLOAD is disabled
+*      - ESP_FAIL: the W5500 refused to open the socket
+*/
+esp_err_t esp_eth_mac_w5500_sock_open(esp_eth_mac_t *mac, const eth_w5500_sock_config_t *config, int *sock);
+
+/**
+* @brief Close an offloaded socket
+*
+* @param mac: W5500 MAC instance
+* @param sock: socket number returned by `esp_eth_mac_w5500_sock_open()`
+*
+* @return
+*      - ESP_OK: socket closed
+*      - ESP_ERR_INVALID_ARG: socket is not open
+*      - ESP_ERR_NOT_SUPPORTED: CONFIG_ETH_W5500_OFFLOAD is disabled
+*/
+esp_err_t esp_eth_mac_w5500_sock_close(esp_eth_mac_t *mac, int sock);
+
+/**
+* @brief Send data on an offloaded socket
+*
+* Returns once the W5500 accepted the SEND command, completion of the previous SEND is checked by the next call.
+*
+* @param mac: W5500 MAC instance
+* @param sock: socket number returned by `esp_eth_mac_w5500_sock_open()`
+* @param data: data to send
+* @param len: length of data, at most the socket buffer size
+* @param peer_ip: destination IP address in network byte order (UDP only)
+* @param peer_port: destination port (UDP only)
+*
+* @return
+*      - ESP_OK: data handed to the W5500
+*      - ESP_ERR_INVALID_ARG: invalid argument or socket is not open
+*      - ESP_ERR_INVALID_STATE: TCP connection is not established
+*      - ESP_ERR_NO_MEM: not enough free space in the socket TX buffer
+*      - ESP_ERR_TIMEOUT: previous SEND did not complete or the TCP connection timed out
+*      - ESP_ERR_NOT_SUPPORTED: CONFIG_ETH_W5500_OFFLOAD is disabled
+*/
+esp_err_t esp_eth_mac_w5500_sock_sendto(esp_eth_mac_t *mac, int sock, const void *data, uint32_t len, uint32_t peer_ip, uint16_t peer_port);
+
+/**
+* @brief Free a receive buffer passed to the TCP/IP stack by the W5500 MAC
+*
+* With CONFIG_ETH_W5500_RX_POOL enabled the buffers come from a preallocated pool and must not be released with `free()`.
+* Install this function as `driver_free_rx_buffer` of the Ethernet `esp_netif` (`esp_netif_set_driver_config()`).
+* Buffers that don't belong to the pool are released with `free()`.
+*
+* @param h: driver handle (unused)
+* @param buffer: buffer received through the stack input path
+*/
+void esp_eth_mac_w5500_free_rx_buf(void *h, void *buffer);
+
 /**
 * @brief Create W5500 Ethernet MAC instance
 *
@@ -5,8 +5,10 @@
  */
 #include <string.h>
 #include <stdlib.h>
+#include <assert.h>
 #include <sys/cdefs.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 #include "esp_eth_mac_spi.h"
 #include "esp_eth_mac_w5500.h"
 #include "driver/gpio.h"
@@ -26,16 +28,44 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "w5500.h"
+#include "w5500_rx_pool.h"
+#include "w5500_req_queue.h"
+#include "w5500_link.h"
 #include "sdkconfig.h"
 
 static const char *TAG = "w5500.mac";
 
 #define W5500_SPI_LOCK_TIMEOUT_MS (50)
-#define W5500_TX_MEM_SIZE (0x4000)
-#define W5500_RX_MEM_SIZE (0x4000)
+#define W5500_SOCK_MEM_KB (16) // TX and RX memory each, shared by all sockets
 #define W5500_100M_TX_TMO_US (200)
 #define W5500_10M_TX_TMO_US (1500)
+#define W5500_TX_DONE_MIN_TICKS (2) // a single tick wait may expire right away, so wait at least two
+#define W5500_TX_RING_LEN (16)      // frames that can be queued in SOCK0 TX memory at once
 #define W5500_ETH_MAC_RX_BUF_SIZE_AUTO (0)
+#define W5500_RX_DMA_ALIGN (4) // SPI DMA writes straight into RX buffers only if address and length are word aligned
+#define W5500_RX_DMA_LEN(len) (((len) + W5500_RX_DMA_ALIGN - 1) & ~(W5500_RX_DMA_ALIGN - 1))
+#define W5500_SPI_BATCH_MAX (4)        // register accesses submitted under one lock
+#define W5500_SPI_QUEUED_MIN_LEN (64)  // batches moving this much data are queued, so the CPU is free while DMA runs
+
+#define W5500_MACRAW_MIN_BUF_KB (2) // SOCK0 buffers must hold at least one full frame
+#define W5500_LINK_CHECK_MS (100)   // PHYCFGR sampling interval of the driver task, there is no link change interrupt
+#if CONFIG_ETH_W5500_OFFLOAD
+#define W5500_OFFLOAD_SEND_TMO_MS (2000) // covers ARP resolution of a new peer (RTR x RCR)
+#define W5500_OFFLOAD_RX_BUF_SIZE (ETH_MAX_PACKET_SIZE)
+#endif
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+#define W5500_OWNER_QUEUE_LEN (16) // requests of other tasks waiting for the driver task, power of two
+#endif
+
+// the default socket buffer split of Kconfig, checked here so a bad one fails the build instead of esp_eth_mac_new_w5500()
+#define W5500_BUF_KB_VALID(kb) ((kb) > 0 && (kb) <= W5500_SOCK_MEM_KB && ((kb) & ((kb) - 1)) == 0)
+_Static_assert(W5500_BUF_KB_VALID(CONFIG_ETH_W5500_MACRAW_BUF_KB) && CONFIG_ETH_W5500_MACRAW_BUF_KB >= W5500_MACRAW_MIN_BUF_KB,
+               "CONFIG_ETH_W5500_MACRAW_BUF_KB must be 2, 4, 8 or 16");
+#if CONFIG_ETH_W5500_OFFLOAD
+_Static_assert(W5500_BUF_KB_VALID(CONFIG_ETH_W5500_OFFLOAD_SOCK_BUF_KB), "CONFIG_ETH_W5500_OFFLOAD_SOCK_BUF_KB must be 1, 2, 4 or 8");
+_Static_assert(CONFIG_ETH_W5500_MACRAW_BUF_KB + CONFIG_ETH_W5500_OFFLOAD_SOCK_NUM * CONFIG_ETH_W5500_OFFLOAD_SOCK_BUF_KB <= W5500_SOCK_MEM_KB,
+               "MAC RAW and offload socket buffers exceed the 16 KB of the W5500");
+#endif
 
 typedef struct {
     uint32_t offset;
@@ -44,20 +74,69 @@ typedef struct {
     uint32_t remain;
 } __attribute__((packed)) emac_w5500_auto_buf_info_t;
 
+/**
+ * @brief Frames queued in SOCK0 TX memory
+ *
+ * Frames are written back-to-back behind the write pointer while the chip is still sending an older one.
+ * Only one SEND can be in flight, the next one is issued from the SEND_OK interrupt.
+ */
+typedef struct {
+    uint16_t end[W5500_TX_RING_LEN]; // value of TX_WR after each queued frame
+    uint8_t head;                    // oldest queued frame
+    uint8_t count;                   // number of queued frames, including the one being sent
+    uint16_t wr;                     // local copy of the TX write pointer, next free byte in TX memory
+    uint16_t rd;                     // start of the oldest frame not confirmed by SEND_OK yet
+    bool busy;                       // SEND issued for the head frame and not completed yet
+    uint16_t mem_size;               // SOCK0 TX memory size
+} emac_w5500_tx_ring_t;
+
+/**
+ * @brief Hardware socket serving an offloaded UDP/TCP endpoint
+ */
+typedef struct {
+    bool open;
+    bool send_busy; // SEND issued, SEND_OK or TIMEOUT not seen yet
+    eth_w5500_sock_config_t config;
+} emac_w5500_sock_t;
+
 typedef struct {
     spi_device_handle_t hdl;
     SemaphoreHandle_t lock;
+    uint32_t queue_size;
+    uint32_t lock_takes;
+    uint64_t lock_us;   // time spent taking and giving the lock
 } eth_spi_info_t;
 
+typedef struct {
+    uint32_t cmd;
+    uint32_t addr;
+    void *data;
+    uint32_t len;
+    bool write;
+} w5500_spi_op_t;
+
+/**
+ * @brief Register accesses submitted to the bus as one locked unit
+ *
+ * The accesses must not depend on each other's results, they are executed in order without releasing the bus.
+ */
+typedef struct {
+    w5500_spi_op_t ops[W5500_SPI_BATCH_MAX];
+    uint32_t num;
+    uint32_t data_len;
+    eth_w5500_spi_path_t path;
+} w5500_spi_batch_t;
+
 typedef struct {
     void *ctx;
     void *(*init)(const void *spi_config);
     esp_err_t (*deinit)(void *spi_ctx);
     esp_err_t (*read)(void *spi_ctx, uint32_t cmd, uint32_t addr, void *data, uint32_t data_len);
     esp_err_t (*write)(void *spi_ctx, uint32_t cmd, uint32_t addr, const void *data, uint32_t data_len);
+    esp_err_t (*batch)(void *spi_ctx, const w5500_spi_batch_t *batch); // NULL for custom SPI drivers
 } eth_spi_custom_driver_t;
 
-typedef struct {
+typedef struct emac_w5500_s {
     esp_eth_mac_t parent;
     esp_eth_mediator_t *eth;
     eth_spi_custom_driver_t spi;
@@ -68,11 +147,51 @@ typedef struct {
     uint32_t poll_period_ms;
     uint8_t addr[ETH_ADDR_LEN];
     bool packets_remain;
-    uint8_t *rx_buffer;
+    uint8_t *rx_batch_buf;
     uint8_t mcast_cnt;
     uint32_t tx_tmo;
+    TaskHandle_t tx_wait_hdl;
+    SemaphoreHandle_t tx_lock;
+    emac_w5500_tx_ring_t tx_ring;
+    w5500_rx_pool_t *rx_pool;
+    uint32_t cmd_spin_us;
+    eth_w5500_cmd_stats_t cmd_stats;
+    eth_w5500_spi_stats_t spi_stats;
+    eth_w5500_sock_buf_config_t sock_buf;
+    uint8_t simr;
+    SemaphoreHandle_t sock_lock;
+    uint8_t *sock_rx_buf;
+    emac_w5500_sock_t socks[ETH_W5500_SOCK_NUM];
+    w5500_req_queue_t *owner_queue;
+    uint8_t phycfg;          // PHYCFGR as last seen, TX checks the link here instead of on the bus
+    bool link_watch;         // chip is initialized, the driver task may sample PHYCFGR
+    bool link_push;          // the PHY driver handed link reporting over, the driver task reports changes itself
+    struct emac_w5500_s *link_next; // next MAC with a mediator, see w5500_link_take_over()
+    eth_link_t link_reported; // as the core was last told through set_link
+    int64_t link_checked_us;
+    int64_t link_changed_us; // when a link change not yet reported through set_link was seen, 0 if none
+    eth_w5500_link_stats_t link_stats;
+    eth_w5500_frame_stats_t frame_stats;
 } emac_w5500_t;
 
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+typedef esp_err_t (*w5500_owner_fn_t)(emac_w5500_t *emac, void *arg);
+
+/**
+ * @brief Work another task hands over to emac_w5500_task, the only task accessing the W5500
+ *
+ * Lives on the stack of the waiting task until done is given. A semaphore of its own rather than a task
+ * notification, so it can't consume a notification the waiting task gets for something else.
+ */
+typedef struct {
+    w5500_owner_fn_t fn;
+    void *arg;
+    esp_err_t ret;
+    SemaphoreHandle_t done;
+    StaticSemaphore_t done_buf;
+} w5500_owner_req_t;
+#endif
+
 static void *w5500_spi_init(const void *spi_config)
 {
     void *ret = NULL;
@@ -93,9 +212,12 @@ static void *w5500_spi_init(const void *spi_config)
     }
     ESP_GOTO_ON_FALSE(spi_bus_add_device(w5500_config->spi_host_id, &spi_devcfg, &spi->hdl) == ESP_OK, NULL,
                       err, TAG, "adding device to SPI host #%i failed", w5500_config->spi_host_id + 1);
+    spi->queue_size = spi_devcfg.queue_size;
+#if !CONFIG_ETH_W5500_SPI_SINGLE_OWNER
     /* create mutex */
     spi->lock = xSemaphoreCreateMutex();
     ESP_GOTO_ON_FALSE(spi->lock, NULL, err, TAG, "create lock failed");
+#endif
 
     ret = spi;
     return ret;
@@ -115,7 +237,9 @@ static esp_err_t w5500_spi_deinit(void *spi_ctx)
     eth_spi_info_t *spi = (eth_spi_info_t *)spi_ctx;
 
     spi_bus_remove_device(spi->hdl);
-    vSemaphoreDelete(spi->lock);
+    if (spi->lock) {
+        vSemaphoreDelete(spi->lock);
+    }
 
     free(spi);
     return ret;
@@ -123,12 +247,28 @@ static esp_err_t w5500_spi_deinit(void *spi_ctx)
 
 static inline bool w5500_spi_lock(eth_spi_info_t *spi)
 {
-    return xSemaphoreTake(spi->lock, pdMS_TO_TICKS(W5500_SPI_LOCK_TIMEOUT_MS)) == pdTRUE;
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    // all accesses are made by emac_w5500_task, other tasks hand them over (see w5500_owner_call())
+    return true;
+#else
+    int64_t start = esp_timer_get_time();
+    bool locked = xSemaphoreTake(spi->lock, pdMS_TO_TICKS(W5500_SPI_LOCK_TIMEOUT_MS)) == pdTRUE;
+    spi->lock_takes++;
+    spi->lock_us += esp_timer_get_time() - start;
+    return locked;
+#endif
 }
 
 static inline bool w5500_spi_unlock(eth_spi_info_t *spi)
 {
-    return xSemaphoreGive(spi->lock) == pdTRUE;
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    return true;
+#else
+    int64_t start = esp_timer_get_time();
+    bool unlocked = xSemaphoreGive(spi->lock) == pdTRUE;
+    spi->lock_us += esp_timer_get_time() - start;
+    return unlocked;
+#endif
 }
 
 static esp_err_t w5500_spi_write(void *spi_ctx, uint32_t cmd, uint32_t addr, const void *value, uint32_t len)
@@ -181,91 +321,427 @@ static esp_err_t w5500_spi_read(void *spi_ctx, uint32_t cmd, uint32_t addr, void
     return ret;
 }
 
+static esp_err_t w5500_spi_batch(void *spi_ctx, const w5500_spi_batch_t *batch)
+{
+    esp_err_t ret = ESP_OK;
+    eth_spi_info_t *spi = (eth_spi_info_t *)spi_ctx;
+    spi_transaction_t trans[W5500_SPI_BATCH_MAX] = {0};
+    spi_transaction_t *done = NULL;
+    // polling is cheaper for a few register bytes, payload transfers are queued so the task sleeps during DMA
+    bool queued = batch->data_len >= W5500_SPI_QUEUED_MIN_LEN && batch->num <= spi->queue_size;
+
+    for (uint32_t i = 0; i < batch->num; i++) {
+        const w5500_spi_op_t *op = &batch->ops[i];
+        trans[i].cmd = op->cmd;
+        trans[i].addr = op->addr;
+        trans[i].length = 8 * op->len;
+        if (op->write) {
+            if (op->len <= 4) {
+                trans[i].flags = SPI_TRANS_USE_TXDATA;
+                memcpy(trans[i].tx_data, op->data, op->len);
+            } else {
+                trans[i].tx_buffer = op->data;
+            }
+        } else {
+            // use direct reads for registers to prevent overwrites by 4-byte boundary writes
+            trans[i].flags = op->len <= 4 ? SPI_TRANS_USE_RXDATA : 0;
+            trans[i].rx_buffer = op->data;
+        }
+    }
+    if (!w5500_spi_lock(spi)) {
+        return ESP_ERR_TIMEOUT;
+    }
+    // keep the bus for the whole batch, so no other device gets in between
+    if (spi_device_acquire_bus(spi->hdl, portMAX_DELAY) != ESP_OK) {
+        w5500_spi_unlock(spi);
+        return ESP_FAIL;
+    }
+    if (queued) {
+        uint32_t pending = 0;
+        for (uint32_t i = 0; i < batch->num && ret == ESP_OK; i++) {
+            if (spi_device_queue_trans(spi->hdl, &trans[i], portMAX_DELAY) == ESP_OK) {
+                pending++;
+            } else {
+                ret = ESP_FAIL;
+            }
+        }
+        // all queued transactions have to be collected, even after an error
+        while (pending--) {
+            if (spi_device_get_trans_result(spi->hdl, &done, portMAX_DELAY) != ESP_OK) {
+                ret = ESP_FAIL;
+            }
+        }
+    } else {
+        for (uint32_t i = 0; i < batch->num && ret == ESP_OK; i++) {
+            if (spi_device_polling_transmit(spi->hdl, &trans[i]) != ESP_OK) {
+                ret = ESP_FAIL;
+            }
+        }
+    }
+    spi_device_release_bus(spi->hdl);
+    w5500_spi_unlock(spi);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "%s(%d): spi transmit failed", __FUNCTION__, __LINE__);
+        return ret;
+    }
+    for (uint32_t i = 0; i < batch->num; i++) {
+        if (trans[i].flags & SPI_TRANS_USE_RXDATA) {
+            memcpy(batch->ops[i].data, trans[i].rx_data, batch->ops[i].len);  // copy register values to output
+        }
+    }
+    return ret;
+}
+
+static inline void w5500_spi_stats_add(emac_w5500_t *emac, eth_w5500_spi_path_t path, uint32_t trans, int64_t start)
+{
+    // statistics only, an occasional lost update between the driver task and transmit is acceptable
+    eth_w5500_spi_path_stats_t *stats = &emac->spi_stats.path[path];
+    stats->batches++;
+    stats->transactions += trans;
+    stats->bus_hold_us += esp_timer_get_time() - start;
+}
+
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+static inline bool w5500_is_owner(emac_w5500_t *emac)
+{
+    return xTaskGetCurrentTaskHandle() == emac->rx_task_hdl;
+}
+
+/**
+ * @brief Run fn in emac_w5500_task and wait for its result
+ *
+ * The request is passed over a lock-free queue, so the W5500 is never accessed by two tasks and needs no lock.
+ * Called from the driver task itself (e.g. from a socket receive callback), fn is simply run in place.
+ */
+static esp_err_t w5500_owner_call(emac_w5500_t *emac, w5500_owner_fn_t fn, void *arg)
+{
+    if (!emac->rx_task_hdl || w5500_is_owner(emac)) {
+        return fn(emac, arg);
+    }
+    w5500_owner_req_t req = {
+        .fn = fn,
+        .arg = arg,
+        .ret = ESP_OK,
+    };
+    req.done = xSemaphoreCreateBinaryStatic(&req.done_buf);
+    int64_t start = esp_timer_get_time();
+    while (!w5500_req_queue_push(emac->owner_queue, &req)) {
+        vTaskDelay(1);
+    }
+    xTaskNotifyGive(emac->rx_task_hdl);
+    xSemaphoreTake(req.done, portMAX_DELAY);
+    vSemaphoreDelete(req.done);
+    // statistics only, an occasional lost update between two requesting tasks is acceptable
+    emac->spi_stats.owner_requests++;
+    emac->spi_stats.owner_wait_us += esp_timer_get_time() - start;
+    return req.ret;
+}
+
+/* called from emac_w5500_task, returns true if any request was served */
+static bool w5500_owner_serve(emac_w5500_t *emac)
+{
+    bool served = false;
+    w5500_owner_req_t *req;
+    while ((req = w5500_req_queue_pop(emac->owner_queue)) != NULL) {
+        req->ret = req->fn(emac, req->arg);
+        // req may be gone once done is given, it is the last access
+        xSemaphoreGive(req->done);
+        served = true;
+    }
+    return served;
+}
+#endif // CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+
+static inline void w5500_batch_init(w5500_spi_batch_t *batch, eth_w5500_spi_path_t path)
+{
+    batch->num = 0;
+    batch->data_len = 0;
+    batch->path = path;
+}
+
+static void w5500_batch_add(w5500_spi_batch_t *batch, uint32_t address, uint32_t mode, void *data, uint32_t len)
+{
+    assert(batch->num < W5500_SPI_BATCH_MAX);
+    w5500_spi_op_t *op = &batch->ops[batch->num++];
+    op->cmd = (address >> W5500_ADDR_OFFSET); // Actually it's the address phase in W5500 SPI frame
+    op->addr = ((address & 0xFFFF) | (mode << W5500_RWB_OFFSET)
+                | W5500_SPI_OP_MODE_VDM); // Actually it's the command phase in W5500 SPI frame
+    op->data = data;
+    op->len = len;
+    op->write = mode == W5500_ACCESS_MODE_WRITE;
+    batch->data_len += len;
+}
+
+static inline void w5500_batch_read(w5500_spi_batch_t *batch, uint32_t address, void *data, uint32_t len)
+{
+    w5500_batch_add(batch, address, W5500_ACCESS_MODE_READ, data, len);
+}
+
+/* data has to stay valid until the batch is submitted */
+static inline void w5500_batch_write(w5500_spi_batch_t *batch, uint32_t address, const void *data, uint32_t len)
+{
+    w5500_batch_add(batch, address, W5500_ACCESS_MODE_WRITE, (void *)data, len);
+}
+
+static esp_err_t w5500_batch_exec(emac_w5500_t *emac, const w5500_spi_batch_t *batch)
+{
+    esp_err_t ret = ESP_OK;
+    int64_t start = esp_timer_get_time();
+    if (emac->spi.batch) {
+        ret = emac->spi.batch(emac->spi.ctx, batch);
+    } else {
+        // custom SPI drivers only know single accesses
+        for (uint32_t i = 0; i < batch->num && ret == ESP_OK; i++) {
+            const w5500_spi_op_t *op = &batch->ops[i];
+            if (op->write) {
+                ret = emac->spi.write(emac->spi.ctx, op->cmd, op->addr, op->data, op->len);
+            } else {
+                ret = emac->spi.read(emac->spi.ctx, op->cmd, op->addr, op->data, op->len);
+            }
+        }
+    }
+    w5500_spi_stats_add(emac, batch->path, batch->num, start);
+    return ret;
+}
+
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+static esp_err_t w5500_owner_batch_exec(emac_w5500_t *emac, void *arg)
+{
+    return w5500_batch_exec(emac, arg);
+}
+#endif
+
+static esp_err_t w5500_batch_submit(emac_w5500_t *emac, const w5500_spi_batch_t *batch)
+{
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    if (!w5500_is_owner(emac)) {
+        return w5500_owner_call(emac, w5500_owner_batch_exec, (void *)batch);
+    }
+#endif
+    return w5500_batch_exec(emac, batch);
+}
+
 static esp_err_t w5500_read(emac_w5500_t *emac, uint32_t address, void *data, uint32_t len)
 {
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    if (!w5500_is_owner(emac)) {
+        // single accesses of other tasks are handed over as a batch
+        w5500_spi_batch_t batch;
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_CTRL);
+        w5500_batch_read(&batch, address, data, len);
+        return w5500_batch_submit(emac, &batch);
+    }
+#endif
     uint32_t cmd = (address >> W5500_ADDR_OFFSET); // Actually it's the address phase in W5500 SPI frame
     uint32_t addr = ((address & 0xFFFF) | (W5500_ACCESS_MODE_READ << W5500_RWB_OFFSET)
                      | W5500_SPI_OP_MODE_VDM); // Actually it's the command phase in W5500 SPI frame
+    int64_t start = esp_timer_get_time();
 
-    return emac->spi.read(emac->spi.ctx, cmd, addr, data, len);
+    esp_err_t ret = emac->spi.read(emac->spi.ctx, cmd, addr, data, len);
+    w5500_spi_stats_add(emac, ETH_W5500_SPI_PATH_CTRL, 1, start);
+    return ret;
 }
 
 static esp_err_t w5500_write(emac_w5500_t *emac, uint32_t address, const void *data, uint32_t len)
 {
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    if (!w5500_is_owner(emac)) {
+        w5500_spi_batch_t batch;
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_CTRL);
+        w5500_batch_write(&batch, address, data, len);
+        return w5500_batch_submit(emac, &batch);
+    }
+#endif
     uint32_t cmd = (address >> W5500_ADDR_OFFSET); // Actually it's the address phase in W5500 SPI frame
     uint32_t addr = ((address & 0xFFFF) | (W5500_ACCESS_MODE_WRITE << W5500_RWB_OFFSET)
                      | W5500_SPI_OP_MODE_VDM); // Actually it's the command phase in W5500 SPI frame
+    int64_t start = esp_timer_get_time();
 
-    return emac->spi.write(emac->spi.ctx, cmd, addr, data, len);
+    esp_err_t ret = emac->spi.write(emac->spi.ctx, cmd, addr, data, len);
+    w5500_spi_stats_add(emac, ETH_W5500_SPI_PATH_CTRL, 1, start);
+    return ret;
 }
 
-static esp_err_t w5500_send_command(emac_w5500_t *emac, uint8_t command, uint32_t timeout_ms)
+static void w5500_cmd_stats_update(emac_w5500_t *emac, uint32_t polls, bool yielded, bool timeout, int64_t elapsed_us)
+{
+    // statistics only, an occasional lost increment between the RX task and transmit is acceptable
+    eth_w5500_cmd_stats_t *stats = &emac->cmd_stats;
+    uint32_t bucket = 31 - __builtin_clz(polls);
+    if (bucket >= ETH_W5500_CMD_POLL_HIST_LEN) {
+        bucket = ETH_W5500_CMD_POLL_HIST_LEN - 1;
+    }
+    stats->poll_hist[bucket]++;
+    stats->yielded += yielded;
+    stats->timeouts += timeout;
+    if (elapsed_us > stats->max_us) {
+        stats->max_us = elapsed_us;
+    }
+}
+
+/* wait for a command written to SCR (on its own or as part of a batch) to be accepted */
+static esp_err_t w5500_wait_command(emac_w5500_t *emac, int sock, eth_w5500_spi_path_t path, uint32_t timeout_ms)
 {
     esp_err_t ret = ESP_OK;
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_CR(0), &command, sizeof(command)), err, TAG, "write SCR failed");
+    uint32_t polls = 0;
+    bool yielded = false;
+    int64_t start = esp_timer_get_time();
+    int64_t elapsed = 0;
+    uint8_t command = 0;
+    w5500_spi_batch_t batch;
     // after W5500 accepts the command, the command register will be cleared automatically
-    uint32_t to = 0;
-    for (to = 0; to < timeout_ms / 10; to++) {
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_CR(0), &command, sizeof(command)), err, TAG, "read SCR failed");
+    // this normally takes a few us, so poll without delay first and only give up the CPU once the spin budget is spent
+    while (1) {
+        w5500_batch_init(&batch, path);
+        w5500_batch_read(&batch, W5500_REG_SOCK_CR(sock), &command, sizeof(command));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read SCR failed");
+        polls++;
         if (!command) {
             break;
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
+        elapsed = esp_timer_get_time() - start;
+        ESP_GOTO_ON_FALSE(elapsed < (int64_t)timeout_ms * 1000, ESP_ERR_TIMEOUT, err, TAG, "send command timeout");
+        if (elapsed >= emac->cmd_spin_us) {
+            yielded = true;
+            vTaskDelay(1);
+        }
     }
-    ESP_GOTO_ON_FALSE(to < timeout_ms / 10, ESP_ERR_TIMEOUT, err, TAG, "send command timeout");
 
 err:
+    if (polls) {
+        w5500_cmd_stats_update(emac, polls, yielded, ret == ESP_ERR_TIMEOUT, esp_timer_get_time() - start);
+    }
     return ret;
 }
 
-static esp_err_t w5500_get_tx_free_size(emac_w5500_t *emac, uint16_t *size)
+static esp_err_t w5500_send_command(emac_w5500_t *emac, uint8_t command, uint32_t timeout_ms)
 {
     esp_err_t ret = ESP_OK;
-    uint16_t free0, free1 = 0;
-    // read TX_FSR register more than once, until we get the same value
-    // this is a trick because we might be interrupted between reading the high/low part of the TX_FSR register (16 bits in length)
-    do {
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_TX_FSR(0), &free0, sizeof(free0)), err, TAG, "read TX FSR failed");
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_TX_FSR(0), &free1, sizeof(free1)), err, TAG, "read TX FSR failed");
-    } while (free0 != free1);
-
-    *size = __builtin_bswap16(free0);
-
+    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_CR(0), &command, sizeof(command)), err, TAG, "write SCR failed");
+    ret = w5500_wait_command(emac, 0, ETH_W5500_SPI_PATH_CTRL, timeout_ms);
 err:
     return ret;
 }
 
-static esp_err_t w5500_get_rx_received_size(emac_w5500_t *emac, uint16_t *size)
+static esp_err_t w5500_get_rx_state(emac_w5500_t *emac, int sock, uint16_t *size, uint16_t *offset)
 {
     esp_err_t ret = ESP_OK;
     uint16_t received0, received1 = 0;
+    w5500_spi_batch_t batch;
+    // read RX_RSR register more than once, until we get the same value
+    // this is a trick because we might be interrupted between reading the high/low part of the RX_RSR register (16 bits in length)
+    // the read pointer is fetched in the same batch
     do {
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_RX_RSR(0), &received0, sizeof(received0)), err, TAG, "read RX RSR failed");
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_RX_RSR(0), &received1, sizeof(received1)), err, TAG, "read RX RSR failed");
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_RX);
+        w5500_batch_read(&batch, W5500_REG_SOCK_RX_RSR(sock), &received0, sizeof(received0));
+        w5500_batch_read(&batch, W5500_REG_SOCK_RX_RSR(sock), &received1, sizeof(received1));
+        w5500_batch_read(&batch, W5500_REG_SOCK_RX_RD(sock), offset, sizeof(*offset));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read RX RSR failed");
     } while (received0 != received1);
     *size = __builtin_bswap16(received0);
+    *offset = __builtin_bswap16(*offset);
 
 err:
     return ret;
 }
 
-static esp_err_t w5500_write_buffer(emac_w5500_t *emac, const void *buffer, uint32_t len, uint16_t offset)
+static esp_err_t w5500_read_buffer(emac_w5500_t *emac, int sock, void *buffer, uint32_t len, uint16_t offset)
 {
     esp_err_t ret = ESP_OK;
-
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_MEM_SOCK_TX(0, offset), buffer, len), err, TAG, "write TX buffer failed");
+    w5500_spi_batch_t batch;
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_RX);
+    w5500_batch_read(&batch, W5500_MEM_SOCK_RX(sock, offset), buffer, len);
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read RX buffer failed");
 err:
     return ret;
 }
 
-static esp_err_t w5500_read_buffer(emac_w5500_t *emac, void *buffer, uint32_t len, uint16_t offset)
+/* move RX_RD to offset and issue RECV, appended to the accesses already in the batch */
+static esp_err_t w5500_rx_release(emac_w5500_t *emac, int sock, w5500_spi_batch_t *batch, uint16_t offset)
 {
     esp_err_t ret = ESP_OK;
-    ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_MEM_SOCK_RX(0, offset), buffer, len), err, TAG, "read RX buffer failed");
+    uint16_t rd = __builtin_bswap16(offset);
+    uint8_t command = W5500_SCR_RECV;
+    w5500_batch_write(batch, W5500_REG_SOCK_RX_RD(sock), &rd, sizeof(rd));
+    w5500_batch_write(batch, W5500_REG_SOCK_CR(sock), &command, sizeof(command));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, batch), err, TAG, "write RX RD failed");
+    ESP_GOTO_ON_ERROR(w5500_wait_command(emac, sock, ETH_W5500_SPI_PATH_RX, 100), err, TAG, "issue RECV command failed");
 err:
     return ret;
 }
 
+/* refresh the cached PHYCFGR, link changes are timed until the core reports them through set_link */
+static void w5500_link_update(emac_w5500_t *emac, uint8_t phycfg)
+{
+    emac->link_checked_us = esp_timer_get_time();
+    if ((phycfg ^ emac->phycfg) & W5500_PHYCFGR_LNK) {
+        emac->link_stats.flaps++;
+        emac->link_changed_us = emac->link_checked_us;
+        ESP_LOGD(TAG, "link %s detected", phycfg & W5500_PHYCFGR_LNK ? "up" : "down");
+    }
+    emac->phycfg = phycfg;
+}
+
+/* in interrupt mode the driver task samples PHYCFGR on its own, the cache is then always recent */
+static inline bool w5500_link_watched(emac_w5500_t *emac)
+{
+    return emac->link_watch && emac->int_gpio_num >= 0;
+}
+
+/* called from emac_w5500_task after sampling, the core learns about a link change now instead of at its next poll */
+static void w5500_link_report(emac_w5500_t *emac)
+{
+    esp_eth_mediator_t *eth = emac->eth;
+    uint8_t phycfg = emac->phycfg;
+    eth_link_t link = (phycfg & W5500_PHYCFGR_LNK) ? ETH_LINK_UP : ETH_LINK_DOWN;
+    if (!emac->link_push || link == emac->link_reported) {
+        return;
+    }
+    if (link == ETH_LINK_UP) {
+        eth_speed_t speed = (phycfg & W5500_PHYCFGR_SPD) ? ETH_SPEED_100M : ETH_SPEED_10M;
+        eth_duplex_t duplex = (phycfg & W5500_PHYCFGR_DPX) ? ETH_DUPLEX_FULL : ETH_DUPLEX_HALF;
+        eth->on_state_changed(eth, ETH_STATE_SPEED, (void *)speed);
+        eth->on_state_changed(eth, ETH_STATE_DUPLEX, (void *)duplex);
+    }
+    // on failure link_reported stays as it is and the next sample tries again
+    if (eth->on_state_changed(eth, ETH_STATE_LINK, (void *)link) != ESP_OK) {
+        ESP_LOGW(TAG, "report link %s failed", link == ETH_LINK_UP ? "up" : "down");
+    }
+}
+
+static inline bool w5500_link_check_due(emac_w5500_t *emac)
+{
+    return emac->link_watch && esp_timer_get_time() - emac->link_checked_us >= W5500_LINK_CHECK_MS * 1000;
+}
+
+static void w5500_link_check(emac_w5500_t *emac)
+{
+    uint8_t phycfg = 0;
+    w5500_spi_batch_t batch;
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_IRQ);
+    w5500_batch_read(&batch, W5500_REG_PHYCFGR, &phycfg, sizeof(phycfg));
+    if (w5500_batch_submit(emac, &batch) == ESP_OK) {
+        w5500_link_update(emac, phycfg);
+    }
+}
+
+#if CONFIG_ETH_W5500_OFFLOAD
+/* called from emac_w5500_task for the chip level interrupts, only offloaded sockets can cause them */
+static void w5500_handle_common_irq(emac_w5500_t *emac, uint8_t ir)
+{
+    if (ir & W5500_IR_CONFLICT) {
+        emac->link_stats.ip_conflicts++;
+        ESP_LOGW(TAG, "IP address conflict detected");
+    }
+    if (ir & W5500_IR_UNREACH) {
+        uint8_t dest[6]; // UIPR and UPORTR are adjacent
+        emac->link_stats.unreachable++;
+        if (w5500_read(emac, W5500_REG_UIPR, dest, sizeof(dest)) == ESP_OK) {
+            ESP_LOGW(TAG, "destination unreachable: %d.%d.%d.%d:%d", dest[0], dest[1], dest[2], dest[3], (dest[4] << 8) | dest[5]);
+        }
+    }
+}
+#endif
+
 static esp_err_t w5500_set_mac_addr(emac_w5500_t *emac)
 {
     esp_err_t ret = ESP_OK;
@@ -321,15 +797,15 @@ err:
 static esp_err_t w5500_setup_default(emac_w5500_t *emac)
 {
     esp_err_t ret = ESP_OK;
-    uint8_t reg_value = 16;
+    uint8_t reg_value = 0;
 
-    // Only SOCK0 can be used as MAC RAW mode, so we give the whole buffer (16KB TX and 16KB RX) to SOCK0, which doesn't have any effect for TX though.
-    // A larger TX buffer doesn't buy us pipelining - each SEND is one frame and must complete before the next.
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_RXBUF_SIZE(0), &reg_value, sizeof(reg_value)), err, TAG, "set rx buffer size failed");
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_TXBUF_SIZE(0), &reg_value, sizeof(reg_value)), err, TAG, "set tx buffer size failed");
-    reg_value = 0;
-    for (int i = 1; i < 8; i++) {
+    // Only SOCK0 can be used as MAC RAW mode, the memory is split between the sockets as configured by sock_buf,
+    // all of it goes to SOCK0 by default unless sockets are offloaded.
+    // Each SEND still covers one frame, but the TX ring writes the following frames into the buffer while it is in flight.
+    for (int i = 0; i < ETH_W5500_SOCK_NUM; i++) {
+        reg_value = emac->sock_buf.rx_size_kb[i];
         ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_RXBUF_SIZE(i), &reg_value, sizeof(reg_value)), err, TAG, "set rx buffer size failed");
+        reg_value = emac->sock_buf.tx_size_kb[i];
         ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_TXBUF_SIZE(i), &reg_value, sizeof(reg_value)), err, TAG, "set tx buffer size failed");
     }
 
@@ -339,11 +815,19 @@ static esp_err_t w5500_setup_default(emac_w5500_t *emac)
     /* Disable interrupt for all sockets by default */
     reg_value = 0;
     ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SIMR, &reg_value, sizeof(reg_value)), err, TAG, "write SIMR failed");
+#if CONFIG_ETH_W5500_OFFLOAD
+    /* Report IP conflicts and unreachable destinations, both are only possible with offloaded sockets */
+    reg_value = W5500_IR_CONFLICT | W5500_IR_UNREACH;
+    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_IMR, &reg_value, sizeof(reg_value)), err, TAG, "write IMR failed");
+#endif
     /* Enable MAC RAW mode for SOCK0, enable MAC filter, no blocking broadcast and block multicast */
     reg_value = W5500_SMR_MAC_RAW | W5500_SMR_MAC_FILTER | W5500_SMR_MAC_BLOCK_MCAST;
     ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_MR(0), &reg_value, sizeof(reg_value)), err, TAG, "write SMR failed");
-    /* Enable receive event for SOCK0 */
+    /* Enable receive event for SOCK0, and send done and send timeout events when TX completion is interrupt driven */
     reg_value = W5500_SIR_RECV;
+    if (emac->int_gpio_num >= 0) {
+        reg_value |= W5500_SIR_SEND | W5500_SIR_TIMEOUT;
+    }
     ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_IMR(0), &reg_value, sizeof(reg_value)), err, TAG, "write SOCK0 IMR failed");
     /* Set the interrupt re-assert level to maximum (~1.5ms) to lower the chances of missing it */
     uint16_t int_level = __builtin_bswap16(0xFFFF);
@@ -353,41 +837,568 @@ err:
     return ret;
 }
 
-static esp_err_t emac_w5500_start(esp_eth_mac_t *mac)
+static esp_err_t w5500_tx_ring_reset(emac_w5500_t *emac)
+{
+    esp_err_t ret = ESP_OK;
+    emac_w5500_tx_ring_t *ring = &emac->tx_ring;
+    uint16_t offset = 0;
+    // read before taking the lock, the driver task may need it to serve the access
+    ESP_RETURN_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_TX_WR(0), &offset, sizeof(offset)), TAG, "read TX WR failed");
+    xSemaphoreTake(emac->tx_lock, portMAX_DELAY);
+    ring->wr = __builtin_bswap16(offset);
+    ring->rd = ring->wr;
+    ring->mem_size = emac->sock_buf.tx_size_kb[0] * 1024;
+    ring->head = 0;
+    ring->count = 0;
+    ring->busy = false;
+    xSemaphoreGive(emac->tx_lock);
+    return ret;
+}
+
+#if CONFIG_ETH_W5500_OFFLOAD
+static esp_err_t w5500_sock_command(emac_w5500_t *emac, int sock, uint8_t command, eth_w5500_spi_path_t path)
+{
+    esp_err_t ret = ESP_OK;
+    w5500_spi_batch_t batch;
+    w5500_batch_init(&batch, path);
+    w5500_batch_write(&batch, W5500_REG_SOCK_CR(sock), &command, sizeof(command));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write SCR failed");
+    ret = w5500_wait_command(emac, sock, path, 100);
+err:
+    return ret;
+}
+
+/* open the hardware socket according to its configuration, must be called with sock_lock held */
+static esp_err_t w5500_sock_setup(emac_w5500_t *emac, int sock)
+{
+    esp_err_t ret = ESP_OK;
+    emac_w5500_sock_t *s = &emac->socks[sock];
+    uint8_t mode = s->config.type == ETH_W5500_SOCK_UDP ? W5500_SMR_UDP : W5500_SMR_TCP;
+    uint16_t port = __builtin_bswap16(s->config.local_port);
+    uint8_t imr = W5500_SIR_RECV | W5500_SIR_CON | W5500_SIR_DISCON;
+    uint8_t status = 0;
+    uint8_t peer[6];
+    w5500_spi_batch_t batch;
+
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_CTRL);
+    w5500_batch_write(&batch, W5500_REG_SOCK_MR(sock), &mode, sizeof(mode));
+    w5500_batch_write(&batch, W5500_REG_SOCK_PORT(sock), &port, sizeof(port));
+    w5500_batch_write(&batch, W5500_REG_SOCK_IMR(sock), &imr, sizeof(imr));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "configure socket %d failed", sock);
+    ESP_GOTO_ON_ERROR(w5500_sock_command(emac, sock, W5500_SCR_OPEN, ETH_W5500_SPI_PATH_CTRL), err, TAG, "issue OPEN command failed");
+    ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_SR(sock), &status, sizeof(status)), err, TAG, "read SSR failed");
+    ESP_GOTO_ON_FALSE(status == (mode == W5500_SMR_UDP ? W5500_SSR_UDP : W5500_SSR_INIT), ESP_FAIL, err, TAG,
+                      "socket %d not opened (SR 0x%02" PRIx8 ")", sock, status);
+    if (s->config.type == ETH_W5500_SOCK_TCP_SERVER) {
+        ESP_GOTO_ON_ERROR(w5500_sock_command(emac, sock, W5500_SCR_LISTEN, ETH_W5500_SPI_PATH_CTRL), err, TAG, "issue LISTEN command failed");
+    } else if (s->config.type == ETH_W5500_SOCK_TCP_CLIENT) {
+        // DIPR and DPORT are adjacent, the connection is established in the background and signalled by CON
+        memcpy(peer, &s->config.peer_ip, 4);
+        peer[4] = s->config.peer_port >> 8;
+        peer[5] = s->config.peer_port & 0xFF;
+        ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_DIPR(sock), peer, sizeof(peer)), err, TAG, "write DIPR failed");
+        ESP_GOTO_ON_ERROR(w5500_sock_command(emac, sock, W5500_SCR_CONNECT, ETH_W5500_SPI_PATH_CTRL), err, TAG, "issue CONNECT command failed");
+    }
+    s->send_busy = false;
+err:
+    return ret;
+}
+
+/* must be called with sock_lock held */
+static esp_err_t w5500_sock_shutdown(emac_w5500_t *emac, int sock)
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t simr = emac->simr & ~(1 << sock);
+    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SIMR, &simr, sizeof(simr)), err, TAG, "write SIMR failed");
+    emac->simr = simr;
+    emac->socks[sock].open = false;
+    ESP_GOTO_ON_ERROR(w5500_sock_command(emac, sock, W5500_SCR_CLOSE, ETH_W5500_SPI_PATH_CTRL), err, TAG, "issue CLOSE command failed");
+err:
+    return ret;
+}
+
+/* sockets without buffer memory can't be offloaded */
+static inline bool w5500_sock_usable(emac_w5500_t *emac, int sock)
+{
+    return sock >= 1 && sock < ETH_W5500_SOCK_NUM && emac->sock_buf.rx_size_kb[sock] && emac->sock_buf.tx_size_kb[sock];
+}
+
+static void w5500_sock_close_all(emac_w5500_t *emac)
+{
+    xSemaphoreTake(emac->sock_lock, portMAX_DELAY);
+    for (int i = 1; i < ETH_W5500_SOCK_NUM; i++) {
+        if (emac->socks[i].open) {
+            w5500_sock_shutdown(emac, i);
+        }
+    }
+    xSemaphoreGive(emac->sock_lock);
+}
+
+/* wait for SEND_OK or TIMEOUT of the previous SEND, must be called with sock_lock held */
+static esp_err_t w5500_sock_wait_sent(emac_w5500_t *emac, int sock)
+{
+    esp_err_t ret = ESP_OK;
+    emac_w5500_sock_t *s = &emac->socks[sock];
+    int64_t start = esp_timer_get_time();
+    int64_t elapsed = 0;
+    uint8_t ir = 0;
+    w5500_spi_batch_t batch;
+    // SEND_OK and TIMEOUT are not enabled in Sn_IMR, so the driver task leaves them to us
+    while (1) {
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+        w5500_batch_read(&batch, W5500_REG_SOCK_IR(sock), &ir, sizeof(ir));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read SOCK IR failed");
+        ir &= W5500_SIR_SEND | W5500_SIR_TIMEOUT;
+        if (ir) {
+            break;
+        }
+        elapsed = esp_timer_get_time() - start;
+        ESP_GOTO_ON_FALSE(elapsed < W5500_OFFLOAD_SEND_TMO_MS * 1000, ESP_ERR_TIMEOUT, err, TAG, "socket %d send timeout", sock);
+        if (elapsed >= emac->cmd_spin_us) {
+            vTaskDelay(1);
+        }
+    }
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+    w5500_batch_write(&batch, W5500_REG_SOCK_IR(sock), &ir, sizeof(ir));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write SOCK IR failed");
+    s->send_busy = false;
+    if (ir & W5500_SIR_TIMEOUT) {
+        if (s->config.type == ETH_W5500_SOCK_UDP) {
+            // ARP for the destination failed, only that datagram is lost
+            ESP_LOGW(TAG, "socket %d: destination unreachable, datagram dropped", sock);
+        } else {
+            // the W5500 closed the connection, a server goes back to listening
+            ESP_LOGW(TAG, "socket %d: TCP connection timed out", sock);
+            if (s->config.type == ETH_W5500_SOCK_TCP_SERVER) {
+                w5500_sock_setup(emac, sock);
+            }
+            ret = ESP_ERR_TIMEOUT;
+        }
+    }
+err:
+    return ret;
+}
+
+/* called from emac_w5500_task, the RX side of a socket is only touched here */
+static void w5500_sock_recv(emac_w5500_t *emac, int sock)
+{
+    emac_w5500_sock_t *s = &emac->socks[sock];
+    uint16_t remain = 0;
+    uint16_t offset = 0;
+    uint8_t header[8];
+    w5500_spi_batch_t batch;
+
+    while (w5500_get_rx_state(emac, sock, &remain, &offset) == ESP_OK && remain) {
+        uint32_t peer_ip = s->config.peer_ip;
+        uint16_t peer_port = s->config.peer_port;
+        uint16_t data_offset = offset;
+        uint16_t data_len = remain;
+        uint16_t consumed = remain;
+        if (s->config.type == ETH_W5500_SOCK_UDP) {
+            // every datagram is preceded by sender IP, sender port and data length
+            if (w5500_read_buffer(emac, sock, header, sizeof(header), offset) != ESP_OK) {
+                break;
+            }
+            memcpy(&peer_ip, header, 4);
+            peer_port = (header[4] << 8) | header[5];
+            data_len = (header[6] << 8) | header[7];
+            data_offset = offset + sizeof(header);
+            consumed = sizeof(header) + data_len;
+            if (consumed > remain) {
+                ESP_LOGE(TAG, "socket %d: invalid datagram length %" PRIu16 ", dropping %" PRIu16 " bytes", sock, data_len, remain);
+                data_len = 0;
+                consumed = remain;
+            }
+        }
+        uint16_t copy_len = data_len > W5500_OFFLOAD_RX_BUF_SIZE ? W5500_OFFLOAD_RX_BUF_SIZE : data_len;
+        if (s->config.type != ETH_W5500_SOCK_UDP) {
+            // a TCP stream is simply consumed in chunks of the receive buffer
+            consumed = copy_len;
+        }
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_RX);
+        if (copy_len) {
+            w5500_batch_read(&batch, W5500_MEM_SOCK_RX(sock, data_offset), emac->sock_rx_buf, W5500_RX_DMA_LEN(copy_len));
+        }
+        if (w5500_rx_release(emac, sock, &batch, offset + consumed) != ESP_OK) {
+            break;
+        }
+        if (copy_len && s->config.on_recv) {
+            s->config.on_recv(sock, emac->sock_rx_buf, copy_len, peer_ip, peer_port, s->config.arg);
+        }
+    }
+}
+
+/* called from emac_w5500_task for every offloaded socket flagged in SIR */
+static void w5500_sock_handle_irq(emac_w5500_t *emac, int sock)
+{
+    emac_w5500_sock_t *s = &emac->socks[sock];
+    uint8_t ir = 0;
+    w5500_spi_batch_t batch;
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_IRQ);
+    w5500_batch_read(&batch, W5500_REG_SOCK_IR(sock), &ir, sizeof(ir));
+    if (w5500_batch_submit(emac, &batch) != ESP_OK) {
+        return;
+    }
+    ir &= W5500_SIR_RECV | W5500_SIR_CON | W5500_SIR_DISCON;
+    if (!ir) {
+        return;
+    }
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_IRQ);
+    w5500_batch_write(&batch, W5500_REG_SOCK_IR(sock), &ir, sizeof(ir));
+    w5500_batch_submit(emac, &batch);
+    if (!s->open) {
+        return;
+    }
+    if (ir & W5500_SIR_CON) {
+        ESP_LOGD(TAG, "socket %d: connected", sock);
+    }
+    if (ir & W5500_SIR_RECV) {
+        w5500_sock_recv(emac, sock);
+    }
+    if (ir & W5500_SIR_DISCON) {
+        ESP_LOGD(TAG, "socket %d: disconnected", sock);
+        xSemaphoreTake(emac->sock_lock, portMAX_DELAY);
+        if (s->open && s->config.type == ETH_W5500_SOCK_TCP_SERVER) {
+            // close the old connection and wait for the next client
+            if (w5500_sock_command(emac, sock, W5500_SCR_CLOSE, ETH_W5500_SPI_PATH_CTRL) != ESP_OK || w5500_sock_setup(emac, sock) != ESP_OK) {
+                ESP_LOGE(TAG, "socket %d: failed to listen again", sock);
+            }
+        }
+        xSemaphoreGive(emac->sock_lock);
+    }
+}
+
+static esp_err_t w5500_set_ip_info(emac_w5500_t *emac, const eth_w5500_ip_info_t *info)
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t gar_subr[8];
+    w5500_spi_batch_t batch;
+    // GAR and SUBR are adjacent, addresses are stored in network byte order in both places
+    memcpy(gar_subr, &info->gw, 4);
+    memcpy(&gar_subr[4], &info->netmask, 4);
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_CTRL);
+    w5500_batch_write(&batch, W5500_REG_GAR, gar_subr, sizeof(gar_subr));
+    w5500_batch_write(&batch, W5500_REG_SIPR, &info->ip, sizeof(info->ip));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write IP configuration failed");
+err:
+    return ret;
+}
+
+static esp_err_t w5500_sock_open(emac_w5500_t *emac, const eth_w5500_sock_config_t *config, int *sock)
+{
+    esp_err_t ret = ESP_OK;
+    int i;
+    xSemaphoreTake(emac->sock_lock, portMAX_DELAY);
+    for (i = 1; i < ETH_W5500_SOCK_NUM && (emac->socks[i].open || !w5500_sock_usable(emac, i)); i++) {
+    }
+    ESP_GOTO_ON_FALSE(i < ETH_W5500_SOCK_NUM, ESP_ERR_NO_MEM, err, TAG, "no free offload socket");
+    emac->socks[i].config = *config;
+    ESP_GOTO_ON_ERROR(w5500_sock_setup(emac, i), err, TAG, "open socket %d failed", i);
+    uint8_t simr = emac->simr | (1 << i);
+    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SIMR, &simr, sizeof(simr)), err, TAG, "write SIMR failed");
+    emac->simr = simr;
+    emac->socks[i].open = true;
+    *sock = i;
+err:
+    xSemaphoreGive(emac->sock_lock);
+    return ret;
+}
+
+static esp_err_t w5500_sock_close(emac_w5500_t *emac, int sock)
+{
+    esp_err_t ret = ESP_OK;
+    xSemaphoreTake(emac->sock_lock, portMAX_DELAY);
+    ESP_GOTO_ON_FALSE(w5500_sock_usable(emac, sock) && emac->socks[sock].open, ESP_ERR_INVALID_ARG, err, TAG,
+                      "socket %d is not open", sock);
+    ret = w5500_sock_shutdown(emac, sock);
+err:
+    xSemaphoreGive(emac->sock_lock);
+    return ret;
+}
+
+static esp_err_t w5500_sock_sendto(emac_w5500_t *emac, int sock, const void *data, uint32_t len, uint32_t peer_ip, uint16_t peer_port)
 {
     esp_err_t ret = ESP_OK;
+    emac_w5500_sock_t *s = NULL;
+    uint16_t free0, free1 = 0;
+    uint16_t offset = 0;
+    uint8_t status = 0;
+    w5500_spi_batch_t batch;
+
+    xSemaphoreTake(emac->sock_lock, portMAX_DELAY);
+    ESP_GOTO_ON_FALSE(w5500_sock_usable(emac, sock) && emac->socks[sock].open, ESP_ERR_INVALID_ARG, err, TAG,
+                      "socket %d is not open", sock);
+    s = &emac->socks[sock];
+    ESP_GOTO_ON_FALSE(len <= emac->sock_buf.tx_size_kb[sock] * 1024, ESP_ERR_INVALID_ARG, err, TAG,
+                      "send length %" PRIu32 " exceeds the socket buffer", len);
+    // only one SEND may be in flight, the previous one is normally long done by the time the next data comes
+    if (s->send_busy) {
+        ESP_GOTO_ON_ERROR(w5500_sock_wait_sent(emac, sock), err, TAG, "previous send failed");
+    }
+    do {
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+        w5500_batch_read(&batch, W5500_REG_SOCK_TX_FSR(sock), &free0, sizeof(free0));
+        w5500_batch_read(&batch, W5500_REG_SOCK_TX_FSR(sock), &free1, sizeof(free1));
+        w5500_batch_read(&batch, W5500_REG_SOCK_TX_WR(sock), &offset, sizeof(offset));
+        w5500_batch_read(&batch, W5500_REG_SOCK_SR(sock), &status, sizeof(status));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read TX FSR failed");
+    } while (free0 != free1);
+    ESP_GOTO_ON_FALSE(s->config.type == ETH_W5500_SOCK_UDP || status == W5500_SSR_ESTABLISHED || status == W5500_SSR_CLOSE_WAIT,
+                      ESP_ERR_INVALID_STATE, err, TAG, "socket %d not connected (SR 0x%02" PRIx8 ")", sock, status);
+    ESP_GOTO_ON_FALSE(len <= __builtin_bswap16(free0), ESP_ERR_NO_MEM, err, TAG, "socket %d TX buffer full", sock);
+    offset = __builtin_bswap16(offset);
+
+    // destination (UDP), data, TX_WR and SEND go out in one batch
+    uint8_t peer[6];
+    uint16_t wr = __builtin_bswap16((uint16_t)(offset + len));
+    uint8_t command = W5500_SCR_SEND;
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+    if (s->config.type == ETH_W5500_SOCK_UDP) {
+        memcpy(peer, &peer_ip, 4);
+        peer[4] = peer_port >> 8;
+        peer[5] = peer_port & 0xFF;
+        w5500_batch_write(&batch, W5500_REG_SOCK_DIPR(sock), peer, sizeof(peer));
+    }
+    w5500_batch_write(&batch, W5500_MEM_SOCK_TX(sock, offset), data, len);
+    w5500_batch_write(&batch, W5500_REG_SOCK_TX_WR(sock), &wr, sizeof(wr));
+    w5500_batch_write(&batch, W5500_REG_SOCK_CR(sock), &command, sizeof(command));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write socket %d data failed", sock);
+    ESP_GOTO_ON_ERROR(w5500_wait_command(emac, sock, ETH_W5500_SPI_PATH_TX, 100), err, TAG, "issue SEND command failed");
+    s->send_busy = true;
+err:
+    xSemaphoreGive(emac->sock_lock);
+    return ret;
+}
+
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+/* arguments of a socket call handed over to the driver task, which also takes sock_lock */
+typedef struct {
+    const eth_w5500_sock_config_t *config;
+    int sock;
+    int *sock_out;
+    const void *data;
+    uint32_t len;
+    uint32_t peer_ip;
+    uint16_t peer_port;
+} w5500_owner_sock_args_t;
+
+static esp_err_t w5500_owner_sock_open(emac_w5500_t *emac, void *arg)
+{
+    w5500_owner_sock_args_t *args = (w5500_owner_sock_args_t *)arg;
+    return w5500_sock_open(emac, args->config, args->sock_out);
+}
+
+static esp_err_t w5500_owner_sock_close(emac_w5500_t *emac, void *arg)
+{
+    w5500_owner_sock_args_t *args = (w5500_owner_sock_args_t *)arg;
+    return w5500_sock_close(emac, args->sock);
+}
+
+static esp_err_t w5500_owner_sock_sendto(emac_w5500_t *emac, void *arg)
+{
+    w5500_owner_sock_args_t *args = (w5500_owner_sock_args_t *)arg;
+    return w5500_sock_sendto(emac, args->sock, args->data, args->len, args->peer_ip, args->peer_port);
+}
+#endif
+
+esp_err_t esp_eth_mac_w5500_sock_open(esp_eth_mac_t *mac, const eth_w5500_sock_config_t *config, int *sock)
+{
+    ESP_RETURN_ON_FALSE(mac && config && sock, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    w5500_owner_sock_args_t args = {
+        .config = config,
+        .sock_out = sock,
+    };
+    return w5500_owner_call(emac, w5500_owner_sock_open, &args);
+#else
+    return w5500_sock_open(emac, config, sock);
+#endif
+}
+
+esp_err_t esp_eth_mac_w5500_sock_close(esp_eth_mac_t *mac, int sock)
+{
+    ESP_RETURN_ON_FALSE(mac, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    w5500_owner_sock_args_t args = {
+        .sock = sock,
+    };
+    return w5500_owner_call(emac, w5500_owner_sock_close, &args);
+#else
+    return w5500_sock_close(emac, sock);
+#endif
+}
+
+esp_err_t esp_eth_mac_w5500_sock_sendto(esp_eth_mac_t *mac, int sock, const void *data, uint32_t len, uint32_t peer_ip, uint16_t peer_port)
+{
+    ESP_RETURN_ON_FALSE(mac && data && len, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
     emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    w5500_owner_sock_args_t args = {
+        .sock = sock,
+        .data = data,
+        .len = len,
+        .peer_ip = peer_ip,
+        .peer_port = peer_port,
+    };
+    return w5500_owner_call(emac, w5500_owner_sock_sendto, &args);
+#else
+    return w5500_sock_sendto(emac, sock, data, len, peer_ip, peer_port);
+#endif
+}
+#else
+esp_err_t esp_eth_mac_w5500_sock_open(esp_eth_mac_t *mac, const eth_w5500_sock_config_t *config, int *sock)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_eth_mac_w5500_sock_close(esp_eth_mac_t *mac, int sock)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_eth_mac_w5500_sock_sendto(esp_eth_mac_t *mac, int sock, const void *data, uint32_t len, uint32_t peer_ip, uint16_t peer_port)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+#endif // CONFIG_ETH_W5500_OFFLOAD
+
+static esp_err_t w5500_start(emac_w5500_t *emac)
+{
+    esp_err_t ret = ESP_OK;
     uint8_t reg_value = 0;
     /* open SOCK0 */
     ESP_GOTO_ON_ERROR(w5500_send_command(emac, W5500_SCR_OPEN, 100), err, TAG, "issue OPEN command failed");
+    /* TX write pointer is only read once here, the TX ring tracks it locally from now on */
+    ESP_GOTO_ON_ERROR(w5500_tx_ring_reset(emac), err, TAG, "TX ring reset failed");
     /* enable interrupt for SOCK0 */
-    reg_value = W5500_SIMR_SOCK0;
+    emac->simr = W5500_SIMR_SOCK0;
+    reg_value = emac->simr;
     ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SIMR, &reg_value, sizeof(reg_value)), err, TAG, "write SIMR failed");
 
 err:
     return ret;
 }
 
-static esp_err_t emac_w5500_stop(esp_eth_mac_t *mac)
+static esp_err_t w5500_stop(emac_w5500_t *emac)
 {
     esp_err_t ret = ESP_OK;
-    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
     uint8_t reg_value = 0;
     /* disable interrupt */
     ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SIMR, &reg_value, sizeof(reg_value)), err, TAG, "write SIMR failed");
     /* close SOCK0 */
     ESP_GOTO_ON_ERROR(w5500_send_command(emac, W5500_SCR_CLOSE, 100), err, TAG, "issue CLOSE command failed");
+    /* frames still queued are dropped together with the socket */
+    xSemaphoreTake(emac->tx_lock, portMAX_DELAY);
+    emac->tx_ring.count = 0;
+    emac->tx_ring.busy = false;
+    xSemaphoreGive(emac->tx_lock);
+#if CONFIG_ETH_W5500_OFFLOAD
+    w5500_sock_close_all(emac);
+#endif
 
 err:
     return ret;
 }
 
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+static esp_err_t w5500_owner_start(emac_w5500_t *emac, void *arg)
+{
+    return w5500_start(emac);
+}
+
+static esp_err_t w5500_owner_stop(emac_w5500_t *emac, void *arg)
+{
+    return w5500_stop(emac);
+}
+#endif
+
+/* with a single SPI owner, start and stop run in the driver task as a whole, they take locks the driver task takes too */
+static esp_err_t emac_w5500_start(esp_eth_mac_t *mac)
+{
+    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    return w5500_owner_call(emac, w5500_owner_start, NULL);
+#else
+    return w5500_start(emac);
+#endif
+}
+
+static esp_err_t emac_w5500_stop(esp_eth_mac_t *mac)
+{
+    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    return w5500_owner_call(emac, w5500_owner_stop, NULL);
+#else
+    return w5500_stop(emac);
+#endif
+}
+
+// MACs with a mediator, for the PHY driver to find its MAC through the mediator they share
+static emac_w5500_t *s_link_macs;
+static portMUX_TYPE s_link_macs_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// under s_link_macs_lock
+static emac_w5500_t *w5500_link_find(esp_eth_mediator_t *eth)
+{
+    emac_w5500_t *emac = s_link_macs;
+    while (emac && emac->eth != eth) {
+        emac = emac->link_next;
+    }
+    return emac;
+}
+
+static void w5500_link_unregister(emac_w5500_t *emac)
+{
+    portENTER_CRITICAL(&s_link_macs_lock);
+    emac_w5500_t **link = &s_link_macs;
+    while (*link && *link != emac) {
+        link = &(*link)->link_next;
+    }
+    if (*link) {
+        *link = emac->link_next;
+    }
+    portEXIT_CRITICAL(&s_link_macs_lock);
+}
+
+esp_err_t w5500_link_take_over(esp_eth_mediator_t *eth, eth_link_t *link)
+{
+    esp_err_t ret = ESP_ERR_NOT_SUPPORTED;
+    portENTER_CRITICAL(&s_link_macs_lock);
+    emac_w5500_t *emac = w5500_link_find(eth);
+    // only in interrupt mode, in poll mode the task sleeps when idle
+    if (emac && w5500_link_watched(emac)) {
+        emac->link_push = true;
+        *link = emac->link_reported;
+        ret = ESP_OK;
+    }
+    portEXIT_CRITICAL(&s_link_macs_lock);
+    return ret;
+}
+
+void w5500_link_hand_back(esp_eth_mediator_t *eth)
+{
+    portENTER_CRITICAL(&s_link_macs_lock);
+    emac_w5500_t *emac = w5500_link_find(eth);
+    if (emac) {
+        // the core checks no link any more and nothing is to be reported
+        emac->link_push = false;
+    }
+    portEXIT_CRITICAL(&s_link_macs_lock);
+}
+
 static esp_err_t emac_w5500_set_mediator(esp_eth_mac_t *mac, esp_eth_mediator_t *eth)
 {
     esp_err_t ret = ESP_OK;
     ESP_GOTO_ON_FALSE(eth, ESP_ERR_INVALID_ARG, err, TAG, "can't set mac's mediator to null");
     emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+    w5500_link_unregister(emac);
     emac->eth = eth;
+    portENTER_CRITICAL(&s_link_macs_lock);
+    emac->link_next = s_link_macs;
+    s_link_macs = emac;
+    portEXIT_CRITICAL(&s_link_macs_lock);
     return ESP_OK;
 err:
     return ret;
@@ -401,6 +1412,8 @@ static esp_err_t emac_w5500_write_phy_reg(esp_eth_mac_t *mac, uint32_t phy_addr,
     // The only PHY register is PHYCFGR
     ESP_GOTO_ON_FALSE(phy_reg == W5500_REG_PHYCFGR, ESP_FAIL, err, TAG, "wrong PHY register");
     ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_PHYCFGR, &reg_value, sizeof(uint8_t)), err, TAG, "write PHY register failed");
+    // mode and reset bits changed, refresh the cache reads are served from
+    w5500_link_check(emac);
 
 err:
     return ret;
@@ -414,7 +1427,13 @@ static esp_err_t emac_w5500_read_phy_reg(esp_eth_mac_t *mac, uint32_t phy_addr,
     // PHY register and MAC registers are mixed together in W5500
     // The only PHY register is PHYCFGR
     ESP_GOTO_ON_FALSE(phy_reg == W5500_REG_PHYCFGR, ESP_FAIL, err, TAG, "wrong PHY register");
+    if (w5500_link_watched(emac)) {
+        // kept recent by the driver task and refreshed on every PHY register write, no SPI access needed
+        *(uint8_t *)reg_value = emac->phycfg;
+        return ESP_OK;
+    }
     ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_PHYCFGR, reg_value, sizeof(uint8_t)), err, TAG, "read PHY register failed");
+    w5500_link_update(emac, (uint8_t)*reg_value);
 
 err:
     return ret;
@@ -501,6 +1520,18 @@ static esp_err_t emac_w5500_set_link(esp_eth_mac_t *mac, eth_link_t link)
 {
     esp_err_t ret = ESP_OK;
     emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+    // time from the driver task seeing the change to the core being told, pushed by the driver task itself when it
+    // watches the link, otherwise at the core's next PHY poll
+    emac->link_reported = link;
+    if (emac->link_changed_us) {
+        uint32_t latency = esp_timer_get_time() - emac->link_changed_us;
+        emac->link_changed_us = 0;
+        emac->link_stats.last_latency_us = latency;
+        if (latency > emac->link_stats.max_latency_us) {
+            emac->link_stats.max_latency_us = latency;
+        }
+        ESP_LOGI(TAG, "link %s, reported %" PRIu32 " us after detection", link == ETH_LINK_UP ? "up" : "down", latency);
+    }
     switch (link) {
     case ETH_LINK_UP:
         ESP_LOGD(TAG, "link is up");
@@ -610,39 +1641,178 @@ static esp_err_t emac_w5500_set_peer_pause_ability(esp_eth_mac_t *mac, uint32_t
     return ESP_ERR_NOT_SUPPORTED;
 }
 
-static inline bool is_w5500_sane_for_rxtx(emac_w5500_t *emac)
+static inline bool w5500_tx_ring_has_room(emac_w5500_tx_ring_t *ring, uint32_t length)
+{
+    return ring->count < W5500_TX_RING_LEN && (uint16_t)(ring->wr - ring->rd) + length <= ring->mem_size;
+}
+
+/* must be called with tx_lock held, TX_WR and SEND are appended to the accesses already in the batch */
+static esp_err_t w5500_tx_ring_kick(emac_w5500_t *emac, w5500_spi_batch_t *batch)
 {
-    uint8_t phycfg;
-    /* phy is ok for rx and tx operations if bits RST and LNK are set (no link down, no reset) */
-    if (w5500_read(emac, W5500_REG_PHYCFGR, &phycfg, 1) == ESP_OK && (phycfg & 0x8001)) {
-        return true;
+    esp_err_t ret = ESP_OK;
+    emac_w5500_tx_ring_t *ring = &emac->tx_ring;
+    // TX_WR is moved to the end of the head frame only, so a SEND never covers more than one frame
+    uint16_t offset = __builtin_bswap16(ring->end[ring->head]);
+    uint8_t command = W5500_SCR_SEND;
+    w5500_batch_write(batch, W5500_REG_SOCK_TX_WR(0), &offset, sizeof(offset));
+    w5500_batch_write(batch, W5500_REG_SOCK_CR(0), &command, sizeof(command));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, batch), err, TAG, "write TX WR failed");
+    ESP_GOTO_ON_ERROR(w5500_wait_command(emac, 0, ETH_W5500_SPI_PATH_TX, 100), err, TAG, "issue SEND command failed");
+    ring->busy = true;
+err:
+    return ret;
+}
+
+/* must be called with tx_lock held, retires the frame ended by SEND_OK or TIMEOUT and starts sending the next one */
+static void w5500_tx_ring_retire(emac_w5500_t *emac)
+{
+    emac_w5500_tx_ring_t *ring = &emac->tx_ring;
+    w5500_spi_batch_t batch;
+    if (ring->busy) {
+        ring->busy = false;
+        ring->rd = ring->end[ring->head];
+        ring->head = (ring->head + 1) % W5500_TX_RING_LEN;
+        ring->count--;
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+        if (ring->count && w5500_tx_ring_kick(emac, &batch) != ESP_OK) {
+            ESP_LOGE(TAG, "dropping %" PRIu8 " queued frame(s)", ring->count);
+            ring->count = 0;
+            ring->rd = ring->wr;
+        }
     }
-    return false;
 }
 
-static esp_err_t emac_w5500_transmit(esp_eth_mac_t *mac, uint8_t *buf, uint32_t length)
+/* called from emac_w5500_task when SEND_OK or TIMEOUT is signalled, a TIMEOUT frame never made it onto the wire */
+static void w5500_tx_ring_complete(emac_w5500_t *emac, bool timeout)
+{
+    xSemaphoreTake(emac->tx_lock, portMAX_DELAY);
+    if (timeout) {
+        emac->frame_stats.tx_errors++;
+    }
+    w5500_tx_ring_retire(emac);
+    /* wake up a sender waiting in emac_w5500_transmit() for room in the ring */
+    if (emac->tx_wait_hdl) {
+        xTaskNotifyGive(emac->tx_wait_hdl);
+    }
+    xSemaphoreGive(emac->tx_lock);
+}
+
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+/* must be called with tx_lock held, waits in emac_w5500_task for SEND_OK of the frame in flight */
+static esp_err_t w5500_tx_ring_poll_sent(emac_w5500_t *emac, TickType_t timeout)
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t status = 0;
+    TickType_t start_tick = xTaskGetTickCount();
+    int64_t start = esp_timer_get_time();
+    w5500_spi_batch_t batch;
+    while (1) {
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+        w5500_batch_read(&batch, W5500_REG_SOCK_IR(0), &status, sizeof(status));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read SOCK0 IR failed");
+        if (status & (W5500_SIR_SEND | W5500_SIR_TIMEOUT)) {
+            break;
+        }
+        ESP_GOTO_ON_FALSE(xTaskGetTickCount() - start_tick < timeout, ESP_ERR_TIMEOUT, err, TAG, "SEND_OK timeout");
+        if (esp_timer_get_time() - start >= emac->cmd_spin_us) {
+            vTaskDelay(1);
+        }
+    }
+    // only SEND_OK and TIMEOUT are cleared, a pending RECV is left for the interrupt handling
+    status &= W5500_SIR_SEND | W5500_SIR_TIMEOUT;
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+    w5500_batch_write(&batch, W5500_REG_SOCK_IR(0), &status, sizeof(status));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write SOCK0 IR failed");
+    if (status & W5500_SIR_TIMEOUT) {
+        emac->frame_stats.tx_errors++;
+    }
+    w5500_tx_ring_retire(emac);
+err:
+    return ret;
+}
+#endif
+
+static esp_err_t emac_w5500_transmit_queued(emac_w5500_t *emac, uint8_t *buf, uint32_t length)
+{
+    esp_err_t ret = ESP_OK;
+    emac_w5500_tx_ring_t *ring = &emac->tx_ring;
+    TickType_t timeout = pdMS_TO_TICKS(emac->tx_tmo / 1000) + W5500_TX_DONE_MIN_TICKS;
+    w5500_spi_batch_t batch;
+
+    xSemaphoreTake(emac->tx_lock, portMAX_DELAY);
+    while (!w5500_tx_ring_has_room(ring, length)) {
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+        // running in the driver task, which is the one retiring frames, so SEND_OK has to be polled right here
+        ESP_GOTO_ON_ERROR(w5500_tx_ring_poll_sent(emac, timeout), err, TAG,
+                          "TX ring full (%" PRIu8 " frames queued)", ring->count);
+#else
+        // the waiter is registered under the lock, so a SEND_OK arriving in between can't be missed
+        emac->tx_wait_hdl = xTaskGetCurrentTaskHandle();
+        xSemaphoreGive(emac->tx_lock);
+        uint32_t notified = ulTaskNotifyTake(pdTRUE, timeout);
+        xSemaphoreTake(emac->tx_lock, portMAX_DELAY);
+        emac->tx_wait_hdl = NULL;
+        ESP_GOTO_ON_FALSE(notified || w5500_tx_ring_has_room(ring, length), ESP_ERR_NO_MEM, err, TAG,
+                          "TX ring full (%" PRIu8 " frames queued)", ring->count);
+#endif
+    }
+    // copy data to tx memory, the chip may still be sending the previous frame meanwhile
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+    w5500_batch_write(&batch, W5500_MEM_SOCK_TX(0, ring->wr), buf, length);
+    ring->wr += length;
+    ring->end[(ring->head + ring->count) % W5500_TX_RING_LEN] = ring->wr;
+    ring->count++;
+    if (!ring->busy) {
+        // nothing in flight, frame data, TX_WR and SEND go out as one batch
+        ret = w5500_tx_ring_kick(emac, &batch);
+    } else if ((ret = w5500_batch_submit(emac, &batch)) != ESP_OK) {
+        ESP_LOGE(TAG, "write frame failed");
+    }
+    if (ret != ESP_OK) {
+        // forget the frame, the chip has not been told about it
+        ring->count--;
+        ring->wr -= length;
+    }
+err:
+    xSemaphoreGive(emac->tx_lock);
+    return ret;
+}
+
+static esp_err_t w5500_transmit(emac_w5500_t *emac, uint8_t *buf, uint32_t length)
 {
     esp_err_t ret = ESP_OK;
-    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
     uint16_t offset = 0;
 
     ESP_GOTO_ON_FALSE(length <= ETH_MAX_PACKET_SIZE, ESP_ERR_INVALID_ARG, err,
                       TAG, "frame size is too big (actual %" PRIu32 ", maximum %u)", length, ETH_MAX_PACKET_SIZE);
+    if (emac->int_gpio_num >= 0) {
+        // SEND_OK is handled by emac_w5500_task off the INT line, so frames can be queued without waiting
+        return emac_w5500_transmit_queued(emac, buf, length);
+    }
     // check if there're free memory to store this packet
-    uint16_t free_size = 0;
-    ESP_GOTO_ON_ERROR(w5500_get_tx_free_size(emac, &free_size), err, TAG, "get free size failed");
+    uint16_t free0, free1 = 0;
+    w5500_spi_batch_t batch;
+    // read TX_FSR register more than once, until we get the same value, the write pointer is fetched in the same batch
+    // this is a trick because we might be interrupted between reading the high/low part of the TX_FSR register (16 bits in length)
+    do {
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+        w5500_batch_read(&batch, W5500_REG_SOCK_TX_FSR(0), &free0, sizeof(free0));
+        w5500_batch_read(&batch, W5500_REG_SOCK_TX_FSR(0), &free1, sizeof(free1));
+        w5500_batch_read(&batch, W5500_REG_SOCK_TX_WR(0), &offset, sizeof(offset));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read TX FSR failed");
+    } while (free0 != free1);
+    uint16_t free_size = __builtin_bswap16(free0);
     ESP_GOTO_ON_FALSE(length <= free_size, ESP_ERR_NO_MEM, err, TAG, "free size (%" PRIu16 ") < send length (%" PRIu32 ")", free_size, length);
-    // get current write pointer
-    ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_TX_WR(0), &offset, sizeof(offset)), err, TAG, "read TX WR failed");
-    offset = __builtin_bswap16(offset);
-    // copy data to tx memory
-    ESP_GOTO_ON_ERROR(w5500_write_buffer(emac, buf, length, offset), err, TAG, "write frame failed");
-    // update write pointer
-    offset += length;
     offset = __builtin_bswap16(offset);
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_TX_WR(0), &offset, sizeof(offset)), err, TAG, "write TX WR failed");
-    // issue SEND command
-    ESP_GOTO_ON_ERROR(w5500_send_command(emac, W5500_SCR_SEND, 100), err, TAG, "issue SEND command failed");
+    // copy data to tx memory, update write pointer and issue SEND command in one batch
+    uint16_t wr = __builtin_bswap16((uint16_t)(offset + length));
+    uint8_t command = W5500_SCR_SEND;
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+    w5500_batch_write(&batch, W5500_MEM_SOCK_TX(0, offset), buf, length);
+    w5500_batch_write(&batch, W5500_REG_SOCK_TX_WR(0), &wr, sizeof(wr));
+    w5500_batch_write(&batch, W5500_REG_SOCK_CR(0), &command, sizeof(command));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write frame failed");
+    ESP_GOTO_ON_ERROR(w5500_wait_command(emac, 0, ETH_W5500_SPI_PATH_TX, 100), err, TAG, "issue SEND command failed");
 
     // pooling the TX done event
     uint8_t status = 0;
@@ -650,19 +1820,70 @@ static esp_err_t emac_w5500_transmit(esp_eth_mac_t *mac, uint8_t *buf, uint32_t
     uint64_t now = 0;
     do {
         now = esp_timer_get_time();
-        if (!is_w5500_sane_for_rxtx(emac) || (now - start) > emac->tx_tmo) {
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+        w5500_batch_read(&batch, W5500_REG_SOCK_IR(0), &status, sizeof(status));
+        ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "read SOCK0 IR failed");
+        /* give up on link down, the link state is kept up to date by the driver task, so no PHYCFGR read here */
+        if (!(emac->phycfg & W5500_PHYCFGR_LNK) || (now - start) > emac->tx_tmo) {
             return ESP_FAIL;
         }
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_IR(0), &status, sizeof(status)), err, TAG, "read SOCK0 IR failed");
     } while (!(status & W5500_SIR_SEND));
     // clear the event bit
     status  = W5500_SIR_SEND;
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_IR(0), &status, sizeof(status)), err, TAG, "write SOCK0 IR failed");
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_TX);
+    w5500_batch_write(&batch, W5500_REG_SOCK_IR(0), &status, sizeof(status));
+    ESP_GOTO_ON_ERROR(w5500_batch_submit(emac, &batch), err, TAG, "write SOCK0 IR failed");
 
 err:
     return ret;
 }
 
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+typedef struct {
+    uint8_t *buf;
+    uint32_t length;
+} w5500_owner_tx_args_t;
+
+static esp_err_t w5500_owner_transmit(emac_w5500_t *emac, void *arg)
+{
+    w5500_owner_tx_args_t *args = (w5500_owner_tx_args_t *)arg;
+    return w5500_transmit(emac, args->buf, args->length);
+}
+#endif
+
+static esp_err_t emac_w5500_transmit(esp_eth_mac_t *mac, uint8_t *buf, uint32_t length)
+{
+    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    // the whole frame is handed over, so the driver task does all of its accesses in one go
+    w5500_owner_tx_args_t args = {
+        .buf = buf,
+        .length = length,
+    };
+    esp_err_t ret = w5500_owner_call(emac, w5500_owner_transmit, &args);
+#else
+    esp_err_t ret = w5500_transmit(emac, buf, length);
+#endif
+    // statistics only, an occasional lost update between two transmitting tasks is acceptable
+    if (ret == ESP_OK) {
+        emac->frame_stats.tx_frames++;
+        emac->frame_stats.tx_bytes += length;
+    } else {
+        emac->frame_stats.tx_errors++;
+    }
+    return ret;
+}
+
+static uint8_t *w5500_alloc_rx_frame(emac_w5500_t *emac, uint32_t len)
+{
+#if CONFIG_ETH_W5500_RX_POOL
+    return w5500_rx_pool_alloc(emac->rx_pool, W5500_RX_DMA_LEN(len));
+#else
+    return heap_caps_malloc(W5500_RX_DMA_LEN(len), MALLOC_CAP_DMA);
+#endif
+}
+
+#if !CONFIG_ETH_W5500_RX_BATCH
 static esp_err_t emac_w5500_alloc_recv_buf(emac_w5500_t *emac, uint8_t **buf, uint32_t *length)
 {
     esp_err_t ret = ESP_OK;
@@ -672,19 +1893,18 @@ static esp_err_t emac_w5500_alloc_recv_buf(emac_w5500_t *emac, uint8_t **buf, ui
     uint16_t remain_bytes = 0;
     *buf = NULL;
 
-    w5500_get_rx_received_size(emac, &remain_bytes);
+    // get received size and current read pointer
+    ESP_GOTO_ON_ERROR(w5500_get_rx_state(emac, 0, &remain_bytes, &offset), err, TAG, "get RX state failed");
     if (remain_bytes) {
-        // get current read pointer
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_RX_RD(0), &offset, sizeof(offset)), err, TAG, "read RX RD failed");
-        offset = __builtin_bswap16(offset);
         // read head
-        ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, &rx_len, sizeof(rx_len), offset), err, TAG, "read frame header failed");
+        ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, 0, &rx_len, sizeof(rx_len), offset), err, TAG, "read frame header failed");
         rx_len = __builtin_bswap16(rx_len) - 2; // data size includes 2 bytes of header
         // frames larger than expected will be truncated
         copy_len = rx_len > *length ? *length : rx_len;
         // runt frames are not forwarded by W5500 (tested on target), but check the length anyway since it could be corrupted at SPI bus
         ESP_GOTO_ON_FALSE(copy_len >= ETH_MIN_PACKET_SIZE - ETH_CRC_LEN, ESP_ERR_INVALID_SIZE, err, TAG, "invalid frame length %" PRIu32, copy_len);
-        *buf = malloc(copy_len);
+        // DMA capable and padded to whole words, so the payload can be read into it without a bounce buffer
+        *buf = w5500_alloc_rx_frame(emac, copy_len);
         if (*buf != NULL) {
             emac_w5500_auto_buf_info_t *buff_info = (emac_w5500_auto_buf_info_t *)*buf;
             buff_info->offset = offset;
@@ -700,6 +1920,7 @@ err:
     *length = rx_len;
     return ret;
 }
+#endif // !CONFIG_ETH_W5500_RX_BATCH
 
 static esp_err_t emac_w5500_receive(esp_eth_mac_t *mac, uint8_t *buf, uint32_t *length)
 {
@@ -708,20 +1929,21 @@ static esp_err_t emac_w5500_receive(esp_eth_mac_t *mac, uint8_t *buf, uint32_t *
     uint16_t offset = 0;
     uint16_t rx_len = 0;
     uint16_t copy_len = 0;
+    uint16_t read_len = 0;
     uint16_t remain_bytes = 0;
+    w5500_spi_batch_t batch;
     emac->packets_remain = false;
 
     if (*length != W5500_ETH_MAC_RX_BUF_SIZE_AUTO) {
-        w5500_get_rx_received_size(emac, &remain_bytes);
+        // get received size and current read pointer
+        ESP_GOTO_ON_ERROR(w5500_get_rx_state(emac, 0, &remain_bytes, &offset), err, TAG, "get RX state failed");
         if (remain_bytes) {
-            // get current read pointer
-            ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_RX_RD(0), &offset, sizeof(offset)), err, TAG, "read RX RD failed");
-            offset = __builtin_bswap16(offset);
             // read head first
-            ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, &rx_len, sizeof(rx_len), offset), err, TAG, "read frame header failed");
+            ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, 0, &rx_len, sizeof(rx_len), offset), err, TAG, "read frame header failed");
             rx_len = __builtin_bswap16(rx_len) - 2; // data size includes 2 bytes of header
             // frames larger than expected will be truncated
             copy_len = rx_len > *length ? *length : rx_len;
+            read_len = copy_len;
         } else {
             // silently return when no frame is waiting
             goto err;
@@ -732,18 +1954,15 @@ static esp_err_t emac_w5500_receive(esp_eth_mac_t *mac, uint8_t *buf, uint32_t *
         copy_len = buff_info->copy_len;
         rx_len = buff_info->rx_len;
         remain_bytes = buff_info->remain;
+        // the buffer was allocated padded, reading a few bytes past the frame keeps the SPI driver from bouncing it
+        read_len = W5500_RX_DMA_LEN(copy_len);
     }
     // 2 bytes of header
     offset += 2;
-    // read the payload
-    ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, emac->rx_buffer, copy_len, offset), err, TAG, "read payload failed, len=%" PRIu16 ", offset=%" PRIu16, rx_len, offset);
-    memcpy(buf, emac->rx_buffer, copy_len);
-    offset += rx_len;
-    // update read pointer
-    offset = __builtin_bswap16(offset);
-    ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_RX_RD(0), &offset, sizeof(offset)), err, TAG, "write RX RD failed");
-    /* issue RECV command */
-    ESP_GOTO_ON_ERROR(w5500_send_command(emac, W5500_SCR_RECV, 100), err, TAG, "issue RECV command failed");
+    // read the payload straight into the buffer handed to the stack, update read pointer and issue RECV in the same batch
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_RX);
+    w5500_batch_read(&batch, W5500_MEM_SOCK_RX(0, offset), buf, read_len);
+    ESP_GOTO_ON_ERROR(w5500_rx_release(emac, 0, &batch, offset + rx_len), err, TAG, "read payload failed, len=%" PRIu16 ", offset=%" PRIu16, rx_len, offset);
     // check if there're more data need to process
     remain_bytes -= rx_len + 2;
     emac->packets_remain = remain_bytes > 0;
@@ -755,28 +1974,97 @@ err:
     return ret;
 }
 
+#if CONFIG_ETH_W5500_RX_BATCH
+/**
+ * @brief Drain the pending RX region in one SPI burst
+ *
+ * RX_RSR and RX_RD are read once, as much of the pending data as fits the batch buffer is read in a single
+ * transaction (the W5500 wraps the address within the socket buffer by itself), the frames are split in RAM and
+ * RX_RD is advanced with a single RECV command for the whole batch.
+ */
+static esp_err_t emac_w5500_receive_batch(emac_w5500_t *emac)
+{
+    esp_err_t ret = ESP_OK;
+    uint16_t offset = 0;
+    uint16_t remain_bytes = 0;
+    uint32_t batch_len = 0;
+    uint32_t pos = 0;
+    w5500_spi_batch_t batch;
+    emac->packets_remain = false;
+
+    ESP_GOTO_ON_ERROR(w5500_get_rx_state(emac, 0, &remain_bytes, &offset), err, TAG, "get RX state failed");
+    if (!remain_bytes) {
+        goto err;
+    }
+    batch_len = remain_bytes > CONFIG_ETH_W5500_RX_BATCH_BUF_SIZE ? CONFIG_ETH_W5500_RX_BATCH_BUF_SIZE : remain_bytes;
+    ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, 0, emac->rx_batch_buf, W5500_RX_DMA_LEN(batch_len), offset), err, TAG,
+                      "read RX batch failed, len=%" PRIu32 ", offset=%" PRIu16, batch_len, offset);
+
+    while (pos + 2 <= batch_len) {
+        // frame length is big endian and includes the 2 bytes of header
+        uint32_t rx_len = (emac->rx_batch_buf[pos] << 8) | emac->rx_batch_buf[pos + 1];
+        if (rx_len < 2 + ETH_MIN_PACKET_SIZE - ETH_CRC_LEN || rx_len > 2 + ETH_MAX_PACKET_SIZE) {
+            // the framing can't be trusted any more, skip everything received so far
+            ESP_LOGE(TAG, "invalid frame length %" PRIu32 " in RX batch, dropping %" PRIu16 " bytes", rx_len, remain_bytes);
+            emac->frame_stats.rx_dropped++;
+            pos = remain_bytes;
+            break;
+        }
+        if (pos + rx_len > batch_len) {
+            // frame continues past the batch buffer, it is picked up by the next batch
+            break;
+        }
+        uint32_t copy_len = rx_len - 2;
+        uint8_t *buffer = w5500_alloc_rx_frame(emac, copy_len);
+        if (buffer) {
+            memcpy(buffer, &emac->rx_batch_buf[pos + 2], copy_len);
+            ESP_LOGD(TAG, "receive len=%" PRIu32, copy_len);
+            emac->frame_stats.rx_frames++;
+            emac->frame_stats.rx_bytes += copy_len;
+            /* pass the buffer to stack (e.g. TCP/IP layer) */
+            emac->eth->stack_input(emac->eth, buffer, copy_len);
+        } else {
+            ESP_LOGD(TAG, "no mem for receive buffer");
+            emac->frame_stats.rx_dropped++;
+        }
+        pos += rx_len;
+    }
+
+    // update read pointer and release the whole batch at once
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_RX);
+    ESP_GOTO_ON_ERROR(w5500_rx_release(emac, 0, &batch, offset + pos), err, TAG, "release RX batch failed");
+    emac->packets_remain = remain_bytes > pos;
+err:
+    return ret;
+}
+#endif // CONFIG_ETH_W5500_RX_BATCH
+
+void esp_eth_mac_w5500_free_rx_buf(void *h, void *buffer)
+{
+    if (!w5500_rx_pool_free(buffer)) {
+        free(buffer);
+    }
+}
+
+#if !CONFIG_ETH_W5500_RX_BATCH
 static esp_err_t emac_w5500_flush_recv_frame(emac_w5500_t *emac)
 {
     esp_err_t ret = ESP_OK;
     uint16_t offset = 0;
     uint16_t rx_len = 0;
     uint16_t remain_bytes = 0;
+    w5500_spi_batch_t batch;
     emac->packets_remain = false;
 
-    w5500_get_rx_received_size(emac, &remain_bytes);
+    // get received size and current read pointer
+    ESP_GOTO_ON_ERROR(w5500_get_rx_state(emac, 0, &remain_bytes, &offset), err, TAG, "get RX state failed");
     if (remain_bytes) {
-        // get current read pointer
-        ESP_GOTO_ON_ERROR(w5500_read(emac, W5500_REG_SOCK_RX_RD(0), &offset, sizeof(offset)), err, TAG, "read RX RD failed");
-        offset = __builtin_bswap16(offset);
         // read head first
-        ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, &rx_len, sizeof(rx_len), offset), err, TAG, "read frame header failed");
-        // update read pointer
+        ESP_GOTO_ON_ERROR(w5500_read_buffer(emac, 0, &rx_len, sizeof(rx_len), offset), err, TAG, "read frame header failed");
+        // update read pointer and issue RECV command
         rx_len = __builtin_bswap16(rx_len);
-        offset += rx_len;
-        offset = __builtin_bswap16(offset);
-        ESP_GOTO_ON_ERROR(w5500_write(emac, W5500_REG_SOCK_RX_RD(0), &offset, sizeof(offset)), err, TAG, "write RX RD failed");
-        /* issue RECV command */
-        ESP_GOTO_ON_ERROR(w5500_send_command(emac, W5500_SCR_RECV, 100), err, TAG, "issue RECV command failed");
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_RX);
+        ESP_GOTO_ON_ERROR(w5500_rx_release(emac, 0, &batch, offset + rx_len), err, TAG, "release frame failed");
         // check if there're more data need to process
         remain_bytes -= rx_len;
         emac->packets_remain = remain_bytes > 0;
@@ -784,6 +2072,7 @@ static esp_err_t emac_w5500_flush_recv_frame(emac_w5500_t *emac)
 err:
     return ret;
 }
+#endif // !CONFIG_ETH_W5500_RX_BATCH
 
 IRAM_ATTR static void w5500_isr_handler(void *arg)
 {
@@ -802,68 +2091,198 @@ static void w5500_poll_timer(void *arg)
     xTaskNotifyGive(emac->rx_task_hdl);
 }
 
-static void emac_w5500_task(void *arg)
+/* one round of emac_w5500_task after a wake-up: interrupt status, link sampling, SEND_OK and received frames */
+static void w5500_service(emac_w5500_t *emac)
 {
-    emac_w5500_t *emac = (emac_w5500_t *)arg;
     uint8_t status = 0;
+    uint8_t clear = 0;
+    uint8_t ir = 0;
+    uint8_t phycfg = 0;
+    bool link_check;
+#if CONFIG_ETH_W5500_OFFLOAD
+    uint8_t sir = 0;
+#endif
+    w5500_spi_batch_t batch;
+#if !CONFIG_ETH_W5500_RX_BATCH
     uint8_t *buffer = NULL;
     uint32_t frame_len = 0;
     uint32_t buf_len = 0;
+#endif
     esp_err_t ret;
+    /* read interrupt status, SIR tells which offloaded sockets need attention, the link is sampled along if due */
+    link_check = w5500_link_check_due(emac);
+    w5500_batch_init(&batch, ETH_W5500_SPI_PATH_IRQ);
+    w5500_batch_read(&batch, W5500_REG_SOCK_IR(0), &status, sizeof(status));
+#if CONFIG_ETH_W5500_OFFLOAD
+    w5500_batch_read(&batch, W5500_REG_SIR, &sir, sizeof(sir));
+    w5500_batch_read(&batch, W5500_REG_IR, &ir, sizeof(ir));
+#endif
+    if (link_check) {
+        w5500_batch_read(&batch, W5500_REG_PHYCFGR, &phycfg, sizeof(phycfg));
+    }
+    if (w5500_batch_submit(emac, &batch) == ESP_OK && link_check) {
+        w5500_link_update(emac, phycfg);
+        w5500_link_report(emac);
+    }
+    /* clear all handled events at once, in poll mode SEND_OK is left for emac_w5500_transmit() to poll */
+    clear = status & (emac->int_gpio_num >= 0 ? W5500_SIR_SEND | W5500_SIR_TIMEOUT | W5500_SIR_RECV : W5500_SIR_RECV);
+    ir &= W5500_IR_CONFLICT | W5500_IR_UNREACH;
+    if (clear || ir) {
+        w5500_batch_init(&batch, ETH_W5500_SPI_PATH_IRQ);
+        if (clear) {
+            w5500_batch_write(&batch, W5500_REG_SOCK_IR(0), &clear, sizeof(clear));
+        }
+        if (ir) {
+            w5500_batch_write(&batch, W5500_REG_IR, &ir, sizeof(ir));
+        }
+        w5500_batch_submit(emac, &batch);
+    }
+#if CONFIG_ETH_W5500_OFFLOAD
+    if (ir) {
+        w5500_handle_common_irq(emac, ir);
+    }
+#endif
+    /* frame transmitted, or given up on by the chip */
+    if (clear & (W5500_SIR_SEND | W5500_SIR_TIMEOUT)) {
+        /* retire the frame and start sending the next queued one */
+        w5500_tx_ring_complete(emac, clear & W5500_SIR_TIMEOUT);
+    }
+    /* packet received */
+    if (clear & W5500_SIR_RECV) {
+#if CONFIG_ETH_W5500_RX_BATCH
+        do {
+            if ((ret = emac_w5500_receive_batch(emac)) != ESP_OK) {
+                ESP_LOGE(TAG, "RX batch failed 0x%x", ret);
+            }
+        } while (emac->packets_remain);
+#else
+        do {
+            /* define max expected frame len */
+            frame_len = ETH_MAX_PACKET_SIZE;
+            if ((ret = emac_w5500_alloc_recv_buf(emac, &buffer, &frame_len)) == ESP_OK) {
+                if (buffer != NULL) {
+                    /* we have memory to receive the frame of maximal size previously defined */
+                    buf_len = W5500_ETH_MAC_RX_BUF_SIZE_AUTO;
+                    if (emac->parent.receive(&emac->parent, buffer, &buf_len) == ESP_OK) {
+                        if (buf_len == 0) {
+                            esp_eth_mac_w5500_free_rx_buf(NULL, buffer);
+                        } else if (frame_len > buf_len) {
+                            ESP_LOGE(TAG, "received frame was truncated");
+                            emac->frame_stats.rx_dropped++;
+                            esp_eth_mac_w5500_free_rx_buf(NULL, buffer);
+                        } else {
+                            ESP_LOGD(TAG, "receive len=%" PRIu32, buf_len);
+                            emac->frame_stats.rx_frames++;
+                            emac->frame_stats.rx_bytes += buf_len;
+                            /* pass the buffer to stack (e.g. TCP/IP layer) */
+                            emac->eth->stack_input(emac->eth, buffer, buf_len);
+                        }
+                    } else {
+                        ESP_LOGE(TAG, "frame read from module failed");
+                        emac->frame_stats.rx_dropped++;
+                        esp_eth_mac_w5500_free_rx_buf(NULL, buffer);
+                    }
+                } else if (frame_len) {
+                    ESP_LOGE(TAG, "invalid combination of frame_len(%" PRIu32 ") and buffer pointer(%p)", frame_len, buffer);
+                }
+            } else if (ret == ESP_ERR_NO_MEM) {
+                ESP_LOGD(TAG, "no mem for receive buffer");
+                emac->frame_stats.rx_dropped++;
+                emac_w5500_flush_recv_frame(emac);
+            } else {
+                ESP_LOGE(TAG, "unexpected error 0x%x", ret);
+            }
+        } while (emac->packets_remain);
+#endif // CONFIG_ETH_W5500_RX_BATCH
+    }
+#if CONFIG_ETH_W5500_OFFLOAD
+    for (int i = 1; i < ETH_W5500_SOCK_NUM; i++) {
+        if (sir & (1 << i)) {
+            w5500_sock_handle_irq(emac, i);
+        }
+    }
+#endif
+}
+
+static void emac_w5500_task(void *arg)
+{
+    emac_w5500_t *emac = (emac_w5500_t *)arg;
     while (1) {
         /* check if the task receives any notification */
         if (emac->int_gpio_num >= 0) {                                   // if in interrupt mode
-            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000)) == 0 &&    // if no notification ...
-                    gpio_get_level(emac->int_gpio_num) != 0) {           // ...and no interrupt asserted
-                continue;                                                // -> just continue to check again
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(W5500_LINK_CHECK_MS)) == 0 &&    // if no notification ...
+                    gpio_get_level(emac->int_gpio_num) != 0) {                          // ...and no interrupt asserted
+                if (w5500_link_check_due(emac)) {                                       // -> sample the link ...
+                    w5500_link_check(emac);
+                    w5500_link_report(emac);
+                }
+                continue;                                                               // ...and check again
             }
         } else {
             ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         }
-        /* read interrupt status */
-        w5500_read(emac, W5500_REG_SOCK_IR(0), &status, sizeof(status));
-        /* packet received */
-        if (status & W5500_SIR_RECV) {
-            status = W5500_SIR_RECV;
-            /* clear interrupt status */
-            w5500_write(emac, W5500_REG_SOCK_IR(0), &status, sizeof(status));
-            do {
-                /* define max expected frame len */
-                frame_len = ETH_MAX_PACKET_SIZE;
-                if ((ret = emac_w5500_alloc_recv_buf(emac, &buffer, &frame_len)) == ESP_OK) {
-                    if (buffer != NULL) {
-                        /* we have memory to receive the frame of maximal size previously defined */
-                        buf_len = W5500_ETH_MAC_RX_BUF_SIZE_AUTO;
-                        if (emac->parent.receive(&emac->parent, buffer, &buf_len) == ESP_OK) {
-                            if (buf_len == 0) {
-                                free(buffer);
-                            } else if (frame_len > buf_len) {
-                                ESP_LOGE(TAG, "received frame was truncated");
-                                free(buffer);
-                            } else {
-                                ESP_LOGD(TAG, "receive len=%" PRIu32, buf_len);
-                                /* pass the buffer to stack (e.g. TCP/IP layer) */
-                                emac->eth->stack_input(emac->eth, buffer, buf_len);
-                            }
-                        } else {
-                            ESP_LOGE(TAG, "frame read from module failed");
-                            free(buffer);
-                        }
-                    } else if (frame_len) {
-                        ESP_LOGE(TAG, "invalid combination of frame_len(%" PRIu32 ") and buffer pointer(%p)", frame_len, buffer);
-                    }
-                } else if (ret == ESP_ERR_NO_MEM) {
-                    ESP_LOGE(TAG, "no mem for receive buffer");
-                    emac_w5500_flush_recv_frame(emac);
-                } else {
-                    ESP_LOGE(TAG, "unexpected error 0x%x", ret);
-                }
-            } while (emac->packets_remain);
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+        /* serve the other tasks first, no need to look at the chip if they were the only reason for waking up */
+        if (w5500_owner_serve(emac) && emac->int_gpio_num >= 0 && gpio_get_level(emac->int_gpio_num) != 0) {
+            continue;
         }
+#endif
+        w5500_service(emac);
     }
     vTaskDelete(NULL);
 }
 
+static esp_err_t emac_w5500_custom_ioctl(esp_eth_mac_t *mac, int cmd, void *data)
+{
+    esp_err_t ret = ESP_OK;
+    emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+    switch (cmd) {
+    case ETH_W5500_CMD_G_RX_POOL_STATS:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "no mem to store RX pool statistics");
+        ESP_GOTO_ON_FALSE(emac->rx_pool, ESP_ERR_NOT_SUPPORTED, err, TAG, "RX pool is disabled (CONFIG_ETH_W5500_RX_POOL)");
+        w5500_rx_pool_get_stats(emac->rx_pool, (eth_w5500_rx_pool_stats_t *)data);
+        break;
+    case ETH_W5500_CMD_G_SPI_STATS:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "no mem to store SPI statistics");
+        memcpy(data, &emac->spi_stats, sizeof(emac->spi_stats));
+        if (emac->spi.batch) {
+            // only the default SPI driver has a lock of its own to account for
+            eth_spi_info_t *spi = (eth_spi_info_t *)emac->spi.ctx;
+            ((eth_w5500_spi_stats_t *)data)->lock_takes = spi->lock_takes;
+            ((eth_w5500_spi_stats_t *)data)->lock_us = spi->lock_us;
+        }
+        break;
+#if CONFIG_ETH_W5500_OFFLOAD
+    case ETH_W5500_CMD_S_IP_INFO:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "IP configuration can't be NULL");
+        ESP_GOTO_ON_ERROR(w5500_set_ip_info(emac, (eth_w5500_ip_info_t *)data), err, TAG, "set IP configuration failed");
+        break;
+#endif
+    case ETH_W5500_CMD_G_LINK_STATS:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "no mem to store link statistics");
+        memcpy(data, &emac->link_stats, sizeof(emac->link_stats));
+        break;
+    case ETH_W5500_CMD_G_FRAME_STATS:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "no mem to store frame statistics");
+        memcpy(data, &emac->frame_stats, sizeof(emac->frame_stats));
+        break;
+    case ETH_W5500_CMD_G_CMD_STATS:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "no mem to store command statistics");
+        memcpy(data, &emac->cmd_stats, sizeof(emac->cmd_stats));
+        break;
+    case ETH_W5500_CMD_S_CMD_SPIN_US:
+        ESP_GOTO_ON_FALSE(data, ESP_ERR_INVALID_ARG, err, TAG, "command spin budget can't be NULL");
+        emac->cmd_spin_us = *(uint32_t *)data;
+        break;
+    default:
+        ESP_GOTO_ON_FALSE(false, ESP_ERR_INVALID_ARG, err, TAG, "unknown io command: %d", cmd);
+        break;
+    }
+
+err:
+    return ret;
+}
+
 static esp_err_t emac_w5500_init(esp_eth_mac_t *mac)
 {
     esp_err_t ret = ESP_OK;
@@ -884,6 +2303,9 @@ static esp_err_t emac_w5500_init(esp_eth_mac_t *mac)
     ESP_GOTO_ON_ERROR(w5500_verify_id(emac), err, TAG, "verify chip ID failed");
     /* default setup of internal registers */
     ESP_GOTO_ON_ERROR(w5500_setup_default(emac), err, TAG, "w5500 default setup failed");
+    /* PHY driver reads are served from the cache from now on, it has to hold the register before */
+    w5500_link_check(emac);
+    emac->link_watch = true;
     return ESP_OK;
 err:
     if (emac->int_gpio_num >= 0) {
@@ -898,6 +2320,8 @@ static esp_err_t emac_w5500_deinit(esp_eth_mac_t *mac)
 {
     emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
     esp_eth_mediator_t *eth = emac->eth;
+    emac->link_watch = false;
+    emac->link_push = false;
     mac->stop(mac);
     if (emac->int_gpio_num >= 0) {
         gpio_isr_handler_remove(emac->int_gpio_num);
@@ -913,16 +2337,50 @@ static esp_err_t emac_w5500_deinit(esp_eth_mac_t *mac)
 static esp_err_t emac_w5500_del(esp_eth_mac_t *mac)
 {
     emac_w5500_t *emac = __containerof(mac, emac_w5500_t, parent);
+    w5500_link_unregister(emac);
     if (emac->poll_timer) {
         esp_timer_delete(emac->poll_timer);
     }
     vTaskDelete(emac->rx_task_hdl);
     emac->spi.deinit(emac->spi.ctx);
-    heap_caps_free(emac->rx_buffer);
+    vSemaphoreDelete(emac->tx_lock);
+    if (emac->sock_lock) {
+        vSemaphoreDelete(emac->sock_lock);
+    }
+    w5500_rx_pool_del(emac->rx_pool);
+    w5500_req_queue_del(emac->owner_queue);
+    heap_caps_free(emac->rx_batch_buf);
+    heap_caps_free(emac->sock_rx_buf);
     free(emac);
     return ESP_OK;
 }
 
+static bool w5500_sock_buf_config_valid(const eth_w5500_sock_buf_config_t *config)
+{
+    uint32_t rx_total = 0;
+    uint32_t tx_total = 0;
+    for (int i = 0; i < ETH_W5500_SOCK_NUM; i++) {
+        uint8_t rx = config->rx_size_kb[i];
+        uint8_t tx = config->tx_size_kb[i];
+        // the chip only knows 0, 1, 2, 4, 8 and 16 KB
+        if (rx > W5500_SOCK_MEM_KB || tx > W5500_SOCK_MEM_KB || (rx & (rx - 1)) || (tx & (tx - 1))) {
+            ESP_LOGE(TAG, "socket %d: buffer size must be 0, 1, 2, 4, 8 or 16 KB", i);
+            return false;
+        }
+        rx_total += rx;
+        tx_total += tx;
+    }
+    if (rx_total > W5500_SOCK_MEM_KB || tx_total > W5500_SOCK_MEM_KB) {
+        ESP_LOGE(TAG, "socket buffers exceed %d KB (RX %" PRIu32 " KB, TX %" PRIu32 " KB)", W5500_SOCK_MEM_KB, rx_total, tx_total);
+        return false;
+    }
+    if (config->rx_size_kb[0] < W5500_MACRAW_MIN_BUF_KB || config->tx_size_kb[0] < W5500_MACRAW_MIN_BUF_KB) {
+        ESP_LOGE(TAG, "MAC RAW socket needs at least %d KB of RX and TX buffer", W5500_MACRAW_MIN_BUF_KB);
+        return false;
+    }
+    return true;
+}
+
 esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, const eth_mac_config_t *mac_config)
 {
     esp_eth_mac_t *ret = NULL;
@@ -935,6 +2393,7 @@ esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, con
     emac->sw_reset_timeout_ms = mac_config->sw_reset_timeout_ms;
     emac->int_gpio_num = w5500_config->int_gpio_num;
     emac->poll_period_ms = w5500_config->poll_period_ms;
+    emac->link_reported = ETH_LINK_DOWN;
     emac->parent.set_mediator = emac_w5500_set_mediator;
     emac->parent.init = emac_w5500_init;
     emac->parent.deinit = emac_w5500_deinit;
@@ -956,6 +2415,10 @@ esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, con
     emac->parent.enable_flow_ctrl = emac_w5500_enable_flow_ctrl;
     emac->parent.transmit = emac_w5500_transmit;
     emac->parent.receive = emac_w5500_receive;
+    emac->parent.custom_ioctl = emac_w5500_custom_ioctl;
+    emac->cmd_spin_us = CONFIG_ETH_W5500_CMD_SPIN_US;
+    ESP_GOTO_ON_FALSE(w5500_sock_buf_config_valid(&w5500_config->sock_buf), NULL, err, TAG, "invalid socket buffer configuration");
+    emac->sock_buf = w5500_config->sock_buf;
 
     if (w5500_config->custom_spi_driver.init != NULL && w5500_config->custom_spi_driver.deinit != NULL
             && w5500_config->custom_spi_driver.read != NULL && w5500_config->custom_spi_driver.write != NULL) {
@@ -972,10 +2435,34 @@ esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, con
         emac->spi.deinit = w5500_spi_deinit;
         emac->spi.read = w5500_spi_read;
         emac->spi.write = w5500_spi_write;
+        emac->spi.batch = w5500_spi_batch;
         /* SPI device init */
         ESP_GOTO_ON_FALSE((emac->spi.ctx = emac->spi.init(w5500_config)) != NULL, NULL, err, TAG, "SPI initialization failed");
     }
 
+    emac->tx_lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(emac->tx_lock, NULL, err, TAG, "create TX lock failed");
+#if CONFIG_ETH_W5500_SPI_SINGLE_OWNER
+    emac->owner_queue = w5500_req_queue_new(W5500_OWNER_QUEUE_LEN);
+    ESP_GOTO_ON_FALSE(emac->owner_queue, NULL, err, TAG, "create request queue failed");
+#endif
+
+#if CONFIG_ETH_W5500_RX_POOL
+    emac->rx_pool = w5500_rx_pool_new(CONFIG_ETH_W5500_RX_POOL_SMALL_NUM, CONFIG_ETH_W5500_RX_POOL_LARGE_NUM,
+                                      W5500_RX_DMA_LEN(ETH_MAX_PACKET_SIZE));
+    ESP_GOTO_ON_FALSE(emac->rx_pool, NULL, err, TAG, "RX pool allocation failed");
+#endif
+#if CONFIG_ETH_W5500_RX_BATCH
+    emac->rx_batch_buf = heap_caps_malloc(W5500_RX_DMA_LEN(CONFIG_ETH_W5500_RX_BATCH_BUF_SIZE), MALLOC_CAP_DMA);
+    ESP_GOTO_ON_FALSE(emac->rx_batch_buf, NULL, err, TAG, "RX batch buffer allocation failed");
+#endif
+#if CONFIG_ETH_W5500_OFFLOAD
+    emac->sock_lock = xSemaphoreCreateMutex();
+    ESP_GOTO_ON_FALSE(emac->sock_lock, NULL, err, TAG, "create socket lock failed");
+    emac->sock_rx_buf = heap_caps_malloc(W5500_RX_DMA_LEN(W5500_OFFLOAD_RX_BUF_SIZE), MALLOC_CAP_DMA);
+    ESP_GOTO_ON_FALSE(emac->sock_rx_buf, NULL, err, TAG, "socket RX buffer allocation failed");
+#endif
+
     /* create w5500 task */
     BaseType_t core_num = tskNO_AFFINITY;
     if (mac_config->flags & ETH_MAC_FLAG_PIN_TO_CORE) {
@@ -985,9 +2472,6 @@ esp_eth_mac_t *esp_eth_mac_new_w5500(const eth_w5500_config_t *w5500_config, con
                                                    mac_config->rx_task_prio, &emac->rx_task_hdl, core_num);
     ESP_GOTO_ON_FALSE(xReturned == pdPASS, NULL, err, TAG, "create w5500 task failed");
 
-    emac->rx_buffer = heap_caps_malloc(ETH_MAX_PACKET_SIZE, MALLOC_CAP_DMA);
-    ESP_GOTO_ON_FALSE(emac->rx_buffer, NULL, err, TAG, "RX buffer allocation failed");
-
     if (emac->int_gpio_num < 0) {
         const esp_timer_create_args_t poll_timer_args = {
             .callback = w5500_poll_timer,
@@ -1011,7 +2495,16 @@ err:
         if (emac->spi.ctx) {
             emac->spi.deinit(emac->spi.ctx);
         }
-        heap_caps_free(emac->rx_buffer);
+        if (emac->tx_lock) {
+            vSemaphoreDelete(emac->tx_lock);
+        }
+        if (emac->sock_lock) {
+            vSemaphoreDelete(emac->sock_lock);
+        }
+        w5500_rx_pool_del(emac->rx_pool);
+        w5500_req_queue_del(emac->owner_queue);
+        heap_caps_free(emac->rx_batch_buf);
+        heap_caps_free(emac->sock_rx_buf);
         free(emac);
     }
     return ret;
@@ -17,6 +17,8 @@
 #include "soc/io_mux_reg.h"
 #include "esp_rom_sys.h"
 #include "w5500.h"
+#include "w5500_link.h"
+#include "sdkconfig.h"
 
 #define W5500_WAIT_FOR_RESET_MS (10) // wait for W5500 internal PLL to be Locked after reset assert
 
@@ -50,6 +52,16 @@ typedef enum {
     W5500_OP_MODE_ALL_CAPABLE,
 } phy_w5500_op_mode_e;
 
+#if CONFIG_ETH_W5500_PHY_MODE_100M_FULL
+#define W5500_FIXED_OP_MODE W5500_OP_MODE_100BT_FULL_AUTO_DIS
+#elif CONFIG_ETH_W5500_PHY_MODE_100M_HALF
+#define W5500_FIXED_OP_MODE W5500_OP_MODE_100BT_HALF_AUTO_DIS
+#elif CONFIG_ETH_W5500_PHY_MODE_10M_FULL
+#define W5500_FIXED_OP_MODE W5500_OP_MODE_10BT_FULL_AUTO_DIS
+#elif CONFIG_ETH_W5500_PHY_MODE_10M_HALF
+#define W5500_FIXED_OP_MODE W5500_OP_MODE_10BT_HALF_AUTO_DIS
+#endif
+
 typedef struct {
     esp_eth_phy_t parent;
     esp_eth_mediator_t *eth;
@@ -68,6 +80,10 @@ static esp_err_t w5500_update_link_duplex_speed(phy_w5500_t *w5500)
     eth_duplex_t duplex = ETH_DUPLEX_HALF;
     phycfg_reg_t phycfg;
 
+    /* in interrupt mode the MAC driver task watches the link and reports changes itself, just follow what it reported */
+    if (w5500_link_take_over(eth, &w5500->link_status) == ESP_OK) {
+        return ESP_OK;
+    }
     ESP_GOTO_ON_ERROR(eth->phy_reg_read(eth, w5500->addr, W5500_REG_PHYCFGR, (uint32_t *) & (phycfg.val)), err, TAG, "read PHYCFG failed");
     eth_link_t link = phycfg.link ? ETH_LINK_UP : ETH_LINK_DOWN;
     /* check if link status changed */
@@ -123,6 +139,8 @@ static esp_err_t w5500_set_link(esp_eth_phy_t *phy, eth_link_t link)
     phy_w5500_t *w5500 = __containerof(phy, phy_w5500_t, parent);
     esp_eth_mediator_t *eth   = w5500->eth;
 
+    /* the driver is stopping, take link reporting back from the MAC driver task */
+    w5500_link_hand_back(eth);
     if (w5500->link_status != link) {
         w5500->link_status = link;
         // link status changed, inmiedately report to upper layers
@@ -140,6 +158,11 @@ static esp_err_t w5500_reset(esp_eth_phy_t *phy)
     esp_eth_mediator_t *eth = w5500->eth;
     phycfg_reg_t phycfg;
     ESP_GOTO_ON_ERROR(eth->phy_reg_read(eth, w5500->addr, W5500_REG_PHYCFGR, (uint32_t *) & (phycfg.val)), err, TAG, "read PHYCFG failed");
+#ifdef W5500_FIXED_OP_MODE
+    // skip auto-negotiation, the mode takes effect with this reset and the link comes up right after it
+    phycfg.opsel = 1;
+    phycfg.opmode = W5500_FIXED_OP_MODE;
+#endif
     phycfg.reset = 0; // set to '0' will reset internal PHY
     ESP_GOTO_ON_ERROR(eth->phy_reg_write(eth, w5500->addr, W5500_REG_PHYCFGR, phycfg.val), err, TAG, "write PHYCFG failed");
     vTaskDelay(pdMS_TO_TICKS(W5500_WAIT_FOR_RESET_MS));
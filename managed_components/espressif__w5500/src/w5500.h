@@ -26,7 +26,10 @@
 #define W5500_MAKE_MAP(offset, bsb) ((offset) << W5500_ADDR_OFFSET | (bsb) << W5500_BSB_OFFSET)
 
 #define W5500_REG_MR        W5500_MAKE_MAP(0x0000, W5500_BSB_COM_REG) // Mode
+#define W5500_REG_GAR       W5500_MAKE_MAP(0x0001, W5500_BSB_COM_REG) // Gateway IP Address
+#define W5500_REG_SUBR      W5500_MAKE_MAP(0x0005, W5500_BSB_COM_REG) // Subnet Mask
 #define W5500_REG_MAC       W5500_MAKE_MAP(0x0009, W5500_BSB_COM_REG) // MAC Address
+#define W5500_REG_SIPR      W5500_MAKE_MAP(0x000F, W5500_BSB_COM_REG) // Source IP Address
 #define W5500_REG_INTLEVEL  W5500_MAKE_MAP(0x0013, W5500_BSB_COM_REG) // Interrupt Level Timeout
 #define W5500_REG_IR        W5500_MAKE_MAP(0x0015, W5500_BSB_COM_REG) // Interrupt
 #define W5500_REG_IMR       W5500_MAKE_MAP(0x0016, W5500_BSB_COM_REG) // Interrupt Mask
@@ -34,13 +37,18 @@
 #define W5500_REG_SIMR      W5500_MAKE_MAP(0x0018, W5500_BSB_COM_REG) // Socket Interrupt Mask
 #define W5500_REG_RTR       W5500_MAKE_MAP(0x0019, W5500_BSB_COM_REG) // Retry Time
 #define W5500_REG_RCR       W5500_MAKE_MAP(0x001B, W5500_BSB_COM_REG) // Retry Count
+#define W5500_REG_UIPR      W5500_MAKE_MAP(0x0028, W5500_BSB_COM_REG) // Unreachable IP Address
+#define W5500_REG_UPORTR    W5500_MAKE_MAP(0x002C, W5500_BSB_COM_REG) // Unreachable Port
 #define W5500_REG_PHYCFGR   W5500_MAKE_MAP(0x002E, W5500_BSB_COM_REG) // PHY Configuration
 #define W5500_REG_VERSIONR  W5500_MAKE_MAP(0x0039, W5500_BSB_COM_REG) // Chip version
 
 #define W5500_REG_SOCK_MR(s)         W5500_MAKE_MAP(0x0000, W5500_BSB_SOCK_REG(s)) // Socket Mode
 #define W5500_REG_SOCK_CR(s)         W5500_MAKE_MAP(0x0001, W5500_BSB_SOCK_REG(s)) // Socket Command
 #define W5500_REG_SOCK_IR(s)         W5500_MAKE_MAP(0x0002, W5500_BSB_SOCK_REG(s)) // Socket Interrupt
-#define W5500_REG_SOCK_SR(s)         W5500_MAKE_MAP(0x0004, W5500_BSB_SOCK_REG(s)) // Socket Status
+#define W5500_REG_SOCK_SR(s)         W5500_MAKE_MAP(0x0003, W5500_BSB_SOCK_REG(s)) // Socket Status
+#define W5500_REG_SOCK_PORT(s)       W5500_MAKE_MAP(0x0004, W5500_BSB_SOCK_REG(s)) // Socket Source Port
+#define W5500_REG_SOCK_DIPR(s)       W5500_MAKE_MAP(0x000C, W5500_BSB_SOCK_REG(s)) // Socket Destination IP Address
+#define W5500_REG_SOCK_DPORT(s)      W5500_MAKE_MAP(0x0010, W5500_BSB_SOCK_REG(s)) // Socket Destination Port
 #define W5500_REG_SOCK_RXBUF_SIZE(s) W5500_MAKE_MAP(0x001E, W5500_BSB_SOCK_REG(s)) // Socket Receive Buffer Size
 #define W5500_REG_SOCK_TXBUF_SIZE(s) W5500_MAKE_MAP(0x001F, W5500_BSB_SOCK_REG(s)) // Socket Transmit Buffer Size
 #define W5500_REG_SOCK_TX_FSR(s)     W5500_MAKE_MAP(0x0020, W5500_BSB_SOCK_REG(s)) // Socket TX Free Size
@@ -57,16 +65,35 @@
 #define W5500_MR_RST (1<<7) // Software reset
 #define W5500_MR_PB  (1<<4) // Ping block (block the response to a ping request)
 
+#define W5500_IR_UNREACH  (1<<6) // Destination unreachable
+#define W5500_IR_CONFLICT (1<<7) // IP conflict
+
 #define W5500_SIMR_SOCK0 (1<<0) // Socket 0 interrupt
 
+#define W5500_PHYCFGR_LNK (1<<0) // Link up
+#define W5500_PHYCFGR_SPD (1<<1) // 100 Mbps
+#define W5500_PHYCFGR_DPX (1<<2) // Full duplex
+
+#define W5500_SMR_TCP        (0x01) // TCP mode
+#define W5500_SMR_UDP        (0x02) // UDP mode
 #define W5500_SMR_MAC_RAW    (1<<2) // MAC RAW mode
 #define W5500_SMR_MAC_FILTER (1<<7) // MAC filter
 #define W5500_SMR_MAC_BLOCK_MCAST (1<<5) // Block multicast
 
 #define W5500_SCR_OPEN  (0x01) // Open command
+#define W5500_SCR_LISTEN  (0x02) // Listen command
+#define W5500_SCR_CONNECT (0x04) // Connect command
 #define W5500_SCR_CLOSE (0x10) // Close command
 #define W5500_SCR_SEND  (0x20) // Send command
 #define W5500_SCR_RECV  (0x40) // Recv command
 
+#define W5500_SIR_CON     (1<<0)  // Connection established
+#define W5500_SIR_DISCON  (1<<1)  // Peer closed the connection
 #define W5500_SIR_RECV (1<<2)  // Receive done
+#define W5500_SIR_TIMEOUT (1<<3)  // ARP or TCP retransmission timeout
 #define W5500_SIR_SEND (1<<4)  // Send done
+
+#define W5500_SSR_INIT        (0x13) // TCP socket opened
+#define W5500_SSR_ESTABLISHED (0x17) // TCP connection established
+#define W5500_SSR_CLOSE_WAIT  (0x1C) // TCP peer sent FIN
+#define W5500_SSR_UDP         (0x22) // UDP socket opened
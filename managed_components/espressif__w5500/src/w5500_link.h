@@ -0,0 +1,34 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "esp_err.h"
+#include "esp_eth_com.h"
+
+// Link reporting shared by the W5500 MAC and PHY drivers of one Ethernet driver, found through their common
+// mediator. Private to this component, the W5500 has no link change interrupt and in interrupt mode the MAC driver
+// task samples PHYCFGR anyway.
+
+/**
+ * @brief Hand link reporting over to the MAC driver task, which reports link changes to the core as it sees them
+ *
+ * Called by the PHY driver on every periodic link check, it then follows the link the core was told.
+ *
+ * @param eth mediator of the Ethernet driver
+ * @param[out] link link state as last reported to the core
+ * @return
+ *      - ESP_OK: the MAC driver task reports link changes
+ *      - ESP_ERR_NOT_SUPPORTED: no W5500 MAC of this mediator watches the link (poll mode, or not initialized),
+ *        the PHY driver reads PHYCFGR and reports link changes itself
+ */
+esp_err_t w5500_link_take_over(esp_eth_mediator_t *eth, eth_link_t *link);
+
+/**
+ * @brief Take link reporting back from the MAC driver task, the driver is stopping
+ *
+ * @param eth mediator of the Ethernet driver
+ */
+void w5500_link_hand_back(esp_eth_mediator_t *eth);
@@ -0,0 +1,94 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <stdlib.h>
+#include <stdatomic.h>
+#include "w5500_req_queue.h"
+
+/* every slot carries a sequence number telling whether it is free for the producer or filled for the consumer of a lap */
+typedef struct {
+    _Atomic uint32_t seq;
+    void *item;
+} w5500_req_slot_t;
+
+struct w5500_req_queue_s {
+    _Atomic uint32_t enqueue_pos;
+    _Atomic uint32_t dequeue_pos;
+    uint32_t mask;
+    w5500_req_slot_t slots[];
+};
+
+w5500_req_queue_t *w5500_req_queue_new(uint32_t len)
+{
+    if (len == 0 || (len & (len - 1))) {
+        return NULL;
+    }
+    w5500_req_queue_t *queue = calloc(1, sizeof(w5500_req_queue_t) + len * sizeof(w5500_req_slot_t));
+    if (!queue) {
+        return NULL;
+    }
+    queue->mask = len - 1;
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    for (uint32_t i = 0; i < len; i++) {
+        atomic_init(&queue->slots[i].seq, i);
+    }
+    return queue;
+}
+
+void w5500_req_queue_del(w5500_req_queue_t *queue)
+{
+    free(queue);
+}
+
+bool w5500_req_queue_push(w5500_req_queue_t *queue, void *item)
+{
+    w5500_req_slot_t *slot;
+    uint32_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    while (1) {
+        slot = &queue->slots[pos & queue->mask];
+        int32_t diff = (int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            // slot is free in this lap, claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->enqueue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // the consumer has not emptied the slot since the previous lap
+            return false;
+        } else {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+    slot->item = item;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    return true;
+}
+
+void *w5500_req_queue_pop(w5500_req_queue_t *queue)
+{
+    w5500_req_slot_t *slot;
+    uint32_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    while (1) {
+        slot = &queue->slots[pos & queue->mask];
+        int32_t diff = (int32_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->dequeue_pos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // nothing published in this slot yet
+            return NULL;
+        } else {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+    void *item = slot->item;
+    // hand the slot over to the producers of the next lap
+    atomic_store_explicit(&slot->seq, pos + queue->mask + 1, memory_order_release);
+    return item;
+}
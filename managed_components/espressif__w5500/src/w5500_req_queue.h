@@ -0,0 +1,38 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct w5500_req_queue_s w5500_req_queue_t;
+
+/**
+ * @brief Create a bounded queue of pointers
+ *
+ * @param len number of entries, must be a power of two
+ * @return queue instance or NULL when out of memory
+ */
+w5500_req_queue_t *w5500_req_queue_new(uint32_t len);
+
+/**
+ * @brief Delete the queue, entries still queued are not touched
+ */
+void w5500_req_queue_del(w5500_req_queue_t *queue);
+
+/**
+ * @brief Append an entry, lock-free and safe from any task
+ *
+ * @return false if the queue is full
+ */
+bool w5500_req_queue_push(w5500_req_queue_t *queue, void *item);
+
+/**
+ * @brief Take the oldest entry, lock-free
+ *
+ * @return entry or NULL when the queue is empty
+ */
+void *w5500_req_queue_pop(w5500_req_queue_t *queue);
@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include <string.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <inttypes.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "w5500_rx_pool.h"
+
+#define W5500_RX_POOL_MAX_INSTANCES (2)
+#define W5500_RX_POOL_EMPTY (0xFFFF)                // list terminator, limits a class to 65535 buffers
+#define W5500_RX_POOL_IDX(head) ((head) & 0xFFFF)
+#define W5500_RX_POOL_TAG_INC (0x10000)             // upper half of the list head is a version tag against ABA
+
+typedef struct {
+    uint8_t *mem;          // buffers of this class, laid out back-to-back
+    uint16_t *next;        // free list links, indexed by buffer
+    uint32_t buf_size;
+    uint32_t num;
+    _Atomic uint32_t head;      // version tag << 16 | index of the first free buffer
+    _Atomic uint32_t in_use;
+    uint32_t high_water;
+    uint32_t alloc_fail;
+    uint64_t occupancy_sum;     // in_use summed at every allocation, for the average
+    uint32_t samples;
+} w5500_rx_pool_class_t;
+
+struct w5500_rx_pool_s {
+    w5500_rx_pool_class_t cls[2];
+};
+
+enum {
+    W5500_RX_POOL_SMALL,
+    W5500_RX_POOL_LARGE,
+};
+
+static const char *TAG = "w5500.pool";
+
+// buffers are returned by the TCP/IP stack without any reference to the MAC, so keep track of the pools here
+static w5500_rx_pool_t *s_pools[W5500_RX_POOL_MAX_INSTANCES];
+static portMUX_TYPE s_pools_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool w5500_rx_pool_class_init(w5500_rx_pool_class_t *cls, uint32_t num, uint32_t buf_size)
+{
+    cls->num = num;
+    cls->buf_size = buf_size;
+    atomic_init(&cls->head, W5500_RX_POOL_EMPTY);
+    atomic_init(&cls->in_use, 0);
+    if (num == 0) {
+        return true;
+    }
+    cls->mem = heap_caps_malloc(num * buf_size, MALLOC_CAP_DMA);
+    cls->next = calloc(num, sizeof(uint16_t));
+    if (!cls->mem || !cls->next) {
+        return false;
+    }
+    for (uint32_t i = 0; i < num; i++) {
+        cls->next[i] = (i + 1 < num) ? i + 1 : W5500_RX_POOL_EMPTY;
+    }
+    atomic_store(&cls->head, 0);
+    return true;
+}
+
+static void *w5500_rx_pool_class_pop(w5500_rx_pool_class_t *cls)
+{
+    uint32_t head = atomic_load(&cls->head);
+    uint32_t new_head;
+    uint32_t idx;
+    do {
+        idx = W5500_RX_POOL_IDX(head);
+        if (idx == W5500_RX_POOL_EMPTY) {
+            return NULL;
+        }
+        new_head = ((head + W5500_RX_POOL_TAG_INC) & ~0xFFFF) | cls->next[idx];
+    } while (!atomic_compare_exchange_weak(&cls->head, &head, new_head));
+
+    // statistics are only updated by the allocating side, which is the single w5500 task
+    uint32_t in_use = atomic_fetch_add(&cls->in_use, 1) + 1;
+    if (in_use > cls->high_water) {
+        cls->high_water = in_use;
+    }
+    cls->occupancy_sum += in_use;
+    cls->samples++;
+    return cls->mem + idx * cls->buf_size;
+}
+
+static void w5500_rx_pool_class_push(w5500_rx_pool_class_t *cls, uint32_t idx)
+{
+    uint32_t head = atomic_load(&cls->head);
+    uint32_t new_head;
+    do {
+        cls->next[idx] = W5500_RX_POOL_IDX(head);
+        new_head = ((head + W5500_RX_POOL_TAG_INC) & ~0xFFFF) | idx;
+    } while (!atomic_compare_exchange_weak(&cls->head, &head, new_head));
+    atomic_fetch_sub(&cls->in_use, 1);
+}
+
+w5500_rx_pool_t *w5500_rx_pool_new(uint32_t small_num, uint32_t large_num, uint32_t large_size)
+{
+    if (small_num >= W5500_RX_POOL_EMPTY || large_num >= W5500_RX_POOL_EMPTY) {
+        ESP_LOGE(TAG, "too many buffers");
+        return NULL;
+    }
+    w5500_rx_pool_t *pool = calloc(1, sizeof(w5500_rx_pool_t));
+    if (!pool) {
+        return NULL;
+    }
+    if (!w5500_rx_pool_class_init(&pool->cls[W5500_RX_POOL_SMALL], small_num, W5500_RX_POOL_SMALL_SIZE) ||
+            !w5500_rx_pool_class_init(&pool->cls[W5500_RX_POOL_LARGE], large_num, large_size)) {
+        ESP_LOGE(TAG, "no mem for %" PRIu32 "+%" PRIu32 " buffers", small_num, large_num);
+        w5500_rx_pool_del(pool);
+        return NULL;
+    }
+    bool registered = false;
+    portENTER_CRITICAL(&s_pools_lock);
+    for (int i = 0; i < W5500_RX_POOL_MAX_INSTANCES; i++) {
+        if (s_pools[i] == NULL) {
+            s_pools[i] = pool;
+            registered = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&s_pools_lock);
+    if (!registered) {
+        ESP_LOGE(TAG, "too many pool instances");
+        w5500_rx_pool_del(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void w5500_rx_pool_del(w5500_rx_pool_t *pool)
+{
+    if (!pool) {
+        return;
+    }
+    portENTER_CRITICAL(&s_pools_lock);
+    for (int i = 0; i < W5500_RX_POOL_MAX_INSTANCES; i++) {
+        if (s_pools[i] == pool) {
+            s_pools[i] = NULL;
+        }
+    }
+    portEXIT_CRITICAL(&s_pools_lock);
+    for (int c = 0; c < 2; c++) {
+        heap_caps_free(pool->cls[c].mem);
+        free(pool->cls[c].next);
+    }
+    free(pool);
+}
+
+void *w5500_rx_pool_alloc(w5500_rx_pool_t *pool, uint32_t size)
+{
+    w5500_rx_pool_class_t *small = &pool->cls[W5500_RX_POOL_SMALL];
+    w5500_rx_pool_class_t *large = &pool->cls[W5500_RX_POOL_LARGE];
+    void *buf = NULL;
+    if (size <= small->buf_size) {
+        buf = w5500_rx_pool_class_pop(small);
+        if (buf) {
+            return buf;
+        }
+        small->alloc_fail++;
+    }
+    if (size <= large->buf_size) {
+        buf = w5500_rx_pool_class_pop(large);
+        if (!buf) {
+            large->alloc_fail++;
+        }
+    }
+    return buf;
+}
+
+bool w5500_rx_pool_free(void *buf)
+{
+    uint8_t *p = buf;
+    for (int i = 0; i < W5500_RX_POOL_MAX_INSTANCES; i++) {
+        w5500_rx_pool_t *pool = s_pools[i];
+        if (!pool) {
+            continue;
+        }
+        for (int c = 0; c < 2; c++) {
+            w5500_rx_pool_class_t *cls = &pool->cls[c];
+            if (cls->num && p >= cls->mem && p < cls->mem + cls->num * cls->buf_size) {
+                w5500_rx_pool_class_push(cls, (p - cls->mem) / cls->buf_size);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void w5500_rx_pool_class_stats(w5500_rx_pool_class_t *cls, eth_w5500_rx_pool_class_stats_t *stats)
+{
+    stats->capacity = cls->num;
+    stats->in_use = atomic_load(&cls->in_use);
+    stats->high_water = cls->high_water;
+    stats->alloc_fail = cls->alloc_fail;
+    stats->avg_in_use = cls->samples ? (float)cls->occupancy_sum / cls->samples : 0.0f;
+}
+
+void w5500_rx_pool_get_stats(w5500_rx_pool_t *pool, eth_w5500_rx_pool_stats_t *stats)
+{
+    w5500_rx_pool_class_stats(&pool->cls[W5500_RX_POOL_SMALL], &stats->small);
+    w5500_rx_pool_class_stats(&pool->cls[W5500_RX_POOL_LARGE], &stats->large);
+}
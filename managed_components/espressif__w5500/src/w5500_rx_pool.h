@@ -0,0 +1,50 @@
+/*
+ * SPDX-FileCopyrightText: 2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_eth_mac_w5500.h"
+
+#define W5500_RX_POOL_SMALL_SIZE (256) // frames up to this size are served from the small class
+
+typedef struct w5500_rx_pool_s w5500_rx_pool_t;
+
+/**
+ * @brief Create a pool of DMA capable receive buffers
+ *
+ * @param small_num number of buffers of W5500_RX_POOL_SMALL_SIZE bytes
+ * @param large_num number of buffers of large_size bytes
+ * @param large_size size of the large buffers, must be a multiple of 4
+ * @return pool instance or NULL when out of memory
+ */
+w5500_rx_pool_t *w5500_rx_pool_new(uint32_t small_num, uint32_t large_num, uint32_t large_size);
+
+/**
+ * @brief Delete the pool, all buffers must have been returned
+ */
+void w5500_rx_pool_del(w5500_rx_pool_t *pool);
+
+/**
+ * @brief Take a buffer of at least size bytes, lock-free
+ *
+ * Small frames fall back to the large class when the small one is empty.
+ *
+ * @return buffer or NULL when no suitable buffer is free
+ */
+void *w5500_rx_pool_alloc(w5500_rx_pool_t *pool, uint32_t size);
+
+/**
+ * @brief Return a buffer to the pool it was taken from, lock-free and safe from any task
+ *
+ * @return true if buf belongs to a pool, false if it is not a pool buffer (and was not touched)
+ */
+bool w5500_rx_pool_free(void *buf);
+
+/**
+ * @brief Read the usage statistics of the pool
+ */
+void w5500_rx_pool_get_stats(w5500_rx_pool_t *pool, eth_w5500_rx_pool_stats_t *stats);